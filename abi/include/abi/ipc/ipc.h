@@ -48,6 +48,9 @@
 /** Maximum active async calls per phone */
 #define IPC_MAX_ASYNC_CALLS  64
 
+/** Maximum number of calls submitted or received by one batched syscall */
+#define IPC_BATCH_MAX  16
+
 /* Flags for calls */
 
 /** This is answer to a call */
@@ -127,6 +130,16 @@ typedef struct {
 	cap_call_handle_t cap_handle;
 } ipc_data_t;
 
+/** Call submitted by SYS_IPC_CALL_ASYNC_BATCH */
+typedef struct {
+	/** Phone capability handle for the call */
+	cap_phone_handle_t phone;
+	/** User-defined label associated with the answer */
+	sysarg_t label;
+	/** Interface, method and payload arguments */
+	sysarg_t args[IPC_CALL_LEN];
+} ipc_batch_call_t;
+
 #endif
 
 /** @}
@@ -108,17 +108,21 @@ enum {
 	 */
 	IPC_M_CONNECT_ME_TO,
 
-	/** Share a single page over IPC.
+	/** Page in a cluster of pages over IPC.
 	 *
 	 * - ARG1 - page-aligned offset from the beginning of the memory object
-	 * - ARG2 - page size
+	 * - ARG2 - size of the cluster, a multiple of page size
 	 * - ARG3 - user defined memory object ID
 	 * - ARG4 - user defined memory object ID
 	 * - ARG5 - user defined memory object ID
 	 *
 	 * on answer, the recipient must set:
 	 *
-	 * - ARG1 - source user page address
+	 * - ARG1 - source user address of the cluster
+	 * - ARG2 - size of the data at ARG1, zero meaning a single page
+	 *
+	 * The pages are copied by the kernel when the call is answered, so the
+	 * recipient may reuse the source buffer afterwards.
 	 */
 	IPC_M_PAGE_IN,
 
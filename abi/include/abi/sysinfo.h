@@ -47,6 +47,7 @@
 /** Maximum name sizes */
 #define TASK_NAME_BUFLEN  64
 #define EXC_NAME_BUFLEN   20
+#define LOCK_NAME_BUFLEN  32
 
 /** Item value type
  *
@@ -68,6 +69,11 @@ typedef struct {
 	uint16_t frequency_mhz;  /**< Frequency in MHz */
 	uint64_t idle_cycles;    /**< Number of idle cycles */
 	uint64_t busy_cycles;    /**< Number of busy cycles */
+	uint64_t steals;         /**< Threads stolen from other CPUs */
+	uint64_t handoffs;       /**< Threads run through direct handoff */
+	uint64_t tlb_shootdowns; /**< TLB shootdowns initiated */
+	uint64_t tlb_ipis;       /**< TLB shootdown IPIs sent */
+	uint64_t tlb_interrupted; /**< CPUs interrupted by TLB shootdowns */
 } stats_cpu_t;
 
 /** Physical memory statistics
@@ -133,6 +139,17 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Profile of a class of kernel locks with the same name
+ *
+ */
+typedef struct {
+	char name[LOCK_NAME_BUFLEN];  /**< Lock name */
+	uint64_t acquisitions;        /**< Number of acquisitions */
+	uint64_t contended;           /**< Acquisitions which found the lock held */
+	uint64_t spin_cycles;         /**< CPU cycles spent waiting for the lock */
+	uint64_t hold_cycles;         /**< CPU cycles the lock was held */
+} stats_lock_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
@@ -45,6 +45,15 @@ void ipi_broadcast_arch(int ipi)
 	*((volatile uint32_t *) MSIM_DORDER_ADDRESS) = 0x7fffffff;
 }
 
+void ipi_unicast_arch(unsigned int cpu, int ipi)
+{
+	/*
+	 * The kernel does not know the mapping between its CPU IDs
+	 * and the dorder bits, fall back to a broadcast.
+	 */
+	ipi_broadcast_arch(ipi);
+}
+
 #endif
 
 uint32_t dorder_cpuid(void)
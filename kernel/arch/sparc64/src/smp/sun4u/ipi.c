@@ -172,5 +172,29 @@ void ipi_broadcast_arch(int ipi)
 	}
 }
 
+/*
+ * Deliver IPI to a single processor.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param cpu Index of the target processor in the cpus array.
+ * @param ipi IPI number.
+ */
+void ipi_unicast_arch(unsigned int cpu, int ipi)
+{
+	void (*func)(void);
+
+	switch (ipi) {
+	case IPI_TLB_SHOOTDOWN:
+		func = tlb_shootdown_ipi_recv;
+		break;
+	default:
+		panic("Unknown IPI (%d).\n", ipi);
+		break;
+	}
+
+	cross_call(cpus[cpu].arch.mid, func);
+}
+
 /** @}
  */
@@ -72,6 +72,11 @@ typedef struct kobject_ops {
 /*
  * Everything in kobject_t except for the atomic reference count, the capability
  * list and its lock is imutable.
+ *
+ * Kernel objects are allocated from a type-safe slab cache, so the reference
+ * count of a freed kernel object remains zero until the memory is reused for
+ * another kernel object. The reference count must not be the first member,
+ * which the slab allocator overwrites in free objects.
  */
 typedef struct kobject {
 	kobject_type_t type;
@@ -114,6 +119,14 @@ typedef struct cap {
 	kobject_t *kobject;
 } cap_t;
 
+/** Geometry of the capability lookup table (see cap_info_t::table). */
+#define CAP_TABLE_LEAF_SIZE  256
+#define CAP_TABLE_LEAVES     128
+#define CAP_TABLE_SIZE       (CAP_TABLE_LEAF_SIZE * CAP_TABLE_LEAVES)
+
+/** Slot of the capability lookup table. */
+typedef kobject_t *_Atomic cap_slot_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
@@ -121,6 +134,16 @@ typedef struct cap_info {
 
 	hash_table_t caps;
 	ra_arena_t *handles;
+
+	/**
+	 * Kernel objects of the published capabilities indexed by handle.
+	 * A leaf is allocated together with the first capability whose handle
+	 * falls into it and lives as long as the task. Slots are only written
+	 * with the lock held, but they are read without it by kobject_get().
+	 * Capabilities with handles beyond the table are looked up in the
+	 * hash table.
+	 */
+	cap_slot_t *_Atomic table[CAP_TABLE_LEAVES];
 } cap_info_t;
 
 extern void caps_init(void);
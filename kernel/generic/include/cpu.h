@@ -36,7 +36,9 @@
 #define KERN_CPU_H_
 
 #include <mm/tlb.h>
+#include <mm/frame.h>
 #include <synch/spinlock.h>
+#include <synch/lockprof.h>
 #include <proc/scheduler.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
@@ -45,6 +47,11 @@
 
 #define CPU                  CURRENT->cpu
 
+/** Timing wheel geometry (see cpu_t::timeout_wheel). */
+#define TIMEOUT_WHEEL_BITS    6
+#define TIMEOUT_WHEEL_SLOTS   (1 << TIMEOUT_WHEEL_BITS)
+#define TIMEOUT_WHEEL_LEVELS  4
+
 /** CPU structure.
  *
  * There is one structure like this for every processor.
@@ -55,14 +62,91 @@ typedef struct cpu {
 	tlb_shootdown_msg_t tlb_messages[TLB_MESSAGE_QUEUE_LEN];
 	size_t tlb_messages_count;
 
+	/**
+	 * TLB invalidations which were not delivered to this CPU because
+	 * it was not running the affected address space at the time. They
+	 * are carried out by as_switch() once the matching ASID is installed.
+	 */
+	tlb_shootdown_msg_t tlb_deferred[TLB_MESSAGE_QUEUE_LEN];
+	size_t tlb_deferred_count;
+
+	/** Address space and ASID installed on this CPU. */
+	struct as *tlb_as;
+	asid_t tlb_asid;
+
+	/** This CPU must acknowledge the TLB shootdown in progress. */
+	bool tlb_target;
+
+	/**
+	 * TLB shootdown statistics (shootdowns initiated by this CPU, IPIs
+	 * it sent and CPUs it interrupted). Only updated by the owning CPU
+	 * while holding the TLB shootdown lock.
+	 */
+	uint64_t tlb_shootdowns;
+	uint64_t tlb_ipis;
+	uint64_t tlb_interrupted;
+
 	context_t saved_context;
 
 	atomic_t nrdy;
 	runq_t rq[RQ_COUNT];
 	volatile size_t needs_relink;
 
+	/**
+	 * Bitmap of non-empty run queues. Bit i is only modified
+	 * with rq[i].lock held and is set iff rq[i].n is non-zero.
+	 */
+	atomic_uint rq_occupied;
+
+	/**
+	 * Run queue selection statistics (number of find_best_thread()
+	 * picks and number of run queues locked during them). These are
+	 * only updated by the owning CPU with interrupts disabled.
+	 */
+	uint64_t rq_picks;
+	uint64_t rq_probes;
+
+	/**
+	 * Number of threads stolen from other CPUs. Only updated
+	 * by the owning CPU with interrupts disabled.
+	 */
+	uint64_t steals;
+
+	/**
+	 * Thread to be run next on this CPU bypassing the run queues (see
+	 * thread_ready_handoff()). Only accessed by the owning CPU with
+	 * interrupts disabled.
+	 */
+	struct thread *handoff;
+
+	/** Number of threads run through handoff. */
+	uint64_t handoffs;
+
+	/** Free frames cached for single frame allocations. */
+	frame_pcpu_t frame_pcpu[FRAME_PCPU_LISTS];
+
+	/** Protects frame_pcpu. Nests inside the zones lock. */
+	IRQ_SPINLOCK_DECLARE(frame_pcpu_lock);
+
+#ifdef CONFIG_LOCK_PROFILE
+	/**
+	 * Lock profiles of this CPU. Only updated by the owning CPU with
+	 * interrupts disabled.
+	 */
+	lock_prof_t lock_prof[LOCK_PROF_CLASSES];
+#endif
+
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+
+	/**
+	 * Hierarchical timing wheel of active timeouts. Slot s on level l
+	 * holds the timeouts which expire in the s-th block of
+	 * TIMEOUT_WHEEL_SLOTS^l ticks. Protected by timeoutlock.
+	 */
+	list_t timeout_wheel[TIMEOUT_WHEEL_LEVELS][TIMEOUT_WHEEL_SLOTS];
+
+	/** Next tick to be processed by the timing wheel. */
+	uint64_t timeout_ticks;
 
 	/**
 	 * When system clock loses a tick, it is
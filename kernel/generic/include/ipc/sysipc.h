@@ -39,16 +39,21 @@
 #include <ipc/irq.h>
 #include <typedefs.h>
 
-extern errno_t ipc_req_internal(cap_phone_handle_t, ipc_data_t *, sysarg_t);
+extern errno_t ipc_req_internal(cap_phone_handle_t, ipc_data_t *, sysarg_t,
+    void **);
 
 extern sys_errno_t sys_ipc_call_async_fast(cap_phone_handle_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, sysarg_t);
 extern sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t, ipc_data_t *,
     sysarg_t);
+extern sys_errno_t sys_ipc_call_async_batch(ipc_batch_call_t *, size_t,
+    size_t *);
 extern sys_errno_t sys_ipc_answer_fast(cap_call_handle_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t);
 extern sys_errno_t sys_ipc_answer_slow(cap_call_handle_t, ipc_data_t *);
 extern sys_errno_t sys_ipc_wait_for_call(ipc_data_t *, uint32_t, unsigned int);
+extern sys_errno_t sys_ipc_wait_batch(ipc_data_t *, size_t, uint32_t,
+    unsigned int, size_t *);
 extern sys_errno_t sys_ipc_poke(void);
 extern sys_errno_t sys_ipc_forward_fast(cap_call_handle_t, cap_phone_handle_t,
     sysarg_t, sysarg_t, sysarg_t, unsigned int);
@@ -47,6 +47,25 @@
 /** Maximum number of zones in the system. */
 #define ZONES_MAX  32
 
+/** Width of a block of frames in the zone free frame index. */
+#define ZONE_BLOCK_WIDTH   6
+#define ZONE_BLOCK_FRAMES  (1 << ZONE_BLOCK_WIDTH)
+
+/** Number of blocks in a zone of given size. */
+#define ZONE_BLOCKS(count) \
+	(((count) + ZONE_BLOCK_FRAMES - 1) >> ZONE_BLOCK_WIDTH)
+
+/** Maximum number of free frames held in a per-CPU frame list. */
+#define FRAME_PCPU_MAX  64
+
+/** Number of frames moved into an empty per-CPU frame list at once. */
+#define FRAME_PCPU_BATCH  16
+
+/** Per-CPU frame lists, one for low memory and one for high memory. */
+#define FRAME_PCPU_LOWMEM   0
+#define FRAME_PCPU_HIGHMEM  1
+#define FRAME_PCPU_LISTS    2
+
 typedef uint8_t frame_flags_t;
 
 #define FRAME_NONE        0x00
@@ -113,10 +132,31 @@ typedef struct {
 	/** Frame bitmap */
 	bitmap_t bitmap;
 
+	/**
+	 * Number of free frames in each block of ZONE_BLOCK_FRAMES frames
+	 * (located after the bitmap in the configuration space).
+	 */
+	uint8_t *block_free;
+
+	/** Block to start the next search at */
+	size_t block_hint;
+
 	/** Array of frame_t structures in this zone */
 	frame_t *frames;
 } zone_t;
 
+/** List of free single frames owned by a CPU.
+ *
+ * Frames in the list are marked as allocated in their zones and
+ * have the reference count of one. The list is protected by the
+ * frame_pcpu_lock of its CPU, which lets other CPUs drain it when
+ * memory runs out.
+ */
+typedef struct {
+	size_t count;
+	pfn_t pfn[FRAME_PCPU_MAX];
+} frame_pcpu_t;
+
 /*
  * The zoneinfo.lock must be locked when accessing zoneinfo structure.
  * Some of the attributes in zone_t structures are 'read-only'
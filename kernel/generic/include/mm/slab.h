@@ -40,9 +40,18 @@
 #include <atomic.h>
 #include <mm/frame.h>
 
-/** Initial Magazine size (TODO: dynamically growing magazines) */
+/** Initial magazine size */
 #define SLAB_MAG_SIZE  4
 
+/** Maximum magazine size, must be SLAB_MAG_SIZE times a power of two */
+#define SLAB_MAG_SIZE_MAX  64
+
+/** Number of contended depot lock acquisitions which double magazine size */
+#define SLAB_MAG_GROW_CONTENTION  16
+
+/** Granularity of slab coloring (typical cache line size) */
+#define SLAB_COLOR_ALIGN  64
+
 /** If object size is less, store control structure inside SLAB */
 #define SLAB_INSIDE_SIZE  (PAGE_SIZE >> 3)
 
@@ -63,6 +72,13 @@
 #define SLAB_CACHE_SLINSIDE     0x02
 /** We add magazine cache later, if we have this flag */
 #define SLAB_CACHE_MAGDEFERRED  (0x04 | SLAB_CACHE_NOMAGAZINE)
+/**
+ * Never return slabs to the frame allocator, so that memory of freed
+ * objects stays reserved for objects of the cache. Apart from the first
+ * word, which is used to link the free objects, the memory is not
+ * modified until the object is allocated again.
+ */
+#define SLAB_CACHE_TYPESAFE     0x08
 
 typedef struct {
 	link_t link;
@@ -97,6 +113,11 @@ typedef struct {
 	size_t frames;   /**< Number of frames to be allocated */
 	size_t objects;  /**< Number of objects that fit in */
 
+	/* Coloring */
+	size_t color_step;  /**< Offset between colors of consecutive slabs */
+	size_t color_max;   /**< Maximum offset of the first object in a slab */
+	size_t color_next;  /**< Color of the next slab, protected by slablock */
+
 	/* Statistics */
 	atomic_t allocated_slabs;
 	atomic_t allocated_objs;
@@ -108,10 +129,20 @@ typedef struct {
 	list_t full_slabs;     /**< List of full slabs */
 	list_t partial_slabs;  /**< List of partial slabs */
 	IRQ_SPINLOCK_DECLARE(slablock);
-	/* Magazines */
-	list_t magazines;  /**< List o full magazines */
+	/* Magazine depot */
+	list_t magazines;        /**< List of full magazines */
+	list_t empty_magazines;  /**< List of empty magazines */
 	IRQ_SPINLOCK_DECLARE(maglock);
 
+	/** Size of newly allocated magazines, protected by maglock */
+	size_t mag_size;
+
+	/** Depot lock statistics, protected by maglock */
+	uint64_t depot_acquires;
+	uint64_t depot_contended;
+	/** Contended acquisitions since the last magazine size change */
+	size_t depot_grow_count;
+
 	/** CPU cache */
 	slab_mag_cache_t *mag_cache;
 } slab_cache_t;
@@ -38,6 +38,8 @@
 #include <arch/mm/asid.h>
 #include <typedefs.h>
 
+struct as;
+
 /**
  * Number of TLB shootdown messages that can be queued in processor tlb_messages
  * queue.
@@ -67,14 +69,16 @@ typedef struct {
 extern void tlb_init(void);
 
 #ifdef CONFIG_SMP
-extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, asid_t, uintptr_t,
-    size_t);
+extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, struct as *, asid_t,
+    uintptr_t, size_t);
 extern void tlb_shootdown_finalize(ipl_t);
 extern void tlb_shootdown_ipi_recv(void);
+extern void tlb_shootdown_as_install(struct as *, asid_t);
 #else
-#define tlb_shootdown_start(w, x, y, z)	interrupts_disable()
+#define tlb_shootdown_start(v, w, x, y, z)	interrupts_disable()
 #define tlb_shootdown_finalize(i)	(interrupts_restore(i));
 #define tlb_shootdown_ipi_recv()
+#define tlb_shootdown_as_install(as, asid)
 #endif /* CONFIG_SMP */
 
 /* Export TLB interface that each architecture must implement. */
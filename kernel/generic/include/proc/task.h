@@ -150,6 +150,7 @@ extern errno_t task_kill(task_id_t);
 extern void task_kill_self(bool) __attribute__((noreturn));
 extern void task_get_accounting(task_t *, uint64_t *, uint64_t *);
 extern void task_print_list(bool);
+extern void task_print_mutexes(void);
 
 extern void perm_set(task_t *, perm_t);
 extern perm_t perm_get(task_t *);
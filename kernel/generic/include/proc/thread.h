@@ -219,6 +219,8 @@ extern thread_t *thread_create(void (*)(void *), void *, task_t *,
 extern void thread_wire(thread_t *, cpu_t *);
 extern void thread_attach(thread_t *, task_t *);
 extern void thread_ready(thread_t *);
+extern void thread_ready_handoff(thread_t *);
+extern void thread_handoff(void);
 extern void thread_exit(void) __attribute__((noreturn));
 extern void thread_interrupt(thread_t *);
 extern bool thread_interrupted(thread_t *);
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_LOCKPROF_H_
+#define KERN_LOCKPROF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum number of distinct lock names that can be profiled */
+#define LOCK_PROF_CLASSES  256
+
+/** Profile of a class of locks
+ *
+ * All locks with the same name belong to the same class. Each CPU keeps
+ * its own profile of every class.
+ *
+ */
+typedef struct {
+	uint64_t acquisitions;  /**< Number of acquisitions */
+	uint64_t contended;     /**< Acquisitions which found the lock held */
+	uint64_t spin_cycles;   /**< Cycles spent waiting for the lock */
+	uint64_t hold_cycles;   /**< Cycles the lock was held */
+} lock_prof_t;
+
+#ifdef CONFIG_LOCK_PROFILE
+
+extern void lock_prof_acquire(size_t *, const char *, bool, uint64_t);
+extern void lock_prof_release(size_t, uint64_t);
+extern bool lock_prof_get(size_t, const char **, lock_prof_t *);
+
+#endif /* CONFIG_LOCK_PROFILE */
+
+#endif
+
+/** @}
+ */
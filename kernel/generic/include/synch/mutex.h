@@ -35,6 +35,7 @@
 #ifndef KERN_MUTEX_H_
 #define KERN_MUTEX_H_
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <synch/semaphore.h>
@@ -51,8 +52,22 @@ struct thread;
 typedef struct {
 	mutex_type_t type;
 	semaphore_t sem;
-	struct thread *owner;
+	struct thread *_Atomic owner;
 	unsigned nesting;
+
+	/**
+	 * Contention statistics (number of acquisitions, acquisitions
+	 * completed by spinning while the owner was running and acquisitions
+	 * which had to go to sleep). Only updated by the owner.
+	 */
+	uint64_t acquisitions;
+	uint64_t spins;
+	uint64_t sleeps;
+
+#ifdef CONFIG_LOCK_PROFILE
+	/** Cycle count at the moment the mutex was acquired, zero if unknown */
+	uint64_t prof_acquired;
+#endif
 } mutex_t;
 
 #define mutex_lock(mtx) \
@@ -68,6 +83,7 @@ extern void mutex_initialize(mutex_t *, mutex_type_t);
 extern bool mutex_locked(mutex_t *);
 extern errno_t _mutex_lock_timeout(mutex_t *, uint32_t, unsigned int);
 extern void mutex_unlock(mutex_t *);
+extern void mutex_print_stats(const char *, mutex_t *);
 
 #endif
 
@@ -38,17 +38,34 @@
 #include <assert.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <preemption.h>
 #include <arch/asm.h>
 
 #ifdef CONFIG_SMP
 
+/*
+ * Spinlocks keep their name and are acquired out of line when they are
+ * either checked for deadlocks or profiled.
+ */
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_LOCK_PROFILE)
+#define SPINLOCK_INSTRUMENTED
+#endif
+
 typedef struct spinlock {
 	atomic_flag flag;
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_INSTRUMENTED
 	const char *name;
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_INSTRUMENTED */
+
+#ifdef CONFIG_LOCK_PROFILE
+	/** Profiling class of the lock plus one, zero if not looked up yet */
+	size_t prof_class;
+
+	/** Cycle count at the moment the lock was acquired */
+	uint64_t prof_acquired;
+#endif /* CONFIG_LOCK_PROFILE */
 } spinlock_t;
 
 /*
@@ -63,7 +80,7 @@ typedef struct spinlock {
  * for statically allocated spinlocks. They declare (either as global
  * or static) symbol and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_INSTRUMENTED
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
@@ -83,7 +100,7 @@ typedef struct spinlock {
 #define spinlock_lock(lock)    spinlock_lock_debug((lock))
 #define spinlock_unlock(lock)  spinlock_unlock_debug((lock))
 
-#else /* CONFIG_DEBUG_SPINLOCK */
+#else /* SPINLOCK_INSTRUMENTED */
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
@@ -120,7 +137,7 @@ _NO_TRACE static inline void spinlock_unlock(spinlock_t *lock)
 	preemption_enable();
 }
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_INSTRUMENTED */
 
 #define SPINLOCK_INITIALIZE(lock_name) \
 	SPINLOCK_INITIALIZE_NAME(lock_name, #lock_name)
@@ -208,7 +225,7 @@ typedef struct {
  * for statically allocated interrupts-disabled spinlocks. They declare (either
  * as global or static symbol) and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_INSTRUMENTED
 
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
@@ -230,7 +247,7 @@ typedef struct {
 		.ipl = 0 \
 	}
 
-#else /* CONFIG_DEBUG_SPINLOCK */
+#else /* SPINLOCK_INSTRUMENTED */
 
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
@@ -250,7 +267,7 @@ typedef struct {
 		.ipl = 0 \
 	}
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_INSTRUMENTED */
 
 #else /* CONFIG_SMP */
 
@@ -42,7 +42,12 @@
 
 typedef enum {
 	WAKEUP_FIRST = 0,
-	WAKEUP_ALL
+	WAKEUP_ALL,
+	/**
+	 * Like WAKEUP_FIRST, but the thread is handed over to the current
+	 * CPU to run next (see thread_ready_handoff()).
+	 */
+	WAKEUP_HANDOFF
 } wakeup_mode_t;
 
 /** Wait queue structure.
@@ -73,6 +73,15 @@
  * kobject_get() or kobject_add_ref(). When the kernel object is removed from
  * the container, the reference count should go down via a call to
  * kobject_put().
+ *
+ * Besides the hash table, each task keeps a two-level table which maps the
+ * handles of its published capabilities directly to kernel objects. The table
+ * lets kobject_get() find a kernel object without taking the task's capability
+ * lock. The reference obtained this way is validated by checking that the
+ * table still contains the kernel object after the reference count has been
+ * incremented. Since kernel objects come from a type-safe slab cache, the
+ * reference count of a kernel object freed in the meantime is zero and the
+ * increment fails instead of resurrecting the object.
  */
 
 #include <cap/cap.h>
@@ -92,6 +101,7 @@
 #define CAPS_LAST	(CAPS_SIZE - 1)
 
 static slab_cache_t *cap_cache;
+static slab_cache_t *cap_leaf_cache;
 static slab_cache_t *kobject_cache;
 
 static size_t caps_hash(const ht_link_t *item)
@@ -123,8 +133,10 @@ void caps_init(void)
 {
 	cap_cache = slab_cache_create("cap_t", sizeof(cap_t), 0, NULL,
 	    NULL, 0);
+	cap_leaf_cache = slab_cache_create("cap_slot_t[]",
+	    sizeof(cap_slot_t) * CAP_TABLE_LEAF_SIZE, 0, NULL, NULL, 0);
 	kobject_cache = slab_cache_create("kobject_t", sizeof(kobject_t), 0,
-	    NULL, NULL, 0);
+	    NULL, NULL, SLAB_CACHE_TYPESAFE);
 }
 
 /** Allocate the capability info structure
@@ -143,6 +155,8 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_span;
 	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
 		goto error_span;
+	for (size_t i = 0; i < CAP_TABLE_LEAVES; i++)
+		atomic_init(&task->cap_info->table[i], NULL);
 	return EOK;
 
 error_span:
@@ -170,6 +184,12 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
+	for (size_t i = 0; i < CAP_TABLE_LEAVES; i++) {
+		cap_slot_t *leaf = atomic_load_explicit(&task->cap_info->table[i],
+		    memory_order_relaxed);
+		if (leaf)
+			slab_free(cap_leaf_cache, leaf);
+	}
 	hash_table_destroy(&task->cap_info->caps);
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
@@ -218,6 +238,54 @@ static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 	link_initialize(&cap->type_link);
 }
 
+/** Get lookup table slot of a capability handle
+ *
+ * @param info    Capability info structure of the task.
+ * @param handle  Capability handle.
+ *
+ * @return Address of the slot.
+ * @return NULL if the handle is not covered by the table.
+ */
+static cap_slot_t *cap_slot(cap_info_t *info, cap_handle_t handle)
+{
+	intptr_t raw = CAP_HANDLE_RAW(handle);
+
+	if ((raw < 0) || (raw >= CAP_TABLE_SIZE))
+		return NULL;
+	cap_slot_t *leaf = atomic_load_explicit(
+	    &info->table[raw / CAP_TABLE_LEAF_SIZE], memory_order_acquire);
+	if (!leaf)
+		return NULL;
+	return &leaf[raw % CAP_TABLE_LEAF_SIZE];
+}
+
+/** Make sure the lookup table has a slot for a capability handle
+ *
+ * @param info    Capability info structure of the task.
+ * @param handle  Capability handle.
+ *
+ * @return True if the handle has a slot or is not covered by the table.
+ * @return False if there is not enough memory for the slot.
+ */
+static bool cap_slot_prepare(cap_info_t *info, uintptr_t handle)
+{
+	assert(mutex_locked(&info->lock));
+
+	if (handle >= CAP_TABLE_SIZE)
+		return true;
+	size_t i = handle / CAP_TABLE_LEAF_SIZE;
+	if (atomic_load_explicit(&info->table[i], memory_order_relaxed))
+		return true;
+
+	cap_slot_t *leaf = slab_alloc(cap_leaf_cache, FRAME_ATOMIC);
+	if (!leaf)
+		return false;
+	for (size_t j = 0; j < CAP_TABLE_LEAF_SIZE; j++)
+		atomic_init(&leaf[j], NULL);
+	atomic_store_explicit(&info->table[i], leaf, memory_order_release);
+	return true;
+}
+
 /** Get capability using capability handle
  *
  * @param task    Task whose capability to get.
@@ -265,6 +333,12 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
+	if (!cap_slot_prepare(task->cap_info, hbase)) {
+		ra_free(task->cap_info->handles, hbase, 1);
+		slab_free(cap_cache, cap);
+		mutex_unlock(&task->cap_info->lock);
+		return ENOMEM;
+	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
 	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
 
@@ -297,12 +371,18 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	cap->kobject = kobj;
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
+	cap_slot_t *slot = cap_slot(task->cap_info, handle);
+	if (slot)
+		atomic_store_explicit(slot, kobj, memory_order_release);
 	mutex_unlock(&task->cap_info->lock);
 	mutex_unlock(&kobj->caps_list_lock);
 }
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
+	cap_slot_t *slot = cap_slot(cap->task->cap_info, cap->handle);
+	if (slot)
+		atomic_store_explicit(slot, NULL, memory_order_relaxed);
 	cap->kobject = NULL;
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
@@ -426,6 +506,65 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw,
 	kobj->ops = ops;
 }
 
+/** Get new reference to kernel object unless it is being destroyed
+ *
+ * @param kobj  Kernel object, possibly freed already.
+ *
+ * @return True if a new reference was created.
+ * @return False if the reference count has already dropped to zero.
+ */
+static bool kobject_tryget(kobject_t *kobj)
+{
+	size_t refcnt = atomic_load_explicit(&kobj->refcnt,
+	    memory_order_relaxed);
+
+	do {
+		if (refcnt == 0)
+			return false;
+	} while (!atomic_compare_exchange_weak(&kobj->refcnt, &refcnt,
+	    refcnt + 1));
+
+	return true;
+}
+
+/** Get new reference to kernel object from capability lookup table slot
+ *
+ * @param slot  Lookup table slot of the capability.
+ * @param type  Kernel object type of the object associated with the
+ *              capability.
+ *
+ * @return Kernel object with incremented reference count on success.
+ * @return NULL if there is no matching capability or kernel object.
+ */
+static kobject_t *kobject_get_lockless(cap_slot_t *slot, kobject_type_t type)
+{
+	while (true) {
+		kobject_t *kobj = atomic_load_explicit(slot,
+		    memory_order_acquire);
+		if (!kobj)
+			return NULL;
+
+		if (!kobject_tryget(kobj))
+			continue;
+
+		/*
+		 * The kernel object may have been unpublished and its memory
+		 * reused before we got the reference.
+		 */
+		if (atomic_load(slot) != kobj) {
+			kobject_put(kobj);
+			continue;
+		}
+
+		if (kobj->type != type) {
+			kobject_put(kobj);
+			return NULL;
+		}
+
+		return kobj;
+	}
+}
+
 /** Get new reference to kernel object from capability
  *
  * @param task    Task from which to get the reference.
@@ -441,6 +580,10 @@ kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
 	kobject_t *kobj = NULL;
 
+	cap_slot_t *slot = cap_slot(task->cap_info, handle);
+	if (slot)
+		return kobject_get_lockless(slot, type);
+
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
 	if (cap) {
@@ -470,6 +470,14 @@ static cmd_info_t tasks_info = {
 	.argv = &tasks_argv
 };
 
+static int cmd_mutexes(cmd_arg_t *argv);
+static cmd_info_t mutexes_info = {
+	.name = "mutexes",
+	.description = "Show contention statistics of task mutexes.",
+	.func = cmd_mutexes,
+	.argc = 0
+};
+
 #ifdef CONFIG_UDEBUG
 
 /* Data and methods for 'btrace' command */
@@ -596,6 +604,7 @@ static cmd_info_t *basic_commands[] = {
 	&help_info,
 	&ipc_info,
 	&kill_info,
+	&mutexes_info,
 	&physmem_info,
 	&reboot_info,
 	&sched_info,
@@ -1251,6 +1260,18 @@ int cmd_tasks(cmd_arg_t *argv)
 	return 1;
 }
 
+/** Command for listing mutex contention statistics
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_mutexes(cmd_arg_t *argv)
+{
+	task_print_mutexes();
+	return 1;
+}
+
 #ifdef CONFIG_UDEBUG
 
 /** Command for printing thread stack trace
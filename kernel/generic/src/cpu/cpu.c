@@ -83,6 +83,8 @@ void cpu_init(void)
 			cpus[i].id = i;
 
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
+			irq_spinlock_initialize(&cpus[i].frame_pcpu_lock,
+			    "cpus[].frame_pcpu_lock");
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
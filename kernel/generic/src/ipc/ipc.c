@@ -325,7 +325,8 @@ void _ipc_answer_free_call(call_t *call, bool selflocked)
 	if (do_lock)
 		irq_spinlock_unlock(&callerbox->lock, true);
 
-	waitq_wakeup(&callerbox->wq, WAKEUP_FIRST);
+	/* The caller waits for the answer, let it run right away */
+	waitq_wakeup(&callerbox->wq, WAKEUP_HANDOFF);
 }
 
 /** Answer a message which is in a callee queue.
@@ -415,7 +416,8 @@ static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
 	list_append(&call->ab_link, &box->calls);
 	irq_spinlock_unlock(&box->lock, true);
 
-	waitq_wakeup(&box->wq, WAKEUP_FIRST);
+	/* Let a thread waiting for calls on the answerbox run right away */
+	waitq_wakeup(&box->wq, WAKEUP_HANDOFF);
 }
 
 /** Send an asynchronous request using a phone to an answerbox.
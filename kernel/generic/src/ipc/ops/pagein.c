@@ -39,9 +39,12 @@
 #include <genarch/mm/page_pt.h>
 #include <genarch/mm/page_ht.h>
 #include <mm/frame.h>
+#include <mm/km.h>
 #include <proc/task.h>
+#include <syscall/copy.h>
 #include <abi/errno.h>
 #include <arch.h>
+#include <stdlib.h>
 
 static errno_t pagein_request_preprocess(call_t *call, phone_t *phone)
 {
@@ -53,8 +56,20 @@ static errno_t pagein_request_preprocess(call_t *call, phone_t *phone)
 	 */
 	if (TASK->taskid <= phone->callee->task->taskid)
 		return ENOTSUP;
-	else
-		return EOK;
+
+	/*
+	 * Requests made by the kernel get a buffer for the frames of the
+	 * paged-in cluster.
+	 */
+	if (call->priv) {
+		size_t pages = max(IPC_GET_ARG2(call->data) >> PAGE_WIDTH, 1);
+
+		call->buffer = malloc(pages * sizeof(uintptr_t));
+		if (!call->buffer)
+			return ENOMEM;
+	}
+
+	return EOK;
 }
 
 static errno_t pagein_answer_preprocess(call_t *answer, ipc_data_t *olddata)
@@ -67,29 +82,45 @@ static errno_t pagein_answer_preprocess(call_t *answer, ipc_data_t *olddata)
 	if (!answer->priv)
 		return EOK;
 
-	if (!IPC_GET_RETVAL(answer->data)) {
+	if (IPC_GET_RETVAL(answer->data) != EOK)
+		return EOK;
 
-		pte_t pte;
+	/*
+	 * Copy the pages into fresh frames so that the pager can reuse its
+	 * buffer as soon as the call is answered.
+	 */
+	uintptr_t src = IPC_GET_ARG1(answer->data);
+	size_t pages = IPC_GET_ARG2(answer->data) >> PAGE_WIDTH;
+	size_t max_pages = max(IPC_GET_ARG2(*olddata) >> PAGE_WIDTH, 1);
+	uintptr_t *frames = (uintptr_t *) answer->buffer;
+
+	if (pages == 0)
+		pages = 1;
+	if (pages > max_pages)
+		pages = max_pages;
+
+	size_t i;
+	for (i = 0; i < pages; i++) {
 		uintptr_t frame;
+		uintptr_t page = km_temporary_page_get(&frame, 0);
 
-		page_table_lock(AS, true);
-		bool found = page_mapping_find(AS, IPC_GET_ARG1(answer->data),
-		    false, &pte);
-		if (found & PTE_PRESENT(&pte)) {
-			frame = PTE_GET_FRAME(&pte);
-			pfn_t pfn = ADDR2PFN(frame);
-			if (find_zone(pfn, 1, 0) != (size_t) -1) {
-				/*
-				 * The frame is in physical memory managed by
-				 * the frame allocator.
-				 */
-				frame_reference_add(ADDR2PFN(frame));
-			}
-			IPC_SET_ARG1(answer->data, frame);
-		} else {
-			IPC_SET_RETVAL(answer->data, ENOENT);
+		errno_t rc = copy_from_uspace((void *) page,
+		    (void *) (src + P2SZ(i)), PAGE_SIZE);
+		km_temporary_page_put(page);
+
+		if (rc != EOK) {
+			frame_free(frame, 1);
+			break;
 		}
-		page_table_unlock(AS, true);
+
+		frames[i] = frame;
+	}
+
+	if (i == 0) {
+		IPC_SET_RETVAL(answer->data, ENOENT);
+	} else {
+		IPC_SET_ARG1(answer->data, frames[0]);
+		IPC_SET_ARG2(answer->data, P2SZ(i));
 	}
 
 	return EOK;
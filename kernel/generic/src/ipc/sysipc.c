@@ -263,6 +263,9 @@ static int process_request(answerbox_t *box, call_t *call)
  * @param handle       Phone capability handle for the call.
  * @param data[inout]  Structure with request/reply data.
  * @param priv         Value to be stored in call->priv.
+ * @param buffer[out]  If not NULL, the kernel buffer of the answered call is
+ *                     handed over here. The caller is responsible for freeing
+ *                     it. Set to NULL if there is no such buffer.
  *
  * @return EOK on success.
  * @return ENOENT if there is no such phone handle.
@@ -270,8 +273,12 @@ static int process_request(answerbox_t *box, call_t *call)
  *
  */
 errno_t
-ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv)
+ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv,
+    void **buffer)
 {
+	if (buffer)
+		*buffer = NULL;
+
 	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
 	if (!kobj->phone)
 		return ENOENT;
@@ -328,6 +335,10 @@ ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv)
 		IPC_SET_RETVAL(call->data, rc);
 
 	memcpy(data->args, call->data.args, sizeof(data->args));
+	if (buffer) {
+		*buffer = call->buffer;
+		call->buffer = NULL;
+	}
 	kobject_put(call->kobject);
 	kobject_put(kobj);
 
@@ -409,17 +420,17 @@ sys_errno_t sys_ipc_call_async_fast(cap_phone_handle_t handle, sysarg_t imethod,
 	return EOK;
 }
 
-/** Make an asynchronous IPC call allowing to transmit the entire payload.
+/** Make an asynchronous IPC call with the entire payload already in kernel.
  *
  * @param handle  Phone capability for the call.
- * @param data    Userspace address of call data with the request.
+ * @param args    Interface, method and payload arguments of the call.
  * @param label   User-defined label.
  *
  * @return See sys_ipc_call_async_fast().
  *
  */
-sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, ipc_data_t *data,
-    sysarg_t label)
+static errno_t ipc_call_async_internal(cap_phone_handle_t handle,
+    const sysarg_t *args, sysarg_t label)
 {
 	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
 	if (!kobj)
@@ -436,13 +447,7 @@ sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, ipc_data_t *data,
 		return ENOMEM;
 	}
 
-	errno_t rc = copy_from_uspace(&call->data.args, &data->args,
-	    sizeof(call->data.args));
-	if (rc != EOK) {
-		kobject_put(call->kobject);
-		kobject_put(kobj);
-		return (sys_errno_t) rc;
-	}
+	memcpy(&call->data.args, args, sizeof(call->data.args));
 
 	/* Set the user-defined label */
 	call->data.answer_label = label;
@@ -458,6 +463,80 @@ sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, ipc_data_t *data,
 	return EOK;
 }
 
+/** Make an asynchronous IPC call allowing to transmit the entire payload.
+ *
+ * @param handle  Phone capability for the call.
+ * @param data    Userspace address of call data with the request.
+ * @param label   User-defined label.
+ *
+ * @return See sys_ipc_call_async_fast().
+ *
+ */
+sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, ipc_data_t *data,
+    sysarg_t label)
+{
+	sysarg_t args[IPC_CALL_LEN];
+
+	errno_t rc = copy_from_uspace(args, &data->args, sizeof(args));
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	return (sys_errno_t) ipc_call_async_internal(handle, args, label);
+}
+
+/** Make several asynchronous IPC calls at once.
+ *
+ * The calls are made in the order in which they appear in the array.
+ * Processing stops at the first call which cannot be made. The number of
+ * calls is stored before each call is made, so that userspace never misses
+ * the answer to a call it believes was not made.
+ *
+ * @param ucalls     Userspace address of an array of calls.
+ * @param count      Number of calls in the array (at most IPC_BATCH_MAX).
+ * @param usubmitted Userspace address where to store the number of calls
+ *                   which were made.
+ *
+ * @return EOK if all calls were made.
+ * @return EINVAL if count is out of range.
+ * @return Otherwise the error code of the first call which failed. See
+ *         sys_ipc_call_async_fast().
+ *
+ */
+sys_errno_t sys_ipc_call_async_batch(ipc_batch_call_t *ucalls, size_t count,
+    size_t *usubmitted)
+{
+	if (count > IPC_BATCH_MAX)
+		return EINVAL;
+
+	errno_t rc = EOK;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		ipc_batch_call_t bcall;
+
+		rc = copy_from_uspace(&bcall, &ucalls[i], sizeof(bcall));
+		if (rc != EOK)
+			break;
+
+		size_t next = i + 1;
+		rc = copy_to_uspace(usubmitted, &next, sizeof(next));
+		if (rc != EOK)
+			break;
+
+		rc = ipc_call_async_internal(bcall.phone, bcall.args, bcall.label);
+		if (rc != EOK) {
+			/* Take back the call announced above */
+			(void) copy_to_uspace(usubmitted, &i, sizeof(i));
+			break;
+		}
+	}
+
+	if ((i == 0) && (rc == EOK))
+		rc = copy_to_uspace(usubmitted, &i, sizeof(i));
+
+	return (sys_errno_t) rc;
+}
+
 /** Forward a received call to another destination
  *
  * Common code for both the fast and the slow version.
@@ -765,7 +844,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
  *
  * @return An error code on error.
  */
-sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+static errno_t ipc_wait_internal(ipc_data_t *calldata, uint32_t usec,
     unsigned int flags)
 {
 	call_t *call = NULL;
@@ -865,6 +944,80 @@ error:
 	return rc;
 }
 
+/** Wait for an incoming IPC call or an answer.
+ *
+ * @param calldata Pointer to buffer where the call/answer data is stored.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ *
+ * @return An error code on error.
+ */
+sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+    unsigned int flags)
+{
+	return (sys_errno_t) ipc_wait_internal(calldata, usec, flags);
+}
+
+/** Wait for incoming IPC calls or answers and receive several at once.
+ *
+ * The first call or answer is waited for as in sys_ipc_wait_for_call().
+ * After it arrives, the calls and answers which are already queued are
+ * received without blocking until the buffer fills up. The number of
+ * buffers is stored before each call is dequeued, so that a received call
+ * is never lost because the number cannot be stored.
+ *
+ * @param calldata  Pointer to an array of buffers where the call/answer
+ *                  data is stored.
+ * @param count     Number of buffers in the array (at most IPC_BATCH_MAX).
+ * @param usec      Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags     Select mode of sleep operation. See waitq_sleep_timeout()
+ *                  for explanation.
+ * @param ureceived Userspace address where to store the number of buffers
+ *                  which were filled.
+ *
+ * @return EOK if at least one call or answer was received.
+ * @return EINVAL if count is out of range.
+ * @return An error code on error. See sys_ipc_wait_for_call().
+ */
+sys_errno_t sys_ipc_wait_batch(ipc_data_t *calldata, size_t count,
+    uint32_t usec, unsigned int flags, size_t *ureceived)
+{
+	if ((count == 0) || (count > IPC_BATCH_MAX))
+		return EINVAL;
+
+	size_t received = 0;
+	errno_t rc = EOK;
+
+	while (received < count) {
+		size_t next = received + 1;
+		rc = copy_to_uspace(ureceived, &next, sizeof(next));
+		if (rc != EOK)
+			break;
+
+		if (received == 0) {
+			rc = ipc_wait_internal(&calldata[0], usec, flags);
+		} else {
+			rc = ipc_wait_internal(&calldata[received],
+			    SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+		}
+
+		if (rc != EOK)
+			break;
+
+		received = next;
+	}
+
+	if (received == 0)
+		return (sys_errno_t) rc;
+
+	/* Take back the buffer announced for a call which was not there */
+	if (received < count)
+		(void) copy_to_uspace(ureceived, &received, sizeof(received));
+
+	return EOK;
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
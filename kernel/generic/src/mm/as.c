@@ -955,7 +955,7 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 */
 
 		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
-		    as->asid, area->base + P2SZ(pages),
+		    as, as->asid, area->base + P2SZ(pages),
 		    area->pages - pages);
 
 		/*
@@ -1104,8 +1104,8 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as, as->asid,
+	    area->base, area->pages);
 
 	/*
 	 * Visit only the pages mapped by used_space.
@@ -1404,8 +1404,8 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as, as->asid,
+	    area->base, area->pages);
 
 	/*
 	 * Remove used pages from page tables and remember their frame
@@ -1685,6 +1685,12 @@ retry:
 	 */
 	as_install_arch(new_as);
 
+	/*
+	 * Let TLB shootdowns know about the new address space and
+	 * catch up on invalidations deferred while it was not installed.
+	 */
+	tlb_shootdown_as_install(new_as, new_as->asid);
+
 	spinlock_unlock(&asidlock);
 
 	AS = new_as;
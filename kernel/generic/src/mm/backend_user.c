@@ -39,6 +39,8 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_ht.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -48,8 +50,13 @@
 #include <assert.h>
 #include <errno.h>
 #include <log.h>
+#include <macros.h>
+#include <stdlib.h>
 #include <str.h>
 
+/** Maximum number of pages paged in on a single page fault. */
+#define USER_CLUSTER_PAGES	8
+
 static bool user_create(as_area_t *);
 static void user_destroy(as_area_t *);
 
@@ -95,6 +102,19 @@ bool user_is_shareable(as_area_t *area)
 	return false;
 }
 
+static bool user_page_mapped(uintptr_t page)
+{
+	pte_t pte;
+
+	return page_mapping_find(AS, page, false, &pte) && PTE_PRESENT(&pte);
+}
+
+static void user_frames_free(uintptr_t *frames, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame_free(frames[i], 1);
+}
+
 /** Service a page fault in the user-paged address space area.
  *
  * The address space area and page tables must be already locked.
@@ -117,38 +137,74 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 
 	as_area_pager_info_t *pager_info = &area->backend_data.pager_info;
 
+	/*
+	 * Page in the whole run of unmapped pages around the faulting page
+	 * within its cluster so that sequential accesses fault only once per
+	 * cluster.
+	 */
+	uintptr_t cbase = area->base + ALIGN_DOWN(upage - area->base,
+	    P2SZ(USER_CLUSTER_PAGES));
+	uintptr_t cend = min(cbase + P2SZ(USER_CLUSTER_PAGES),
+	    area->base + P2SZ(area->pages));
+
+	uintptr_t start = upage;
+	while (start > cbase && !user_page_mapped(start - PAGE_SIZE))
+		start -= PAGE_SIZE;
+
+	uintptr_t end = upage + PAGE_SIZE;
+	while (end < cend && !user_page_mapped(end))
+		end += PAGE_SIZE;
+
 	ipc_data_t data = { };
 	IPC_SET_IMETHOD(data, IPC_M_PAGE_IN);
-	IPC_SET_ARG1(data, upage - area->base);
-	IPC_SET_ARG2(data, PAGE_SIZE);
+	IPC_SET_ARG1(data, start - area->base);
+	IPC_SET_ARG2(data, end - start);
 	IPC_SET_ARG3(data, pager_info->id1);
 	IPC_SET_ARG4(data, pager_info->id2);
 	IPC_SET_ARG5(data, pager_info->id3);
 
-	errno_t rc = ipc_req_internal(pager_info->pager, &data, (sysarg_t) true);
+	uintptr_t *frames;
+	errno_t rc = ipc_req_internal(pager_info->pager, &data, (sysarg_t) true,
+	    (void **) &frames);
 
 	if (rc != EOK) {
 		log(LF_USPACE, LVL_FATAL,
 		    "Page-in request for page %#" PRIxPTR
 		    " at pager %p failed with error %s.",
 		    upage, pager_info->pager, str_error_name(rc));
+		if (frames)
+			free(frames);
 		return AS_PF_FAULT;
 	}
 
-	if (IPC_GET_RETVAL(data) != EOK)
+	if (IPC_GET_RETVAL(data) != EOK) {
+		if (frames)
+			free(frames);
 		return AS_PF_FAULT;
+	}
 
 	/*
-	 * A successful reply will contain the physical frame in ARG1.
-	 * The physical frame will have the reference count already
-	 * incremented (if applicable).
+	 * A successful reply contains the size of the paged-in part of the
+	 * cluster in ARG2. The frames, which are already allocated for us,
+	 * are in the buffer of the call.
 	 */
+	assert(frames != NULL);
 
-	uintptr_t frame = IPC_GET_ARG1(data);
-	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
-	if (!used_space_insert(&area->used_space, upage, 1))
+	size_t count = IPC_GET_ARG2(data) >> PAGE_WIDTH;
+	if (upage >= start + P2SZ(count)) {
+		user_frames_free(frames, count);
+		free(frames);
+		return AS_PF_FAULT;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		page_mapping_insert(AS, start + P2SZ(i), frames[i],
+		    as_area_get_flags(area));
+	}
+	if (!used_space_insert(&area->used_space, start, count))
 		panic("Cannot insert used space.");
 
+	free(frames);
 	return AS_PF_OK;
 }
 
@@ -38,6 +38,16 @@
  *
  * This file contains the physical frame allocator and memory zone management.
  * The frame allocator is built on top of the two-level bitmap structure.
+ * Besides the bitmap, each zone keeps the number of free frames in every
+ * block of ZONE_BLOCK_FRAMES frames. The index lets searches for free
+ * frames skip fully allocated blocks and extend a range over fully free
+ * blocks without examining their bits.
+ *
+ * Single frames are allocated from and freed to small per-CPU lists of
+ * free frames, which are refilled from the zones in batches. The lists of
+ * a CPU are protected by its frame_pcpu_lock, which is normally taken
+ * only by the owning CPU, but also by any CPU which drains all lists when
+ * it runs out of memory. The lock nests inside the zones lock.
  *
  */
 
@@ -61,6 +71,7 @@
 #include <config.h>
 #include <str.h>
 #include <proc/thread.h> /* THREAD */
+#include <cpu.h>
 
 zones_t zones;
 
@@ -147,6 +158,29 @@ _NO_TRACE static size_t zones_insert_zone(pfn_t base, size_t count,
 	return i;
 }
 
+/** Get number of free frames held in the per-CPU frame lists.
+ *
+ * The lists of other CPUs are read without synchronization,
+ * therefore the result is only approximate.
+ *
+ * @return Number of frames in all per-CPU frame lists.
+ *
+ */
+_NO_TRACE static size_t frame_pcpu_count(void)
+{
+	size_t total = 0;
+
+	if (cpus == NULL)
+		return 0;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		for (unsigned int j = 0; j < FRAME_PCPU_LISTS; j++)
+			total += cpus[i].frame_pcpu[j].count;
+	}
+
+	return total;
+}
+
 /** Get total available frames.
  *
  * Assume interrupts are disabled and zones lock is
@@ -163,7 +197,7 @@ _NO_TRACE static size_t frame_total_free_get_internal(void)
 	for (i = 0; i < zones.count; i++)
 		total += zones.info[i].free_count;
 
-	return total;
+	return total + frame_pcpu_count();
 }
 
 _NO_TRACE size_t frame_total_free_get(void)
@@ -209,18 +243,159 @@ _NO_TRACE size_t find_zone(pfn_t frame, size_t count, size_t hint)
 	return (size_t) -1;
 }
 
-/** @return True if zone can allocate specified number of frames */
-_NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
-    pfn_t constraint)
+/** Find a range of free frames in a zone starting at a given block.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param zone       Zone to search.
+ * @param first      First block to examine.
+ * @param count      Number of free frames we are trying to find.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first frame.
+ * @param index      Place to store the zone-relative index of the
+ *                   first frame of the range.
+ *
+ * @return True if a suitable range was found.
+ *
+ */
+_NO_TRACE static bool zone_find_free_from(zone_t *zone, size_t first,
+    size_t count, pfn_t constraint, size_t *index)
 {
-	/*
-	 * The function bitmap_allocate_range() does not modify
-	 * the bitmap if the last argument is NULL.
-	 */
+	size_t blocks = ZONE_BLOCKS(zone->count);
+	size_t start = 0;
+	size_t run = 0;
+
+	for (size_t block = first; block < blocks; block++) {
+		size_t bstart = block << ZONE_BLOCK_WIDTH;
+		size_t bsize = min((size_t) ZONE_BLOCK_FRAMES,
+		    zone->count - bstart);
+
+		if (zone->block_free[block] == 0) {
+			run = 0;
+			continue;
+		}
+
+		if ((zone->block_free[block] == bsize) &&
+		    ((run > 0) || (((zone->base + bstart) & constraint) == 0))) {
+			/* The whole block is free */
+			if (run == 0)
+				start = bstart;
+
+			run += bsize;
+		} else {
+			for (size_t i = bstart; i < bstart + bsize; i++) {
+				if (bitmap_get(&zone->bitmap, i)) {
+					run = 0;
+					continue;
+				}
+
+				if (run == 0) {
+					if (((zone->base + i) & constraint) != 0)
+						continue;
+
+					start = i;
+				}
+
+				if (++run == count)
+					break;
+			}
+		}
+
+		if (run >= count) {
+			*index = start;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Find a range of free frames in a zone.
+ *
+ * The search resumes at the block of the last allocation and frames
+ * which are not high-priority memory are preferred.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param zone       Zone to search.
+ * @param count      Number of free frames we are trying to find.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first frame.
+ * @param index      Place to store the zone-relative index of the
+ *                   first frame of the range.
+ *
+ * @return True if zone can allocate specified number of frames.
+ *
+ */
+_NO_TRACE static bool zone_find_free(zone_t *zone, size_t count,
+    pfn_t constraint, size_t *index)
+{
+	if ((!(zone->flags & ZONE_AVAILABLE)) || (zone->free_count < count))
+		return false;
+
+	size_t lowprio = 0;
+	if ((FRAME_LOWPRIO > zone->base) &&
+	    (FRAME_LOWPRIO < zone->base + zone->count))
+		lowprio = (FRAME_LOWPRIO - zone->base) >> ZONE_BLOCK_WIDTH;
+
+	size_t first[] = {
+		max(lowprio, zone->block_hint),
+		lowprio,
+		0
+	};
+
+	for (size_t i = 0; i < sizeof(first) / sizeof(first[0]); i++) {
+		if ((i > 0) && (first[i] >= first[i - 1]))
+			continue;
+
+		if (zone_find_free_from(zone, first[i], count, constraint,
+		    index))
+			return true;
+	}
 
-	return ((zone->flags & ZONE_AVAILABLE) &&
-	    bitmap_allocate_range(&zone->bitmap, count, zone->base,
-	    FRAME_LOWPRIO, constraint, NULL));
+	return false;
+}
+
+/** Find the longest range of free frames and the number of free blocks.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ */
+_NO_TRACE static void zone_fragmentation(zone_t *zone, size_t *free_blocks,
+    size_t *largest)
+{
+	size_t blocks = ZONE_BLOCKS(zone->count);
+	size_t run = 0;
+
+	*free_blocks = 0;
+	*largest = 0;
+
+	for (size_t block = 0; block < blocks; block++) {
+		size_t bstart = block << ZONE_BLOCK_WIDTH;
+		size_t bsize = min((size_t) ZONE_BLOCK_FRAMES,
+		    zone->count - bstart);
+
+		if (zone->block_free[block] == bsize) {
+			(*free_blocks)++;
+			run += bsize;
+		} else if (zone->block_free[block] == 0) {
+			run = 0;
+		} else {
+			for (size_t i = bstart; i < bstart + bsize; i++) {
+				if (bitmap_get(&zone->bitmap, i)) {
+					run = 0;
+				} else {
+					run++;
+					*largest = max(*largest, run);
+				}
+			}
+		}
+
+		*largest = max(*largest, run);
+	}
 }
 
 /** Find a zone that can allocate specified number of frames
@@ -233,13 +408,15 @@ _NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param index      Place to store the zone-relative index of the
+ *                   first free frame found.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, size_t *index)
 {
 	for (size_t pos = 0; pos < zones.count; pos++) {
 		size_t i = (pos + hint) % zones.count;
@@ -249,7 +426,7 @@ _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
 			continue;
 
 		/* Check if the zone can satisfy the allocation request. */
-		if (zone_can_alloc(&zones.info[i], count, constraint))
+		if (zone_find_free(&zones.info[i], count, constraint, index))
 			return i;
 	}
 
@@ -279,13 +456,15 @@ _NO_TRACE static bool is_high_priority(pfn_t base, size_t count)
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param index      Place to store the zone-relative index of the
+ *                   first free frame found.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no low-priority zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone_lowprio(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, size_t *index)
 {
 	for (size_t pos = 0; pos < zones.count; pos++) {
 		size_t i = (pos + hint) % zones.count;
@@ -299,7 +478,7 @@ _NO_TRACE static size_t find_free_zone_lowprio(size_t count, zone_flags_t flags,
 			continue;
 
 		/* Check if the zone can satisfy the allocation request. */
-		if (zone_can_alloc(&zones.info[i], count, constraint))
+		if (zone_find_free(&zones.info[i], count, constraint, index))
 			return i;
 	}
 
@@ -316,13 +495,15 @@ _NO_TRACE static size_t find_free_zone_lowprio(size_t count, zone_flags_t flags,
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param index      Place to store the zone-relative index of the
+ *                   first free frame found.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, size_t *index)
 {
 	if (hint >= zones.count)
 		hint = 0;
@@ -332,12 +513,13 @@ _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
 	 * zones with high-priority memory.
 	 */
 
-	size_t znum = find_free_zone_lowprio(count, flags, constraint, hint);
+	size_t znum = find_free_zone_lowprio(count, flags, constraint, hint,
+	    index);
 	if (znum != (size_t) -1)
 		return znum;
 
 	/* Take all zones into account */
-	return find_free_zone_all(count, flags, constraint, hint);
+	return find_free_zone_all(count, flags, constraint, hint, index);
 }
 
 /******************/
@@ -355,29 +537,23 @@ _NO_TRACE static frame_t *zone_get_frame(zone_t *zone, size_t index)
 /** Allocate frame in particular zone.
  *
  * Assume zone is locked and is available for allocation.
- * Panics if allocation is impossible.
  *
- * @param zone       Zone to allocate from.
- * @param count      Number of frames to allocate
- * @param constraint Indication of bits that cannot be set in the
- *                   physical frame number of the first allocated frame.
+ * @param zone  Zone to allocate from.
+ * @param count Number of frames to allocate
+ * @param index Index of the first frame of a free range found
+ *              by zone_find_free().
  *
  * @return Frame index in zone.
  *
  */
 _NO_TRACE static size_t zone_frame_alloc(zone_t *zone, size_t count,
-    pfn_t constraint)
+    size_t index)
 {
 	assert(zone->flags & ZONE_AVAILABLE);
+	assert(index + count <= zone->count);
 
 	/* Allocate frames from zone */
-	size_t index = (size_t) -1;
-	int avail = bitmap_allocate_range(&zone->bitmap, count, zone->base,
-	    FRAME_LOWPRIO, constraint, &index);
-
-	(void) avail;
-	assert(avail);
-	assert(index != (size_t) -1);
+	bitmap_set_range(&zone->bitmap, index, count);
 
 	/* Update frame reference count */
 	for (size_t i = 0; i < count; i++) {
@@ -385,11 +561,13 @@ _NO_TRACE static size_t zone_frame_alloc(zone_t *zone, size_t count,
 
 		assert(frame->refcount == 0);
 		frame->refcount = 1;
+		zone->block_free[(index + i) >> ZONE_BLOCK_WIDTH]--;
 	}
 
 	/* Update zone information. */
 	zone->free_count -= count;
 	zone->busy_count += count;
+	zone->block_hint = index >> ZONE_BLOCK_WIDTH;
 
 	return index;
 }
@@ -414,6 +592,9 @@ _NO_TRACE static size_t zone_frame_free(zone_t *zone, size_t index)
 
 	if (!--frame->refcount) {
 		bitmap_set(&zone->bitmap, index, 0);
+		zone->block_free[index >> ZONE_BLOCK_WIDTH]++;
+		zone->block_hint = min(zone->block_hint,
+		    index >> ZONE_BLOCK_WIDTH);
 
 		/* Update zone information. */
 		zone->free_count++;
@@ -436,6 +617,7 @@ _NO_TRACE static void zone_mark_unavailable(zone_t *zone, size_t index)
 
 	frame->refcount = 1;
 	bitmap_set_range(&zone->bitmap, index, 1);
+	zone->block_free[index >> ZONE_BLOCK_WIDTH]--;
 
 	zone->free_count--;
 	reserve_force_alloc(1);
@@ -474,6 +656,10 @@ _NO_TRACE static void zone_merge_internal(size_t z1, size_t z2, zone_t *old_z1,
 	bitmap_clear_range(&zones.info[z1].bitmap, 0, zones.info[z1].count);
 
 	zones.info[z1].frames = (frame_t *) confdata;
+	zones.info[z1].block_free = (uint8_t *) confdata +
+	    (sizeof(frame_t) * zones.info[z1].count) +
+	    bitmap_size(zones.info[z1].count);
+	zones.info[z1].block_hint = 0;
 
 	/*
 	 * Copy frames and bits from both zones to preserve parents, etc.
@@ -491,6 +677,16 @@ _NO_TRACE static void zone_merge_internal(size_t z1, size_t z2, zone_t *old_z1,
 		zones.info[z1].frames[base_diff + i] =
 		    zones.info[z2].frames[i];
 	}
+
+	/* Rebuild the free frame index from the bitmap */
+	size_t blocks = ZONE_BLOCKS(zones.info[z1].count);
+	for (size_t block = 0; block < blocks; block++)
+		zones.info[z1].block_free[block] = 0;
+
+	for (size_t i = 0; i < zones.info[z1].count; i++) {
+		if (!bitmap_get(&zones.info[z1].bitmap, i))
+			zones.info[z1].block_free[i >> ZONE_BLOCK_WIDTH]++;
+	}
 }
 
 /** Return old configuration frames into the zone.
@@ -555,12 +751,13 @@ bool zone_merge(size_t z1, size_t z2)
 
 	/* Allocate merged zone data inside one of the zones */
 	pfn_t pfn;
-	if (zone_can_alloc(&zones.info[z1], cframes, 0)) {
+	size_t index;
+	if (zone_find_free(&zones.info[z1], cframes, 0, &index)) {
 		pfn = zones.info[z1].base +
-		    zone_frame_alloc(&zones.info[z1], cframes, 0);
-	} else if (zone_can_alloc(&zones.info[z2], cframes, 0)) {
+		    zone_frame_alloc(&zones.info[z1], cframes, index);
+	} else if (zone_find_free(&zones.info[z2], cframes, 0, &index)) {
 		pfn = zones.info[z2].base +
-		    zone_frame_alloc(&zones.info[z2], cframes, 0);
+		    zone_frame_alloc(&zones.info[z2], cframes, index);
 	} else {
 		ret = false;
 		goto errout;
@@ -649,10 +846,26 @@ _NO_TRACE static void zone_construct(zone_t *zone, pfn_t start, size_t count,
 
 		for (size_t i = 0; i < count; i++)
 			frame_initialize(&zone->frames[i]);
+
+		/*
+		 * Initialize the free frame index (located after the bitmap
+		 * in the configuration space).
+		 */
+
+		zone->block_free = (uint8_t *) confdata +
+		    (sizeof(frame_t) * count) + bitmap_size(count);
+
+		for (size_t block = 0; block < ZONE_BLOCKS(count); block++) {
+			zone->block_free[block] = min((size_t) ZONE_BLOCK_FRAMES,
+			    count - (block << ZONE_BLOCK_WIDTH));
+		}
 	} else {
 		bitmap_initialize(&zone->bitmap, 0, NULL);
 		zone->frames = NULL;
+		zone->block_free = NULL;
 	}
+
+	zone->block_hint = 0;
 }
 
 /** Compute configuration data size for zone.
@@ -664,7 +877,8 @@ _NO_TRACE static void zone_construct(zone_t *zone, pfn_t start, size_t count,
  */
 size_t zone_conf_size(size_t count)
 {
-	return (count * sizeof(frame_t) + bitmap_size(count));
+	return (count * sizeof(frame_t) + bitmap_size(count) +
+	    ZONE_BLOCKS(count));
 }
 
 /** Allocate external configuration frames from low memory. */
@@ -816,17 +1030,204 @@ void *frame_get_parent(pfn_t pfn, size_t hint)
 }
 
 static size_t try_find_zone(size_t count, bool lowmem,
-    pfn_t frame_constraint, size_t hint)
+    pfn_t frame_constraint, size_t hint, size_t *index)
 {
 	if (!lowmem) {
 		size_t znum = find_free_zone(count,
-		    ZONE_HIGHMEM | ZONE_AVAILABLE, frame_constraint, hint);
+		    ZONE_HIGHMEM | ZONE_AVAILABLE, frame_constraint, hint,
+		    index);
 		if (znum != (size_t) -1)
 			return znum;
 	}
 
 	return find_free_zone(count, ZONE_LOWMEM | ZONE_AVAILABLE,
-	    frame_constraint, hint);
+	    frame_constraint, hint, index);
+}
+
+/** Get the per-CPU frame list for frames of a zone.
+ *
+ * Assume interrupts are disabled.
+ *
+ * @return Frame list or NULL if frames of the zone are not
+ *         to be held in the per-CPU frame lists.
+ *
+ */
+_NO_TRACE static frame_pcpu_t *frame_pcpu_list(zone_t *zone)
+{
+	if (zone->flags & ZONE_HIGHMEM)
+		return &CPU->frame_pcpu[FRAME_PCPU_HIGHMEM];
+
+	if (zone->flags & ZONE_LOWMEM)
+		return &CPU->frame_pcpu[FRAME_PCPU_LOWMEM];
+
+	return NULL;
+}
+
+/** Allocate a single frame from the per-CPU frame lists.
+ *
+ * A request which may be satisfied from high memory takes a frame from
+ * the high memory list and falls back to the low memory list, since any
+ * frame satisfies it. When the lists it looks at are empty, they are
+ * refilled with up to FRAME_PCPU_BATCH frames from a single zone.
+ * High-priority memory is handed out one frame at a time and never
+ * cached.
+ *
+ * @param lowmem True if the frame must be in low memory.
+ * @param pfn    Place to store the frame number of the allocated frame.
+ *
+ * @return True if a frame was allocated, false if no free frame is
+ *         available without reclaiming memory.
+ *
+ */
+_NO_TRACE static bool frame_pcpu_alloc(bool lowmem, pfn_t *pfn)
+{
+	ipl_t ipl = interrupts_disable();
+
+	if (CPU == NULL) {
+		interrupts_restore(ipl);
+		return false;
+	}
+
+	frame_pcpu_t *lowmem_list = &CPU->frame_pcpu[FRAME_PCPU_LOWMEM];
+	frame_pcpu_t *highmem_list = &CPU->frame_pcpu[FRAME_PCPU_HIGHMEM];
+
+	irq_spinlock_lock(&CPU->frame_pcpu_lock, false);
+
+	frame_pcpu_t *list = NULL;
+	if ((!lowmem) && (highmem_list->count > 0))
+		list = highmem_list;
+	else if (lowmem_list->count > 0)
+		list = lowmem_list;
+
+	if (list != NULL) {
+		*pfn = list->pfn[--list->count];
+		irq_spinlock_unlock(&CPU->frame_pcpu_lock, false);
+		interrupts_restore(ipl);
+		return true;
+	}
+
+	irq_spinlock_unlock(&CPU->frame_pcpu_lock, false);
+
+	/* Refill the list from a zone */
+	bool found = false;
+	size_t index;
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	size_t znum = try_find_zone(1, lowmem, 0, 0, &index);
+	if (znum != (size_t) -1) {
+		zone_t *zone = &zones.info[znum];
+
+		*pfn = zone->base + zone_frame_alloc(zone, 1, index);
+		found = true;
+
+		/*
+		 * Only fill a list which the next request of this kind
+		 * looks at.
+		 */
+		list = frame_pcpu_list(zone);
+		if ((list == highmem_list) && (lowmem))
+			list = NULL;
+
+		if ((list != NULL) && (!is_high_priority(*pfn, 1))) {
+			irq_spinlock_lock(&CPU->frame_pcpu_lock, false);
+
+			while ((list->count < FRAME_PCPU_BATCH) &&
+			    (zone_find_free(zone, 1, 0, &index)) &&
+			    (!is_high_priority(zone->base + index, 1))) {
+				list->pfn[list->count++] = zone->base +
+				    zone_frame_alloc(zone, 1, index);
+			}
+
+			irq_spinlock_unlock(&CPU->frame_pcpu_lock, false);
+		}
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+	interrupts_restore(ipl);
+
+	return found;
+}
+
+/** Put a single frame being freed into a per-CPU frame list.
+ *
+ * The frame keeps its reference and stays marked as allocated in
+ * the zone. Frames are returned directly to the zone if somebody
+ * waits for free memory.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param zone  Zone of the frame.
+ * @param index Frame index relative to zone.
+ *
+ * @return True if the frame was put into a per-CPU frame list.
+ *
+ */
+_NO_TRACE static bool frame_pcpu_free(zone_t *zone, size_t index)
+{
+	if ((CPU == NULL) || (mem_avail_req > 0))
+		return false;
+
+	if (zone_get_frame(zone, index)->refcount != 1)
+		return false;
+
+	if (is_high_priority(zone->base + index, 1))
+		return false;
+
+	frame_pcpu_t *list = frame_pcpu_list(zone);
+	if (list == NULL)
+		return false;
+
+	irq_spinlock_lock(&CPU->frame_pcpu_lock, false);
+
+	bool cached = (list->count < FRAME_PCPU_MAX);
+	if (cached)
+		list->pfn[list->count++] = zone->base + index;
+
+	irq_spinlock_unlock(&CPU->frame_pcpu_lock, false);
+	return cached;
+}
+
+/** Return frames of all CPUs' frame lists to the zones.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @return Number of frames returned.
+ *
+ */
+_NO_TRACE static size_t frame_pcpu_drain(void)
+{
+	size_t freed = 0;
+
+	/* The per-CPU locks are initialized by the time CPU is set. */
+	if ((cpus == NULL) || (CPU == NULL))
+		return 0;
+
+	for (unsigned int c = 0; c < config.cpu_count; c++) {
+		cpu_t *cpu = &cpus[c];
+
+		irq_spinlock_lock(&cpu->frame_pcpu_lock, false);
+
+		for (unsigned int i = 0; i < FRAME_PCPU_LISTS; i++) {
+			frame_pcpu_t *list = &cpu->frame_pcpu[i];
+
+			while (list->count > 0) {
+				pfn_t pfn = list->pfn[--list->count];
+				size_t znum = find_zone(pfn, 1, 0);
+
+				assert(znum != (size_t) -1);
+
+				freed += zone_frame_free(&zones.info[znum],
+				    pfn - zones.info[znum].base);
+			}
+		}
+
+		irq_spinlock_unlock(&cpu->frame_pcpu_lock, false);
+	}
+
+	return freed;
 }
 
 /** Allocate frames of physical memory.
@@ -854,19 +1255,37 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
-loop:
-	irq_spinlock_lock(&zones.lock, true);
-
 	// TODO: Print diagnostic if neither is explicitly specified.
 	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
 
+	/*
+	 * Unconstrained single frames come from the per-CPU frame lists.
+	 */
+	if ((count == 1) && (frame_constraint == 0) && (pzone == NULL)) {
+		pfn_t pfn;
+		if (frame_pcpu_alloc(lowmem, &pfn))
+			return PFN2ADDR(pfn);
+	}
+
+loop:
+	irq_spinlock_lock(&zones.lock, true);
+
 	/*
 	 * First, find suitable frame zone.
 	 */
-	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
+	size_t index;
+	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint,
+	    &index);
+
+	/*
+	 * If no memory, return the frames cached by all CPUs first.
+	 */
+	if ((znum == (size_t) -1) && (frame_pcpu_drain() > 0))
+		znum = try_find_zone(count, lowmem, frame_constraint, hint,
+		    &index);
 
 	/*
-	 * If no memory, reclaim some slab memory,
+	 * If still no memory, reclaim some slab memory,
 	 * if it does not help, reclaim all.
 	 */
 	if ((znum == (size_t) -1) && (!(flags & FRAME_NO_RECLAIM))) {
@@ -876,7 +1295,7 @@ loop:
 
 		if (freed > 0)
 			znum = try_find_zone(count, lowmem,
-			    frame_constraint, hint);
+			    frame_constraint, hint, &index);
 
 		if (znum == (size_t) -1) {
 			irq_spinlock_unlock(&zones.lock, true);
@@ -885,7 +1304,7 @@ loop:
 
 			if (freed > 0)
 				znum = try_find_zone(count, lowmem,
-				    frame_constraint, hint);
+				    frame_constraint, hint, &index);
 		}
 	}
 
@@ -945,8 +1364,8 @@ loop:
 		goto loop;
 	}
 
-	pfn_t pfn = zone_frame_alloc(&zones.info[znum], count,
-	    frame_constraint) + zones.info[znum].base;
+	pfn_t pfn = zone_frame_alloc(&zones.info[znum], count, index) +
+	    zones.info[znum].base;
 
 	irq_spinlock_unlock(&zones.lock, true);
 
@@ -987,6 +1406,16 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 
 		assert(znum != (size_t) -1);
 
+		/*
+		 * A single frame losing its last reference is kept
+		 * by this CPU for subsequent allocations.
+		 */
+		if ((count == 1) && (frame_pcpu_free(&zones.info[znum],
+		    pfn - zones.info[znum].base))) {
+			freed++;
+			continue;
+		}
+
 		freed += zone_frame_free(&zones.info[znum],
 		    pfn - zones.info[znum].base);
 	}
@@ -1190,6 +1619,12 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 			*unavail += (uint64_t) FRAMES2SIZE(zones.info[i].count);
 	}
 
+	/* Frames held in the per-CPU frame lists are free */
+	uint64_t pcpu = (uint64_t) FRAMES2SIZE(frame_pcpu_count());
+	pcpu = min(pcpu, *busy);
+	*busy -= pcpu;
+	*free += pcpu;
+
 	irq_spinlock_unlock(&zones.lock, true);
 }
 
@@ -1199,11 +1634,13 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 void zones_print_list(void)
 {
 #ifdef __32_BITS__
-	printf("[nr] [base addr] [frames    ] [flags ] [free frames ] [busy frames ]\n");
+	printf("[nr] [base addr] [frames    ] [flags ] [free frames ] [busy frames ]"
+	    " [free blocks] [largest run ]\n");
 #endif
 
 #ifdef __64_BITS__
-	printf("[nr] [base address    ] [frames    ] [flags ] [free frames ] [busy frames ]\n");
+	printf("[nr] [base address    ] [frames    ] [flags ] [free frames ] [busy frames ]"
+	    " [free blocks] [largest run ]\n");
 #endif
 
 	/*
@@ -1235,6 +1672,8 @@ void zones_print_list(void)
 		zone_flags_t flags = zones.info[i].flags;
 		size_t free_count = zones.info[i].free_count;
 		size_t busy_count = zones.info[i].busy_count;
+		size_t free_blocks = 0;
+		size_t largest = 0;
 
 		bool available = ((flags & ZONE_AVAILABLE) != 0);
 		bool lowmem = ((flags & ZONE_LOWMEM) != 0);
@@ -1242,6 +1681,9 @@ void zones_print_list(void)
 		bool highprio = is_high_priority(fbase, count);
 
 		if (available) {
+			zone_fragmentation(&zones.info[i], &free_blocks,
+			    &largest);
+
 			if (lowmem)
 				free_lowmem += free_count;
 
@@ -1287,12 +1729,16 @@ void zones_print_list(void)
 		    (flags & ZONE_HIGHMEM) ? 'H' : '-');
 
 		if (available)
-			printf("%14zu %14zu",
-			    free_count, busy_count);
+			printf("%14zu %14zu %13zu %14zu",
+			    free_count, busy_count, free_blocks, largest);
 
 		printf("\n");
 	}
 
+	irq_spinlock_lock(&zones.lock, true);
+	size_t pcpu = frame_pcpu_count();
+	irq_spinlock_unlock(&zones.lock, true);
+
 	printf("\n");
 
 	uint64_t size;
@@ -1312,6 +1758,10 @@ void zones_print_list(void)
 	    false);
 	printf("Available high priority: %zu frames (%" PRIu64 " %s)\n",
 	    free_highprio, size, size_suffix);
+
+	bin_order_suffix(FRAMES2SIZE(pcpu), &size, &size_suffix, false);
+	printf("Held in per-CPU lists:   %zu frames (%" PRIu64 " %s)\n",
+	    pcpu, size, size_suffix);
 }
 
 /** Prints zone details.
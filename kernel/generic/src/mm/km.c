@@ -68,7 +68,7 @@ static unsigned km_flush_deferred(void)
 	unsigned i = 0;
 	ipl_t ipl;
 
-	ipl = tlb_shootdown_start(TLB_INVL_ASID, ASID_KERNEL, 0, 0);
+	ipl = tlb_shootdown_start(TLB_INVL_ASID, AS_KERNEL, ASID_KERNEL, 0, 0);
 
 	for (i = 0; i < deferred_pages; i++) {
 		page_mapping_remove(AS_KERNEL, deferred_page[i]);
@@ -165,7 +165,7 @@ static void km_unmap_aligned(uintptr_t vaddr, size_t size)
 
 	page_table_lock(AS_KERNEL, true);
 
-	ipl = tlb_shootdown_start(TLB_INVL_ASID, ASID_KERNEL, 0, 0);
+	ipl = tlb_shootdown_start(TLB_INVL_ASID, AS_KERNEL, ASID_KERNEL, 0, 0);
 
 	for (offs = 0; offs < size; offs += PAGE_SIZE)
 		page_mapping_remove(AS_KERNEL, vaddr + offs);
@@ -40,13 +40,7 @@
  * with the following exceptions:
  * @li empty slabs are deallocated immediately
  *     (in Linux they are kept in linked list, in Solaris ???)
- * @li empty magazines are deallocated when not needed
- *     (in Solaris they are held in linked list in slab cache)
- *
- * Following features are not currently supported but would be easy to do:
- * @li cache coloring
- * @li dynamic magazine growing (different magazine sizes are already
- *     supported, but we would need to adjust allocation strategy)
+ * @li magazines only grow, the size is never decreased
  *
  * The slab allocator supports per-CPU caches ('magazines') to facilitate
  * good SMP scaling.
@@ -57,9 +51,16 @@
  * it is used, otherwise a new one is allocated.
  *
  * When an object is being deallocated, it is put to a CPU-bound magazine.
- * If there is no such magazine, a new one is allocated (if this fails,
- * the object is deallocated into slab). If the magazine is full, it is
- * put into cpu-shared list of magazines and a new one is allocated.
+ * If there is no such magazine, an empty one is taken from the cache's
+ * depot or a new one is allocated (if this fails, the object is
+ * deallocated into slab). If the magazine is full, it is put into the
+ * depot's list of full magazines.
+ *
+ * Each cache has its own depot of full and empty magazines. Contention
+ * on the depot lock is counted and whenever it reaches
+ * SLAB_MAG_GROW_CONTENTION, the size of new magazines is doubled (up to
+ * SLAB_MAG_SIZE_MAX), so that busy caches go to the depot less often.
+ * Magazines of each size come from their own magazine cache.
  *
  * The CPU-bound magazine is actually a pair of magazines in order to avoid
  * thrashing when somebody is allocating/deallocating 1 item at the magazine
@@ -70,6 +71,11 @@
  * Empty slabs are immediately freed (thrashing will be avoided because
  * of magazines).
  *
+ * The space wasted at the end of a slab is used for coloring: the first
+ * object of consecutive slabs is offset by a different multiple of
+ * SLAB_COLOR_ALIGN so that objects at the same index do not map to the
+ * same CPU cache sets.
+ *
  * The slab information structure is kept inside the data area, if possible.
  * The cache can be marked that it should not use magazines. This is used
  * only for slab related caches to avoid deadlocks and infinite recursion
@@ -78,22 +84,13 @@
  * The slab allocator allocates a lot of space and does not free it. When
  * the frame allocator fails to allocate a frame, it calls slab_reclaim().
  * It tries 'light reclaim' first, then brutal reclaim. The light reclaim
- * releases slabs from cpu-shared magazine-list, until at least 1 slab
- * is deallocated in each cache (this algorithm should probably change).
+ * releases empty magazines and slabs from the depot's magazine-list, until
+ * at least 1 slab is deallocated in each cache (this algorithm should
+ * probably change).
  * The brutal reclaim removes all cached objects, even from CPU-bound
  * magazines.
  *
  * @todo
- * For better CPU-scaling the magazine allocation strategy should
- * be extended. Currently, if the cache does not have magazine, it asks
- * for non-cpu cached magazine cache to provide one. It might be feasible
- * to add cpu-cached magazine cache (which would allocate it's magazines
- * from non-cpu-cached mag. cache). This would provide a nice per-cpu
- * buffer. The other possibility is to use the per-cache
- * 'empty-magazine-list', which decreases competing for 1 per-system
- * magazine cache.
- *
- * @todo
  * It might be good to add granularity of locks even to slab level,
  * we could then try_spinlock over all partial slabs and thus improve
  * scalability even on slab level.
@@ -120,8 +117,20 @@
 IRQ_SPINLOCK_STATIC_INITIALIZE(slab_cache_lock);
 static LIST_INITIALIZE(slab_cache_list);
 
-/** Magazine cache */
-static slab_cache_t mag_cache;
+/** Number of magazine sizes (SLAB_MAG_SIZE up to SLAB_MAG_SIZE_MAX) */
+#define MAG_CACHE_COUNT  5
+
+/** Magazine caches, one for each magazine size */
+static slab_cache_t mag_cache[MAG_CACHE_COUNT];
+
+/** Names of the magazine caches */
+static const char *mag_cache_names[MAG_CACHE_COUNT] = {
+	"slab_magazine_t(4)",
+	"slab_magazine_t(8)",
+	"slab_magazine_t(16)",
+	"slab_magazine_t(32)",
+	"slab_magazine_t(64)"
+};
 
 /** Cache for cache descriptors */
 static slab_cache_t slab_cache_cache;
@@ -142,6 +151,7 @@ typedef struct {
 	slab_cache_t *cache;  /**< Pointer to parent cache. */
 	link_t link;          /**< List of full/partial slabs. */
 	void *start;          /**< Start address of first available item. */
+	size_t color;         /**< Offset of start from the slab frames. */
 	size_t available;     /**< Count of available items in this slab. */
 	size_t nextavail;     /**< The index of next available item. */
 } slab_t;
@@ -183,12 +193,25 @@ _NO_TRACE static slab_t *slab_space_alloc(slab_cache_t *cache,
 		slab = data + fsize - sizeof(*slab);
 	}
 
+	/*
+	 * Offset the objects of consecutive slabs by different multiples
+	 * of the color step so that they do not all compete for the same
+	 * CPU cache sets.
+	 */
+	irq_spinlock_lock(&cache->slablock, true);
+	size_t color = cache->color_next;
+	cache->color_next += cache->color_step;
+	if (cache->color_next > cache->color_max)
+		cache->color_next = 0;
+	irq_spinlock_unlock(&cache->slablock, true);
+
 	/* Fill in slab structures */
 	size_t i;
 	for (i = 0; i < cache->frames; i++)
 		frame_set_parent(ADDR2PFN(KA2PA(data)) + i, slab, zone);
 
-	slab->start = data;
+	slab->start = data + color;
+	slab->color = color;
 	slab->available = cache->objects;
 	slab->nextavail = 0;
 	slab->cache = cache;
@@ -207,7 +230,7 @@ _NO_TRACE static slab_t *slab_space_alloc(slab_cache_t *cache,
  */
 _NO_TRACE static size_t slab_space_free(slab_cache_t *cache, slab_t *slab)
 {
-	frame_free(KA2PA(slab->start), slab->cache->frames);
+	frame_free(KA2PA(slab->start - slab->color), slab->cache->frames);
 	if (!(cache->flags & SLAB_CACHE_SLINSIDE))
 		slab_free(slab_extern_cache, slab);
 
@@ -254,7 +277,8 @@ _NO_TRACE static size_t slab_obj_destroy(slab_cache_t *cache, void *obj,
 	slab->available++;
 
 	/* Move it to correct list */
-	if (slab->available == cache->objects) {
+	if ((slab->available == cache->objects) &&
+	    (!(cache->flags & SLAB_CACHE_TYPESAFE))) {
 		/* Free associated memory */
 		list_remove(&slab->link);
 		irq_spinlock_unlock(&cache->slablock, true);
@@ -326,6 +350,87 @@ _NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
 /* CPU-Cache slab functions */
 /****************************/
 
+/** Lock the magazine depot of a cache
+ *
+ * Contended acquisitions are counted and once there were
+ * SLAB_MAG_GROW_CONTENTION of them, the size of new magazines
+ * is doubled so that the CPUs visit the depot less often.
+ *
+ * @return Interrupt priority level to be passed to depot_unlock().
+ *
+ */
+_NO_TRACE static ipl_t depot_lock(slab_cache_t *cache)
+{
+	ipl_t ipl = interrupts_disable();
+
+	if (!irq_spinlock_trylock(&cache->maglock)) {
+		irq_spinlock_lock(&cache->maglock, false);
+
+		cache->depot_contended++;
+		if ((cache->mag_size < SLAB_MAG_SIZE_MAX) &&
+		    (++cache->depot_grow_count >= SLAB_MAG_GROW_CONTENTION)) {
+			cache->mag_size <<= 1;
+			cache->depot_grow_count = 0;
+		}
+	}
+
+	cache->depot_acquires++;
+	return ipl;
+}
+
+/** Unlock the magazine depot of a cache
+ *
+ */
+_NO_TRACE static void depot_unlock(slab_cache_t *cache, ipl_t ipl)
+{
+	irq_spinlock_unlock(&cache->maglock, false);
+	interrupts_restore(ipl);
+}
+
+/** Return magazine cache for magazines of given size
+ *
+ */
+_NO_TRACE static slab_cache_t *mag_cache_get(size_t size)
+{
+	assert(size >= SLAB_MAG_SIZE);
+	assert(size <= SLAB_MAG_SIZE_MAX);
+
+	return &mag_cache[fnzb(size / SLAB_MAG_SIZE)];
+}
+
+/** Allocate an empty magazine of the current size of the cache
+ *
+ */
+_NO_TRACE static slab_magazine_t *magazine_alloc(slab_cache_t *cache)
+{
+	size_t size = cache->mag_size;
+
+	/*
+	 * We do not want to sleep just because of caching,
+	 * especially we do not want reclaiming to start, as
+	 * this would deadlock.
+	 *
+	 */
+	slab_magazine_t *mag = slab_alloc(mag_cache_get(size),
+	    FRAME_ATOMIC | FRAME_NO_RECLAIM);
+	if (!mag)
+		return NULL;
+
+	mag->size = size;
+	mag->busy = 0;
+
+	return mag;
+}
+
+/** Free memory associated with an empty magazine
+ *
+ */
+_NO_TRACE static void magazine_free(slab_magazine_t *mag)
+{
+	assert(mag->busy == 0);
+	slab_free(mag_cache_get(mag->size), mag);
+}
+
 /** Find a full magazine in cache, take it from list and return it
  *
  * @param first If true, return first, else last mag.
@@ -337,7 +442,7 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 	slab_magazine_t *mag = NULL;
 	link_t *cur;
 
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = depot_lock(cache);
 	if (!list_empty(&cache->magazines)) {
 		if (first)
 			cur = list_first(&cache->magazines);
@@ -348,7 +453,7 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 		list_remove(&mag->link);
 		atomic_dec(&cache->magazine_counter);
 	}
-	irq_spinlock_unlock(&cache->maglock, true);
+	depot_unlock(cache, ipl);
 
 	return mag;
 }
@@ -359,12 +464,56 @@ _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 _NO_TRACE static void put_mag_to_cache(slab_cache_t *cache,
     slab_magazine_t *mag)
 {
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = depot_lock(cache);
 
 	list_prepend(&mag->link, &cache->magazines);
 	atomic_inc(&cache->magazine_counter);
 
-	irq_spinlock_unlock(&cache->maglock, true);
+	depot_unlock(cache, ipl);
+}
+
+/** Take an empty magazine from the depot or allocate a new one
+ *
+ * Magazines smaller than the current magazine size of the cache
+ * are not reused.
+ *
+ */
+_NO_TRACE static slab_magazine_t *get_empty_mag(slab_cache_t *cache)
+{
+	slab_magazine_t *mag = NULL;
+
+	ipl_t ipl = depot_lock(cache);
+	if (!list_empty(&cache->empty_magazines)) {
+		mag = list_get_instance(list_first(&cache->empty_magazines),
+		    slab_magazine_t, link);
+		list_remove(&mag->link);
+	}
+	depot_unlock(cache, ipl);
+
+	if ((mag) && (mag->size == cache->mag_size))
+		return mag;
+
+	if (mag)
+		magazine_free(mag);
+
+	return magazine_alloc(cache);
+}
+
+/** Return an empty magazine to the depot
+ *
+ */
+_NO_TRACE static void put_empty_mag(slab_cache_t *cache, slab_magazine_t *mag)
+{
+	assert(mag->busy == 0);
+
+	if (mag->size != cache->mag_size) {
+		magazine_free(mag);
+		return;
+	}
+
+	ipl_t ipl = depot_lock(cache);
+	list_prepend(&mag->link, &cache->empty_magazines);
+	depot_unlock(cache, ipl);
 }
 
 /** Free all objects in magazine and free memory associated with magazine
@@ -383,11 +532,32 @@ _NO_TRACE static size_t magazine_destroy(slab_cache_t *cache,
 		atomic_dec(&cache->cached_objs);
 	}
 
-	slab_free(&mag_cache, mag);
+	mag->busy = 0;
+	magazine_free(mag);
 
 	return frames;
 }
 
+/** Free all empty magazines in the depot of a cache
+ *
+ */
+_NO_TRACE static void depot_empty_free(slab_cache_t *cache)
+{
+	list_t mags;
+	list_initialize(&mags);
+
+	ipl_t ipl = depot_lock(cache);
+	list_concat(&mags, &cache->empty_magazines);
+	depot_unlock(cache, ipl);
+
+	while (!list_empty(&mags)) {
+		slab_magazine_t *mag = list_get_instance(list_first(&mags),
+		    slab_magazine_t, link);
+		list_remove(&mag->link);
+		magazine_free(mag);
+	}
+}
+
 /** Find full magazine, set it as current and return it
  *
  */
@@ -414,8 +584,9 @@ _NO_TRACE static slab_magazine_t *get_full_current_mag(slab_cache_t *cache)
 	if (!newmag)
 		return NULL;
 
+	/* Both local magazines are empty, keep the last one in the depot */
 	if (lastmag)
-		magazine_destroy(cache, lastmag);
+		put_empty_mag(cache, lastmag);
 
 	cache->mag_cache[CPU->id].last = cmag;
 	cache->mag_cache[CPU->id].current = newmag;
@@ -476,22 +647,11 @@ _NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 		}
 	}
 
-	/* current | last are full | nonexistent, allocate new */
-
-	/*
-	 * We do not want to sleep just because of caching,
-	 * especially we do not want reclaiming to start, as
-	 * this would deadlock.
-	 *
-	 */
-	slab_magazine_t *newmag = slab_alloc(&mag_cache,
-	    FRAME_ATOMIC | FRAME_NO_RECLAIM);
+	/* current | last are full | nonexistent, get an empty one */
+	slab_magazine_t *newmag = get_empty_mag(cache);
 	if (!newmag)
 		return NULL;
 
-	newmag->size = SLAB_MAG_SIZE;
-	newmag->busy = 0;
-
 	/* Flush last to magazine list */
 	if (lastmag)
 		put_mag_to_cache(cache, lastmag);
@@ -606,10 +766,13 @@ _NO_TRACE static void _slab_cache_create(slab_cache_t *cache, const char *name,
 	list_initialize(&cache->full_slabs);
 	list_initialize(&cache->partial_slabs);
 	list_initialize(&cache->magazines);
+	list_initialize(&cache->empty_magazines);
 
 	irq_spinlock_initialize(&cache->slablock, "slab.cache.slablock");
 	irq_spinlock_initialize(&cache->maglock, "slab.cache.maglock");
 
+	cache->mag_size = SLAB_MAG_SIZE;
+
 	if (!(cache->flags & SLAB_CACHE_NOMAGAZINE))
 		(void) make_magcache(cache);
 
@@ -629,6 +792,11 @@ _NO_TRACE static void _slab_cache_create(slab_cache_t *cache, const char *name,
 	if (badness(cache) > sizeof(slab_t))
 		cache->flags |= SLAB_CACHE_SLINSIDE;
 
+	/* Use the remaining wasted space for coloring */
+	cache->color_step = ALIGN_UP(SLAB_COLOR_ALIGN, align);
+	cache->color_max = ALIGN_DOWN(badness(cache), cache->color_step);
+	cache->color_next = 0;
+
 	/* Add cache to cache list */
 	irq_spinlock_lock(&slab_cache_lock, true);
 	list_append(&cache->link, &slab_cache_list);
@@ -673,6 +841,8 @@ _NO_TRACE static size_t _slab_reclaim(slab_cache_t *cache, unsigned int flags)
 	slab_magazine_t *mag;
 	size_t frames = 0;
 
+	depot_empty_free(cache);
+
 	while ((magcount--) && (mag = get_mag_from_cache(cache, 0))) {
 		frames += magazine_destroy(cache, mag);
 		if ((!(flags & SLAB_RECLAIM_ALL)) && (frames))
@@ -807,7 +977,7 @@ size_t slab_reclaim(unsigned int flags)
 void slab_print_list(void)
 {
 	printf("[cache name      ] [size  ] [pages ] [obj/pg] [slabs ]"
-	    " [cached] [alloc ] [ctl]\n");
+	    " [cached] [alloc ] [ctl] [mag] [depot   ] [contended]\n");
 
 	size_t skip = 0;
 	while (true) {
@@ -860,23 +1030,36 @@ void slab_print_list(void)
 		long cached_objs = atomic_load(&cache->cached_objs);
 		long allocated_objs = atomic_load(&cache->allocated_objs);
 		unsigned int flags = cache->flags;
+		size_t mag_size = cache->mag_size;
+		uint64_t depot_acquires = cache->depot_acquires;
+		uint64_t depot_contended = cache->depot_contended;
 
 		irq_spinlock_unlock(&slab_cache_lock, true);
 
-		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s\n",
+		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s",
 		    name, size, frames, objects, allocated_slabs,
 		    cached_objs, allocated_objs,
 		    flags & SLAB_CACHE_SLINSIDE ? "in" : "out");
+
+		if (flags & SLAB_CACHE_NOMAGAZINE)
+			printf("\n");
+		else
+			printf(" %5zu %10" PRIu64 " %11" PRIu64 "\n", mag_size,
+			    depot_acquires, depot_contended);
 	}
 }
 
 void slab_cache_init(void)
 {
-	/* Initialize magazine cache */
-	_slab_cache_create(&mag_cache, "slab_magazine_t",
-	    sizeof(slab_magazine_t) + SLAB_MAG_SIZE * sizeof(void *),
-	    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
-	    SLAB_CACHE_SLINSIDE);
+	/* Initialize magazine caches */
+	size_t i;
+	for (i = 0; i < MAG_CACHE_COUNT; i++) {
+		_slab_cache_create(&mag_cache[i], mag_cache_names[i],
+		    sizeof(slab_magazine_t) +
+		    (SLAB_MAG_SIZE << i) * sizeof(void *),
+		    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
+		    SLAB_CACHE_SLINSIDE);
+	}
 
 	/* Initialize slab_cache cache */
 	_slab_cache_create(&slab_cache_cache, "slab_cache_cache",
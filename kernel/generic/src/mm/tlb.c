@@ -35,12 +35,15 @@
  * @brief Generic TLB shootdown algorithm.
  *
  * The algorithm implemented here is based on the CMU TLB shootdown
- * algorithm and is further simplified (e.g. all CPUs receive all TLB
- * shootdown messages).
+ * algorithm. Only CPUs which have the affected address space installed
+ * are interrupted, the others invalidate their TLBs lazily when they
+ * switch to the address space.
  */
 
 #include <mm/tlb.h>
 #include <mm/asid.h>
+#include <mm/as.h>
+#include <mm/page.h>
 #include <arch/mm/tlb.h>
 #include <assert.h>
 #include <smp/ipi.h>
@@ -51,6 +54,7 @@
 #include <arch.h>
 #include <panic.h>
 #include <cpu.h>
+#include <macros.h>
 
 void tlb_init(void)
 {
@@ -67,12 +71,140 @@ void tlb_init(void)
  */
 IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 
+/**
+ * Set while a TLB shootdown is in progress, i.e. while tlblock is held
+ * by its initiator. Written only with tlblock held.
+ */
+static volatile bool tlb_shootdown_busy = false;
+
+/** Queue a TLB shootdown message.
+ *
+ * The message is merged with a queued message for the same ASID if
+ * their page ranges overlap or are adjacent and it is dropped if it is
+ * already covered by a queued message. If the queue overflows, it is
+ * replaced by a single TLB_INVL_ALL message.
+ *
+ * @param queue Message queue.
+ * @param len   Number of messages in the queue.
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ */
+static void tlb_message_enqueue(tlb_shootdown_msg_t *queue, size_t *len,
+    tlb_invalidate_type_t type, asid_t asid, uintptr_t page, size_t count)
+{
+	size_t i;
+
+	for (i = 0; (type != TLB_INVL_ALL) && (i < *len); i++) {
+		tlb_shootdown_msg_t *msg = &queue[i];
+
+		if (msg->type == TLB_INVL_ALL)
+			return;
+
+		if (msg->asid != asid)
+			continue;
+
+		if (msg->type == TLB_INVL_ASID)
+			return;
+
+		if (type == TLB_INVL_ASID) {
+			msg->type = TLB_INVL_ASID;
+			msg->page = 0;
+			msg->count = 0;
+			return;
+		}
+
+		uintptr_t first = msg->page >> PAGE_WIDTH;
+		uintptr_t last = first + msg->count;
+		uintptr_t new_first = page >> PAGE_WIDTH;
+		uintptr_t new_last = new_first + count;
+
+		if ((new_first <= last) && (first <= new_last)) {
+			first = min(first, new_first);
+			msg->page = first << PAGE_WIDTH;
+			msg->count = max(last, new_last) - first;
+			return;
+		}
+	}
+
+	if ((type == TLB_INVL_ALL) || (*len == TLB_MESSAGE_QUEUE_LEN)) {
+		/*
+		 * The message queue is full.
+		 * Erase the queue and store one TLB_INVL_ALL message.
+		 */
+		*len = 1;
+		queue[0].type = TLB_INVL_ALL;
+		queue[0].asid = ASID_INVALID;
+		queue[0].page = 0;
+		queue[0].count = 0;
+	} else {
+		/*
+		 * Enqueue the message.
+		 */
+		size_t idx = (*len)++;
+		queue[idx].type = type;
+		queue[idx].asid = asid;
+		queue[idx].page = page;
+		queue[idx].count = count;
+	}
+}
+
+/** Carry out one TLB shootdown message on the current CPU.
+ *
+ * @param msg Message to process.
+ *
+ */
+static void tlb_message_process(tlb_shootdown_msg_t *msg)
+{
+	switch (msg->type) {
+	case TLB_INVL_ALL:
+		tlb_invalidate_all();
+		break;
+	case TLB_INVL_ASID:
+		tlb_invalidate_asid(msg->asid);
+		break;
+	case TLB_INVL_PAGES:
+		assert(msg->count);
+		tlb_invalidate_pages(msg->asid, msg->page, msg->count);
+		break;
+	default:
+		panic("Unknown type (%d).", msg->type);
+		break;
+	}
+}
+
+/** Process TLB shootdown messages queued for the current CPU. */
+static void tlb_messages_process(void)
+{
+	irq_spinlock_lock(&CPU->lock, false);
+	assert(CPU->tlb_messages_count <= TLB_MESSAGE_QUEUE_LEN);
+
+	size_t i;
+	for (i = 0; i < CPU->tlb_messages_count; i++) {
+		tlb_message_process(&CPU->tlb_messages[i]);
+
+		if (CPU->tlb_messages[i].type == TLB_INVL_ALL)
+			break;
+	}
+
+	CPU->tlb_messages_count = 0;
+	irq_spinlock_unlock(&CPU->lock, false);
+}
+
 /** Send TLB shootdown message.
  *
- * This function attempts to deliver TLB shootdown message
- * to all other processors.
+ * This function attempts to deliver TLB shootdown message to all
+ * processors which may be using the affected translations, i.e. to all
+ * other processors in case of kernel mappings and to processors which
+ * have the address space installed otherwise. The remaining processors
+ * are not interrupted, the invalidation is deferred until they install
+ * the address space again (see tlb_shootdown_as_install()).
  *
  * @param type  Type describing scope of shootdown.
+ * @param as    Address space whose translations are to be invalidated
+ *              or NULL if only the ASID is known.
  * @param asid  Address space, if required by type.
  * @param page  Virtual page address, if required by type.
  * @param count Number of pages, if required by type.
@@ -80,12 +212,17 @@ IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
  * @return The interrupt priority level as it existed prior to this call.
  *
  */
-ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
+ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, as_t *as, asid_t asid,
     uintptr_t page, size_t count)
 {
 	ipl_t ipl = interrupts_disable();
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
+	tlb_shootdown_busy = true;
+
+	/* Kernel mappings are shared by all address spaces. */
+	bool global = (type == TLB_INVL_ALL) || (asid == ASID_KERNEL);
+	size_t targets = 0;
 
 	size_t i;
 	for (i = 0; i < config.cpu_count; i++) {
@@ -95,34 +232,38 @@ ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
 		cpu_t *cpu = &cpus[i];
 
 		irq_spinlock_lock(&cpu->lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
-			/*
-			 * The message queue is full.
-			 * Erase the queue and store one TLB_INVL_ALL message.
-			 */
-			cpu->tlb_messages_count = 1;
-			cpu->tlb_messages[0].type = TLB_INVL_ALL;
-			cpu->tlb_messages[0].asid = ASID_INVALID;
-			cpu->tlb_messages[0].page = 0;
-			cpu->tlb_messages[0].count = 0;
+		cpu->tlb_target = global || ((cpu->tlb_asid == asid) &&
+		    ((as == NULL) || (cpu->tlb_as == as)));
+		if (cpu->tlb_target) {
+			tlb_message_enqueue(cpu->tlb_messages,
+			    &cpu->tlb_messages_count, type, asid, page, count);
+			targets++;
 		} else {
-			/*
-			 * Enqueue the message.
-			 */
-			size_t idx = cpu->tlb_messages_count++;
-			cpu->tlb_messages[idx].type = type;
-			cpu->tlb_messages[idx].asid = asid;
-			cpu->tlb_messages[idx].page = page;
-			cpu->tlb_messages[idx].count = count;
+			tlb_message_enqueue(cpu->tlb_deferred,
+			    &cpu->tlb_deferred_count, type, asid, page, count);
 		}
 		irq_spinlock_unlock(&cpu->lock, false);
 	}
 
-	tlb_shootdown_ipi_send();
+	CPU->tlb_shootdowns++;
+	CPU->tlb_interrupted += targets;
+
+	if (global) {
+		tlb_shootdown_ipi_send();
+		CPU->tlb_ipis++;
+	} else {
+		for (i = 0; i < config.cpu_count; i++) {
+			if ((i != CPU->id) && (cpus[i].tlb_target)) {
+				ipi_unicast(i, VECTOR_TLB_SHOOTDOWN_IPI);
+				CPU->tlb_ipis++;
+			}
+		}
+	}
 
 busy_wait:
 	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].tlb_active)
+		if ((i != CPU->id) && (cpus[i].tlb_target) &&
+		    (cpus[i].tlb_active))
 			goto busy_wait;
 	}
 
@@ -136,6 +277,7 @@ busy_wait:
  */
 void tlb_shootdown_finalize(ipl_t ipl)
 {
+	tlb_shootdown_busy = false;
 	irq_spinlock_unlock(&tlblock, false);
 	CPU->tlb_active = true;
 	interrupts_restore(ipl);
@@ -157,39 +299,63 @@ void tlb_shootdown_ipi_recv(void)
 	irq_spinlock_lock(&tlblock, false);
 	irq_spinlock_unlock(&tlblock, false);
 
+	tlb_messages_process();
+	CPU->tlb_active = true;
+}
+
+/** Announce a newly installed address space.
+ *
+ * Called from as_switch() with interrupts disabled after the address space
+ * has been installed on the current CPU. From now on, TLB shootdowns for
+ * the address space interrupt this CPU. Invalidations which were deferred
+ * while the CPU was running other address spaces are carried out here.
+ *
+ * @param as   Installed address space.
+ * @param asid ASID of the installed address space.
+ *
+ */
+void tlb_shootdown_as_install(as_t *as, asid_t asid)
+{
+	irq_spinlock_lock(&CPU->lock, false);
+	CPU->tlb_as = as;
+	CPU->tlb_asid = asid;
+	irq_spinlock_unlock(&CPU->lock, false);
+
+	if (tlb_shootdown_busy) {
+		/*
+		 * The shootdown in progress might have passed this CPU over
+		 * and the page tables are still being changed. Wait for it
+		 * to finish just as its recipients do.
+		 */
+		CPU->tlb_active = false;
+		irq_spinlock_lock(&tlblock, false);
+		irq_spinlock_unlock(&tlblock, false);
+
+		tlb_messages_process();
+		CPU->tlb_active = true;
+	}
+
 	irq_spinlock_lock(&CPU->lock, false);
-	assert(CPU->tlb_messages_count <= TLB_MESSAGE_QUEUE_LEN);
 
 	size_t i;
-	for (i = 0; i < CPU->tlb_messages_count; i++) {
-		tlb_invalidate_type_t type = CPU->tlb_messages[i].type;
-		asid_t asid = CPU->tlb_messages[i].asid;
-		uintptr_t page = CPU->tlb_messages[i].page;
-		size_t count = CPU->tlb_messages[i].count;
+	size_t kept = 0;
+	for (i = 0; i < CPU->tlb_deferred_count; i++) {
+		tlb_shootdown_msg_t *msg = &CPU->tlb_deferred[i];
 
-		switch (type) {
-		case TLB_INVL_ALL:
+		if (msg->type == TLB_INVL_ALL) {
 			tlb_invalidate_all();
-			break;
-		case TLB_INVL_ASID:
-			tlb_invalidate_asid(asid);
-			break;
-		case TLB_INVL_PAGES:
-			assert(count);
-			tlb_invalidate_pages(asid, page, count);
-			break;
-		default:
-			panic("Unknown type (%d).", type);
+			kept = 0;
 			break;
 		}
 
-		if (type == TLB_INVL_ALL)
-			break;
+		if (msg->asid == asid)
+			tlb_message_process(msg);
+		else
+			CPU->tlb_deferred[kept++] = *msg;
 	}
 
-	CPU->tlb_messages_count = 0;
+	CPU->tlb_deferred_count = kept;
 	irq_spinlock_unlock(&CPU->lock, false);
-	CPU->tlb_active = true;
 }
 
 #endif /* CONFIG_SMP */
@@ -34,12 +34,14 @@
  * @file
  * @brief Scheduler and load balancing.
  *
- * This file contains the scheduler and kcpulb kernel thread which
- * performs load-balancing of per-CPU run queues.
+ * This file contains the scheduler. Load-balancing of per-CPU run
+ * queues is done by idle CPUs, which steal ready threads from
+ * the busiest of the other CPUs before they go to sleep.
  */
 
 #include <assert.h>
 #include <atomic.h>
+#include <bitops.h>
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
@@ -172,6 +174,117 @@ void scheduler_init(void)
 {
 }
 
+#ifdef CONFIG_SMP
+/** Choose a CPU to steal work from
+ *
+ * The busiest active CPU is chosen. Among equally busy CPUs, the one
+ * with the closest following ID is preferred. This is a cheap topology
+ * hint: hardware threads and cores of one package are usually numbered
+ * consecutively and share some of their caches.
+ *
+ * @return CPU with ready threads or NULL if all other CPUs are idle.
+ *
+ */
+static cpu_t *steal_victim(void)
+{
+	cpu_t *victim = NULL;
+	size_t victim_nrdy = 0;
+
+	for (size_t d = 1; d < config.cpu_active; d++) {
+		cpu_t *cpu = &cpus[(CPU->id + d) % config.cpu_active];
+
+		size_t rdy = atomic_load(&cpu->nrdy);
+		if (rdy > victim_nrdy) {
+			victim = cpu;
+			victim_nrdy = rdy;
+		}
+	}
+
+	return victim;
+}
+
+/** Steal a ready thread from another CPU
+ *
+ * Search the run queues of @a cpu from the lowest priority and take
+ * the last thread which is allowed to migrate.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param cpu CPU to steal from.
+ *
+ * @return Stolen thread in the Entering state or NULL if there is no
+ *         thread to steal.
+ *
+ */
+static thread_t *steal_thread(cpu_t *cpu)
+{
+	unsigned int occupied = atomic_load(&cpu->rq_occupied);
+
+	while (occupied != 0) {
+		/* The highest set bit denotes the lowest-priority queue. */
+		unsigned int rq = fnzb32(occupied);
+		occupied &= ~(1U << rq);
+
+		irq_spinlock_lock(&(cpu->rq[rq].lock), false);
+
+		/* Search rq from the back */
+		link_t *link = cpu->rq[rq].rq.head.prev;
+
+		while (link != &(cpu->rq[rq].rq.head)) {
+			thread_t *thread = list_get_instance(link, thread_t,
+			    rq_link);
+
+			/*
+			 * Do not steal CPU-wired threads, threads already
+			 * stolen, threads for which migration was temporarily
+			 * disabled or threads whose FPU context is still in
+			 * the CPU.
+			 */
+			irq_spinlock_lock(&thread->lock, false);
+
+			if ((!thread->wired) && (!thread->stolen) &&
+			    (!thread->nomigrate) &&
+			    (!thread->fpu_context_engaged)) {
+				/*
+				 * Remove thread from ready queue.
+				 */
+				atomic_dec(&cpu->nrdy);
+				atomic_dec(&nrdy);
+
+				if (--cpu->rq[rq].n == 0) {
+					atomic_fetch_and(&cpu->rq_occupied,
+					    ~(1U << rq));
+				}
+				list_remove(&thread->rq_link);
+
+				irq_spinlock_unlock(&(cpu->rq[rq].lock), false);
+
+#ifdef SCHEDULER_VERBOSE
+				log(LF_OTHER, LVL_DEBUG,
+				    "cpu%u: stealing tid %" PRIu64 " from "
+				    "cpu%u, nrdy=%zu", CPU->id, thread->tid,
+				    cpu->id, atomic_load(&cpu->nrdy));
+#endif
+
+				thread->stolen = true;
+				thread->state = Entering;
+
+				irq_spinlock_unlock(&thread->lock, false);
+				return thread;
+			}
+
+			irq_spinlock_unlock(&thread->lock, false);
+
+			link = link->prev;
+		}
+
+		irq_spinlock_unlock(&(cpu->rq[rq].lock), false);
+	}
+
+	return NULL;
+}
+#endif /* CONFIG_SMP */
+
 /** Get thread to be scheduled
  *
  * Get the optimal thread to be scheduled
@@ -188,6 +301,22 @@ static thread_t *find_best_thread(void)
 loop:
 
 	if (atomic_load(&CPU->nrdy) == 0) {
+#ifdef CONFIG_SMP
+		/*
+		 * Before going idle, try to steal a thread from
+		 * the busiest of the other CPUs.
+		 */
+		cpu_t *victim = steal_victim();
+		if (victim != NULL) {
+			thread_t *thread = steal_thread(victim);
+			if (thread != NULL) {
+				CPU->steals++;
+				thread_ready(thread);
+				goto loop;
+			}
+		}
+#endif /* CONFIG_SMP */
+
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
@@ -210,12 +339,24 @@ loop:
 
 	assert(!CPU->idle);
 
-	unsigned int i;
-	for (i = 0; i < RQ_COUNT; i++) {
+	CPU->rq_picks++;
+
+	unsigned int occupied;
+	while ((occupied = atomic_load(&CPU->rq_occupied)) != 0) {
+		/*
+		 * The lowest set bit denotes the highest-priority
+		 * non-empty queue.
+		 */
+		unsigned int i = fnzb32(occupied & -occupied);
+
+		CPU->rq_probes++;
+
 		irq_spinlock_lock(&(CPU->rq[i].lock), false);
 		if (CPU->rq[i].n == 0) {
 			/*
-			 * If this queue is empty, try a lower-priority queue.
+			 * The queue has been emptied since we looked at
+			 * the bitmap (e.g. by load balancing). Its bit
+			 * has been cleared, so just look again.
 			 */
 			irq_spinlock_unlock(&(CPU->rq[i].lock), false);
 			continue;
@@ -223,7 +364,8 @@ loop:
 
 		atomic_dec(&CPU->nrdy);
 		atomic_dec(&nrdy);
-		CPU->rq[i].n--;
+		if (--CPU->rq[i].n == 0)
+			atomic_fetch_and(&CPU->rq_occupied, ~(1U << i));
 
 		/*
 		 * Take the first thread from the queue.
@@ -278,6 +420,7 @@ static void relink_rq(int start)
 			list_concat(&list, &CPU->rq[i + 1].rq);
 			size_t n = CPU->rq[i + 1].n;
 			CPU->rq[i + 1].n = 0;
+			atomic_fetch_and(&CPU->rq_occupied, ~(1U << (i + 1)));
 			irq_spinlock_unlock(&CPU->rq[i + 1].lock, false);
 
 			/* Append rq[i + 1] to rq[i] */
@@ -285,6 +428,8 @@ static void relink_rq(int start)
 			irq_spinlock_lock(&CPU->rq[i].lock, false);
 			list_concat(&CPU->rq[i].rq, &list);
 			CPU->rq[i].n += n;
+			if (CPU->rq[i].n > 0)
+				atomic_fetch_or(&CPU->rq_occupied, 1U << i);
 			irq_spinlock_unlock(&CPU->rq[i].lock, false);
 		}
 
@@ -401,10 +546,15 @@ void scheduler_separated_stack(void)
 	if (old_as)
 		as_hold(old_as);
 
+	/* Rest of the time slice, given to a thread run through handoff */
+	uint64_t donated = 0;
+
 	if (THREAD) {
 		/* Must be run after the switch to scheduler stack */
 		after_thread_ran();
 
+		donated = THREAD->ticks;
+
 		switch (THREAD->state) {
 		case Running:
 			irq_spinlock_unlock(&THREAD->lock, false);
@@ -468,7 +618,20 @@ void scheduler_separated_stack(void)
 		THREAD = NULL;
 	}
 
-	THREAD = find_best_thread();
+	if (CPU->handoff != NULL) {
+		/*
+		 * A thread has been handed over to this CPU, run it
+		 * without going through the run queues.
+		 */
+		THREAD = CPU->handoff;
+		CPU->handoff = NULL;
+		CPU->handoffs++;
+
+		irq_spinlock_lock(&THREAD->lock, false);
+		THREAD->ticks = (donated > 0) ? donated : us2ticks(10000);
+		irq_spinlock_unlock(&THREAD->lock, false);
+	} else
+		THREAD = find_best_thread();
 
 	irq_spinlock_lock(&THREAD->lock, false);
 	int priority = THREAD->priority;
@@ -536,177 +699,6 @@ void scheduler_separated_stack(void)
 	/* Not reached */
 }
 
-#ifdef CONFIG_SMP
-/** Load balancing thread
- *
- * SMP load balancing thread, supervising thread supplies
- * for the CPU it's wired to.
- *
- * @param arg Generic thread argument (unused).
- *
- */
-void kcpulb(void *arg)
-{
-	size_t average;
-	size_t rdy;
-
-	/*
-	 * Detach kcpulb as nobody will call thread_join_timeout() on it.
-	 */
-	thread_detach(THREAD);
-
-loop:
-	/*
-	 * Work in 1s intervals.
-	 */
-	thread_sleep(1);
-
-not_satisfied:
-	/*
-	 * Calculate the number of threads that will be migrated/stolen from
-	 * other CPU's. Note that situation can have changed between two
-	 * passes. Each time get the most up to date counts.
-	 *
-	 */
-	average = atomic_load(&nrdy) / config.cpu_active + 1;
-	rdy = atomic_load(&CPU->nrdy);
-
-	if (average <= rdy)
-		goto satisfied;
-
-	size_t count = average - rdy;
-
-	/*
-	 * Searching least priority queues on all CPU's first and most priority
-	 * queues on all CPU's last.
-	 */
-	size_t acpu;
-	size_t acpu_bias = 0;
-	int rq;
-
-	for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
-		for (acpu = 0; acpu < config.cpu_active; acpu++) {
-			cpu_t *cpu = &cpus[(acpu + acpu_bias) % config.cpu_active];
-
-			/*
-			 * Not interested in ourselves.
-			 * Doesn't require interrupt disabling for kcpulb has
-			 * THREAD_FLAG_WIRED.
-			 *
-			 */
-			if (CPU == cpu)
-				continue;
-
-			if (atomic_load(&cpu->nrdy) <= average)
-				continue;
-
-			irq_spinlock_lock(&(cpu->rq[rq].lock), true);
-			if (cpu->rq[rq].n == 0) {
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-				continue;
-			}
-
-			thread_t *thread = NULL;
-
-			/* Search rq from the back */
-			link_t *link = cpu->rq[rq].rq.head.prev;
-
-			while (link != &(cpu->rq[rq].rq.head)) {
-				thread = (thread_t *) list_get_instance(link,
-				    thread_t, rq_link);
-
-				/*
-				 * Do not steal CPU-wired threads, threads
-				 * already stolen, threads for which migration
-				 * was temporarily disabled or threads whose
-				 * FPU context is still in the CPU.
-				 */
-				irq_spinlock_lock(&thread->lock, false);
-
-				if ((!thread->wired) && (!thread->stolen) &&
-				    (!thread->nomigrate) &&
-				    (!thread->fpu_context_engaged)) {
-					/*
-					 * Remove thread from ready queue.
-					 */
-					irq_spinlock_unlock(&thread->lock,
-					    false);
-
-					atomic_dec(&cpu->nrdy);
-					atomic_dec(&nrdy);
-
-					cpu->rq[rq].n--;
-					list_remove(&thread->rq_link);
-
-					break;
-				}
-
-				irq_spinlock_unlock(&thread->lock, false);
-
-				link = link->prev;
-				thread = NULL;
-			}
-
-			if (thread) {
-				/*
-				 * Ready thread on local CPU
-				 */
-
-				irq_spinlock_pass(&(cpu->rq[rq].lock),
-				    &thread->lock);
-
-#ifdef KCPULB_VERBOSE
-				log(LF_OTHER, LVL_DEBUG,
-				    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
-				    "nrdy=%ld, avg=%ld", CPU->id, thread->tid,
-				    CPU->id, atomic_load(&CPU->nrdy),
-				    atomic_load(&nrdy) / config.cpu_active);
-#endif
-
-				thread->stolen = true;
-				thread->state = Entering;
-
-				irq_spinlock_unlock(&thread->lock, true);
-				thread_ready(thread);
-
-				if (--count == 0)
-					goto satisfied;
-
-				/*
-				 * We are not satisfied yet, focus on another
-				 * CPU next time.
-				 *
-				 */
-				acpu_bias++;
-
-				continue;
-			} else
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-
-		}
-	}
-
-	if (atomic_load(&CPU->nrdy)) {
-		/*
-		 * Be a little bit light-weight and let migrated threads run.
-		 *
-		 */
-		scheduler();
-	} else {
-		/*
-		 * We failed to migrate a single thread.
-		 * Give up this turn.
-		 *
-		 */
-		goto loop;
-	}
-
-	goto not_satisfied;
-
-satisfied:
-	goto loop;
-}
-#endif /* CONFIG_SMP */
 
 /** Print information about threads & scheduler queues
  *
@@ -724,6 +716,15 @@ void sched_print_list(void)
 		    cpus[cpu].id, &cpus[cpu], atomic_load(&cpus[cpu].nrdy),
 		    cpus[cpu].needs_relink);
 
+		uint64_t picks = cpus[cpu].rq_picks;
+		uint64_t probes = cpus[cpu].rq_probes;
+		printf("\trq picks=%" PRIu64 ", probes=%" PRIu64
+		    ", probes/pick=%" PRIu64 ".%02" PRIu64 ", steals=%"
+		    PRIu64 "\n", picks, probes,
+		    picks ? probes / picks : 0,
+		    picks ? (probes * 100 / picks) % 100 : 0,
+		    cpus[cpu].steals);
+
 		unsigned int i;
 		for (i = 0; i < RQ_COUNT; i++) {
 			irq_spinlock_lock(&(cpus[cpu].rq[i].lock), false);
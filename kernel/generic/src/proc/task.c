@@ -699,6 +699,29 @@ void task_print_list(bool additional)
 	irq_spinlock_unlock(&tasks_lock, true);
 }
 
+/** Print contention statistics of the mutexes of all tasks. */
+void task_print_mutexes(void)
+{
+	/* Messing with task structures, avoid deadlock */
+	irq_spinlock_lock(&tasks_lock, true);
+
+	printf("[id    ] [name        ] [mutex   ] [acquired  ] [spun      ]"
+	    " [slept     ]\n");
+
+	task_t *task = task_first();
+	while (task != NULL) {
+		printf("%-8" PRIu64 " %-14s ", task->taskid, task->name);
+		mutex_print_stats("as", &task->as->lock);
+
+		printf("%-8" PRIu64 " %-14s ", task->taskid, task->name);
+		mutex_print_stats("caps", &task->cap_info->lock);
+
+		task = task_next(task);
+	}
+
+	irq_spinlock_unlock(&tasks_lock, true);
+}
+
 /** Get key function for the @c tasks ordered dictionary.
  *
  * @param odlink Link
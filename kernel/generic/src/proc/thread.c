@@ -240,8 +240,12 @@ void thread_init(void)
 	THREAD = NULL;
 
 	atomic_store(&nrdy, 0);
+	/*
+	 * Thread structures are type-safe so that mutex_spin() can inspect
+	 * the state of a mutex owner without holding a reference to it.
+	 */
 	thread_cache = slab_cache_create("thread_t", sizeof(thread_t), 0,
-	    thr_constructor, thr_destructor, 0);
+	    thr_constructor, thr_destructor, SLAB_CACHE_TYPESAFE);
 
 #ifdef CONFIG_FPU
 	fpu_context_cache = slab_cache_create("fpu_context_t",
@@ -314,13 +318,81 @@ void thread_ready(thread_t *thread)
 	 */
 
 	list_append(&thread->rq_link, &cpu->rq[i].rq);
-	cpu->rq[i].n++;
+	if (cpu->rq[i].n++ == 0)
+		atomic_fetch_or(&cpu->rq_occupied, 1U << i);
 	irq_spinlock_unlock(&(cpu->rq[i].lock), true);
 
 	atomic_inc(&nrdy);
 	atomic_inc(&cpu->nrdy);
 }
 
+/** Make thread ready to run next on the current CPU
+ *
+ * The thread does not enter any run queue. Instead, the next invocation of
+ * the scheduler on the current CPU switches to it and the thread inherits
+ * the rest of the time slice of the current thread. This is meant for
+ * threads woken up by a userspace thread which is about to block or yield,
+ * e.g. a server thread receiving a request in ipc_wait_for_call().
+ *
+ * If the current thread is not a userspace thread, if another thread is
+ * already waiting for a handoff or if the thread cannot run on the current
+ * CPU, the thread is readied normally.
+ *
+ * @param thread Thread to make ready.
+ *
+ */
+void thread_ready_handoff(thread_t *thread)
+{
+	ipl_t ipl = interrupts_disable();
+
+	if ((CPU == NULL) || (THREAD == NULL) || (!THREAD->uspace) ||
+	    (CPU->handoff != NULL)) {
+		interrupts_restore(ipl);
+		thread_ready(thread);
+		return;
+	}
+
+	irq_spinlock_lock(&thread->lock, false);
+
+	if ((thread->wired || thread->nomigrate ||
+	    thread->fpu_context_engaged) && (thread->cpu != CPU)) {
+		irq_spinlock_unlock(&thread->lock, false);
+		interrupts_restore(ipl);
+		thread_ready(thread);
+		return;
+	}
+
+	assert(thread->state != Ready);
+
+	before_thread_is_ready(thread);
+
+	if (thread->priority < RQ_COUNT - 1)
+		thread->priority++;
+
+	thread->cpu = CPU;
+	thread->state = Ready;
+	CPU->handoff = thread;
+
+	irq_spinlock_unlock(&thread->lock, false);
+	interrupts_restore(ipl);
+}
+
+/** Switch to the thread handed over to the current CPU, if any
+ *
+ * The current thread is readied and gives the rest of its time slice
+ * to the thread readied by thread_ready_handoff().
+ *
+ */
+void thread_handoff(void)
+{
+	ipl_t ipl = interrupts_disable();
+	bool pending = (CPU->handoff != NULL);
+	interrupts_restore(ipl);
+
+	if (pending)
+		scheduler();
+}
+
 /** Create new thread
  *
  * Create a new thread.
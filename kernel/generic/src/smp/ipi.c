@@ -59,6 +59,18 @@ void ipi_broadcast(int ipi)
 		ipi_broadcast_arch(ipi);
 }
 
+/** Send IPI message to one CPU
+ *
+ * @param cpu Index of the destination CPU in the cpus array.
+ * @param ipi Message to send.
+ *
+ */
+void ipi_unicast(unsigned int cpu, int ipi)
+{
+	if (config.cpu_count > 1)
+		ipi_unicast_arch(cpu, ipi);
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Lock contention profiling.
+ *
+ * Locks are grouped into classes by their name. The class of a lock is
+ * looked up in an open-addressing table when the lock is first acquired
+ * and cached in the lock afterwards. Each CPU accumulates the profile of
+ * every class separately, so that profiling does not add any contention
+ * of its own.
+ */
+
+#include <synch/lockprof.h>
+#include <arch.h>
+#include <arch/asm.h>
+#include <arch/cycle.h>
+#include <config.h>
+#include <cpu.h>
+#include <str.h>
+
+#ifdef CONFIG_LOCK_PROFILE
+
+/** Names of the lock classes, NULL for unused classes */
+static const char *_Atomic lock_prof_names[LOCK_PROF_CLASSES];
+
+/** Class of the locks which do not fit into the table */
+#define LOCK_PROF_OVERFLOW  0
+
+/** Find or create the class of locks with a given name.
+ *
+ * @param name  Lock name.
+ *
+ * @return Class index.
+ *
+ */
+static size_t lock_prof_class(const char *name)
+{
+	size_t hash = 0;
+	for (const char *c = name; *c != 0; c++)
+		hash = hash * 31 + (uint8_t) *c;
+
+	for (size_t i = 0; i < LOCK_PROF_CLASSES - 1; i++) {
+		size_t cls = 1 + (hash + i) % (LOCK_PROF_CLASSES - 1);
+		const char *cur = atomic_load_explicit(&lock_prof_names[cls],
+		    memory_order_acquire);
+
+		if (cur == NULL) {
+			if (atomic_compare_exchange_strong_explicit(
+			    &lock_prof_names[cls], &cur, name,
+			    memory_order_acq_rel, memory_order_acquire))
+				return cls;
+		}
+
+		if ((cur == name) || (str_cmp(cur, name) == 0))
+			return cls;
+	}
+
+	return LOCK_PROF_OVERFLOW;
+}
+
+/** Record acquisition of a lock.
+ *
+ * @param cls        Cached class of the lock plus one, zero if the class
+ *                   was not looked up yet.
+ * @param name       Lock name.
+ * @param contended  True if the lock was held by someone else.
+ * @param spin       Number of cycles spent waiting for the lock.
+ *
+ */
+void lock_prof_acquire(size_t *cls, const char *name, bool contended,
+    uint64_t spin)
+{
+	if (*cls == 0) {
+		if (name == NULL)
+			name = "(unnamed)";
+
+		*cls = lock_prof_class(name) + 1;
+	}
+
+	ipl_t ipl = interrupts_disable();
+
+	if (CPU != NULL) {
+		lock_prof_t *prof = &CPU->lock_prof[*cls - 1];
+
+		prof->acquisitions++;
+		if (contended) {
+			prof->contended++;
+			prof->spin_cycles += spin;
+		}
+	}
+
+	interrupts_restore(ipl);
+}
+
+/** Record release of a lock.
+ *
+ * @param cls   Cached class of the lock plus one.
+ * @param hold  Number of cycles the lock was held.
+ *
+ */
+void lock_prof_release(size_t cls, uint64_t hold)
+{
+	if (cls == 0)
+		return;
+
+	ipl_t ipl = interrupts_disable();
+
+	if (CPU != NULL)
+		CPU->lock_prof[cls - 1].hold_cycles += hold;
+
+	interrupts_restore(ipl);
+}
+
+/** Get the profile of a class of locks summed over all CPUs.
+ *
+ * The per-CPU profiles are read without synchronization, so the result
+ * is only approximate.
+ *
+ * @param cls   Class index.
+ * @param name  Place to store the name of the class.
+ * @param prof  Place to store the profile.
+ *
+ * @return False if the class is not used.
+ *
+ */
+bool lock_prof_get(size_t cls, const char **name, lock_prof_t *prof)
+{
+	if (cls == LOCK_PROF_OVERFLOW)
+		*name = "(overflow)";
+	else
+		*name = atomic_load_explicit(&lock_prof_names[cls],
+		    memory_order_acquire);
+
+	prof->acquisitions = 0;
+	prof->contended = 0;
+	prof->spin_cycles = 0;
+	prof->hold_cycles = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		prof->acquisitions += cpus[i].lock_prof[cls].acquisitions;
+		prof->contended += cpus[i].lock_prof[cls].contended;
+		prof->spin_cycles += cpus[i].lock_prof[cls].spin_cycles;
+		prof->hold_cycles += cpus[i].lock_prof[cls].hold_cycles;
+	}
+
+	return ((*name != NULL) && (prof->acquisitions > 0));
+}
+
+#endif /* CONFIG_LOCK_PROFILE */
+
+/** @}
+ */
@@ -37,12 +37,34 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <synch/mutex.h>
+#include <synch/lockprof.h>
 #include <synch/semaphore.h>
 #include <arch.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <config.h>
+#include <print.h>
 #include <proc/thread.h>
+#include <arch/cycle.h>
+
+#ifdef CONFIG_LOCK_PROFILE
+
+/** Mutexes have no names, so they are profiled by their type */
+static const char *mutex_prof_names[] = {
+	[MUTEX_PASSIVE] = "mutex (passive)",
+	[MUTEX_RECURSIVE] = "mutex (recursive)",
+	[MUTEX_ACTIVE] = "mutex (active)"
+};
+
+static size_t mutex_prof_class[] = {
+	[MUTEX_PASSIVE] = 0,
+	[MUTEX_RECURSIVE] = 0,
+	[MUTEX_ACTIVE] = 0
+};
+
+#endif /* CONFIG_LOCK_PROFILE */
 
 /** Initialize mutex.
  *
@@ -54,6 +76,12 @@ void mutex_initialize(mutex_t *mtx, mutex_type_t type)
 	mtx->type = type;
 	mtx->owner = NULL;
 	mtx->nesting = 0;
+	mtx->acquisitions = 0;
+	mtx->spins = 0;
+	mtx->sleeps = 0;
+#ifdef CONFIG_LOCK_PROFILE
+	mtx->prof_acquired = 0;
+#endif
 	semaphore_initialize(&mtx->sem, 1);
 }
 
@@ -70,6 +98,98 @@ bool mutex_locked(mutex_t *mtx)
 
 #define MUTEX_DEADLOCK_THRESHOLD	100000000
 
+/** Maximum number of iterations spent spinning on a passive mutex */
+#define MUTEX_SPIN_THRESHOLD	4096
+
+/** Spin on a contended mutex while its owner is running.
+ *
+ * Mutexes are mostly held only for a short time by a thread running on
+ * another CPU. In that case it is cheaper to wait for the owner to release
+ * the mutex than to go to sleep and be woken up again. Spinning stops as
+ * soon as the owner is not running anymore or the spin threshold is
+ * reached.
+ *
+ * The owner is inspected without holding any reference to it. This is
+ * safe since thread structures are allocated from a type-safe slab cache.
+ *
+ * @param mtx  Mutex.
+ *
+ * @return True if the mutex was acquired, false if the caller should
+ *         go to sleep.
+ *
+ */
+static bool mutex_spin(mutex_t *mtx)
+{
+	if (config.cpu_active < 2)
+		return false;
+
+	for (unsigned int i = 0; i < MUTEX_SPIN_THRESHOLD; i++) {
+		thread_t *owner = atomic_load_explicit(&mtx->owner,
+		    memory_order_relaxed);
+
+		if (owner == NULL) {
+			if (semaphore_trydown(&mtx->sem) == EOK)
+				return true;
+		} else if ((owner == THREAD) || (owner->state != Running) ||
+		    (owner->cpu == CPU)) {
+			return false;
+		}
+	}
+
+	return false;
+}
+
+/** Acquire passive mutex.
+ *
+ * The mutex is first acquired by spinning if the owner is running on
+ * another CPU. Only if that fails, the thread goes to sleep.
+ *
+ * @param mtx    Mutex.
+ * @param usec   Timeout in microseconds.
+ * @param flags  Specify mode of operation.
+ *
+ * @return See comment for waitq_sleep_timeout().
+ *
+ */
+static errno_t mutex_lock_passive(mutex_t *mtx, uint32_t usec,
+    unsigned int flags)
+{
+	errno_t rc = semaphore_trydown(&mtx->sem);
+
+#ifdef CONFIG_LOCK_PROFILE
+	bool contended = (rc != EOK);
+	uint64_t wait_start = contended ? get_cycle() : 0;
+#endif
+
+	if ((rc != EOK) && ((usec != SYNCH_NO_TIMEOUT) ||
+	    !(flags & SYNCH_FLAGS_NON_BLOCKING))) {
+		if (mutex_spin(mtx)) {
+			rc = EOK;
+			mtx->spins++;
+		} else {
+			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+			if (rc == EOK)
+				mtx->sleeps++;
+		}
+	}
+
+	if (rc == EOK) {
+		atomic_store_explicit(&mtx->owner, THREAD,
+		    memory_order_relaxed);
+		mtx->acquisitions++;
+
+#ifdef CONFIG_LOCK_PROFILE
+		uint64_t now = get_cycle();
+		lock_prof_acquire(&mutex_prof_class[mtx->type],
+		    mutex_prof_names[mtx->type], contended,
+		    contended ? now - wait_start : 0);
+		mtx->prof_acquired = now;
+#endif
+	}
+
+	return rc;
+}
+
 /** Acquire mutex.
  *
  * Timeout mode and non-blocking mode can be requested.
@@ -89,7 +209,7 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 	errno_t rc;
 
 	if (mtx->type == MUTEX_PASSIVE && THREAD) {
-		rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+		rc = mutex_lock_passive(mtx, usec, flags);
 	} else if (mtx->type == MUTEX_RECURSIVE) {
 		assert(THREAD);
 
@@ -97,11 +217,9 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 			mtx->nesting++;
 			return EOK;
 		} else {
-			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
-			if (rc == EOK) {
-				mtx->owner = THREAD;
+			rc = mutex_lock_passive(mtx, usec, flags);
+			if (rc == EOK)
 				mtx->nesting = 1;
-			}
 		}
 	} else {
 		assert((mtx->type == MUTEX_ACTIVE) || !THREAD);
@@ -137,10 +255,33 @@ void mutex_unlock(mutex_t *mtx)
 		assert(mtx->owner == THREAD);
 		if (--mtx->nesting > 0)
 			return;
-		mtx->owner = NULL;
 	}
+
+	if (mtx->type != MUTEX_ACTIVE)
+		atomic_store_explicit(&mtx->owner, NULL, memory_order_relaxed);
+
+#ifdef CONFIG_LOCK_PROFILE
+	if (mtx->prof_acquired != 0) {
+		lock_prof_release(mutex_prof_class[mtx->type],
+		    get_cycle() - mtx->prof_acquired);
+		mtx->prof_acquired = 0;
+	}
+#endif
+
 	semaphore_up(&mtx->sem);
 }
 
+/** Print contention statistics of a mutex.
+ *
+ * @param name  Name of the mutex.
+ * @param mtx   Mutex.
+ *
+ */
+void mutex_print_stats(const char *name, mutex_t *mtx)
+{
+	printf("%-10s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n", name,
+	    mtx->acquisitions, mtx->spins, mtx->sleeps);
+}
+
 /** @}
  */
@@ -35,7 +35,9 @@
  * @brief Spinlocks.
  */
 
+#include <stdint.h>
 #include <synch/spinlock.h>
+#include <synch/lockprof.h>
 #include <atomic.h>
 #include <barrier.h>
 #include <arch.h>
@@ -45,6 +47,7 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <arch/cycle.h>
 
 #ifdef CONFIG_SMP
 
@@ -56,29 +59,48 @@
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
 	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_INSTRUMENTED
 	lock->name = name;
 #endif
+#ifdef CONFIG_LOCK_PROFILE
+	lock->prof_class = 0;
+	lock->prof_acquired = 0;
+#endif
 }
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_INSTRUMENTED
 
 /** Lock spinlock
  *
  * Lock spinlock.
  * This version has limitted ability to report
- * possible occurence of deadlock.
+ * possible occurence of deadlock and records
+ * the lock profile.
  *
  * @param lock Pointer to spinlock_t structure.
  *
  */
 void spinlock_lock_debug(spinlock_t *lock)
 {
+#ifdef CONFIG_DEBUG_SPINLOCK
 	size_t i = 0;
 	bool deadlock_reported = false;
+#endif
+#ifdef CONFIG_LOCK_PROFILE
+	bool contended = false;
+	uint64_t spin_start = 0;
+#endif
 
 	preemption_disable();
 	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+#ifdef CONFIG_LOCK_PROFILE
+		if (!contended) {
+			contended = true;
+			spin_start = get_cycle();
+		}
+#endif
+
+#ifdef CONFIG_DEBUG_SPINLOCK
 		/*
 		 * We need to be careful about particular locks
 		 * which are directly used to report deadlocks
@@ -110,10 +132,20 @@ void spinlock_lock_debug(spinlock_t *lock)
 			i = 0;
 			deadlock_reported = true;
 		}
+#endif
 	}
 
+#ifdef CONFIG_DEBUG_SPINLOCK
 	if (deadlock_reported)
 		printf("cpu%u: not deadlocked\n", CPU->id);
+#endif
+
+#ifdef CONFIG_LOCK_PROFILE
+	uint64_t now = get_cycle();
+	lock_prof_acquire(&lock->prof_class, lock->name, contended,
+	    contended ? now - spin_start : 0);
+	lock->prof_acquired = now;
+#endif
 }
 
 /** Unlock spinlock
@@ -126,6 +158,10 @@ void spinlock_unlock_debug(spinlock_t *lock)
 {
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 
+#ifdef CONFIG_LOCK_PROFILE
+	lock_prof_release(lock->prof_class, get_cycle() - lock->prof_acquired);
+#endif
+
 	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
 	preemption_enable();
 }
@@ -150,6 +186,13 @@ bool spinlock_trylock(spinlock_t *lock)
 	if (!ret)
 		preemption_enable();
 
+#ifdef CONFIG_LOCK_PROFILE
+	if (ret) {
+		lock_prof_acquire(&lock->prof_class, lock->name, false, 0);
+		lock->prof_acquired = get_cycle();
+	}
+#endif
+
 	return ret;
 }
 
@@ -92,6 +92,13 @@ sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	if (THREAD->interrupted)
 		thread_exit();
 
+	/*
+	 * Switch directly to a thread woken up by the system call, e.g.
+	 * the server thread which received an IPC call or the client
+	 * thread which received an answer.
+	 */
+	thread_handoff();
+
 #ifdef CONFIG_UDEBUG
 	if (THREAD->udebug.active) {
 		udebug_syscall_event(a1, a2, a3, a4, a5, a6, id, rc, true);
@@ -154,11 +161,13 @@ syshandler_t syscall_table[SYSCALL_END] = {
 	/* IPC related syscalls. */
 	[SYS_IPC_CALL_ASYNC_FAST] = (syshandler_t) sys_ipc_call_async_fast,
 	[SYS_IPC_CALL_ASYNC_SLOW] = (syshandler_t) sys_ipc_call_async_slow,
+	[SYS_IPC_CALL_ASYNC_BATCH] = (syshandler_t) sys_ipc_call_async_batch,
 	[SYS_IPC_ANSWER_FAST] = (syshandler_t) sys_ipc_answer_fast,
 	[SYS_IPC_ANSWER_SLOW] = (syshandler_t) sys_ipc_answer_slow,
 	[SYS_IPC_FORWARD_FAST] = (syshandler_t) sys_ipc_forward_fast,
 	[SYS_IPC_FORWARD_SLOW] = (syshandler_t) sys_ipc_forward_slow,
 	[SYS_IPC_WAIT] = (syshandler_t) sys_ipc_wait_for_call,
+	[SYS_IPC_WAIT_BATCH] = (syshandler_t) sys_ipc_wait_batch,
 	[SYS_IPC_POKE] = (syshandler_t) sys_ipc_poke,
 	[SYS_IPC_HANGUP] = (syshandler_t) sys_ipc_hangup,
 	[SYS_IPC_CONNECT_KBOX] = (syshandler_t) sys_ipc_connect_kbox,
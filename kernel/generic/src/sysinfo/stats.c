@@ -41,6 +41,7 @@
 #include <sysinfo/sysinfo.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
+#include <synch/lockprof.h>
 #include <time/clock.h>
 #include <mm/frame.h>
 #include <proc/task.h>
@@ -117,6 +118,11 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 		stats_cpus[i].frequency_mhz = cpus[i].frequency_mhz;
 		stats_cpus[i].busy_cycles = cpus[i].busy_cycles;
 		stats_cpus[i].idle_cycles = cpus[i].idle_cycles;
+		stats_cpus[i].steals = cpus[i].steals;
+		stats_cpus[i].handoffs = cpus[i].handoffs;
+		stats_cpus[i].tlb_shootdowns = cpus[i].tlb_shootdowns;
+		stats_cpus[i].tlb_ipis = cpus[i].tlb_ipis;
+		stats_cpus[i].tlb_interrupted = cpus[i].tlb_interrupted;
 
 		irq_spinlock_unlock(&cpus[i].lock, true);
 	}
@@ -560,6 +566,61 @@ static void *get_stats_exceptions(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_exceptions);
 }
 
+#ifdef CONFIG_LOCK_PROFILE
+
+/** Get lock profiles
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_lock_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_locks(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	const char *name;
+	lock_prof_t prof;
+
+	size_t count = 0;
+	for (size_t i = 0; i < LOCK_PROF_CLASSES; i++) {
+		if (lock_prof_get(i, &name, &prof))
+			count++;
+	}
+
+	*size = sizeof(stats_lock_t) * count;
+	if ((dry_run) || (count == 0))
+		return NULL;
+
+	stats_lock_t *stats_locks = (stats_lock_t *) malloc(*size);
+	if (stats_locks == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	/* New classes may appear meanwhile, so do not overrun the buffer */
+	size_t j = 0;
+	for (size_t i = 0; (i < LOCK_PROF_CLASSES) && (j < count); i++) {
+		if (!lock_prof_get(i, &name, &prof))
+			continue;
+
+		str_cpy(stats_locks[j].name, LOCK_NAME_BUFLEN, name);
+		stats_locks[j].acquisitions = prof.acquisitions;
+		stats_locks[j].contended = prof.contended;
+		stats_locks[j].spin_cycles = prof.spin_cycles;
+		stats_locks[j].hold_cycles = prof.hold_cycles;
+		j++;
+	}
+
+	*size = sizeof(stats_lock_t) * j;
+	return ((void *) stats_locks);
+}
+
+#endif /* CONFIG_LOCK_PROFILE */
+
 /** Get exception statistics
  *
  * Get statistics of a given exception. The exception number
@@ -754,6 +815,9 @@ void stats_init(void)
 	sysinfo_set_item_gen_data("system.tasks", NULL, get_stats_tasks, NULL);
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
 	sysinfo_set_item_gen_data("system.exceptions", NULL, get_stats_exceptions, NULL);
+#ifdef CONFIG_LOCK_PROFILE
+	sysinfo_set_item_gen_data("system.locks", NULL, get_stats_locks, NULL);
+#endif
 	sysinfo_set_subtree_fn("system.tasks", NULL, get_stats_task, NULL);
 	sysinfo_set_subtree_fn("system.threads", NULL, get_stats_thread, NULL);
 	sysinfo_set_subtree_fn("system.exceptions", NULL, get_stats_exception, NULL);
@@ -161,33 +161,7 @@ void clock(void)
 		clock_update_counters();
 		cpu_update_accounting();
 
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-
-		link_t *cur;
-		while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-			timeout_t *timeout = list_get_instance(cur, timeout_t,
-			    link);
-
-			irq_spinlock_lock(&timeout->lock, false);
-			if (timeout->ticks-- != 0) {
-				irq_spinlock_unlock(&timeout->lock, false);
-				break;
-			}
-
-			list_remove(cur);
-			timeout_handler_t handler = timeout->handler;
-			void *arg = timeout->arg;
-			timeout_reinitialize(timeout);
-
-			irq_spinlock_unlock(&timeout->lock, false);
-			irq_spinlock_unlock(&CPU->timeoutlock, false);
-
-			handler(arg);
-
-			irq_spinlock_lock(&CPU->timeoutlock, false);
-		}
-
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
+		timeout_tick();
 	}
 	CPU->missed_clock_ticks = 0;
 
@@ -44,6 +44,13 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <assert.h>
+
+/** Largest number of ticks the timing wheel can schedule ahead. */
+#define TIMEOUT_WHEEL_SPAN \
+	((UINT64_C(1) << (TIMEOUT_WHEEL_BITS * TIMEOUT_WHEEL_LEVELS)) - 1)
+
+#define TIMEOUT_WHEEL_MASK  (TIMEOUT_WHEEL_SLOTS - 1)
 
 /** Initialize timeouts
  *
@@ -53,7 +60,13 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+
+	for (unsigned int l = 0; l < TIMEOUT_WHEEL_LEVELS; l++) {
+		for (unsigned int s = 0; s < TIMEOUT_WHEEL_SLOTS; s++)
+			list_initialize(&CPU->timeout_wheel[l][s]);
+	}
+
+	CPU->timeout_ticks = 0;
 }
 
 /** Reinitialize timeout
@@ -66,7 +79,7 @@ void timeout_init(void)
 void timeout_reinitialize(timeout_t *timeout)
 {
 	timeout->cpu = NULL;
-	timeout->ticks = 0;
+	timeout->deadline = 0;
 	timeout->handler = NULL;
 	timeout->arg = NULL;
 	link_initialize(&timeout->link);
@@ -85,10 +98,45 @@ void timeout_initialize(timeout_t *timeout)
 	timeout_reinitialize(timeout);
 }
 
+/** Insert timeout into the timing wheel of a CPU
+ *
+ * The timeout goes to the lowest level whose span covers its deadline.
+ * Timeouts which are further away than the whole wheel can cover are put
+ * into the last slot of the highest level and are reinserted once the
+ * slot is cascaded.
+ *
+ * @param cpu     CPU whose timing wheel is to be used. Its timeoutlock
+ *                must be held.
+ * @param timeout Timeout to be inserted.
+ *
+ */
+static void timeout_wheel_insert(cpu_t *cpu, timeout_t *timeout)
+{
+	assert(irq_spinlock_locked(&cpu->timeoutlock));
+
+	uint64_t now = cpu->timeout_ticks;
+	uint64_t deadline = timeout->deadline;
+
+	if (deadline < now)
+		deadline = now;
+	else if (deadline - now > TIMEOUT_WHEEL_SPAN)
+		deadline = now + TIMEOUT_WHEEL_SPAN;
+
+	uint64_t delta = deadline - now;
+	unsigned int level = 0;
+	while ((level < TIMEOUT_WHEEL_LEVELS - 1) &&
+	    (delta >> (TIMEOUT_WHEEL_BITS * (level + 1))) != 0)
+		level++;
+
+	unsigned int slot = (deadline >> (TIMEOUT_WHEEL_BITS * level)) &
+	    TIMEOUT_WHEEL_MASK;
+	list_append(&timeout->link, &cpu->timeout_wheel[level][slot]);
+}
+
 /** Register timeout
  *
  * Insert timeout handler f (with argument arg)
- * to timeout list and make it execute in
+ * to the timing wheel and make it execute in
  * time microseconds (or slightly more).
  *
  * @param timeout Timeout structure.
@@ -107,49 +155,12 @@ void timeout_register(timeout_t *timeout, uint64_t time,
 		panic("Unexpected: timeout->cpu != 0.");
 
 	timeout->cpu = CPU;
-	timeout->ticks = us2ticks(time);
+	timeout->deadline = CPU->timeout_ticks + us2ticks(time);
 
 	timeout->handler = handler;
 	timeout->arg = arg;
 
-	/*
-	 * Insert timeout into the active timeouts list according to timeout->ticks.
-	 */
-	uint64_t sum = 0;
-	timeout_t *target = NULL;
-	link_t *cur;
-	for (cur = CPU->timeout_active_list.head.next;
-	    cur != &CPU->timeout_active_list.head; cur = cur->next) {
-		target = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&target->lock, false);
-
-		if (timeout->ticks < sum + target->ticks) {
-			irq_spinlock_unlock(&target->lock, false);
-			break;
-		}
-
-		sum += target->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
-
-	/* Avoid using cur->prev directly */
-	link_t *prev = cur->prev;
-	list_insert_after(&timeout->link, prev);
-
-	/*
-	 * Adjust timeout->ticks according to ticks
-	 * accumulated in target's predecessors.
-	 */
-	timeout->ticks -= sum;
-
-	/*
-	 * Decrease ticks of timeout's immediate succesor by timeout->ticks.
-	 */
-	if (cur != &CPU->timeout_active_list.head) {
-		irq_spinlock_lock(&target->lock, false);
-		target->ticks -= timeout->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
+	timeout_wheel_insert(CPU, timeout);
 
 	irq_spinlock_unlock(&timeout->lock, false);
 	irq_spinlock_unlock(&CPU->timeoutlock, true);
@@ -157,7 +168,7 @@ void timeout_register(timeout_t *timeout, uint64_t time,
 
 /** Unregister timeout
  *
- * Remove timeout from timeout list.
+ * Remove timeout from the timing wheel.
  *
  * @param timeout Timeout to unregister.
  *
@@ -183,17 +194,9 @@ grab_locks:
 
 	/*
 	 * Now we know for sure that timeout hasn't been activated yet
-	 * and is lurking in timeout->cpu->timeout_active_list.
+	 * and is lurking in the timing wheel of timeout->cpu.
 	 */
 
-	link_t *cur = timeout->link.next;
-	if (cur != &timeout->cpu->timeout_active_list.head) {
-		timeout_t *tmp = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&tmp->lock, false);
-		tmp->ticks += timeout->ticks;
-		irq_spinlock_unlock(&tmp->lock, false);
-	}
-
 	list_remove(&timeout->link);
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, false);
 
@@ -203,5 +206,63 @@ grab_locks:
 	return true;
 }
 
+/** Advance the timing wheel of the current CPU by one tick
+ *
+ * Whenever the lowest level wraps around, the due slots of the higher
+ * levels are cascaded down. Then the timeouts of the current slot of the
+ * lowest level are run. To avoid lock ordering problems, the handlers are
+ * run with no locks held.
+ *
+ * Must be called with interrupts disabled.
+ *
+ */
+void timeout_tick(void)
+{
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	uint64_t now = CPU->timeout_ticks;
+	unsigned int slot = now & TIMEOUT_WHEEL_MASK;
+
+	for (unsigned int l = 1; (l < TIMEOUT_WHEEL_LEVELS) &&
+	    ((now >> (TIMEOUT_WHEEL_BITS * (l - 1))) & TIMEOUT_WHEEL_MASK) == 0;
+	    l++) {
+		list_t cascade;
+		list_initialize(&cascade);
+		list_concat(&cascade, &CPU->timeout_wheel[l][(now >>
+		    (TIMEOUT_WHEEL_BITS * l)) & TIMEOUT_WHEEL_MASK]);
+
+		link_t *cur;
+		while ((cur = list_first(&cascade)) != NULL) {
+			list_remove(cur);
+			timeout_wheel_insert(CPU,
+			    list_get_instance(cur, timeout_t, link));
+		}
+	}
+
+	CPU->timeout_ticks = now + 1;
+
+	list_t *expired = &CPU->timeout_wheel[0][slot];
+	link_t *cur;
+	while ((cur = list_first(expired)) != NULL) {
+		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+
+		irq_spinlock_lock(&timeout->lock, false);
+
+		list_remove(cur);
+		timeout_handler_t handler = timeout->handler;
+		void *arg = timeout->arg;
+		timeout_reinitialize(timeout);
+
+		irq_spinlock_unlock(&timeout->lock, false);
+		irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+		handler(arg);
+
+		irq_spinlock_lock(&CPU->timeoutlock, false);
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+}
+
 /** @}
  */
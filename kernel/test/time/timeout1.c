@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <stdint.h>
+#include <atomic.h>
+#include <arch/cycle.h>
+#include <stdlib.h>
+#include <proc/thread.h>
+#include <time/timeout.h>
+
+/** Number of timeouts kept pending during the measurement. */
+#define PENDING  10000
+
+/** Number of measured register/unregister pairs. */
+#define ROUNDS   1000
+
+/** Pending timeouts expire no sooner than this (usec). */
+#define PENDING_BASE  60000000
+
+static void timeout_handler(void *arg)
+{
+	bool *fired = (bool *) arg;
+	*fired = true;
+}
+
+/** Expiring timeout used to check handler invocation. */
+typedef struct {
+	/** Delay in microseconds. */
+	uint32_t usec;
+	/** Whether the timeout is unregistered before it expires. */
+	bool cancel;
+	timeout_t timeout;
+	/** Number of handler invocations. */
+	atomic_t calls;
+	/** Sequence number of the last invocation. */
+	size_t seq;
+} probe_t;
+
+/*
+ * Listed in the order in which they must fire. The delays straddle the
+ * first level of the timing wheel so that cascading is exercised too.
+ */
+static probe_t probes[] = {
+	{ .usec = 20000 },
+	{ .usec = 50000 },
+	{ .usec = 100000, .cancel = true },
+	{ .usec = 300000 },
+	{ .usec = 900000 },
+	{ .usec = 1000000, .cancel = true },
+	{ .usec = 1500000 }
+};
+
+#define PROBES  (sizeof(probes) / sizeof(probes[0]))
+
+/** Order in which the probes are registered. */
+static const size_t probe_order[PROBES] = { 4, 0, 6, 2, 1, 5, 3 };
+
+/** Wait this long for all probes to expire (usec). */
+#define PROBE_WAIT  2500000
+
+static atomic_t probe_seq;
+
+static void probe_handler(void *arg)
+{
+	probe_t *probe = (probe_t *) arg;
+
+	probe->seq = atomic_postinc(&probe_seq);
+	atomic_inc(&probe->calls);
+}
+
+static const char *test_expiration(void)
+{
+	atomic_store(&probe_seq, 0);
+
+	for (size_t i = 0; i < PROBES; i++) {
+		probe_t *probe = &probes[probe_order[i]];
+
+		atomic_store(&probe->calls, 0);
+		probe->seq = 0;
+		timeout_initialize(&probe->timeout);
+		timeout_register(&probe->timeout, probe->usec, probe_handler,
+		    probe);
+	}
+
+	for (size_t i = 0; i < PROBES; i++) {
+		if (probes[i].cancel && !timeout_unregister(&probes[i].timeout))
+			return "Unable to unregister pending timeout";
+	}
+
+	thread_usleep(PROBE_WAIT);
+
+	size_t expected = 0;
+	for (size_t i = 0; i < PROBES; i++) {
+		probe_t *probe = &probes[i];
+		size_t calls = atomic_load(&probe->calls);
+
+		TPRINTF("Timeout %" PRIu32 " us: %zu call(s)\n", probe->usec,
+		    calls);
+
+		if (probe->cancel) {
+			if (calls != 0)
+				return "Unregistered timeout fired";
+			continue;
+		}
+
+		if (calls == 0)
+			return "Timeout did not fire";
+		if (calls > 1)
+			return "Timeout fired more than once";
+		if (probe->seq != expected)
+			return "Timeouts fired out of order";
+
+		expected++;
+	}
+
+	/* Unregistering an expired timeout must fail and not call it again. */
+	if (timeout_unregister(&probes[0].timeout))
+		return "Expired timeout unregistered";
+	if (atomic_load(&probes[0].calls) != 1)
+		return "Expired timeout fired again";
+
+	return NULL;
+}
+
+const char *test_timeout1(void)
+{
+	const char *err = test_expiration();
+	if (err)
+		return err;
+
+	timeout_t *pending = malloc(PENDING * sizeof(timeout_t));
+	if (!pending)
+		return "Unable to allocate pending timeouts";
+
+	bool fired = false;
+
+	/*
+	 * Spread the pending timeouts over one to three minutes. None of
+	 * them expires during the test and all of them land in the third
+	 * level of the timing wheel, so the test measures the cost of
+	 * registering and unregistering timeouts while many others are
+	 * pending.
+	 */
+	uint64_t start = get_cycle();
+	for (size_t i = 0; i < PENDING; i++) {
+		timeout_initialize(&pending[i]);
+		timeout_register(&pending[i], PENDING_BASE + i * 9973,
+		    timeout_handler, &fired);
+	}
+	uint64_t fill = get_cycle() - start;
+
+	TPRINTF("Registered %d pending timeouts in %" PRIu64 " cycles\n",
+	    PENDING, fill);
+
+	timeout_t probe;
+	timeout_initialize(&probe);
+
+	uint64_t reg = 0;
+	uint64_t unreg = 0;
+
+	for (size_t i = 0; i < ROUNDS; i++) {
+		start = get_cycle();
+		timeout_register(&probe, PENDING_BASE + (i % PENDING) * 9973,
+		    timeout_handler, &fired);
+		uint64_t mid = get_cycle();
+		bool unregistered = timeout_unregister(&probe);
+		uint64_t end = get_cycle();
+
+		if (!unregistered) {
+			err = "Probe timeout fired prematurely";
+			break;
+		}
+
+		reg += mid - start;
+		unreg += end - mid;
+	}
+
+	if (!err) {
+		TPRINTF("Average register: %" PRIu64 " cycles, "
+		    "unregister: %" PRIu64 " cycles\n",
+		    reg / ROUNDS, unreg / ROUNDS);
+	}
+
+	for (size_t i = 0; i < PENDING; i++) {
+		if (!timeout_unregister(&pending[i]) && !err)
+			err = "Pending timeout fired prematurely";
+	}
+
+	if (fired && !err)
+		err = "Timeout handler called prematurely";
+
+	free(pending);
+	return err;
+}
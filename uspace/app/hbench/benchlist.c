@@ -38,13 +38,19 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_dir_ops,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
 	&benchmark_file_read,
 	&benchmark_malloc1,
+	&benchmark_malloc1_mt,
 	&benchmark_malloc2,
+	&benchmark_malloc2_mt,
+	&benchmark_mpsc_mt,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ping_pong,
+	&benchmark_ping_pong_mt,
+	&benchmark_tcp_stream
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -141,5 +141,29 @@ const char *bench_env_param_get(bench_env_t *env, const char *key, const char *d
 	return param->value;
 }
 
+/** Get numeric benchmark parameter.
+ *
+ * @param env Benchmark environment.
+ * @param key Parameter name.
+ * @param default_value Value to use when the parameter is not set
+ *        or is not a valid number.
+ * @return Parameter value.
+ */
+size_t bench_env_param_get_size(bench_env_t *env, const char *key,
+    size_t default_value)
+{
+	const char *str = bench_env_param_get(env, key, NULL);
+	if (str == NULL) {
+		return default_value;
+	}
+
+	size_t value;
+	if (str_size_t(str, NULL, 10, true, &value) != EOK) {
+		return default_value;
+	}
+
+	return value;
+}
+
 /** @}
  */
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+#define DEFAULT_FILES 1000
+#define MAX_PATH_LENGTH 256
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *path = bench_env_param_get(env, "dirname", "/tmp/hbench");
+
+	errno_t rc = vfs_link_path(path, KIND_DIRECTORY, NULL);
+	if (rc != EOK && rc != EEXIST) {
+		return bench_run_fail(run, "failed to create directory %s: %s",
+		    path, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	const char *path = bench_env_param_get(env, "dirname", "/tmp/hbench");
+
+	errno_t rc = vfs_unlink_path(path);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove directory %s: %s",
+		    path, str_error(rc));
+	}
+
+	return true;
+}
+
+/** Execute directory operations benchmark.
+ *
+ * Each iteration creates the given number of files in a single directory,
+ * looks each of them up and removes them again.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *dir = bench_env_param_get(env, "dirname", "/tmp/hbench");
+	size_t files = bench_env_param_get_size(env, "files", DEFAULT_FILES);
+	char path[MAX_PATH_LENGTH];
+	vfs_stat_t st;
+	errno_t rc;
+	int fd;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		for (size_t f = 0; f < files; f++) {
+			snprintf(path, sizeof(path), "%s/f%zu", dir, f);
+			rc = vfs_lookup(path, WALK_REGULAR | WALK_MUST_CREATE,
+			    &fd);
+			if (rc != EOK) {
+				return bench_run_fail(run, "failed to create %s: %s",
+				    path, str_error(rc));
+			}
+			vfs_put(fd);
+		}
+
+		for (size_t f = 0; f < files; f++) {
+			snprintf(path, sizeof(path), "%s/f%zu", dir, f);
+			rc = vfs_stat_path(path, &st);
+			if (rc != EOK) {
+				return bench_run_fail(run, "failed to look up %s: %s",
+				    path, str_error(rc));
+			}
+		}
+
+		for (size_t f = 0; f < files; f++) {
+			snprintf(path, sizeof(path), "%s/f%zu", dir, f);
+			rc = vfs_unlink_path(path);
+			if (rc != EOK) {
+				return bench_run_fail(run, "failed to remove %s: %s",
+				    path, str_error(rc));
+			}
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_dir_ops = {
+	.name = "dir_ops",
+	.desc = "Create, look up and remove 'files' files in directory 'dirname'.",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -36,21 +36,26 @@
 #include <stdlib.h>
 #include "../hbench.h"
 
-#define BUFFER_SIZE 4096
+#define DEFAULT_BUFFER_SIZE 4096
 
 /** Execute file reading benchmark.
  *
  * Note that while this benchmark tries to measure speed of file reading,
  * it rather measures speed of FS cache as it is highly probable that the
- * corresponding blocks would be cached after first run.
+ * corresponding blocks would be cached after first run. Files bigger than
+ * the block cache are read from the device on every run, which makes the
+ * benchmark exercise the block readahead instead.
  */
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
 	const char *path = bench_env_param_get(env, "filename", "/data/web/helenos.png");
+	size_t buffer_size = bench_env_param_get_size(env, "buffer",
+	    DEFAULT_BUFFER_SIZE);
 
-	char *buf = malloc(BUFFER_SIZE);
+	char *buf = malloc(buffer_size);
 	if (buf == NULL) {
-		return bench_run_fail(run, "failed to allocate %dB buffer", BUFFER_SIZE);
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    buffer_size);
 	}
 
 	bool ret = true;
@@ -73,7 +78,7 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 			goto leave_close;
 		}
 		while (!feof(file)) {
-			fread(buf, 1, BUFFER_SIZE, file);
+			fread(buf, 1, buffer_size, file);
 			if (ferror(file)) {
 				bench_run_fail(run, "failed to read from %s: %s",
 				    path, str_error(errno));
@@ -95,7 +100,7 @@ leave_free_buf:
 
 benchmark_t benchmark_file_read = {
 	.name = "file_read",
-	.desc = "Sequentially read contents of a file (use 'filename' param to alter the default).",
+	.desc = "Sequentially read contents of a file (use 'filename' and 'buffer' params to alter the defaults).",
 	.entry = &runner,
 	.setup = NULL,
 	.teardown = NULL
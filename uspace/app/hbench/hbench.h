@@ -89,6 +89,13 @@ typedef bool (*benchmark_entry_t)(bench_env_t *, bench_run_t *, uint64_t);
  */
 typedef bool (*benchmark_helper_t)(bench_env_t *, bench_run_t *);
 
+/** Worker of a parallel benchmark.
+ *
+ * Besides the run (used for error reporting only), it receives the index
+ * of the worker, number of iterations to execute and user argument.
+ */
+typedef bool (*bench_worker_t)(bench_run_t *, size_t, uint64_t, void *);
+
 typedef struct {
 	const char *name;
 	const char *desc;
@@ -99,6 +106,8 @@ typedef struct {
 
 extern void bench_run_init(bench_run_t *, char *, size_t);
 extern bool bench_run_fail(bench_run_t *, const char *, ...);
+extern bool bench_run_parallel(bench_run_t *, size_t, uint64_t,
+    bench_worker_t, void *);
 
 /*
  * We keep the following two functions inline to ensure that we start
@@ -125,19 +134,26 @@ extern void csv_report_close(void);
 extern errno_t bench_env_init(bench_env_t *);
 extern errno_t bench_env_param_set(bench_env_t *, const char *, const char *);
 extern const char *bench_env_param_get(bench_env_t *, const char *, const char *);
+extern size_t bench_env_param_get_size(bench_env_t *, const char *, size_t);
 extern void bench_env_cleanup(bench_env_t *);
 
 extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_dir_ops;
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
 extern benchmark_t benchmark_file_read;
 extern benchmark_t benchmark_malloc1;
+extern benchmark_t benchmark_malloc1_mt;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_malloc2_mt;
+extern benchmark_t benchmark_mpsc_mt;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_ping_pong_mt;
+extern benchmark_t benchmark_tcp_stream;
 
 #endif
 
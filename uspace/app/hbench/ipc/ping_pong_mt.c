@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ipc_test.h>
+#include <async.h>
+#include <errno.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+#define DEFAULT_CLIENTS 4
+
+static ipc_test_t **tests = NULL;
+static size_t clients = 0;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	size_t count = bench_env_param_get_size(env, "clients",
+	    DEFAULT_CLIENTS);
+	if (count == 0)
+		return bench_run_fail(run, "number of clients must be positive");
+
+	tests = calloc(count, sizeof(ipc_test_t *));
+	if (tests == NULL)
+		return bench_run_fail(run, "failed allocating client array");
+	clients = count;
+
+	/* Each client has its own connection to the server. */
+	for (size_t i = 0; i < clients; i++) {
+		errno_t rc = ipc_test_create(&tests[i]);
+		if (rc != EOK) {
+			return bench_run_fail(run,
+			    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	for (size_t i = 0; i < clients; i++) {
+		if (tests[i] != NULL)
+			ipc_test_destroy(tests[i]);
+	}
+
+	free(tests);
+	tests = NULL;
+	clients = 0;
+	return true;
+}
+
+static bool worker(bench_run_t *run, size_t index, uint64_t niter, void *arg)
+{
+	for (uint64_t count = 0; count < niter; count++) {
+		errno_t rc = ipc_test_ping(tests[index]);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending ping message: %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return bench_run_parallel(run, clients, niter, worker, NULL);
+}
+
+benchmark_t benchmark_ping_pong_mt = {
+	.name = "ping_pong_mt",
+	.desc = "IPC ping-pong benchmark with 'clients' concurrent connections",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * By default data is received from a peer, so that frames go through the
+ * NIC driver and ethip. With QEMU user networking the host is 10.0.2.2
+ * and can act as the peer e.g. by running 'nc -l 8017 < /dev/zero'.
+ */
+#define DEFAULT_PEER_ADDR "10.0.2.2"
+#define DEFAULT_LOOPBACK_ADDR "127.0.0.1"
+#define DEFAULT_PORT 8017
+#define DEFAULT_BUFFER_SIZE 16384
+
+/*
+ * Each buffer is sent in full before it is read on the other end, so it
+ * must fit into the receive window.
+ */
+#define MAX_BUFFER_SIZE (64 * 1024)
+
+/** How long to wait for the listener to accept the connection (usec) */
+#define ACCEPT_TIMEOUT (5 * 1000 * 1000)
+
+static tcp_t *tcp = NULL;
+static tcp_listener_t *listener = NULL;
+static tcp_conn_t *client = NULL;
+static tcp_conn_t *server = NULL;
+
+/** Both ends of the connection are local */
+static bool loopback = false;
+
+static FIBRIL_MUTEX_INITIALIZE(accept_lock);
+static FIBRIL_CONDVAR_INITIALIZE(accept_cv);
+
+static void new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	fibril_mutex_lock(&accept_lock);
+	server = conn;
+	fibril_condvar_broadcast(&accept_cv);
+	fibril_mutex_unlock(&accept_lock);
+}
+
+static tcp_listen_cb_t listen_cb = {
+	.new_conn = new_conn
+};
+
+static tcp_cb_t conn_cb = {
+	.connected = NULL
+};
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (client != NULL)
+		tcp_conn_destroy(client);
+	if (server != NULL)
+		tcp_conn_destroy(server);
+	if (listener != NULL)
+		tcp_listener_destroy(listener);
+	if (tcp != NULL)
+		tcp_destroy(tcp);
+
+	client = NULL;
+	server = NULL;
+	listener = NULL;
+	tcp = NULL;
+
+	return true;
+}
+
+/** Connect to the peer or to ourselves through the TCP service. */
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *mode = bench_env_param_get(env, "mode", "peer");
+	size_t port = bench_env_param_get_size(env, "port", DEFAULT_PORT);
+	const char *addr;
+	inet_ep_t ep;
+	inet_ep2_t epp;
+	errno_t rc;
+
+	if (str_cmp(mode, "peer") == 0) {
+		loopback = false;
+		addr = bench_env_param_get(env, "addr", DEFAULT_PEER_ADDR);
+	} else if (str_cmp(mode, "loopback") == 0) {
+		loopback = true;
+		addr = bench_env_param_get(env, "addr", DEFAULT_LOOPBACK_ADDR);
+	} else {
+		return bench_run_fail(run, "mode must be 'peer' or 'loopback'");
+	}
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed contacting TCP service: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	if (loopback) {
+		inet_ep_init(&ep);
+		ep.port = port;
+
+		rc = tcp_listener_create(tcp, &ep, &listen_cb, NULL, &conn_cb,
+		    NULL, &listener);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed listening on port %zu: "
+			    "%s (%d)", port, str_error(rc), rc);
+			goto error;
+		}
+	}
+
+	inet_ep2_init(&epp);
+	epp.remote.port = port;
+
+	rc = inet_addr_parse(addr, &epp.remote.addr, NULL);
+	if (rc != EOK) {
+		bench_run_fail(run, "invalid address %s", addr);
+		goto error;
+	}
+
+	rc = tcp_conn_create(tcp, &epp, &conn_cb, NULL, &client);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed connecting to %s: %s (%d)",
+		    addr, str_error(rc), rc);
+		goto error;
+	}
+
+	rc = tcp_conn_wait_connected(client);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed connecting to %s: %s (%d)",
+		    addr, str_error(rc), rc);
+		goto error;
+	}
+
+	if (!loopback)
+		return true;
+
+	fibril_mutex_lock(&accept_lock);
+	rc = EOK;
+	while (server == NULL && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&accept_cv, &accept_lock,
+		    ACCEPT_TIMEOUT);
+	}
+	fibril_mutex_unlock(&accept_lock);
+
+	if (server == NULL) {
+		bench_run_fail(run, "connection was not accepted");
+		goto error;
+	}
+
+	return true;
+
+error:
+	teardown(env, run);
+	return false;
+}
+
+/** Receive a buffer full of data from a connection.
+ *
+ * @param run  Benchmark run
+ * @param conn Connection to receive from
+ * @param buf  Buffer
+ * @param size Buffer size
+ * @return True on success
+ */
+static bool receive_buffer(bench_run_t *run, tcp_conn_t *conn, uint8_t *buf,
+    size_t size)
+{
+	size_t left = size;
+	size_t nrecv;
+	errno_t rc;
+
+	while (left > 0) {
+		rc = tcp_conn_recv_wait(conn, buf, left, &nrecv);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed receiving data: "
+			    "%s (%d)", str_error(rc), rc);
+		}
+
+		if (nrecv == 0)
+			return bench_run_fail(run, "connection closed by peer");
+
+		left -= nrecv;
+	}
+
+	return true;
+}
+
+/** Stream data through the connection.
+ *
+ * In peer mode the data sent by the peer is received, so frames go
+ * through the NIC driver, ethip, inetsrv and tcp. In loopback mode the
+ * data is sent from one end of a local connection to the other and
+ * travels through the loopback link instead.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	size_t buffer_size = bench_env_param_get_size(env, "buffer",
+	    DEFAULT_BUFFER_SIZE);
+	uint8_t *sbuf = NULL;
+	uint8_t *rbuf = NULL;
+	errno_t rc;
+	bool ret = true;
+
+	if (buffer_size == 0 || buffer_size > MAX_BUFFER_SIZE) {
+		return bench_run_fail(run, "buffer size must be between 1 "
+		    "and %d", MAX_BUFFER_SIZE);
+	}
+
+	sbuf = calloc(buffer_size, 1);
+	rbuf = malloc(buffer_size);
+	if (sbuf == NULL || rbuf == NULL) {
+		ret = bench_run_fail(run, "failed to allocate %zuB buffers",
+		    buffer_size);
+		goto leave;
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		if (!loopback) {
+			ret = receive_buffer(run, client, rbuf, buffer_size);
+			if (!ret)
+				goto leave;
+			continue;
+		}
+
+		rc = tcp_conn_send(client, sbuf, buffer_size);
+		if (rc != EOK) {
+			ret = bench_run_fail(run, "failed sending data: %s (%d)",
+			    str_error(rc), rc);
+			goto leave;
+		}
+
+		ret = receive_buffer(run, server, rbuf, buffer_size);
+		if (!ret)
+			goto leave;
+	}
+	bench_run_stop(run);
+
+leave:
+	free(sbuf);
+	free(rbuf);
+	return ret;
+}
+
+benchmark_t benchmark_tcp_stream = {
+	.name = "tcp_stream",
+	.desc = "TCP bulk receive from a peer through the NIC (use 'mode=loopback' for a local connection, 'addr', 'port' and 'buffer' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
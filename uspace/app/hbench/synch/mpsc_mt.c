@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+#define DEFAULT_PRODUCERS 4
+
+/*
+ * Throughput of the multi-producer, single-consumer channel. Worker 0 is
+ * the consumer, the remaining 'producers' workers each send their share of
+ * messages. The consumer checks that messages of every producer arrive in
+ * the order in which they were sent.
+ */
+
+typedef struct {
+	size_t producer;
+	uint64_t seq;
+} message_t;
+
+typedef struct {
+	mpsc_t *channel;
+	size_t producers;
+} shared_t;
+
+static bool consume(bench_run_t *run, shared_t *shared, uint64_t size)
+{
+	uint64_t *next = calloc(shared->producers, sizeof(uint64_t));
+	if (next == NULL)
+		return bench_run_fail(run, "failed to allocate consumer state");
+
+	for (uint64_t i = 0; i < size * shared->producers; i++) {
+		message_t msg;
+		errno_t rc = mpsc_receive(shared->channel, &msg, NULL);
+		if (rc != EOK) {
+			free(next);
+			return bench_run_fail(run, "failed to receive: %s",
+			    str_error(rc));
+		}
+
+		if ((msg.producer >= shared->producers) ||
+		    (msg.seq != next[msg.producer])) {
+			free(next);
+			return bench_run_fail(run, "message out of order");
+		}
+
+		next[msg.producer]++;
+	}
+
+	free(next);
+	return true;
+}
+
+static bool worker(bench_run_t *run, size_t index, uint64_t size, void *arg)
+{
+	shared_t *shared = arg;
+
+	if (index == 0)
+		return consume(run, shared, size);
+
+	for (uint64_t i = 0; i < size; i++) {
+		message_t msg = {
+			.producer = index - 1,
+			.seq = i
+		};
+
+		errno_t rc = mpsc_send(shared->channel, &msg);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to send: %s",
+			    str_error(rc));
+		}
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	shared_t shared;
+
+	shared.producers = bench_env_param_get_size(env, "producers",
+	    DEFAULT_PRODUCERS);
+	if (shared.producers == 0)
+		return bench_run_fail(run, "at least one producer is needed");
+
+	shared.channel = mpsc_create(sizeof(message_t));
+	if (shared.channel == NULL)
+		return bench_run_fail(run, "failed to create channel");
+
+	bool ok = bench_run_parallel(run, shared.producers + 1, size, worker,
+	    &shared);
+
+	mpsc_destroy(shared.channel);
+	return ok;
+}
+
+benchmark_t benchmark_mpsc_mt = {
+	.name = "mpsc_mt",
+	.desc = "Throughput of an MPSC channel fed by 'producers' workers",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -33,10 +33,33 @@
  * @file
  */
 
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "hbench.h"
 
+#define WORKER_ERROR_BUFFER_SIZE 256
+
+/** Number of fibril runners spawned so far (in addition to the main thread). */
+static size_t runners_spawned = 0;
+
+typedef struct {
+	bench_worker_t worker;
+	void *arg;
+	uint64_t niter;
+	fibril_semaphore_t finished;
+	fibril_mutex_t lock;
+	bench_run_t *run;
+	bool failed;
+} parallel_t;
+
+typedef struct {
+	parallel_t *parallel;
+	size_t index;
+} parallel_worker_t;
+
 /** Initialize bench run structure.
  *
  * @param run Structure to intialize.
@@ -75,5 +98,100 @@ bool bench_run_fail(bench_run_t *run, const char *fmt, ...)
 	return false;
 }
 
+static errno_t parallel_worker_fibril(void *arg)
+{
+	parallel_worker_t *pw = arg;
+	parallel_t *parallel = pw->parallel;
+	char error_buffer[WORKER_ERROR_BUFFER_SIZE];
+	bench_run_t run;
+
+	bench_run_init(&run, error_buffer, WORKER_ERROR_BUFFER_SIZE);
+
+	if (!parallel->worker(&run, pw->index, parallel->niter, parallel->arg)) {
+		fibril_mutex_lock(&parallel->lock);
+		if (!parallel->failed) {
+			parallel->failed = true;
+			bench_run_fail(parallel->run, "worker %zu: %s", pw->index,
+			    error_buffer);
+		}
+		fibril_mutex_unlock(&parallel->lock);
+	}
+
+	fibril_semaphore_up(&parallel->finished);
+	return EOK;
+}
+
+/** Execute benchmark workers in parallel.
+ *
+ * Each worker runs in its own fibril and enough fibril runners are spawned
+ * so that all workers can run on separate threads. The measured time covers
+ * the whole parallel section.
+ *
+ * @param run Current benchmark run.
+ * @param count Number of workers.
+ * @param niter Number of iterations for each worker.
+ * @param worker Worker implementation.
+ * @param arg Argument passed to each worker.
+ * @return Whether all workers succeeded.
+ */
+bool bench_run_parallel(bench_run_t *run, size_t count, uint64_t niter,
+    bench_worker_t worker, void *arg)
+{
+	parallel_t parallel = {
+		.worker = worker,
+		.arg = arg,
+		.niter = niter,
+		.run = run,
+		.failed = false
+	};
+
+	fibril_semaphore_initialize(&parallel.finished, 0);
+	fibril_mutex_initialize(&parallel.lock);
+
+	parallel_worker_t *workers = calloc(count, sizeof(parallel_worker_t));
+	fid_t *fids = calloc(count, sizeof(fid_t));
+	if ((workers == NULL) || (fids == NULL)) {
+		free(workers);
+		free(fids);
+		return bench_run_fail(run, "failed to allocate %zu workers", count);
+	}
+
+	/* Fibril runners cannot be stopped, so only spawn the missing ones. */
+	if (count > runners_spawned + 1) {
+		runners_spawned += fibril_test_spawn_runners(
+		    count - runners_spawned - 1);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		workers[i].parallel = &parallel;
+		workers[i].index = i;
+
+		fids[i] = fibril_create(parallel_worker_fibril, &workers[i]);
+		if (fids[i] == 0) {
+			for (size_t j = 0; j < i; j++)
+				fibril_destroy(fids[j]);
+
+			free(workers);
+			free(fids);
+			return bench_run_fail(run, "failed to create worker %zu", i);
+		}
+	}
+
+	bench_run_start(run);
+
+	for (size_t i = 0; i < count; i++)
+		fibril_add_ready(fids[i]);
+
+	for (size_t i = 0; i < count; i++)
+		fibril_semaphore_down(&parallel.finished);
+
+	bench_run_stop(run);
+
+	free(workers);
+	free(fids);
+
+	return !parallel.failed;
+}
+
 /** @}
  */
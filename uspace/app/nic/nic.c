@@ -53,6 +53,7 @@ typedef struct {
 	nic_unicast_mode_t unicast_mode;
 	nic_multicast_mode_t multicast_mode;
 	nic_broadcast_mode_t broadcast_mode;
+	nic_device_stats_t stats;
 	int speed;
 } nic_info_t;
 
@@ -174,6 +175,13 @@ static errno_t nic_get_info(service_id_t svc_id, char *svc_name,
 		goto error;
 	}
 
+	rc = nic_get_stats(sess, &info->stats);
+	if (rc != EOK) {
+		printf("Error getting NIC statistics.\n");
+		rc = EIO;
+		goto error;
+	}
+
 	return EOK;
 error:
 	return rc;
@@ -335,6 +343,16 @@ static errno_t nic_list(void)
 			    nic_duplex_mode_str(nic_info.duplex));
 		}
 
+		printf("\tReceived frames: %lu in %lu batches (max %lu)\n",
+		    nic_info.stats.receive_packets,
+		    nic_info.stats.receive_batches,
+		    nic_info.stats.receive_batch_max);
+		printf("\tReceive interrupts: %lu, polls: %lu, "
+		    "switches to polling: %lu\n",
+		    nic_info.stats.receive_interrupts,
+		    nic_info.stats.receive_polls,
+		    nic_info.stats.receive_poll_switches);
+
 		free(svc_name);
 		free(addr_str);
 	}
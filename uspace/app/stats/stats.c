@@ -139,7 +139,8 @@ static void list_cpus(void)
 		return;
 	}
 
-	printf("[id] [MHz     ] [busy cycles] [idle cycles]\n");
+	printf("[id] [MHz     ] [busy cycles] [idle cycles] [steals    ]"
+	    " [handoffs  ] [shootdowns] [IPIs      ] [CPUs/shootdown]\n");
 
 	size_t i;
 	for (i = 0; i < count; i++) {
@@ -151,9 +152,20 @@ static void list_cpus(void)
 			order_suffix(cpus[i].busy_cycles, &bcycles, &bsuffix);
 			order_suffix(cpus[i].idle_cycles, &icycles, &isuffix);
 
-			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c\n",
-			    cpus[i].frequency_mhz, bcycles, bsuffix,
-			    icycles, isuffix);
+			/* Average number of CPUs interrupted per shootdown */
+			uint64_t avg = 0;
+			if (cpus[i].tlb_shootdowns > 0) {
+				avg = cpus[i].tlb_interrupted * 100 /
+				    cpus[i].tlb_shootdowns;
+			}
+
+			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c"
+			    " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+			    " %12" PRIu64 " %13" PRIu64 ".%02" PRIu64 "\n",
+			    cpus[i].frequency_mhz, bcycles, bsuffix, icycles,
+			    isuffix, cpus[i].steals, cpus[i].handoffs,
+			    cpus[i].tlb_shootdowns,
+			    cpus[i].tlb_ipis, avg / 100, avg % 100);
 		} else
 			printf("inactive\n");
 	}
@@ -161,6 +173,53 @@ static void list_cpus(void)
 	free(cpus);
 }
 
+static int lock_cmp(const void *a, const void *b)
+{
+	const stats_lock_t *la = a;
+	const stats_lock_t *lb = b;
+
+	if (la->spin_cycles > lb->spin_cycles)
+		return -1;
+
+	if (la->spin_cycles < lb->spin_cycles)
+		return 1;
+
+	return 0;
+}
+
+static void list_locks(void)
+{
+	size_t count;
+	stats_lock_t *locks = stats_get_locks(&count);
+
+	if (locks == NULL) {
+		fprintf(stderr, "%s: Unable to get lock profiles (is the kernel"
+		    " built with lock profiling?)\n", NAME);
+		return;
+	}
+
+	/* Most time spent waiting first */
+	qsort(locks, count, sizeof(stats_lock_t), lock_cmp);
+
+	printf("[name                          ] [acquired   ] [contended  ]"
+	    " [spin cycles] [hold cycles]\n");
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		uint64_t scycles, hcycles;
+		char ssuffix, hsuffix;
+
+		order_suffix(locks[i].spin_cycles, &scycles, &ssuffix);
+		order_suffix(locks[i].hold_cycles, &hcycles, &hsuffix);
+
+		printf("%-32s %13" PRIu64 " %13" PRIu64 " %12" PRIu64 "%c"
+		    " %12" PRIu64 "%c\n", locks[i].name, locks[i].acquisitions,
+		    locks[i].contended, scycles, ssuffix, hcycles, hsuffix);
+	}
+
+	free(locks);
+}
+
 static void print_load(void)
 {
 	size_t count;
@@ -199,7 +258,7 @@ static void print_uptime(void)
 static void usage(const char *name)
 {
 	printf(
-	    "Usage: %s [-t task_id] [-a] [-c] [-l] [-u]\n"
+	    "Usage: %s [-t task_id] [-a] [-c] [-k] [-l] [-u]\n"
 	    "\n"
 	    "Options:\n"
 	    "\t-t task_id\n"
@@ -214,6 +273,10 @@ static void usage(const char *name)
 	    "\t--cpus\n"
 	    "\t\tList CPUs\n"
 	    "\n"
+	    "\t-k\n"
+	    "\t--locks\n"
+	    "\t\tList kernel lock profiles\n"
+	    "\n"
 	    "\t-l\n"
 	    "\t--load\n"
 	    "\t\tPrint system load\n"
@@ -236,6 +299,7 @@ int main(int argc, char *argv[])
 	bool toggle_threads = false;
 	bool toggle_all = false;
 	bool toggle_cpus = false;
+	bool toggle_locks = false;
 	bool toggle_load = false;
 	bool toggle_uptime = false;
 
@@ -266,6 +330,13 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
+		/* Locks */
+		if ((off = arg_parse_short_long(argv[i], "-k", "--locks")) != -1) {
+			toggle_tasks = false;
+			toggle_locks = true;
+			continue;
+		}
+
 		/* Threads */
 		if ((off = arg_parse_short_long(argv[i], "-t", "--task=")) != -1) {
 			// TODO: Support for 64b range
@@ -307,6 +378,9 @@ int main(int argc, char *argv[])
 	if (toggle_cpus)
 		list_cpus();
 
+	if (toggle_locks)
+		list_locks();
+
 	if (toggle_load)
 		print_load();
 
@@ -260,6 +260,7 @@ static inline void print_cpu_info(data_t *data)
 			print_percent(data->cpus_perc[i].idle, 2);
 			fputs(", busy: ", stdout);
 			print_percent(data->cpus_perc[i].busy, 2);
+			printf(", steals: %" PRIu64, data->cpus[i].steals);
 		} else
 			printf("cpu%u inactive", data->cpus[i].id);
 
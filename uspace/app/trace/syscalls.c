@@ -52,12 +52,14 @@ const sc_desc_t syscall_desc[] = {
 
 	[SYS_IPC_CALL_ASYNC_FAST] = { "ipc_call_async_fast", 6, V_HASH },
 	[SYS_IPC_CALL_ASYNC_SLOW] = { "ipc_call_async_slow", 3, V_HASH },
+	[SYS_IPC_CALL_ASYNC_BATCH] = { "ipc_call_async_batch", 3, V_ERRNO },
 
 	[SYS_IPC_ANSWER_FAST] = { "ipc_answer_fast", 6, V_ERRNO },
 	[SYS_IPC_ANSWER_SLOW] = { "ipc_answer_slow", 2, V_ERRNO },
 	[SYS_IPC_FORWARD_FAST] = { "ipc_forward_fast", 6, V_ERRNO },
 	[SYS_IPC_FORWARD_SLOW] = { "ipc_forward_slow", 3, V_ERRNO },
 	[SYS_IPC_WAIT] = { "ipc_wait_for_call", 3, V_HASH },
+	[SYS_IPC_WAIT_BATCH] = { "ipc_wait_batch", 5, V_ERRNO },
 	[SYS_IPC_POKE] = { "ipc_poke", 0, V_ERRNO },
 	[SYS_IPC_HANGUP] = { "ipc_hangup", 1, V_ERRNO },
 
@@ -1160,13 +1160,20 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 }
 
 /** Receive frames
+ *
+ * The frames are collected under the receive lock and then delivered
+ * to the client as a single batch.
  *
  * @param nic NIC data
  *
+ * @return Number of received frames
+ *
  */
-static void e1000_receive_frames(nic_t *nic)
+static size_t e1000_receive_frames(nic_t *nic)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+	size_t count = 0;
 
 	fibril_mutex_lock(&e1000->rx_lock);
 
@@ -1179,10 +1186,13 @@ static void e1000_receive_frames(nic_t *nic)
 	while (rx_descriptor->status & 0x01) {
 		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
 
-		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
+		nic_frame_t *frame = NULL;
+		if (frames != NULL)
+			frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
 			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
-			nic_received_frame(nic, frame);
+			nic_frame_list_append(frames, frame);
+			count++;
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
@@ -1197,6 +1207,9 @@ static void e1000_receive_frames(nic_t *nic)
 	}
 
 	fibril_mutex_unlock(&e1000->rx_lock);
+
+	nic_received_frame_list(nic, frames);
+	return count;
 }
 
 /** Enable E1000 interupts
@@ -1227,11 +1240,15 @@ static void e1000_disable_interrupts(e1000_t *e1000)
  * @param nic NIC data
  * @param icr ICR register value
  *
+ * @return Number of received frames
+ *
  */
-static void e1000_interrupt_handler_impl(nic_t *nic, uint32_t icr)
+static size_t e1000_interrupt_handler_impl(nic_t *nic, uint32_t icr)
 {
 	if (icr & ICR_RXT0)
-		e1000_receive_frames(nic);
+		return e1000_receive_frames(nic);
+
+	return 0;
 }
 
 /** Handle device interrupt
@@ -1247,8 +1264,11 @@ static void e1000_interrupt_handler(ipc_call_t *icall,
 	nic_t *nic = NIC_DATA_DEV(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	e1000_interrupt_handler_impl(nic, icr);
-	e1000_enable_interrupts(e1000);
+	size_t frames = e1000_interrupt_handler_impl(nic, icr);
+
+	/* Under heavy load the frames are polled instead */
+	if (!nic_report_rx_interrupt(nic, frames))
+		e1000_enable_interrupts(e1000);
 }
 
 /** Register interrupt handler for the card in the system
@@ -1295,7 +1315,11 @@ static void e1000_poll(nic_t *nic)
 	assert(e1000);
 
 	uint32_t icr = E1000_REG_READ(e1000, E1000_ICR);
-	e1000_interrupt_handler_impl(nic, icr);
+	size_t frames = e1000_interrupt_handler_impl(nic, icr);
+
+	/* Back to interrupts once the load drops in adaptive mode */
+	if (!nic_report_rx_poll(nic, frames))
+		e1000_enable_interrupts(e1000);
 }
 
 /** Calculates ITR register interrupt from timespec structure
@@ -1341,6 +1365,12 @@ static errno_t e1000_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
 		E1000_REG_WRITE(e1000, E1000_ITR, (uint32_t) itr_interval);
 		e1000_enable_interrupts(e1000);
 		break;
+	case NIC_POLL_ADAPTIVE:
+		E1000_REG_WRITE(e1000, E1000_ITR,
+		    e1000_calculate_itr_interval_from_usecs(
+		    E1000_DEFAULT_INTERRUPT_INTERVAL_USEC));
+		e1000_enable_interrupts(e1000);
+		break;
 	default:
 		return ENOTSUP;
 	}
@@ -2181,10 +2211,7 @@ errno_t e1000_dev_add(ddf_dev_t *dev)
 	if (rc != EOK)
 		goto err_rx_structure;
 
-	struct timespec period;
-	period.tv_sec = 0;
-	period.tv_nsec = USEC2NSEC(E1000_DEFAULT_INTERRUPT_INTERVAL_USEC);
-	rc = nic_report_poll_mode(nic, NIC_POLL_PERIODIC, &period);
+	rc = nic_report_poll_mode(nic, NIC_POLL_ADAPTIVE, NULL);
 	if (rc != EOK)
 		goto err_rx_structure;
 
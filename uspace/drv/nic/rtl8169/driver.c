@@ -73,6 +73,9 @@ static errno_t rtl8169_defective_set_mode(ddf_fun_t *fun, uint32_t mode);
 static errno_t rtl8169_on_activated(nic_t *nic_data);
 static errno_t rtl8169_on_stopped(nic_t *nic_data);
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size);
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period);
+static void rtl8169_poll(nic_t *nic_data);
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev);
 static inline errno_t rtl8169_register_int_handler(nic_t *nic_data,
     cap_irq_handle_t *handle);
@@ -316,6 +319,7 @@ static rtl8169_t *rtl8169_create_dev_data(ddf_dev_t *dev)
 	nic_set_filtering_change_handlers(nic_data,
 	    rtl8169_unicast_set, rtl8169_multicast_set, rtl8169_broadcast_set,
 	    NULL, NULL);
+	nic_set_poll_handlers(nic_data, rtl8169_poll_mode_change, rtl8169_poll);
 
 	fibril_mutex_initialize(&rtl8169->rx_lock);
 	fibril_mutex_initialize(&rtl8169->tx_lock);
@@ -429,6 +433,10 @@ static errno_t rtl8169_dev_add(ddf_dev_t *dev)
 	if (rc != EOK)
 		goto err_pio;
 
+	rc = nic_report_poll_mode(nic_data, NIC_POLL_ADAPTIVE, NULL);
+	if (rc != EOK)
+		goto err_pio;
+
 	cap_irq_handle_t irq_handle;
 	rc = rtl8169_register_int_handler(nic_data, &irq_handle);
 	if (rc != EOK) {
@@ -747,7 +755,8 @@ static errno_t rtl8169_on_activated(nic_t *nic_data)
 	pio_write_32(rtl8169->regs + RCR, rcr);
 	pio_write_16(rtl8169->regs + RMS, BUFFER_SIZE);
 
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	rtl8169->int_mask = DEFAULT_INTERRUPTS;
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 	/* XXX Check return value */
 	hw_res_enable_interrupt(rtl8169->parent_sess, rtl8169->irq);
 
@@ -974,7 +983,7 @@ static void rtl8169_transmit_done(ddf_dev_t *dev)
 	fibril_mutex_unlock(&rtl8169->tx_lock);
 }
 
-static void rtl8169_receive_done(ddf_dev_t *dev)
+static size_t rtl8169_receive_done(ddf_dev_t *dev)
 {
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
@@ -984,6 +993,7 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 	void *buffer;
 	unsigned int tail, fsidx = 0;
 	int frame_size;
+	size_t count = 0;
 
 	ddf_msg(LVL_DEBUG, "rtl8169_receive_done()");
 
@@ -1014,9 +1024,17 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 
 			frame_size = descr->control & 0x1fff;
 			buffer = rtl8169->rx_buff + (BUFFER_SIZE * tail);
-			frame = nic_alloc_frame(nic_data, frame_size);
-			memcpy(frame->data, buffer, frame_size);
-			nic_frame_list_append(frames, frame);
+			frame = NULL;
+			if (frames != NULL)
+				frame = nic_alloc_frame(nic_data, frame_size);
+			if (frame != NULL) {
+				memcpy(frame->data, buffer, frame_size);
+				nic_frame_list_append(frames, frame);
+				count++;
+			} else {
+				ddf_msg(LVL_WARN, "Cannot allocate RX frame, "
+				    "frame dropped");
+			}
 		}
 
 		tail = (tail + 1) % RX_BUFFERS_COUNT;
@@ -1029,7 +1047,26 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 	fibril_mutex_unlock(&rtl8169->rx_lock);
 
 	nic_received_frame_list(nic_data, frames);
+	return count;
+}
+
+/** Enable or disable the receive interrupts
+ *
+ * @param rtl8169 Device data
+ * @param enable  Enable the receive interrupts
+ */
+static void rtl8169_rx_interrupts_set(rtl8169_t *rtl8169, bool enable)
+{
+	fibril_mutex_lock(&rtl8169->rx_lock);
+
+	if (enable)
+		rtl8169->int_mask |= RX_INTERRUPTS;
+	else
+		rtl8169->int_mask &= ~RX_INTERRUPTS;
+
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 
+	fibril_mutex_unlock(&rtl8169->rx_lock);
 }
 
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
@@ -1040,9 +1077,10 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	uint16_t isr = (uint16_t) IPC_GET_ARG2(*icall) & INT_KNOWN;
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+	size_t frames = 0;
 
 	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 
 	while (isr != 0) {
 		ddf_msg(LVL_DEBUG, "irq handler: remaining isr=0x%04x", isr);
@@ -1071,7 +1109,7 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 		}
 
 		if (isr & (INT_RER | INT_ROK)) {
-			rtl8169_receive_done(dev);
+			frames += rtl8169_receive_done(dev);
 			pio_write_16(rtl8169->regs + ISR, (INT_RER | INT_ROK));
 		}
 
@@ -1079,6 +1117,72 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	}
 
 	pio_write_16(rtl8169->regs + ISR, 0xffff);
+
+	/* Under heavy load the frames are polled instead */
+	if (nic_report_rx_interrupt(nic_data, frames))
+		rtl8169_rx_interrupts_set(rtl8169, false);
+}
+
+/** Set polling mode
+ *
+ *  @param nic_data  The device to set
+ *  @param mode      The mode to set
+ *  @param period    The period for NIC_POLL_PERIODIC
+ *
+ *  @returns EOK if succeed
+ *  @returns ENOTSUP if the mode is not supported
+ */
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	errno_t rc = EOK;
+
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	fibril_mutex_lock(&rtl8169->rx_lock);
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+	case NIC_POLL_ADAPTIVE:
+		rtl8169->int_mask = DEFAULT_INTERRUPTS;
+		break;
+	case NIC_POLL_ON_DEMAND:
+		/* Only reception is polled, transmit completion stays on IRQ */
+		rtl8169->int_mask = DEFAULT_INTERRUPTS & ~RX_INTERRUPTS;
+		break;
+	default:
+		rc = ENOTSUP;
+		break;
+	}
+
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+
+	fibril_mutex_unlock(&rtl8169->rx_lock);
+
+	return rc;
+}
+
+/** Force receiving all frames in the receive buffer
+ *
+ *  Completed transmissions are reclaimed as well.
+ *
+ *  @param nic_data  The device to receive
+ */
+static void rtl8169_poll(nic_t *nic_data)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	/* Frames arriving from now on raise the interrupt again */
+	pio_write_16(rtl8169->regs + ISR, (INT_RER | INT_ROK));
+	size_t frames = rtl8169_receive_done(nic_get_ddf_dev(nic_data));
+
+	/* Reclaim sent descriptors in case transmit interrupts were missed */
+	pio_write_16(rtl8169->regs + ISR, (INT_TER | INT_TOK | INT_TDU));
+	rtl8169_transmit_done(nic_get_ddf_dev(nic_data));
+
+	/* Back to interrupts once the load drops in adaptive mode */
+	if (!nic_report_rx_poll(nic_data, frames))
+		rtl8169_rx_interrupts_set(rtl8169, true);
 }
 
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
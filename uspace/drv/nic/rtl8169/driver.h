@@ -46,6 +46,11 @@
 #define	TX_BUFFERS_SIZE		(BUFFER_SIZE * TX_BUFFERS_COUNT)
 #define	RX_BUFFERS_SIZE		(BUFFER_SIZE * RX_BUFFERS_COUNT)
 
+/** Interrupts enabled in the immediate and adaptive poll modes */
+#define	DEFAULT_INTERRUPTS	0xffff
+/** Interrupts masked while polling in the adaptive poll mode */
+#define	RX_INTERRUPTS		(INT_ROK | INT_RER)
+
 /** RTL8139 device data */
 typedef struct rtl8169_data {
 	/** DDF device */
@@ -69,11 +69,14 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+static size_t virtio_net_receive(nic_t *nic)
 {
-	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+	size_t count = 0;
+
+	fibril_mutex_lock(&virtio_net->rx_lock);
 
 	uint16_t descno;
 	uint32_t len;
@@ -88,10 +91,13 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 			continue;
 		}
 
-		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
+		nic_frame_t *frame = NULL;
+		if (frames)
+			frame = nic_alloc_frame(nic, len - sizeof(*hdr));
 		if (frame) {
 			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
+			nic_frame_list_append(frames, frame);
+			count++;
 		} else {
 			ddf_msg(LVL_WARN,
 			    "Cannot allocate RX frame, packet dropped");
@@ -100,6 +106,26 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
 	}
 
+	fibril_mutex_unlock(&virtio_net->rx_lock);
+
+	nic_received_frame_list(nic, frames);
+	return count;
+}
+
+static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	size_t frames = virtio_net_receive(nic);
+
+	/* Under heavy load the frames are polled instead */
+	if (nic_report_rx_interrupt(nic, frames))
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, false);
+
+	uint16_t descno;
+	uint32_t len;
 	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
 		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
 		    descno);
@@ -110,6 +136,40 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	}
 }
 
+static void virtio_net_poll(nic_t *nic)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	size_t frames = virtio_net_receive(nic);
+
+	/* Back to interrupts once the load drops in adaptive mode */
+	if (!nic_report_rx_poll(nic, frames)) {
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, true);
+		/* Pick up frames which arrived before interrupts were enabled */
+		virtio_net_receive(nic);
+	}
+}
+
+static errno_t virtio_net_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+	case NIC_POLL_ADAPTIVE:
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, true);
+		return EOK;
+	case NIC_POLL_ON_DEMAND:
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, false);
+		return EOK;
+	default:
+		return ENOTSUP;
+	}
+}
+
 static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
@@ -180,6 +240,8 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	nic_set_specific(nic, virtio_net);
 
+	fibril_mutex_initialize(&virtio_net->rx_lock);
+
 	errno_t rc = virtio_pci_dev_initialize(dev, &virtio_net->virtio_dev);
 	if (rc != EOK)
 		return rc;
@@ -414,6 +476,12 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
+	nic_set_poll_handlers(nic, virtio_net_poll_mode_change,
+	    virtio_net_poll);
+
+	rc = nic_report_poll_mode(nic, NIC_POLL_ADAPTIVE, NULL);
+	if (rc != EOK)
+		goto destroy;
 
 	rc = ddf_fun_bind(fun);
 	if (rc != EOK) {
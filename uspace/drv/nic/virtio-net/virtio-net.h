@@ -73,6 +73,9 @@ typedef struct {
 	uint16_t tx_free_head;
 	uint16_t ct_free_head;
 
+	/** Serializes receiving between the interrupt handler and polling */
+	fibril_mutex_t rx_lock;
+
 	int irq;
 	cap_irq_handle_t irq_handle;
 } virtio_net_t;
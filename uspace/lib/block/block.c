@@ -54,24 +54,65 @@
 #include <str_error.h>
 #include <offset.h>
 #include <inttypes.h>
+#include <qsort.h>
+#include <stdatomic.h>
+#include <time.h>
 #include "block.h"
 
 #define MAX_WRITE_RETRIES 10
 
+/** Initial size of the readahead window (in logical blocks). */
+#define RA_MIN_BLOCKS	2
+/** Maximum size of the readahead window (in logical blocks). */
+#define RA_MAX_BLOCKS	8
+
+/** Maximum number of blocks written back with a single request. */
+#define FLUSH_MAX_BLOCKS	32
+/** Default maximum age of a dirty block in write-back mode. */
+#define FLUSH_AGE_DEFAULT	SEC2USEC(5)
+/** Default percentage of dirty blocks that triggers a write-back. */
+#define FLUSH_RATIO_DEFAULT	50
+
+/** Number of independently locked parts of a block cache. */
+#define CACHE_SHARDS	8
+
 /** Lock protecting the device connection list */
 static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
 static LIST_INITIALIZE(dcl);
 
+/** Part of a block cache holding blocks with the same address hash. */
 typedef struct {
 	fibril_mutex_t lock;
+	hash_table_t block_hash;
+	/**
+	 * All blocks of the shard in CLOCK order, the first block being under
+	 * the clock hand.
+	 */
+	list_t clock_list;
+	unsigned blocks;          /**< Number of blocks in the shard. */
+	unsigned blocks_free;     /**< Number of unreferenced blocks. */
+	uint64_t hits;            /**< Number of block_get() cache hits. */
+	uint64_t misses;          /**< Number of block_get() cache misses. */
+	uint64_t evictions;       /**< Number of blocks reused for others. */
+} cache_shard_t;
+
+typedef struct {
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
 	unsigned block_count;     /**< Total number of blocks. */
-	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
-	list_t free_list;
+	atomic_uint blocks_cached; /**< Number of cached blocks. */
+	atomic_uint blocks_dirty; /**< Number of blocks accounted as dirty. */
 	enum cache_mode mode;
+	cache_shard_t shards[CACHE_SHARDS];
+	/** Protects the flusher state. */
+	fibril_mutex_t lock;
+	usec_t flush_age;         /**< Maximum age of a dirty block. */
+	atomic_uint flush_ratio;  /**< Percentage of dirty blocks to flush at. */
+	/** Wakes up the flusher and signals its termination. */
+	fibril_condvar_t flush_cv;
+	bool flusher_running;
+	bool flusher_stop;
 } cache_t;
 
 typedef struct {
@@ -84,11 +125,17 @@ typedef struct {
 	aoff64_t pblocks;    /**< Number of physical blocks */
 	size_t pblock_size;  /**< Physical block size. */
 	cache_t *cache;
+	/** Logical block expected next if the access is sequential. */
+	_Atomic aoff64_t ra_next;
+	/** Current readahead window (logical blocks). */
+	atomic_size_t ra_window;
 } devcon_t;
 
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static errno_t write_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static aoff64_t ba_ltop(devcon_t *, aoff64_t);
+static errno_t cache_flush(devcon_t *, aoff64_t, aoff64_t, usec_t);
+static errno_t cache_flusher(void *);
 
 static devcon_t *devcon_search(service_id_t service_id)
 {
@@ -123,6 +170,8 @@ static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
 	devcon->pblock_size = bsize;
 	devcon->pblocks = dev_size;
 	devcon->cache = NULL;
+	atomic_init(&devcon->ra_next, 0);
+	atomic_init(&devcon->ra_window, 0);
 
 	fibril_mutex_lock(&dcl_lock);
 	list_foreach(dcl, link, devcon_t, d) {
@@ -281,11 +330,16 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 		return ENOMEM;
 
 	fibril_mutex_initialize(&cache->lock);
-	list_initialize(&cache->free_list);
 	cache->lblock_size = size;
 	cache->block_count = blocks;
-	cache->blocks_cached = 0;
+	atomic_init(&cache->blocks_cached, 0);
+	atomic_init(&cache->blocks_dirty, 0);
 	cache->mode = mode;
+	cache->flush_age = FLUSH_AGE_DEFAULT;
+	atomic_init(&cache->flush_ratio, FLUSH_RATIO_DEFAULT);
+	fibril_condvar_initialize(&cache->flush_cv);
+	cache->flusher_running = false;
+	cache->flusher_stop = false;
 
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
@@ -294,13 +348,145 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	}
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
-
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
-		free(cache);
-		return ENOMEM;
+	atomic_store(&devcon->ra_next, 0);
+	atomic_store(&devcon->ra_window, 0);
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_initialize(&shard->lock);
+		list_initialize(&shard->clock_list);
+		shard->blocks = 0;
+		shard->blocks_free = 0;
+		shard->hits = 0;
+		shard->misses = 0;
+		shard->evictions = 0;
+
+		if (!hash_table_create(&shard->block_hash, 0, 0, &cache_ops)) {
+			while (i-- > 0)
+				hash_table_destroy(&cache->shards[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
 	}
 
 	devcon->cache = cache;
+
+	if (mode == CACHE_MODE_WB) {
+		/* Dirty blocks are written back by a background fibril. */
+		fid_t fid = fibril_create(cache_flusher, devcon);
+		if (!fid) {
+			devcon->cache = NULL;
+			for (unsigned i = 0; i < CACHE_SHARDS; i++)
+				hash_table_destroy(&cache->shards[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
+
+		cache->flusher_running = true;
+		fibril_add_ready(fid);
+	}
+
+	return EOK;
+}
+
+/** Set write-back parameters of the block cache.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param max_age	Maximum time a block can stay dirty.
+ * @param ratio		Percentage of dirty cached blocks at which the dirty
+ *			blocks are written back regardless of their age.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_set_writeback(service_id_t service_id, usec_t max_age,
+    unsigned ratio)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOENT;
+	if (max_age <= 0 || ratio > 100)
+		return EINVAL;
+
+	cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->lock);
+	cache->flush_age = max_age;
+	atomic_store(&cache->flush_ratio, ratio);
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->lock);
+
+	return EOK;
+}
+
+/** Get statistics of the block cache.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param stats		Place to store the statistics.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_get_stats(service_id_t service_id,
+    block_cache_stats_t *stats)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOENT;
+
+	cache = devcon->cache;
+
+	stats->hits = 0;
+	stats->misses = 0;
+	stats->evictions = 0;
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->evictions += shard->evictions;
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	stats->blocks_cached = atomic_load(&cache->blocks_cached);
+	stats->blocks_dirty = atomic_load(&cache->blocks_dirty);
+	return EOK;
+}
+
+/** Get block cache hit/miss/eviction counters.
+ *
+ * This has the signature of libfs_ops_t.cache_stats so that file system
+ * servers which use the block cache can plug it in directly.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param hits		Place to store the number of cache hits.
+ * @param misses	Place to store the number of cache misses.
+ * @param evictions	Place to store the number of evicted blocks.
+ *
+ * @return		EOK on success or ENOENT if the device has no cache.
+ */
+errno_t block_cache_stats(service_id_t service_id, uint64_t *hits,
+    uint64_t *misses, uint64_t *evictions)
+{
+	block_cache_stats_t stats;
+	errno_t rc;
+
+	rc = block_cache_get_stats(service_id, &stats);
+	if (rc != EOK)
+		return rc;
+
+	*hits = stats.hits;
+	*misses = stats.misses;
+	*evictions = stats.evictions;
 	return EOK;
 }
 
@@ -316,30 +502,52 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	/* Stop the flusher. */
+	fibril_mutex_lock(&cache->lock);
+	cache->flusher_stop = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	while (cache->flusher_running)
+		fibril_condvar_wait(&cache->flush_cv, &cache->lock);
+	fibril_mutex_unlock(&cache->lock);
+
+	/*
+	 * Write back as much as possible in clusters first. Whatever fails
+	 * to be written is retried block by block below.
+	 */
+	(void) cache_flush(devcon, 0, 0, 0);
+
 	/*
-	 * We are expecting to find all blocks for this device handle on the
-	 * free list, i.e. the block reference count should be zero. Do not
+	 * We are expecting all blocks for this device handle to be
+	 * unreferenced, i.e. the block reference count should be zero. Do not
 	 * bother with the cache and block locks because we are single-threaded.
 	 */
-	while (!list_empty(&cache->free_list)) {
-		block_t *b = list_get_instance(list_first(&cache->free_list),
-		    block_t, free_link);
-
-		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
 
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
+		while (!list_empty(&shard->clock_list)) {
+			block_t *b = list_get_instance(
+			    list_first(&shard->clock_list), block_t, clock_link);
 
-		free(b->data);
-		free(b);
+			assert(b->refcnt == 0);
+			if (b->dirty) {
+				rc = write_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data, b->size);
+				if (rc != EOK)
+					return rc;
+			}
+
+			list_remove(&b->clock_link);
+			hash_table_remove_item(&shard->block_hash,
+			    &b->hash_link);
+			shard->blocks--;
+
+			free(b->data);
+			free(b);
+		}
 	}
 
-	hash_table_destroy(&cache->block_hash);
+	for (unsigned i = 0; i < CACHE_SHARDS; i++)
+		hash_table_destroy(&cache->shards[i].block_hash);
 	devcon->cache = NULL;
 	free(cache);
 
@@ -348,15 +556,61 @@ errno_t block_cache_fini(service_id_t service_id)
 
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
-static bool cache_can_grow(cache_t *cache)
+static bool cache_can_grow(cache_t *cache, cache_shard_t *shard)
 {
-	if (cache->blocks_cached < CACHE_LO_WATERMARK)
+	if (atomic_load(&cache->blocks_cached) < CACHE_LO_WATERMARK)
 		return true;
-	if (!list_empty(&cache->free_list))
+	if (shard->blocks_free > 0)
 		return false;
 	return true;
 }
 
+/** Get the shard of the cache holding the given block. */
+static cache_shard_t *cache_shard(cache_t *cache, aoff64_t lba)
+{
+	return &cache->shards[lba % CACHE_SHARDS];
+}
+
+/** Choose a block to be reused using the CLOCK algorithm.
+ *
+ * The clock hand is the head of the shard's block list. Blocks that the hand
+ * passes move to the end of the list. Recently accessed blocks lose their
+ * accessed flag and get a second chance.
+ *
+ * @param shard		Locked shard.
+ * @param clean_only	If true, dirty blocks are not considered.
+ *
+ * @return		Unreferenced block or NULL if there is none.
+ */
+static block_t *cache_clock_victim(cache_shard_t *shard, bool clean_only)
+{
+	assert(fibril_mutex_is_locked(&shard->lock));
+
+	if (shard->blocks_free == 0)
+		return NULL;
+
+	for (unsigned steps = 2 * shard->blocks; steps > 0; steps--) {
+		link_t *link = list_first(&shard->clock_list);
+		block_t *b = list_get_instance(link, block_t, clock_link);
+
+		list_remove(link);
+		list_append(link, &shard->clock_list);
+
+		if (b->refcnt > 0)
+			continue;
+		if (b->accessed) {
+			b->accessed = false;
+			continue;
+		}
+		if (clean_only && b->dirty)
+			continue;
+
+		return b;
+	}
+
+	return NULL;
+}
+
 static void block_initialize(block_t *b)
 {
 	fibril_mutex_initialize(&b->lock);
@@ -364,8 +618,243 @@ static void block_initialize(block_t *b)
 	b->write_failures = 0;
 	b->dirty = false;
 	b->toxic = false;
+	b->accessed = false;
 	fibril_rwlock_initialize(&b->contents_lock);
-	link_initialize(&b->free_link);
+	b->dirty_counted = false;
+}
+
+/** Account for a change of the dirty state of a block.
+ *
+ * Clients mark blocks dirty directly, so the cache notices them only when
+ * they are released.
+ *
+ * @param cache		Locked cache.
+ * @param b		Locked block.
+ */
+static void block_track_dirty(cache_t *cache, block_t *b)
+{
+	if (b->dirty && !b->dirty_counted) {
+		getuptime(&b->dirtied);
+		b->dirty_counted = true;
+		atomic_fetch_add(&cache->blocks_dirty, 1);
+	} else if (!b->dirty && b->dirty_counted) {
+		b->dirty_counted = false;
+		atomic_fetch_sub(&cache->blocks_dirty, 1);
+	}
+}
+
+/** Stop accounting for a block which is leaving the cache or being reused. */
+static void block_untrack(cache_t *cache, block_t *b)
+{
+	if (b->dirty_counted) {
+		b->dirty_counted = false;
+		atomic_fetch_sub(&cache->blocks_dirty, 1);
+	}
+}
+
+/** Get a block structure for a block that is going to be prefetched.
+ *
+ * Unlike block_get(), this never writes back dirty blocks and does not grow
+ * the cache beyond the high watermark, so that prefetching never evicts
+ * anything expensive.
+ *
+ * @param cache		Cache.
+ * @param shard		Locked shard the block is going to belong to.
+ *
+ * @return		Block structure or NULL if none is available.
+ */
+static block_t *prefetch_block_alloc(cache_t *cache, cache_shard_t *shard)
+{
+	block_t *b;
+
+	assert(fibril_mutex_is_locked(&shard->lock));
+
+	if (atomic_load(&cache->blocks_cached) < CACHE_HI_WATERMARK) {
+		b = malloc(sizeof(block_t));
+		if (b) {
+			b->data = malloc(cache->lblock_size);
+			if (b->data) {
+				atomic_fetch_add(&cache->blocks_cached, 1);
+				list_append(&b->clock_link, &shard->clock_list);
+				shard->blocks++;
+				return b;
+			}
+			free(b);
+		}
+	}
+
+	b = cache_clock_victim(shard, true);
+	if (!b)
+		return NULL;
+
+	/* Skip blocks that are just being written back. */
+	if (!fibril_mutex_trylock(&b->lock))
+		return NULL;
+	bool dirty = b->dirty;
+	fibril_mutex_unlock(&b->lock);
+	if (dirty)
+		return NULL;
+
+	hash_table_remove_item(&shard->block_hash, &b->hash_link);
+	block_untrack(cache, b);
+	shard->blocks_free--;
+	shard->evictions++;
+	return b;
+}
+
+/** Read a run of blocks into the cache with a single device request.
+ *
+ * Blocks at the start of the range that are already cached are skipped. The
+ * run then ends at the next cached block or when no block structure can be
+ * obtained cheaply.
+ *
+ * @param devcon	Device connection.
+ * @param ba		First logical block address.
+ * @param cnt		Number of blocks (at most RA_MAX_BLOCKS).
+ * @param done		Place to store the number of blocks processed (read
+ *			or skipped). Zero means no progress could be made.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_prefetch(devcon_t *devcon, aoff64_t ba, size_t cnt,
+    size_t *done)
+{
+	cache_t *cache = devcon->cache;
+	block_t *blocks[RA_MAX_BLOCKS];
+	size_t skip = 0;
+	size_t n = 0;
+	errno_t rc = EOK;
+
+	assert(cnt <= RA_MAX_BLOCKS);
+
+	while (skip < cnt) {
+		aoff64_t lba = ba + skip;
+		cache_shard_t *shard = cache_shard(cache, lba);
+
+		fibril_mutex_lock(&shard->lock);
+		bool cached = hash_table_find(&shard->block_hash, &lba) != NULL;
+		fibril_mutex_unlock(&shard->lock);
+		if (!cached)
+			break;
+		skip++;
+	}
+
+	while (skip + n < cnt) {
+		aoff64_t lba = ba + skip + n;
+		cache_shard_t *shard = cache_shard(cache, lba);
+
+		fibril_mutex_lock(&shard->lock);
+		if (hash_table_find(&shard->block_hash, &lba)) {
+			fibril_mutex_unlock(&shard->lock);
+			break;
+		}
+
+		block_t *b = prefetch_block_alloc(cache, shard);
+		if (!b) {
+			fibril_mutex_unlock(&shard->lock);
+			break;
+		}
+
+		block_initialize(b);
+		b->service_id = devcon->service_id;
+		b->size = cache->lblock_size;
+		b->lba = lba;
+		b->pba = ba_ltop(devcon, b->lba);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
+
+		/*
+		 * Keep the block locked until its contents are read so that
+		 * concurrent block_get() callers wait for the data.
+		 */
+		fibril_mutex_lock(&b->lock);
+		fibril_mutex_unlock(&shard->lock);
+		blocks[n++] = b;
+	}
+
+	*done = skip + n;
+	if (n == 0)
+		return EOK;
+
+	void *buf = malloc(n * cache->lblock_size);
+	if (buf) {
+		rc = read_blocks(devcon, blocks[0]->pba,
+		    n * cache->blocks_cluster, buf, n * cache->lblock_size);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		block_t *b = blocks[i];
+
+		if (!buf) {
+			/* Fall back to reading the blocks one by one. */
+			if (read_blocks(devcon, b->pba, cache->blocks_cluster,
+			    b->data, cache->lblock_size) != EOK)
+				b->toxic = true;
+		} else if (rc != EOK) {
+			b->toxic = true;
+		} else {
+			memcpy(b->data, buf + i * cache->lblock_size,
+			    cache->lblock_size);
+		}
+
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	/*
+	 * Only drop the references after all blocks are unlocked, as
+	 * block_put() takes the shard lock, which may be held by someone
+	 * waiting for one of the blocks.
+	 */
+	for (size_t i = 0; i < n; i++)
+		(void) block_put(blocks[i]);
+
+	free(buf);
+	return rc;
+}
+
+/** Update sequential access detection and get the readahead window.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Logical block address being accessed.
+ *
+ * @return		Number of blocks to read ahead starting at @a ba,
+ *			zero if no readahead should be done.
+ */
+static size_t readahead_window(devcon_t *devcon, aoff64_t ba)
+{
+	cache_t *cache = devcon->cache;
+	cache_shard_t *shard = cache_shard(cache, ba);
+	size_t window = 0;
+
+	/*
+	 * The detection is merely a heuristic, so concurrent accesses only
+	 * need to keep the state consistent, not exact.
+	 */
+	if (atomic_exchange(&devcon->ra_next, ba + 1) != ba) {
+		/* Random access, close the window. */
+		atomic_store(&devcon->ra_window, 0);
+		return 0;
+	}
+
+	fibril_mutex_lock(&shard->lock);
+	bool cached = hash_table_find(&shard->block_hash, &ba) != NULL;
+	fibril_mutex_unlock(&shard->lock);
+
+	if (!cached) {
+		/* Sequential miss, open or widen the window. */
+		window = atomic_load(&devcon->ra_window);
+		if (window == 0)
+			window = RA_MIN_BLOCKS;
+		else
+			window = min(2 * window, RA_MAX_BLOCKS);
+		atomic_store(&devcon->ra_window, window);
+	}
+
+	/* Do not read past the end of the device. */
+	aoff64_t pleft = devcon->pblocks - ba_ltop(devcon, ba);
+	if (window > pleft / cache->blocks_cluster)
+		window = pleft / cache->blocks_cluster;
+
+	return window;
 }
 
 /** Instantiate a block in memory and get a reference to it.
@@ -384,8 +873,8 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 {
 	devcon_t *devcon;
 	cache_t *cache;
+	cache_shard_t *shard;
 	block_t *b;
-	link_t *link;
 	aoff64_t p_ba;
 	errno_t rc;
 
@@ -395,6 +884,7 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 	assert(devcon->cache);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, ba);
 
 	/*
 	 * Check whether the logical block (or part of it) is beyond
@@ -407,12 +897,24 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 		return EIO;
 	}
 
+	if (!(flags & BLOCK_FLAGS_NOREAD)) {
+		/*
+		 * On a sequential miss, read the following blocks along with
+		 * the requested one using a single device request.
+		 */
+		size_t window = readahead_window(devcon, ba);
+		if (window > 1) {
+			size_t done;
+			(void) cache_prefetch(devcon, ba, window, &done);
+		}
+	}
+
 retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *hlink = hash_table_find(&shard->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -421,16 +923,18 @@ retry:
 		b = hash_table_get_inst(hlink, block_t, hash_link);
 		fibril_mutex_lock(&b->lock);
 		if (b->refcnt++ == 0)
-			list_remove(&b->free_link);
+			shard->blocks_free--;
+		b->accessed = true;
 		if (b->toxic)
 			rc = EIO;
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		shard->hits++;
+		fibril_mutex_unlock(&shard->lock);
 	} else {
 		/*
 		 * The block was not found in the cache.
 		 */
-		if (cache_can_grow(cache)) {
+		if (cache_can_grow(cache, shard)) {
 			/*
 			 * We can grow the cache by allocating new blocks.
 			 * Should the allocation fail, we fail over and try to
@@ -445,34 +949,33 @@ retry:
 				b = NULL;
 				goto recycle;
 			}
-			cache->blocks_cached++;
+			atomic_fetch_add(&cache->blocks_cached, 1);
+			list_append(&b->clock_link, &shard->clock_list);
+			shard->blocks++;
 		} else {
 			/*
-			 * Try to recycle a block from the free list.
+			 * Try to recycle an unreferenced block of the shard.
 			 */
 		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
+			b = cache_clock_victim(shard, false);
+			if (!b) {
+				fibril_mutex_unlock(&shard->lock);
 				rc = ENOMEM;
 				goto out;
 			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
 
 			fibril_mutex_lock(&b->lock);
 			if (b->dirty) {
 				/*
 				 * The block needs to be written back to the
 				 * device before it changes identity. Do this
-				 * while not holding the cache lock so that
-				 * concurrency is not impeded. Also move the
-				 * block to the end of the free list so that we
+				 * while not holding the shard lock so that
+				 * concurrency is not impeded. The clock hand
+				 * has already moved past the block so that we
 				 * do not slow down other instances of
-				 * block_get() draining the free list.
+				 * block_get() looking for a block to recycle.
 				 */
-				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
+				fibril_mutex_unlock(&shard->lock);
 				rc = write_blocks(devcon, b->pba,
 				    cache->blocks_cluster, b->data, b->size);
 				if (rc != EOK) {
@@ -496,7 +999,7 @@ retry:
 					b->write_failures = 0;
 
 				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
+				if (!fibril_mutex_trylock(&shard->lock)) {
 					/*
 					 * Somebody is probably racing with us.
 					 * Unlock the block and retry.
@@ -504,16 +1007,16 @@ retry:
 					fibril_mutex_unlock(&b->lock);
 					goto retry;
 				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
+				hlink = hash_table_find(&shard->block_hash, &ba);
 				if (hlink) {
 					/*
 					 * Someone else must have already
 					 * instantiated the block while we were
-					 * not holding the cache lock.
-					 * Leave the recycled block on the
-					 * freelist and continue as if we
-					 * found the block of interest during
-					 * the first try.
+					 * not holding the shard lock.
+					 * Leave the recycled block in the
+					 * cache and continue as if we found
+					 * the block of interest during the
+					 * first try.
 					 */
 					fibril_mutex_unlock(&b->lock);
 					goto found;
@@ -523,27 +1026,30 @@ retry:
 			fibril_mutex_unlock(&b->lock);
 
 			/*
-			 * Unlink the block from the free list and the hash
-			 * table.
+			 * Remove the block from the hash table. It stays in
+			 * the clock list under its new identity.
 			 */
-			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			hash_table_remove_item(&shard->block_hash, &b->hash_link);
+			block_untrack(cache, b);
+			shard->blocks_free--;
+			shard->evictions++;
 		}
 
+		shard->misses++;
 		block_initialize(b);
 		b->service_id = service_id;
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
 
 		/*
-		 * Lock the block before releasing the cache lock. Thus we don't
+		 * Lock the block before releasing the shard lock. Thus we don't
 		 * kill concurrent operations on the cache while doing I/O on
 		 * the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
 
 		if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
@@ -571,7 +1077,7 @@ out:
 
 /** Release a reference to a block.
  *
- * If the last reference is dropped, the block is put on the free list.
+ * If the last reference is dropped, the block becomes a candidate for reuse.
  *
  * @param block		Block of which a reference is to be released.
  *
@@ -581,6 +1087,7 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
+	cache_shard_t *shard;
 	unsigned blocks_cached;
 	enum cache_mode mode;
 	errno_t rc = EOK;
@@ -590,19 +1097,18 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, block->lba);
 
 retry:
-	fibril_mutex_lock(&cache->lock);
-	blocks_cached = cache->blocks_cached;
+	blocks_cached = atomic_load(&cache->blocks_cached);
 	mode = cache->mode;
-	fibril_mutex_unlock(&cache->lock);
 
 	/*
 	 * Determine whether to sync the block. Syncing the block is best done
-	 * when not holding the cache lock as it does not impede concurrency.
-	 * Since the situation may have changed when we unlocked the cache, the
+	 * when not holding the shard lock as it does not impede concurrency.
+	 * Since the situation may have changed when we unlocked the shard, the
 	 * blocks_cached and mode variables are mere hints. We will recheck the
-	 * conditions later when the cache lock is held again.
+	 * conditions later when the shard lock is held.
 	 */
 	fibril_mutex_lock(&block->lock);
 	if (block->toxic)
@@ -617,15 +1123,16 @@ retry:
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
 	fibril_mutex_lock(&block->lock);
+	block_track_dirty(cache, block);
 	if (!--block->refcnt) {
 		/*
 		 * Last reference to the block was dropped. Either free the
-		 * block or put it on the free list. In case of an I/O error,
-		 * free the block.
+		 * block or leave it in the cache for reuse. In case of an I/O
+		 * error, free the block.
 		 */
-		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
+		if ((atomic_load(&cache->blocks_cached) > CACHE_HI_WATERMARK) ||
 		    (rc != EOK)) {
 			/*
 			 * Currently there are too many cached blocks or there
@@ -635,14 +1142,14 @@ retry:
 			if (block->dirty) {
 				/*
 				 * We cannot sync the block while holding the
-				 * cache lock. Release everything and retry.
+				 * shard lock. Release everything and retry.
 				 */
 				block->refcnt++;
 
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
 					fibril_mutex_unlock(&block->lock);
-					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&shard->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -654,35 +1161,92 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			hash_table_remove_item(&shard->block_hash, &block->hash_link);
+			list_remove(&block->clock_link);
+			shard->blocks--;
+			block_untrack(cache, block);
 			fibril_mutex_unlock(&block->lock);
 			free(block->data);
 			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
+			atomic_fetch_sub(&cache->blocks_cached, 1);
+			fibril_mutex_unlock(&shard->lock);
 			return rc;
 		}
 		/*
-		 * Put the block on the free list.
+		 * Leave the block in the cache.
 		 */
 		if (cache->mode != CACHE_MODE_WB && block->dirty) {
 			/*
-			 * We cannot sync the block while holding the cache
+			 * We cannot sync the block while holding the shard
 			 * lock. Release everything and retry.
 			 */
 			block->refcnt++;
 			fibril_mutex_unlock(&block->lock);
-			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&shard->lock);
 			goto retry;
 		}
-		list_append(&block->free_link, &cache->free_list);
+		shard->blocks_free++;
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
+
+	/* Kick the flusher if there are too many dirty blocks. */
+	if (cache->mode == CACHE_MODE_WB &&
+	    atomic_load(&cache->blocks_dirty) * 100 >
+	    atomic_load(&cache->flush_ratio) *
+	    atomic_load(&cache->blocks_cached))
+		fibril_condvar_signal(&cache->flush_cv);
 
 	return rc;
 }
 
+/** Read blocks into the cache ahead of their use.
+ *
+ * Contiguous runs of blocks that are not cached yet are read using as few
+ * device requests as possible. Prefetching is only a hint: it never evicts
+ * dirty blocks and silently stops when the cache cannot take more blocks.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of first block (logical).
+ * @param cnt		Number of blocks.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_prefetch(service_id_t service_id, aoff64_t ba, size_t cnt)
+{
+	devcon_t *devcon;
+	cache_t *cache;
+	errno_t rc;
+
+	devcon = devcon_search(service_id);
+	assert(devcon);
+	assert(devcon->cache);
+
+	cache = devcon->cache;
+
+	/* Clip the range at the end of the device. */
+	aoff64_t lblocks = devcon->pblocks / cache->blocks_cluster;
+	if (ba >= lblocks)
+		return EOK;
+	if (cnt > lblocks - ba)
+		cnt = lblocks - ba;
+
+	while (cnt > 0) {
+		size_t done;
+
+		rc = cache_prefetch(devcon, ba, min(cnt, RA_MAX_BLOCKS), &done);
+		if (rc != EOK)
+			return rc;
+		if (done == 0)
+			break;
+
+		ba += done;
+		cnt -= done;
+	}
+
+	return EOK;
+}
+
 /** Read sequential data from a block device.
  *
  * @param service_id	Service ID of the block device.
@@ -788,20 +1352,31 @@ errno_t block_write_direct(service_id_t service_id, aoff64_t ba, size_t cnt,
 }
 
 /** Synchronize blocks to persistent storage.
+ *
+ * Dirty cached blocks overlapping the range are written back first, unless
+ * they are currently referenced.
  *
  * @param service_id	Service ID of the block device.
  * @param ba		Address of first block (physical).
- * @param cnt		Number of blocks.
+ * @param cnt		Number of blocks, zero for the whole device.
  *
  * @return		EOK on success or an error code on failure.
  */
 errno_t block_sync_cache(service_id_t service_id, aoff64_t ba, size_t cnt)
 {
 	devcon_t *devcon;
+	errno_t rc;
 
 	devcon = devcon_search(service_id);
 	assert(devcon);
 
+	if (devcon->cache) {
+		/* Write back the cached blocks within the range first. */
+		rc = cache_flush(devcon, ba, cnt, 0);
+		if (rc != EOK)
+			return rc;
+	}
+
 	return bd_sync_cache(devcon->bd, ba, cnt);
 }
 
@@ -960,6 +1535,224 @@ static errno_t write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *dat
 	return rc;
 }
 
+static int block_lba_cmp(const void *a, const void *b)
+{
+	const block_t *ba = *(const block_t **) a;
+	const block_t *bb = *(const block_t **) b;
+
+	if (ba->lba < bb->lba)
+		return -1;
+	return ba->lba > bb->lba;
+}
+
+/** Write back a run of blocks with adjacent addresses.
+ *
+ * The caller holds a reference to each of the blocks. A block is only marked
+ * clean if nobody else holds a reference, as somebody may be modifying it.
+ *
+ * @param devcon	Device connection.
+ * @param blocks	Blocks sorted by address.
+ * @param n		Number of blocks (at most FLUSH_MAX_BLOCKS).
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t flush_run(devcon_t *devcon, block_t **blocks, size_t n)
+{
+	cache_t *cache = devcon->cache;
+	size_t size = cache->lblock_size;
+	bool cleaned[FLUSH_MAX_BLOCKS];
+	void *buf = NULL;
+	errno_t rc = EOK;
+
+	assert(n <= FLUSH_MAX_BLOCKS);
+
+	if (n > 1)
+		buf = malloc(n * size);
+
+	if (!buf) {
+		/* Write the blocks one by one. */
+		for (size_t i = 0; i < n; i++) {
+			block_t *b = blocks[i];
+			fibril_mutex_lock(&b->lock);
+			errno_t brc = write_blocks(devcon, b->pba,
+			    cache->blocks_cluster, b->data, b->size);
+			if (brc == EOK) {
+				b->write_failures = 0;
+				if (b->refcnt == 1)
+					b->dirty = false;
+			} else {
+				b->write_failures++;
+				rc = brc;
+			}
+			fibril_mutex_unlock(&b->lock);
+		}
+
+		return rc;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		block_t *b = blocks[i];
+		fibril_mutex_lock(&b->lock);
+		memcpy(buf + i * size, b->data, size);
+		cleaned[i] = (b->refcnt == 1);
+		if (cleaned[i])
+			b->dirty = false;
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	rc = write_blocks(devcon, blocks[0]->pba, n * cache->blocks_cluster,
+	    buf, n * size);
+
+	for (size_t i = 0; i < n; i++) {
+		block_t *b = blocks[i];
+		fibril_mutex_lock(&b->lock);
+		if (rc == EOK) {
+			b->write_failures = 0;
+		} else {
+			b->write_failures++;
+			if (cleaned[i])
+				b->dirty = true;
+		}
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	free(buf);
+	return rc;
+}
+
+/** Write back dirty blocks, clustering blocks with adjacent addresses.
+ *
+ * Only blocks that are not referenced are written back.
+ *
+ * @param devcon	Device connection.
+ * @param pba		First physical block of the range to write back.
+ * @param pcnt		Number of physical blocks, zero for the whole device.
+ * @param min_age	Write back only blocks that have been dirty for at
+ *			least this long.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_flush(devcon_t *devcon, aoff64_t pba, aoff64_t pcnt,
+    usec_t min_age)
+{
+	cache_t *cache = devcon->cache;
+	struct timespec now;
+	block_t **blocks;
+	size_t nblocks = 0;
+	errno_t rc = EOK;
+
+	getuptime(&now);
+
+	/*
+	 * Blocks added to the cache while we are collecting them need not be
+	 * written back by this call.
+	 */
+	size_t max_blocks = atomic_load(&cache->blocks_cached);
+	if (max_blocks == 0)
+		return EOK;
+
+	blocks = malloc(max_blocks * sizeof(block_t *));
+	if (!blocks)
+		return ENOMEM;
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+
+		list_foreach(shard->clock_list, clock_link, block_t, b) {
+			if (nblocks == max_blocks)
+				break;
+
+			if (pcnt != 0 && (b->pba >= pba + pcnt ||
+			    b->pba + cache->blocks_cluster <= pba))
+				continue;
+
+			/* Skip blocks that are just being written back. */
+			if (!fibril_mutex_trylock(&b->lock))
+				continue;
+
+			bool flush = b->refcnt == 0 && b->dirty && !b->toxic;
+			if (flush && min_age > 0) {
+				flush = b->dirty_counted &&
+				    NSEC2USEC(ts_sub_diff(&now, &b->dirtied)) >=
+				    min_age;
+			}
+
+			if (flush) {
+				/* Keep the block in the cache while writing it. */
+				b->refcnt++;
+				shard->blocks_free--;
+				blocks[nblocks++] = b;
+			}
+
+			fibril_mutex_unlock(&b->lock);
+		}
+
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	qsort(blocks, nblocks, sizeof(block_t *), block_lba_cmp);
+
+	for (size_t i = 0; i < nblocks;) {
+		size_t n = 1;
+		while (i + n < nblocks && n < FLUSH_MAX_BLOCKS &&
+		    blocks[i + n]->lba == blocks[i]->lba + n)
+			n++;
+
+		errno_t frc = flush_run(devcon, &blocks[i], n);
+		if (frc != EOK)
+			rc = frc;
+		i += n;
+	}
+
+	for (size_t i = 0; i < nblocks; i++)
+		(void) block_put(blocks[i]);
+
+	free(blocks);
+	return rc;
+}
+
+/** Background fibril writing back dirty blocks of a write-back cache.
+ *
+ * Blocks are written back once they have been dirty for too long, or
+ * immediately if the cache has too many dirty blocks.
+ *
+ * @param arg		Device connection.
+ *
+ * @return		EOK.
+ */
+static errno_t cache_flusher(void *arg)
+{
+	devcon_t *devcon = (devcon_t *) arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->lock);
+
+	while (!cache->flusher_stop) {
+		(void) fibril_condvar_wait_timeout(&cache->flush_cv,
+		    &cache->lock, max(cache->flush_age / 2, 1));
+		if (cache->flusher_stop)
+			break;
+
+		usec_t min_age = cache->flush_age;
+		if (atomic_load(&cache->blocks_dirty) * 100 >
+		    atomic_load(&cache->flush_ratio) *
+		    atomic_load(&cache->blocks_cached))
+			min_age = 0;
+
+		fibril_mutex_unlock(&cache->lock);
+		(void) cache_flush(devcon, 0, 0, min_age);
+		fibril_mutex_lock(&cache->lock);
+	}
+
+	cache->flusher_running = false;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->lock);
+
+	return EOK;
+}
+
 /** Convert logical block address to physical block address. */
 static aoff64_t ba_ltop(devcon_t *devcon, aoff64_t lba)
 {
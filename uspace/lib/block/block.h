@@ -70,6 +70,8 @@ typedef struct block {
 	bool dirty;
 	/** If true, the blcok does not contain valid data. */
 	bool toxic;
+	/** If true, the block was accessed since the clock hand passed it. */
+	bool accessed;
 	/** Readers / Writer lock protecting the contents of the block. */
 	fibril_rwlock_t contents_lock;
 	/** Service ID of service providing the block device. */
@@ -82,14 +84,32 @@ typedef struct block {
 	size_t size;
 	/** Number of write failures. */
 	int write_failures;
-	/** Link for placing the block into the free block list. */
-	link_t free_link;
+	/** If true, the block is accounted as dirty by the cache. */
+	bool dirty_counted;
+	/** Time when the cache first noticed the block being dirty. */
+	struct timespec dirtied;
+	/** Link for placing the block into the cache's clock list. */
+	link_t clock_link;
 	/** Link for placing the block into the block hash table. */
 	ht_link_t hash_link;
 	/** Buffer with the block data. */
 	void *data;
 } block_t;
 
+/** Block cache statistics */
+typedef struct {
+	/** Number of block_get() calls that found the block cached. */
+	uint64_t hits;
+	/** Number of block_get() calls that had to instantiate the block. */
+	uint64_t misses;
+	/** Number of cached blocks reused for different blocks. */
+	uint64_t evictions;
+	/** Number of cached blocks. */
+	unsigned blocks_cached;
+	/** Number of cached blocks known to be dirty. */
+	unsigned blocks_dirty;
+} block_cache_stats_t;
+
 /** Caching mode */
 enum cache_mode {
 	/** Write-Through */
@@ -106,9 +126,14 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_set_writeback(service_id_t, usec_t, unsigned);
+extern errno_t block_cache_get_stats(service_id_t, block_cache_stats_t *);
+extern errno_t block_cache_stats(service_id_t, uint64_t *, uint64_t *,
+    uint64_t *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
+extern errno_t block_prefetch(service_id_t, aoff64_t, size_t);
 
 extern errno_t block_seqread(service_id_t, void *, size_t *, size_t *, aoff64_t *,
     void *, size_t);
@@ -139,6 +139,9 @@ typedef struct {
 	/** Pointer to where the answer data is stored. */
 	ipc_call_t *dataptr;
 
+	/** Exchange in whose batch the message is queued or NULL if sent. */
+	async_exch_t *exch;
+
 	errno_t retval;
 } amsg_t;
 
@@ -232,6 +235,123 @@ void async_reply_received(ipc_call_t *data)
 	fibril_rmutex_unlock(&message_mutex);
 }
 
+/** Make all calls queued in the batch of an exchange.
+ *
+ * Messages whose calls could not be made are completed with the error
+ * code returned by the kernel.
+ *
+ * @param exch Exchange whose batch is to be flushed.
+ *
+ */
+static void async_batch_flush(async_exch_t *exch)
+{
+	if (exch->batch_count == 0)
+		return;
+
+	size_t submitted = 0;
+	errno_t rc = ipc_call_async_batch(exch->batch, exch->batch_count,
+	    &submitted);
+
+	fibril_rmutex_lock(&message_mutex);
+
+	for (size_t i = 0; i < exch->batch_count; i++) {
+		amsg_t *msg = (amsg_t *) exch->batch[i].label;
+		if (msg == NULL)
+			continue;
+
+		msg->exch = NULL;
+
+		if (i < submitted)
+			continue;
+
+		msg->retval = rc;
+		msg->done = true;
+
+		if (msg->forget)
+			amsg_destroy(msg);
+		else
+			fibril_notify(&msg->received);
+	}
+
+	fibril_rmutex_unlock(&message_mutex);
+
+	exch->batch_count = 0;
+}
+
+/** Queue a call in the batch of an exchange.
+ *
+ * @param exch    Exchange for sending the message.
+ * @param msg     Message record of the call or NULL if no answer is awaited.
+ * @param imethod Service-defined interface and method.
+ * @param arg1    Service-defined payload argument.
+ * @param arg2    Service-defined payload argument.
+ * @param arg3    Service-defined payload argument.
+ * @param arg4    Service-defined payload argument.
+ * @param arg5    Service-defined payload argument.
+ *
+ * @return True if the call was queued, false if the exchange is not
+ *         in batch mode and the call must be made directly.
+ *
+ */
+static bool async_batch_push(async_exch_t *exch, amsg_t *msg,
+    sysarg_t imethod, sysarg_t arg1, sysarg_t arg2, sysarg_t arg3,
+    sysarg_t arg4, sysarg_t arg5)
+{
+	if (!exch->batching)
+		return false;
+
+	if (exch->batch_count == IPC_BATCH_MAX)
+		async_batch_flush(exch);
+
+	ipc_batch_call_t *bcall = &exch->batch[exch->batch_count++];
+
+	bcall->phone = exch->phone;
+	bcall->label = (sysarg_t) msg;
+	bcall->args[0] = imethod;
+	bcall->args[1] = arg1;
+	bcall->args[2] = arg2;
+	bcall->args[3] = arg3;
+	bcall->args[4] = arg4;
+	bcall->args[5] = arg5;
+
+	if (msg != NULL)
+		msg->exch = exch;
+
+	return true;
+}
+
+/** Start queueing calls made in an exchange.
+ *
+ * Until async_batch_end() is called, the calls made by async_send_*() and
+ * async_msg_*() in the exchange are queued and made together by a single
+ * syscall. The queue is also flushed when it fills up, when an answer to
+ * one of the queued calls is waited for and when the exchange ends. Since
+ * async_req_*() and the data transfer wrappers are built on async_send_*(),
+ * a request followed by its data transfer costs a single syscall.
+ *
+ * @param exch Exchange to switch to batch mode.
+ *
+ */
+void async_batch_begin(async_exch_t *exch)
+{
+	if (exch != NULL)
+		exch->batching = true;
+}
+
+/** Make all calls queued in an exchange and stop queueing further calls.
+ *
+ * @param exch Exchange to switch back from batch mode.
+ *
+ */
+void async_batch_end(async_exch_t *exch)
+{
+	if (exch == NULL)
+		return;
+
+	async_batch_flush(exch);
+	exch->batching = false;
+}
+
 /** Send message and return id of the sent message.
  *
  * The return value can be used as input for async_wait() to wait for
@@ -260,6 +380,9 @@ static aid_t async_send_fast(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1
 
 	msg->dataptr = dataptr;
 
+	if (async_batch_push(exch, msg, imethod, arg1, arg2, arg3, arg4, 0))
+		return (aid_t) msg;
+
 	errno_t rc = ipc_call_async_4(exch->phone, imethod, arg1, arg2, arg3,
 	    arg4, msg);
 	if (rc != EOK) {
@@ -301,6 +424,9 @@ static aid_t async_send_slow(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1
 
 	msg->dataptr = dataptr;
 
+	if (async_batch_push(exch, msg, imethod, arg1, arg2, arg3, arg4, arg5))
+		return (aid_t) msg;
+
 	errno_t rc = ipc_call_async_5(exch->phone, imethod, arg1, arg2, arg3,
 	    arg4, arg5, msg);
 	if (rc != EOK) {
@@ -364,6 +490,9 @@ void async_wait_for(aid_t amsgid, errno_t *retval)
 	}
 
 	amsg_t *msg = (amsg_t *) amsgid;
+	if (msg->exch != NULL)
+		async_batch_flush(msg->exch);
+
 	fibril_wait_for(&msg->received);
 
 	if (retval)
@@ -395,6 +524,8 @@ errno_t async_wait_timeout(aid_t amsgid, errno_t *retval, usec_t timeout)
 	}
 
 	amsg_t *msg = (amsg_t *) amsgid;
+	if (msg->exch != NULL)
+		async_batch_flush(msg->exch);
 
 	/*
 	 * Negative timeout is converted to zero timeout to avoid
@@ -736,34 +867,39 @@ errno_t async_req_5_5(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1, sysar
 
 void async_msg_0(async_exch_t *exch, sysarg_t imethod)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, 0, 0, 0, 0, 0)))
 		ipc_call_async_0(exch->phone, imethod, NULL);
 }
 
 void async_msg_1(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, arg1, 0, 0, 0, 0)))
 		ipc_call_async_1(exch->phone, imethod, arg1, NULL);
 }
 
 void async_msg_2(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
     sysarg_t arg2)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, arg1, arg2, 0, 0, 0)))
 		ipc_call_async_2(exch->phone, imethod, arg1, arg2, NULL);
 }
 
 void async_msg_3(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, arg1, arg2, arg3, 0, 0)))
 		ipc_call_async_3(exch->phone, imethod, arg1, arg2, arg3, NULL);
 }
 
 void async_msg_4(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3, sysarg_t arg4)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, arg1, arg2, arg3, arg4, 0)))
 		ipc_call_async_4(exch->phone, imethod, arg1, arg2, arg3, arg4,
 		    NULL);
 }
@@ -771,7 +907,9 @@ void async_msg_4(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
 void async_msg_5(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
     sysarg_t arg2, sysarg_t arg3, sysarg_t arg4, sysarg_t arg5)
 {
-	if (exch != NULL)
+	if ((exch != NULL) &&
+	    (!async_batch_push(exch, NULL, imethod, arg1, arg2, arg3, arg4,
+	    arg5)))
 		ipc_call_async_5(exch->phone, imethod, arg1, arg2, arg3, arg4,
 		    arg5, NULL);
 }
@@ -1043,6 +1181,8 @@ async_exch_t *async_exchange_begin(async_sess_t *sess)
 				link_initialize(&exch->global_link);
 				exch->sess = sess;
 				exch->phone = sess->phone;
+				exch->batching = false;
+				exch->batch_count = 0;
 			}
 		} else if (mgmt == EXCHANGE_PARALLEL) {
 			cap_phone_handle_t phone;
@@ -1061,6 +1201,8 @@ async_exch_t *async_exchange_begin(async_sess_t *sess)
 					link_initialize(&exch->global_link);
 					exch->sess = sess;
 					exch->phone = phone;
+					exch->batching = false;
+					exch->batch_count = 0;
 				} else
 					async_hangup_internal(phone);
 			} else if (!list_empty(&inactive_exch_list)) {
@@ -1109,6 +1251,8 @@ void async_exchange_end(async_exch_t *exch)
 	if (exch == NULL)
 		return;
 
+	async_batch_end(exch);
+
 	async_sess_t *sess = exch->sess;
 	assert(sess != NULL);
 
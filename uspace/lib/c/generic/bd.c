@@ -86,6 +86,9 @@ errno_t bd_read_blocks(bd_t *bd, aoff64_t ba, size_t cnt, void *data, size_t siz
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
 
+	/* Make the request and the data transfer in a single syscall */
+	async_batch_begin(exch);
+
 	ipc_call_t answer;
 	aid_t req = async_send_3(exch, BD_READ_BLOCKS, LOWER32(ba),
 	    UPPER32(ba), cnt, &answer);
@@ -109,6 +112,7 @@ errno_t bd_read_blocks(bd_t *bd, aoff64_t ba, size_t cnt, void *data, size_t siz
 errno_t bd_read_toc(bd_t *bd, uint8_t session, void *buf, size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
+	async_batch_begin(exch);
 
 	ipc_call_t answer;
 	aid_t req = async_send_1(exch, BD_READ_TOC, session, &answer);
@@ -133,6 +137,7 @@ errno_t bd_write_blocks(bd_t *bd, aoff64_t ba, size_t cnt, const void *data,
     size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
+	async_batch_begin(exch);
 
 	ipc_call_t answer;
 	aid_t req = async_send_3(exch, BD_WRITE_BLOCKS, LOWER32(ba),
@@ -113,6 +113,9 @@ errno_t inet_send(inet_dgram_t *dgram, uint8_t ttl, inet_df_t df)
 {
 	async_exch_t *exch = async_exchange_begin(inet_sess);
 
+	/* The request goes out together with the first data transfer */
+	async_batch_begin(exch);
+
 	ipc_call_t answer;
 	aid_t req = async_send_4(exch, INET_SEND, dgram->iplink, dgram->tos,
 	    ttl, df, &answer);
@@ -228,6 +231,7 @@ static void inet_ev_recv(ipc_call_t *icall)
 		return;
 	}
 
+	/* Unless the callback took over the data */
 	rc = inet_ev_ops->recv(&dgram);
 	free(dgram.data);
 	async_answer_0(icall, rc);
@@ -453,14 +453,10 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	errno_t rc;
 
 	exch = async_exchange_begin(conn->tcp->sess);
+	async_batch_begin(exch);
 	aid_t req = async_send_1(exch, TCP_CONN_SEND, conn->id, NULL);
 
 	rc = async_data_write_start(exch, data, bytes);
-	if (rc != EOK) {
-		async_forget(req);
-		return rc;
-	}
-
 	async_exchange_end(exch);
 
 	if (rc != EOK) {
@@ -551,6 +547,7 @@ errno_t tcp_conn_recv(tcp_conn_t *conn, void *buf, size_t bsize, size_t *nrecv)
 	}
 
 	exch = async_exchange_begin(conn->tcp->sess);
+	async_batch_begin(exch);
 	aid_t req = async_send_1(exch, TCP_CONN_RECV, conn->id, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
 	async_exchange_end(exch);
@@ -600,6 +597,7 @@ again:
 	}
 
 	exch = async_exchange_begin(conn->tcp->sess);
+	async_batch_begin(exch);
 	aid_t req = async_send_1(exch, TCP_CONN_RECV_WAIT, conn->id, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
 	async_exchange_end(exch);
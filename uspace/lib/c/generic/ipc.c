@@ -109,6 +109,26 @@ errno_t ipc_call_async_slow(cap_phone_handle_t phandle, sysarg_t imethod,
 	    (sysarg_t) label);
 }
 
+/** Make several asynchronous calls at once.
+ *
+ * The calls are made in the order in which they appear in the array.
+ * The kernel stops at the first call which cannot be made.
+ *
+ * @param calls      Array of calls to make.
+ * @param count      Number of calls in the array (at most IPC_BATCH_MAX).
+ * @param submitted  Place to store the number of calls which were made.
+ *
+ * @return EOK if all calls were made.
+ * @return Error code of the first call which failed.
+ *
+ */
+errno_t ipc_call_async_batch(ipc_batch_call_t *calls, size_t count,
+    size_t *submitted)
+{
+	return (errno_t) __SYSCALL3(SYS_IPC_CALL_ASYNC_BATCH,
+	    (sysarg_t) calls, (sysarg_t) count, (sysarg_t) submitted);
+}
+
 /** Answer received call (fast version).
  *
  * The fast answer makes use of passing retval and first four arguments in
@@ -176,6 +196,28 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for several calls or answers at once.
+ *
+ * Blocks until the first call or answer arrives and then receives the
+ * already queued ones without blocking.
+ *
+ * @param calls     Array of buffers for the received calls.
+ * @param count     Number of buffers in the array (at most IPC_BATCH_MAX).
+ * @param usec      Timeout.
+ * @param flags     Flags passed to the kernel.
+ * @param received  Place to store the number of buffers which were filled.
+ *
+ * @return EOK if at least one call or answer was received.
+ * @return An error code otherwise.
+ *
+ */
+errno_t ipc_wait_batch(ipc_call_t *calls, size_t count, sysarg_t usec,
+    unsigned int flags, size_t *received)
+{
+	return (errno_t) __SYSCALL5(SYS_IPC_WAIT_BATCH, (sysarg_t) calls,
+	    (sysarg_t) count, usec, flags, (sysarg_t) received);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
@@ -58,6 +58,12 @@
 /** Magic used in heap descriptor. */
 #define HEAP_AREA_MAGIC  UINT32_C(0xBEEFCAFE)
 
+/** Magic used in slab descriptors. */
+#define HEAP_SLAB_MAGIC  UINT32_C(0xBEEF0303)
+
+/** Magic used in headers of small objects allocated from slabs. */
+#define HEAP_SLAB_OBJ_MAGIC  UINT32_C(0xBEEF0404)
+
 /** Allocation alignment.
  *
  * This also covers the alignment of fields
@@ -76,6 +82,24 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Size and alignment of a slab.
+ *
+ * Slabs are allocated as ordinary heap blocks and carved
+ * into small objects of a single size class.
+ *
+ */
+#define SLAB_SIZE  (4 * PAGE_SIZE)
+
+/** Number of slab size classes.
+ *
+ * Size class i holds objects of (BASE_ALIGN << i) bytes.
+ *
+ */
+#define SLAB_CLASS_COUNT  6
+
+/** Largest allocation served from slabs. */
+#define SLAB_CLASS_MAX  (BASE_ALIGN << (SLAB_CLASS_COUNT - 1))
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -184,6 +208,86 @@ typedef struct {
 	uint32_t magic;
 } heap_block_foot_t;
 
+/** Link of a free slab object
+ *
+ * Stored in the payload of the free object.
+ *
+ */
+typedef struct heap_slab_link {
+	struct heap_slab_link *next;
+} heap_slab_link_t;
+
+/** Slab descriptor
+ *
+ * Each slab belongs to the cache of one thread, which allocates
+ * from it and frees into it without taking the heap lock. Objects
+ * freed by other threads are put on a separate list protected by
+ * the heap lock and are reclaimed by the owner when it runs out
+ * of free objects.
+ *
+ * The descriptor is located at the very beginning of the slab,
+ * the objects follow. Each object is preceded by a heap block
+ * header with HEAP_SLAB_OBJ_MAGIC, so that free() can tell small
+ * objects from ordinary heap blocks.
+ *
+ */
+typedef struct heap_slab {
+	/** Cache owning the slab */
+	struct heap_cache *cache;
+
+	/** Previous slab on the partial list of the owner */
+	struct heap_slab *prev;
+
+	/** Next slab on the partial list of the owner */
+	struct heap_slab *next;
+
+	/** Free objects (accessed only by the owner) */
+	heap_slab_link_t *free;
+
+	/** Number of objects not on the free list (accessed only by the owner) */
+	size_t used;
+
+	/** Size class */
+	unsigned int sclass;
+
+	/** Slab is on the partial list of the owner */
+	bool partial;
+
+	/** Objects freed by other threads (protected by the heap lock) */
+	heap_slab_link_t *remote_free;
+
+	/** Next slab with remote frees (protected by the heap lock) */
+	struct heap_slab *remote_next;
+
+	/** Slab is on the remote list of the owner */
+	bool remote;
+
+	/** A magic value */
+	uint32_t magic;
+} heap_slab_t;
+
+/** Per-thread slab cache
+ *
+ * The cache is attached to the thread context fibril of a
+ * fibril runner thread and therefore only accessed by a single
+ * thread at a time. When the thread exits, the cache becomes dead
+ * and is protected by the heap lock until another thread adopts it.
+ *
+ */
+typedef struct heap_cache {
+	/** Slabs with free objects for each size class */
+	heap_slab_t *partial[SLAB_CLASS_COUNT];
+
+	/** Slabs with remotely freed objects (protected by the heap lock) */
+	heap_slab_t *remote;
+
+	/** The owner has exited (protected by the heap lock) */
+	bool dead;
+
+	/** Next dead cache (protected by the heap lock) */
+	struct heap_cache *next_dead;
+} heap_cache_t;
+
 /** First heap area */
 static heap_area_t *first_heap_area = NULL;
 
@@ -193,6 +297,9 @@ static heap_area_t *last_heap_area = NULL;
 /** Next heap block to examine (next fit algorithm) */
 static heap_block_head_t *next_fit = NULL;
 
+/** Caches of exited threads waiting to be adopted */
+static heap_cache_t *dead_caches = NULL;
+
 /** Futex for thread-safe heap manipulation */
 static fibril_rmutex_t malloc_mutex;
 
@@ -763,6 +870,454 @@ static void *malloc_internal(const size_t size, const size_t align)
 	return heap_grow_and_alloc(gross_size, falign);
 }
 
+/** Free a memory block
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param addr The address of the block.
+ *
+ */
+static void free_internal(void *const addr)
+{
+	/* Calculate the position of the header. */
+	heap_block_head_t *head =
+	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
+
+	block_check(head);
+	malloc_assert(!head->free);
+
+	heap_area_t *area = head->area;
+
+	area_check(area);
+	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
+	malloc_assert((void *) head < area->end);
+
+	/* Mark the block itself as free. */
+	head->free = true;
+
+	/* Look at the next block. If it is free, merge the two. */
+	heap_block_head_t *next_head =
+	    (heap_block_head_t *) (((void *) head) + head->size);
+
+	if ((void *) next_head < area->end) {
+		block_check(next_head);
+		if (next_head->free)
+			block_init(head, head->size + next_head->size, true, area);
+	}
+
+	/* Look at the previous block. If it is free, merge the two. */
+	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
+		heap_block_foot_t *prev_foot =
+		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
+
+		heap_block_head_t *prev_head =
+		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+
+		block_check(prev_head);
+
+		if (prev_head->free)
+			block_init(prev_head, prev_head->size + head->size, true,
+			    area);
+	}
+
+	heap_shrink(area);
+}
+
+/** Get the slab cache of the current thread
+ *
+ * Threads which have never blocked have no thread context
+ * fibril yet and use the heap directly.
+ *
+ * @param create Create the cache if it does not exist yet.
+ *
+ * @return Slab cache or NULL if there is none.
+ *
+ */
+static heap_cache_t *heap_cache_get(bool create)
+{
+	if (!__tcb_is_set())
+		return NULL;
+
+	fibril_t *ctx = fibril_self()->thread_ctx;
+	if (ctx == NULL)
+		return NULL;
+
+	if ((ctx->malloc_cache == NULL) && (create)) {
+		heap_lock();
+
+		/* Adopt the slabs of an exited thread if there are any */
+		heap_cache_t *cache = dead_caches;
+		if (cache != NULL) {
+			dead_caches = cache->next_dead;
+			cache->next_dead = NULL;
+			cache->dead = false;
+		} else {
+			cache = malloc_internal(sizeof(heap_cache_t),
+			    BASE_ALIGN);
+			if (cache != NULL)
+				memset(cache, 0, sizeof(heap_cache_t));
+		}
+
+		heap_unlock();
+
+		if (cache == NULL)
+			return NULL;
+
+		ctx->malloc_cache = cache;
+	}
+
+	return ctx->malloc_cache;
+}
+
+/** Get slab size class for an allocation size
+ *
+ * @param size Requested size (at most SLAB_CLASS_MAX).
+ *
+ * @return Size class.
+ *
+ */
+static inline unsigned int slab_class(size_t size)
+{
+	if (size <= BASE_ALIGN)
+		return 0;
+
+	return fnzb(size - 1) - fnzb(BASE_ALIGN) + 1;
+}
+
+/** Check a slab descriptor
+ *
+ * @param slab Slab to check.
+ *
+ */
+static void slab_check(heap_slab_t *slab)
+{
+	malloc_assert(slab->magic == HEAP_SLAB_MAGIC);
+	malloc_assert(((uintptr_t) slab % SLAB_SIZE) == 0);
+	malloc_assert(slab->sclass < SLAB_CLASS_COUNT);
+}
+
+/** Get the slab containing a small object
+ *
+ * @param head Header of the object.
+ *
+ * @return Slab containing the object.
+ *
+ */
+static heap_slab_t *slab_of(heap_block_head_t *head)
+{
+	heap_slab_t *slab = (heap_slab_t *) ALIGN_DOWN((uintptr_t) head,
+	    SLAB_SIZE);
+
+	slab_check(slab);
+	return slab;
+}
+
+/** Insert a slab to the partial list of its owner
+ *
+ * @param slab Slab to insert.
+ *
+ */
+static void slab_partial_insert(heap_slab_t *slab)
+{
+	heap_cache_t *cache = slab->cache;
+	heap_slab_t *first = cache->partial[slab->sclass];
+
+	slab->prev = NULL;
+	slab->next = first;
+	if (first != NULL)
+		first->prev = slab;
+
+	cache->partial[slab->sclass] = slab;
+	slab->partial = true;
+}
+
+/** Remove a slab from the partial list of its owner
+ *
+ * @param slab Slab to remove.
+ *
+ */
+static void slab_partial_remove(heap_slab_t *slab)
+{
+	heap_cache_t *cache = slab->cache;
+
+	if (slab->prev != NULL)
+		slab->prev->next = slab->next;
+	else
+		cache->partial[slab->sclass] = slab->next;
+
+	if (slab->next != NULL)
+		slab->next->prev = slab->prev;
+
+	slab->prev = NULL;
+	slab->next = NULL;
+	slab->partial = false;
+}
+
+/** Create a new slab
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param cache  Owner of the new slab.
+ * @param sclass Size class of the new slab.
+ *
+ * @return New slab or NULL on not enough memory.
+ *
+ */
+static heap_slab_t *slab_create(heap_cache_t *cache, unsigned int sclass)
+{
+	heap_slab_t *slab = malloc_internal(SLAB_SIZE, SLAB_SIZE);
+	if (slab == NULL)
+		return NULL;
+
+	slab->cache = cache;
+	slab->prev = NULL;
+	slab->next = NULL;
+	slab->free = NULL;
+	slab->used = 0;
+	slab->sclass = sclass;
+	slab->partial = false;
+	slab->remote_free = NULL;
+	slab->remote_next = NULL;
+	slab->remote = false;
+	slab->magic = HEAP_SLAB_MAGIC;
+
+	size_t obj_size = sizeof(heap_block_head_t) + (BASE_ALIGN << sclass);
+	uintptr_t end = (uintptr_t) slab + SLAB_SIZE;
+	heap_slab_link_t **last = &slab->free;
+
+	for (uintptr_t obj = ALIGN_UP((uintptr_t) slab + sizeof(heap_slab_t),
+	    BASE_ALIGN); obj + obj_size <= end; obj += obj_size) {
+		heap_block_head_t *head = (heap_block_head_t *) obj;
+
+		head->size = obj_size;
+		head->free = true;
+		head->area = NULL;
+		head->magic = HEAP_SLAB_OBJ_MAGIC;
+
+		heap_slab_link_t *link = (heap_slab_link_t *)
+		    (obj + sizeof(heap_block_head_t));
+		malloc_assert(((uintptr_t) link % BASE_ALIGN) == 0);
+
+		*last = link;
+		last = &link->next;
+	}
+
+	*last = NULL;
+	return slab;
+}
+
+/** Reclaim objects freed by other threads
+ *
+ * Should be called only inside the critical section
+ * by the owner of the cache.
+ *
+ * @param cache Cache to reclaim objects for.
+ *
+ */
+static void cache_reclaim(heap_cache_t *cache)
+{
+	while (cache->remote != NULL) {
+		heap_slab_t *slab = cache->remote;
+		cache->remote = slab->remote_next;
+
+		slab->remote_next = NULL;
+		slab->remote = false;
+
+		heap_slab_link_t *link = slab->remote_free;
+		slab->remote_free = NULL;
+
+		while (link != NULL) {
+			heap_slab_link_t *next = link->next;
+
+			link->next = slab->free;
+			slab->free = link;
+			slab->used--;
+
+			link = next;
+		}
+
+		if (!slab->partial)
+			slab_partial_insert(slab);
+	}
+}
+
+/** Return an empty slab to the heap
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param slab Empty slab which is on the partial list of its owner.
+ *
+ */
+static void slab_destroy(heap_slab_t *slab)
+{
+	malloc_assert(slab->used == 0);
+	malloc_assert(!slab->remote);
+
+	slab_partial_remove(slab);
+	slab->magic = 0;
+	free_internal(slab);
+}
+
+/** Allocate a small object from the slab cache
+ *
+ * @param cache  Slab cache of the current thread.
+ * @param sclass Size class to allocate from.
+ *
+ * @return Allocated object or NULL on not enough memory.
+ *
+ */
+static void *slab_alloc(heap_cache_t *cache, unsigned int sclass)
+{
+	heap_slab_t *slab = cache->partial[sclass];
+
+	if (slab == NULL) {
+		heap_lock();
+
+		cache_reclaim(cache);
+
+		slab = cache->partial[sclass];
+		if (slab == NULL) {
+			slab = slab_create(cache, sclass);
+			if (slab != NULL)
+				slab_partial_insert(slab);
+		}
+
+		heap_unlock();
+
+		if (slab == NULL)
+			return NULL;
+	}
+
+	heap_slab_link_t *link = slab->free;
+	malloc_assert(link != NULL);
+
+	slab->free = link->next;
+	slab->used++;
+
+	if (slab->free == NULL)
+		slab_partial_remove(slab);
+
+	heap_block_head_t *head = (heap_block_head_t *)
+	    ((void *) link - sizeof(heap_block_head_t));
+
+	malloc_assert(head->magic == HEAP_SLAB_OBJ_MAGIC);
+	malloc_assert(head->free);
+
+	head->free = false;
+	return (void *) link;
+}
+
+/** Free a small object
+ *
+ * Objects freed by the owner of the slab are returned to the slab
+ * without locking. Objects freed by other threads are queued for
+ * the owner under the heap lock.
+ *
+ * @param head Header of the object.
+ *
+ */
+static void slab_free(heap_block_head_t *head)
+{
+	heap_slab_t *slab = slab_of(head);
+	heap_slab_link_t *link = (heap_slab_link_t *)
+	    ((void *) head + sizeof(heap_block_head_t));
+
+	if (slab->cache != heap_cache_get(false)) {
+		heap_lock();
+
+		malloc_assert(!head->free);
+		head->free = true;
+
+		if (slab->cache->dead) {
+			/* Nobody owns the slab, free the object right away */
+			link->next = slab->free;
+			slab->free = link;
+			slab->used--;
+
+			if (!slab->partial)
+				slab_partial_insert(slab);
+
+			if (slab->used == 0)
+				slab_destroy(slab);
+
+			heap_unlock();
+			return;
+		}
+
+		link->next = slab->remote_free;
+		slab->remote_free = link;
+
+		if (!slab->remote) {
+			slab->remote = true;
+			slab->remote_next = slab->cache->remote;
+			slab->cache->remote = slab;
+		}
+
+		heap_unlock();
+		return;
+	}
+
+	malloc_assert(!head->free);
+	head->free = true;
+
+	link->next = slab->free;
+	slab->free = link;
+	slab->used--;
+
+	if (!slab->partial)
+		slab_partial_insert(slab);
+
+	/*
+	 * Return an empty slab to the heap unless it is the last
+	 * slab with free objects in its size class.
+	 */
+	if ((slab->used == 0) && ((slab->prev != NULL) ||
+	    (slab->next != NULL))) {
+		heap_lock();
+		slab_destroy(slab);
+		heap_unlock();
+	}
+}
+
+/** Release the slab cache of an exiting thread
+ *
+ * Empty slabs are returned to the heap. The cache with the remaining
+ * slabs is kept for adoption by another thread, meanwhile objects freed
+ * into it are returned to their slabs directly.
+ *
+ */
+void __malloc_thread_fini(void)
+{
+	heap_cache_t *cache = heap_cache_get(false);
+	if (cache == NULL)
+		return;
+
+	fibril_self()->thread_ctx->malloc_cache = NULL;
+
+	heap_lock();
+
+	cache_reclaim(cache);
+
+	for (unsigned int sclass = 0; sclass < SLAB_CLASS_COUNT; sclass++) {
+		heap_slab_t *slab = cache->partial[sclass];
+
+		while (slab != NULL) {
+			heap_slab_t *next = slab->next;
+
+			if (slab->used == 0)
+				slab_destroy(slab);
+
+			slab = next;
+		}
+	}
+
+	cache->dead = true;
+	cache->next_dead = dead_caches;
+	dead_caches = cache;
+
+	heap_unlock();
+}
+
 /** Allocate memory by number of elements
  *
  * @param nmemb Number of members to allocate.
@@ -792,6 +1347,12 @@ void *calloc(const size_t nmemb, const size_t size)
  */
 void *malloc(const size_t size)
 {
+	if (size <= SLAB_CLASS_MAX) {
+		heap_cache_t *cache = heap_cache_get(true);
+		if (cache != NULL)
+			return slab_alloc(cache, slab_class(size));
+	}
+
 	heap_lock();
 	void *block = malloc_internal(size, BASE_ALIGN);
 	heap_unlock();
@@ -815,6 +1376,10 @@ void *memalign(const size_t align, const size_t size)
 	size_t palign =
 	    1 << (fnzb(max(sizeof(void *), align) - 1) + 1);
 
+	/* Small objects are always aligned on BASE_ALIGN */
+	if (palign <= BASE_ALIGN)
+		return malloc(size);
+
 	heap_lock();
 	void *block = malloc_internal(size, palign);
 	heap_unlock();
@@ -840,12 +1405,29 @@ void *realloc(void *const addr, const size_t size)
 	if (addr == NULL)
 		return malloc(size);
 
-	heap_lock();
-
 	/* Calculate the position of the header. */
 	heap_block_head_t *head =
 	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
 
+	if (head->magic == HEAP_SLAB_OBJ_MAGIC) {
+		malloc_assert(!head->free);
+
+		/* Small objects are reallocated in place if possible. */
+		size_t net_size = head->size - sizeof(heap_block_head_t);
+		if (size <= net_size)
+			return addr;
+
+		void *ptr = malloc(size);
+		if (ptr != NULL) {
+			memcpy(ptr, addr, net_size);
+			free(addr);
+		}
+
+		return ptr;
+	}
+
+	heap_lock();
+
 	block_check(head);
 	malloc_assert(!head->free);
 
@@ -949,51 +1531,16 @@ void free(void *const addr)
 	if (addr == NULL)
 		return;
 
-	heap_lock();
-
-	/* Calculate the position of the header. */
 	heap_block_head_t *head =
 	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
 
-	block_check(head);
-	malloc_assert(!head->free);
-
-	heap_area_t *area = head->area;
-
-	area_check(area);
-	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) head < area->end);
-
-	/* Mark the block itself as free. */
-	head->free = true;
-
-	/* Look at the next block. If it is free, merge the two. */
-	heap_block_head_t *next_head =
-	    (heap_block_head_t *) (((void *) head) + head->size);
-
-	if ((void *) next_head < area->end) {
-		block_check(next_head);
-		if (next_head->free)
-			block_init(head, head->size + next_head->size, true, area);
-	}
-
-	/* Look at the previous block. If it is free, merge the two. */
-	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-		heap_block_foot_t *prev_foot =
-		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
-
-		heap_block_head_t *prev_head =
-		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
-
-		block_check(prev_head);
-
-		if (prev_head->free)
-			block_init(prev_head, prev_head->size + head->size, true,
-			    area);
+	if (head->magic == HEAP_SLAB_OBJ_MAGIC) {
+		slab_free(head);
+		return;
 	}
 
-	heap_shrink(area);
-
+	heap_lock();
+	free_internal(addr);
 	heap_unlock();
 }
 
@@ -91,6 +91,15 @@ struct async_exch {
 
 	/** Exchange identification */
 	cap_phone_handle_t phone;
+
+	/** Calls are being queued in batch instead of being made at once */
+	bool batching;
+
+	/** Number of calls queued in batch */
+	size_t batch_count;
+
+	/** Calls queued to be made by a single syscall */
+	ipc_batch_call_t batch[IPC_BATCH_MAX];
 };
 
 extern void __async_server_init(void);
@@ -62,6 +62,15 @@ struct fibril {
 
 	fibril_t *thread_ctx;
 
+	/* Slab cache of the thread (only used in thread context fibrils). */
+	struct heap_cache *malloc_cache;
+
+	/*
+	 * Runner the fibril is queued to when it becomes ready. For thread
+	 * context fibrils, this is the runner of the thread itself.
+	 */
+	struct fibril_runner *runner;
+
 	bool is_running : 1;
 	bool is_writer : 1;
 	/* In some places, we use fibril structs that can't be freed. */
@@ -37,6 +37,7 @@
 
 extern void __malloc_init(void);
 extern void __malloc_fini(void);
+extern void __malloc_thread_fini(void);
 
 #endif
 
@@ -183,6 +183,35 @@ stats_thread_t *stats_get_threads(size_t *count)
 	return stats_threads;
 }
 
+/** Get kernel lock profiles.
+ *
+ * The profiles are only available if the kernel was built
+ * with lock profiling.
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_lock_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_lock_t *stats_get_locks(size_t *count)
+{
+	size_t size = 0;
+	stats_lock_t *stats_locks =
+	    (stats_lock_t *) sysinfo_get_data("system.locks", &size);
+
+	if ((size % sizeof(stats_lock_t)) != 0) {
+		if (stats_locks != NULL)
+			free(stats_locks);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_lock_t);
+	return stats_locks;
+}
+
 /** Get exception statistics.
  *
  * @param count Number of records returned.
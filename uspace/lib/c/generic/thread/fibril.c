@@ -83,6 +83,20 @@ typedef enum {
 	SWITCH_FROM_BLOCKED,
 } _switch_type_t;
 
+/** Ready queue of one runner thread.
+ *
+ * Fibrils that become ready are queued to the runner they last ran on, so
+ * that they tend to stay on the same thread. A runner that runs out of ready
+ * fibrils steals them from the other runners before waiting for IPC.
+ */
+typedef struct fibril_runner {
+	/* Next runner in runner_list. */
+	struct fibril_runner *next;
+	/* Protects ready_list. */
+	futex_t lock;
+	list_t ready_list;
+} runner_t;
+
 static bool multithreaded = false;
 
 /* This futex serializes access to global data. */
@@ -90,7 +104,6 @@ static futex_t fibril_futex;
 static futex_t ready_semaphore;
 static long ready_st_count;
 
-static LIST_INITIALIZE(ready_list);
 static LIST_INITIALIZE(fibril_list);
 static LIST_INITIALIZE(timeout_list);
 
@@ -99,6 +112,14 @@ static LIST_INITIALIZE(ipc_waiter_list);
 static LIST_INITIALIZE(ipc_buffer_list);
 static LIST_INITIALIZE(ipc_buffer_free_list);
 
+/*
+ * Runners only ever get prepended to runner_list and are never removed, so
+ * the list can be walked without locking. The default runner holds fibrils
+ * that are not affine to any particular runner.
+ */
+static runner_t default_runner;
+static _Atomic(runner_t *) runner_list;
+
 /* Only used as unique markers for triggered events. */
 static fibril_t _fibril_event_triggered;
 static fibril_t _fibril_event_timed_out;
@@ -110,8 +131,9 @@ static inline void _ready_debug_check(void)
 {
 #ifdef READY_DEBUG
 	assert(!multithreaded);
-	long count = (long) list_count(&ready_list) +
-	    (long) list_count(&ipc_buffer_free_list);
+	long count = (long) list_count(&ipc_buffer_free_list);
+	for (runner_t *r = atomic_load(&runner_list); r; r = r->next)
+		count += (long) list_count(&r->ready_list);
 	assert(ready_st_count == count);
 #endif
 }
@@ -136,8 +158,97 @@ static inline errno_t _ready_down(const struct timespec *expires)
 	return EOK;
 }
 
+/** Try to take a ready token without blocking.
+ *
+ * @return True if a token was taken.
+ */
+static inline bool _ready_trydown(void)
+{
+	if (multithreaded)
+		return futex_trydown(&ready_semaphore);
+
+	if (ready_st_count <= 0)
+		return false;
+
+	ready_st_count--;
+	return true;
+}
+
 static atomic_int threads_in_ipc_wait;
 
+/*
+ * Number of calls and answers received by one IPC wait. The first one is
+ * covered by the ready token of the waiting thread, each of the others by a
+ * call buffer reserved together with its token before the wait.
+ */
+#define IPC_WAIT_BATCH  8
+
+/** Create a ready queue for a new runner thread.
+ *
+ * @return New runner or NULL if out of memory.
+ */
+static runner_t *_runner_create(void)
+{
+	runner_t *r = malloc(sizeof(runner_t));
+	if (!r)
+		return NULL;
+
+	if (futex_initialize(&r->lock, 1) != EOK) {
+		free(r);
+		return NULL;
+	}
+
+	list_initialize(&r->ready_list);
+
+	r->next = atomic_load(&runner_list);
+	while (!atomic_compare_exchange_weak(&runner_list, &r->next, r))
+		;
+
+	return r;
+}
+
+/** @return Runner of the current thread. */
+static runner_t *_runner_current(void)
+{
+	fibril_t *ctx = fibril_self()->thread_ctx;
+	if (ctx && ctx->runner)
+		return ctx->runner;
+
+	return &default_runner;
+}
+
+static fibril_t *_runner_pop(runner_t *r)
+{
+	futex_lock(&r->lock);
+	fibril_t *f = list_pop(&r->ready_list, fibril_t, link);
+	futex_unlock(&r->lock);
+	return f;
+}
+
+/**
+ * Take a ready fibril from the current runner's queue, or steal one from
+ * another runner if there is none.
+ */
+static fibril_t *_runner_pop_any(void)
+{
+	runner_t *self = _runner_current();
+
+	fibril_t *f = _runner_pop(self);
+	if (f)
+		return f;
+
+	for (runner_t *r = atomic_load(&runner_list); r; r = r->next) {
+		if (r == self)
+			continue;
+
+		f = _runner_pop(r);
+		if (f)
+			return f;
+	}
+
+	return NULL;
+}
+
 /** Function that spans the whole life-cycle of a fibril.
  *
  * Each fibril begins execution in this function. Then the function implementing
@@ -237,22 +348,103 @@ static fibril_t *_fibril_trigger_internal(fibril_event_t *event, fibril_t *reaso
 	return f;
 }
 
-static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
+static errno_t _ipc_wait(ipc_call_t *calls, size_t count,
+    const struct timespec *expires, size_t *received)
 {
-	if (!expires)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
+	sysarg_t usec = SYNCH_NO_TIMEOUT;
+	unsigned int flags = SYNCH_FLAGS_NONE;
 
-	if (expires->tv_sec == 0)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (expires) {
+		struct timespec now;
+		getuptime(&now);
 
-	struct timespec now;
-	getuptime(&now);
+		if ((expires->tv_sec == 0) || ts_gteq(&now, expires))
+			flags = SYNCH_FLAGS_NON_BLOCKING;
+		else
+			usec = NSEC2USEC(ts_sub_diff(expires, &now));
+	}
 
-	if (ts_gteq(&now, expires))
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (count == 1) {
+		*received = 1;
+		return ipc_wait(calls, usec, flags);
+	}
 
-	return ipc_wait(call, NSEC2USEC(ts_sub_diff(expires, &now)),
-	    SYNCH_FLAGS_NONE);
+	return ipc_wait_batch(calls, count, usec, flags, received);
+}
+
+/** Reserve call buffers for the extra calls of a batched IPC wait.
+ *
+ * Each reserved buffer is taken off the free list together with its
+ * ready token, just like a buffer holding a received call.
+ *
+ * @param bufs  Array where to store the reserved buffers.
+ * @param count Maximum number of buffers to reserve.
+ *
+ * @return Number of buffers reserved.
+ */
+static size_t _ipc_buffer_reserve(_ipc_buffer_t **bufs, size_t count)
+{
+	size_t n = 0;
+
+	while (n < count) {
+		if (!_ready_trydown())
+			break;
+
+		futex_lock(&ipc_lists_futex);
+		bufs[n] = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
+		futex_unlock(&ipc_lists_futex);
+
+		if (bufs[n] == NULL) {
+			/* The token belonged to a ready fibril. */
+			_ready_up();
+			break;
+		}
+
+		n++;
+	}
+
+	return n;
+}
+
+/** Return unused reserved call buffers to the free list.
+ *
+ * @param bufs  Array of reserved buffers.
+ * @param count Number of buffers in the array.
+ */
+static void _ipc_buffer_release(_ipc_buffer_t **bufs, size_t count)
+{
+	if (count == 0)
+		return;
+
+	futex_lock(&ipc_lists_futex);
+
+	for (size_t i = 0; i < count; i++) {
+		list_append(&bufs[i]->link, &ipc_buffer_free_list);
+		_ready_up();
+	}
+
+	futex_unlock(&ipc_lists_futex);
+}
+
+static void _ready_list_push(fibril_t *f)
+{
+	if (!f)
+		return;
+
+	futex_assert_is_locked(&fibril_futex);
+
+	/* Enqueue to the runner the fibril last ran on. */
+	runner_t *r = f->runner ? f->runner : _runner_current();
+	futex_lock(&r->lock);
+	list_append(&f->link, &r->ready_list);
+	futex_unlock(&r->lock);
+	_ready_up();
+
+	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
+		DPRINTF("Poking.\n");
+		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
+		ipc_poke();
+	}
 }
 
 /*
@@ -280,11 +472,21 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	 * Either there is a ready fibril in the list, or it's our turn to
 	 * call `ipc_wait_cycle()`. There is one extra token on the semaphore
 	 * for each entry of the call buffer.
+	 *
+	 * Popping from the ready queues does not require fibril_futex, since
+	 * switching to the popped fibril cannot complete before whoever
+	 * queued it has finished switching away from it. However, fibrils are
+	 * only queued with fibril_futex held, so we must hold it while making
+	 * sure there is really nothing to run before going to IPC wait.
 	 */
 
+	fibril_t *f = _runner_pop_any();
+	if (f)
+		return f;
+
 	if (!locked)
 		futex_lock(&fibril_futex);
-	fibril_t *f = list_pop(&ready_list, fibril_t, link);
+	f = _runner_pop_any();
 	if (!f)
 		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
 		    memory_order_relaxed);
@@ -297,19 +499,33 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	if (!multithreaded)
 		assert(list_empty(&ipc_buffer_list));
 
-	/* No fibril is ready, IPC wait it is. */
-	ipc_call_t call = { 0 };
-	rc = _ipc_wait(&call, expires);
+	/*
+	 * No fibril is ready, IPC wait it is. Receive calls which are already
+	 * queued in the kernel in the same syscall.
+	 */
+	_ipc_buffer_t *spare[IPC_WAIT_BATCH - 1];
+	size_t spares = _ipc_buffer_reserve(spare, IPC_WAIT_BATCH - 1);
+
+	ipc_call_t calls[IPC_WAIT_BATCH];
+	calls[0] = (ipc_call_t) { 0 };
+	size_t received = 0;
+	rc = _ipc_wait(calls, spares + 1, expires, &received);
 
 	atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
 	    memory_order_relaxed);
 
 	if (rc != EOK && rc != ENOENT) {
+		_ipc_buffer_release(spare, spares);
 		/* Return token. */
 		_ready_up();
 		return NULL;
 	}
 
+	if (rc != EOK)
+		received = 1;
+
+	assert(received >= 1 && received <= spares + 1);
+
 	/*
 	 * We might get ENOENT due to a poke.
 	 * In that case, we propagate the null call out of fibril_ipc_wait(),
@@ -331,22 +547,56 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 
 	_ipc_waiter_t *w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
 	if (w) {
-		*w->call = call;
+		*w->call = calls[0];
 		w->rc = rc;
-		/* We switch to the woken up fibril immediately if possible. */
 		f = _fibril_trigger_internal(&w->event, _EVENT_TRIGGERED);
 
+		/*
+		 * We switch to the woken up fibril immediately if it last ran
+		 * on this thread. Otherwise, it is handed over to its own
+		 * runner so that it keeps its thread locality.
+		 */
+		if (f && f->runner && f->runner != _runner_current()) {
+			_ready_list_push(f);
+			f = NULL;
+		}
+
 		/* Return token. */
 		_ready_up();
 	} else {
 		_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
 		assert(buf);
-		*buf = (_ipc_buffer_t) { .call = call, .rc = rc };
+		*buf = (_ipc_buffer_t) { .call = calls[0], .rc = rc };
 		list_append(&buf->link, &ipc_buffer_list);
 	}
 
+	/*
+	 * The rest of the batch is handed out the same way, using the
+	 * reserved buffers. Woken up fibrils are queued to their runners.
+	 */
+	for (size_t i = 1; i < received; i++) {
+		_ipc_buffer_t *buf = spare[i - 1];
+
+		w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
+		if (w) {
+			*w->call = calls[i];
+			w->rc = EOK;
+			_ready_list_push(_fibril_trigger_internal(&w->event,
+			    _EVENT_TRIGGERED));
+
+			/* Return the buffer and its token. */
+			list_append(&buf->link, &ipc_buffer_free_list);
+			_ready_up();
+		} else {
+			*buf = (_ipc_buffer_t) { .call = calls[i], .rc = EOK };
+			list_append(&buf->link, &ipc_buffer_list);
+		}
+	}
+
 	futex_unlock(&ipc_lists_futex);
 
+	_ipc_buffer_release(&spare[received - 1], spares - (received - 1));
+
 	if (!locked)
 		futex_unlock(&fibril_futex);
 
@@ -359,24 +609,6 @@ static fibril_t *_ready_list_pop_nonblocking(bool locked)
 	return _ready_list_pop(&tv, locked);
 }
 
-static void _ready_list_push(fibril_t *f)
-{
-	if (!f)
-		return;
-
-	futex_assert_is_locked(&fibril_futex);
-
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
-	_ready_up();
-
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
-		DPRINTF("Poking.\n");
-		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
-		ipc_poke();
-	}
-}
-
 /* Blocks the current fibril until an IPC call arrives. */
 static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 {
@@ -485,6 +717,10 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 		break;
 	}
 
+	/* The destination fibril becomes affine to this thread. */
+	if (srcf->thread_ctx && dstf != srcf->thread_ctx)
+		dstf->runner = srcf->thread_ctx->runner;
+
 	dstf->thread_ctx = srcf->thread_ctx;
 	srcf->thread_ctx = NULL;
 
@@ -631,10 +867,14 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 	DPRINTF("### Fibril %p sleeping on event %p.\n", fibril_self(), event);
 
 	if (!fibril_self()->thread_ctx) {
-		fibril_self()->thread_ctx =
+		fibril_t *helper = (fibril_t *)
 		    fibril_create_generic(_helper_fibril_fn, NULL, PAGE_SIZE);
-		if (!fibril_self()->thread_ctx)
+		if (!helper)
 			return ENOMEM;
+
+		/* Without a runner, the thread uses the default one. */
+		helper->runner = _runner_create();
+		fibril_self()->thread_ctx = helper;
 	}
 
 	futex_lock(&fibril_futex);
@@ -782,6 +1022,7 @@ void fibril_yield(void)
 
 static void _runner_fn(void *arg)
 {
+	fibril_self()->runner = _runner_create();
 	_helper_fibril_fn(arg);
 }
 
@@ -869,6 +1110,11 @@ void __fibrils_init(void)
 		abort();
 	if (futex_initialize(&ipc_lists_futex, 1) != EOK)
 		abort();
+	if (futex_initialize(&default_runner.lock, 1) != EOK)
+		abort();
+
+	list_initialize(&default_runner.ready_list);
+	atomic_store(&runner_list, &default_runner);
 
 	/*
 	 * We allow a fixed, small amount of parallelism for IPC reads, but
@@ -42,23 +42,52 @@
  * A multi-producer, single-consumer concurrent FIFO channel with unlimited
  * buffering.
  *
- * The current implementation is based on the super simple two-lock queue
- * by Michael and Scott
- * (http://www.cs.rochester.edu/~scott/papers/1996_PODC_queues.pdf)
+ * The current implementation is based on the intrusive MPSC queue by
+ * Dmitry Vyukov
+ * (http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue)
  *
- * The original algorithm uses one lock on each side. Since this queue is
- * single-consumer, we only use the tail lock.
+ * Producers append a node by atomically exchanging the tail pointer and then
+ * linking the previous tail to the new node. They never block each other.
+ * The consumer may briefly observe a node whose successor is not linked yet,
+ * in which case it waits for the notification the producer sends after
+ * linking it.
+ *
+ * Nodes released by the consumer are kept in a small per-channel cache from
+ * which producers take them, so that sending does not allocate once the
+ * channel is warmed up. Every cache slot is taken and filled by a single
+ * atomic operation, which avoids the ABA problem of a shared free stack.
+ *
+ * To make sure no element is appended behind the close node, producers
+ * announce themselves in the `senders` word before touching the queue.
+ * Closing the channel sets a flag in the same word and waits for the
+ * producers that were already in flight before appending the close node.
  */
 
+/** Number of released nodes cached for reuse by producers. */
+#define MPSC_FREE_NODES  64
+
+/** Flag in mpsc_t::senders set once the channel is closed. */
+#define MPSC_CLOSED  1
+
+/** Increment of mpsc_t::senders for each producer in flight. */
+#define MPSC_SENDER  2
+
 typedef struct mpsc_node mpsc_node_t;
 
 struct mpsc {
 	size_t elem_size;
-	fibril_rmutex_t t_lock;
+	size_t senders;
 	mpsc_node_t *head;
 	mpsc_node_t *tail;
 	mpsc_node_t *close_node;
 	fibril_event_t event;
+
+	/* Cache of released nodes. */
+	mpsc_node_t *free_nodes[MPSC_FREE_NODES];
+	/* Slot where producers start looking for a cached node. */
+	size_t free_take;
+	/* Slot where the consumer starts looking for an empty slot. */
+	size_t free_put;
 };
 
 struct mpsc_node {
@@ -79,13 +108,6 @@ mpsc_t *mpsc_create(size_t elem_size)
 		return NULL;
 	}
 
-	if (fibril_rmutex_initialize(&q->t_lock) != EOK) {
-		free(q);
-		free(n);
-		free(c);
-		return NULL;
-	}
-
 	q->elem_size = elem_size;
 	q->head = q->tail = n;
 	q->close_node = c;
@@ -102,27 +124,60 @@ void mpsc_destroy(mpsc_t *q)
 		n = next;
 	}
 
-	fibril_rmutex_destroy(&q->t_lock);
+	/* The close node is only linked in the queue once it is closed. */
+	if (!(q->senders & MPSC_CLOSED))
+		free(q->close_node);
+
+	for (size_t i = 0; i < MPSC_FREE_NODES; i++)
+		free(q->free_nodes[i]);
 
 	free(q);
 }
 
-static errno_t _mpsc_push(mpsc_t *q, mpsc_node_t *n)
+/** Take a node from the cache or allocate a new one. */
+static mpsc_node_t *_mpsc_node_get(mpsc_t *q)
 {
-	fibril_rmutex_lock(&q->t_lock);
+	size_t start = __atomic_fetch_add(&q->free_take, 1, __ATOMIC_RELAXED);
 
-	if (q->tail == q->close_node) {
-		fibril_rmutex_unlock(&q->t_lock);
-		return EINVAL;
+	for (size_t i = 0; i < MPSC_FREE_NODES; i++) {
+		mpsc_node_t **slot =
+		    &q->free_nodes[(start + i) % MPSC_FREE_NODES];
+
+		if (__atomic_load_n(slot, __ATOMIC_RELAXED) == NULL)
+			continue;
+
+		mpsc_node_t *n = __atomic_exchange_n(slot, NULL,
+		    __ATOMIC_ACQUIRE);
+		if (n != NULL)
+			return n;
 	}
 
-	__atomic_store_n(&q->tail->next, n, __ATOMIC_RELEASE);
-	q->tail = n;
+	return malloc(sizeof(mpsc_node_t) + q->elem_size);
+}
 
-	fibril_rmutex_unlock(&q->t_lock);
+/** Return a node released by the consumer to the cache. */
+static void _mpsc_node_put(mpsc_t *q, mpsc_node_t *n)
+{
+	for (size_t i = 0; i < MPSC_FREE_NODES; i++) {
+		size_t idx = (q->free_put + i) % MPSC_FREE_NODES;
+		mpsc_node_t *expected = NULL;
 
-	fibril_notify(&q->event);
-	return EOK;
+		if (__atomic_compare_exchange_n(&q->free_nodes[idx], &expected,
+		    n, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			q->free_put = idx + 1;
+			return;
+		}
+	}
+
+	free(n);
+}
+
+static void _mpsc_push(mpsc_t *q, mpsc_node_t *n)
+{
+	__atomic_store_n(&n->next, NULL, __ATOMIC_RELAXED);
+
+	mpsc_node_t *prev = __atomic_exchange_n(&q->tail, n, __ATOMIC_ACQ_REL);
+	__atomic_store_n(&prev->next, n, __ATOMIC_RELEASE);
 }
 
 /**
@@ -135,14 +190,27 @@ static errno_t _mpsc_push(mpsc_t *q, mpsc_node_t *n)
  */
 errno_t mpsc_send(mpsc_t *q, const void *b)
 {
-	mpsc_node_t *n = malloc(sizeof(mpsc_node_t) + q->elem_size);
-	if (!n)
+	size_t senders = __atomic_fetch_add(&q->senders, MPSC_SENDER,
+	    __ATOMIC_SEQ_CST);
+
+	if (senders & MPSC_CLOSED) {
+		__atomic_fetch_sub(&q->senders, MPSC_SENDER, __ATOMIC_RELEASE);
+		return EINVAL;
+	}
+
+	mpsc_node_t *n = _mpsc_node_get(q);
+	if (!n) {
+		__atomic_fetch_sub(&q->senders, MPSC_SENDER, __ATOMIC_RELEASE);
 		return ENOMEM;
+	}
 
-	n->next = NULL;
 	memcpy(n->data, b, q->elem_size);
+	_mpsc_push(q, n);
+
+	__atomic_fetch_sub(&q->senders, MPSC_SENDER, __ATOMIC_RELEASE);
 
-	return _mpsc_push(q, n);
+	fibril_notify(&q->event);
+	return EOK;
 }
 
 /**
@@ -173,16 +241,28 @@ errno_t mpsc_receive(mpsc_t *q, void *b, const struct timespec *expires)
 	memcpy(b, new_head->data, q->elem_size);
 	q->head = new_head;
 
-	free(n);
+	_mpsc_node_put(q, n);
 	return EOK;
 }
 
 /**
  * Close the channel.
  *
+ * Closing an already closed channel has no effect.
+ *
  * This function is safe for use under restricted mutex lock.
  */
 void mpsc_close(mpsc_t *q)
 {
+	size_t senders = __atomic_fetch_or(&q->senders, MPSC_CLOSED,
+	    __ATOMIC_SEQ_CST);
+	if (senders & MPSC_CLOSED)
+		return;
+
+	/* Wait for the producers which did not see the flag. */
+	while (__atomic_load_n(&q->senders, __ATOMIC_ACQUIRE) != MPSC_CLOSED)
+		;
+
 	_mpsc_push(q, q->close_node);
+	fibril_notify(&q->event);
 }
@@ -46,6 +46,7 @@
 
 #include "../private/thread.h"
 #include "../private/fibril.h"
+#include "../private/malloc.h"
 
 /** Main thread function.
  *
@@ -73,6 +74,7 @@ void __thread_main(uspace_arg_t *uarg)
 	 * free(uarg);
 	 */
 
+	__malloc_thread_fini();
 	fibril_teardown(fibril);
 	thread_exit(0);
 }
@@ -311,6 +311,39 @@ errno_t vfs_cwd_set(const char *path)
 	return EOK;
 }
 
+/** Get VFS directory entry cache statistics.
+ *
+ * @param stats Place to store the statistics
+ * @return EOK on success or an error code
+ */
+errno_t vfs_dcache_stats(vfs_dcache_stats_t *stats)
+{
+	errno_t rc;
+	aid_t req;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_0(exch, VFS_IN_DCACHE_STATS, NULL);
+	rc = async_data_read_start(exch, (void *) stats,
+	    sizeof(vfs_dcache_stats_t));
+	if (rc != EOK) {
+		vfs_exchange_end(exch);
+
+		errno_t rc_orig;
+		async_wait_for(req, &rc_orig);
+
+		if (rc_orig != EOK)
+			rc = rc_orig;
+
+		return rc;
+	}
+
+	vfs_exchange_end(exch);
+	async_wait_for(req, &rc);
+
+	return rc;
+}
+
 /** Start an async exchange on the VFS session
  *
  * @return      New exchange
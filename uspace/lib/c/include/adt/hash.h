@@ -110,4 +110,21 @@ static inline size_t hash_combine(size_t seed, size_t hash)
 	return seed;
 }
 
+/** Produces a hash of a NUL-terminated string.
+ *
+ * Uses the FNV-1a hash function on the bytes of the string and mixes
+ * the result so that all of its bits are usable.
+ */
+static inline size_t hash_string(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	for (const unsigned char *c = (const unsigned char *) str; *c; c++) {
+		hash ^= *c;
+		hash *= 16777619U;
+	}
+
+	return hash_mix(hash);
+}
+
 #endif
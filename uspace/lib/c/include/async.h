@@ -286,6 +286,9 @@ extern errno_t async_hangup(async_sess_t *);
 extern async_exch_t *async_exchange_begin(async_sess_t *);
 extern void async_exchange_end(async_exch_t *);
 
+extern void async_batch_begin(async_exch_t *);
+extern void async_batch_end(async_exch_t *);
+
 /*
  * FIXME These functions just work around problems with parallel exchange
  * management. Proper solution needs to be implemented.
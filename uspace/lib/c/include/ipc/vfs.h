@@ -61,6 +61,8 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** Names may appear or disappear without VFS knowing about it. */
+	bool volatile_namespace;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -71,6 +73,7 @@ typedef struct {
 
 typedef enum {
 	VFS_IN_CLONE = IPC_FIRST_USER_METHOD,
+	VFS_IN_DCACHE_STATS,
 	VFS_IN_FSPROBE,
 	VFS_IN_FSTYPES,
 	VFS_IN_MOUNT,
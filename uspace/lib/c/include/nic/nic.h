@@ -40,6 +40,7 @@
 
 #include <nic/eth_phys.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /** Ethernet address length. */
 #define ETH_ADDR  6
@@ -83,6 +84,23 @@
 
 #define NIC_DEVICE_PRINT_FMT  "%x"
 
+/**
+ * Size of one slot of a receive frame pool shared between the NIC driver
+ * and its client. Each slot holds one frame (including a VLAN tag).
+ */
+#define NIC_RX_SLOT_SIZE  2048
+
+/** Maximum number of frames delivered to the client in a single batch */
+#define NIC_RX_BATCH_MAX  64
+
+/** Frame stored in a slot of the shared receive frame pool */
+typedef struct nic_rx_slot {
+	/** Slot number */
+	size_t slot;
+	/** Frame size in bytes */
+	size_t size;
+} nic_rx_slot_t;
+
 /**
  * Structure covering the MAC address.
  */
@@ -222,6 +240,22 @@ typedef struct nic_device_stats {
 	unsigned long receive_compressed;
 	/** Total compressed packet transmitted. */
 	unsigned long send_compressed;
+
+	/* receive batching and interrupt moderation */
+
+	/**
+	 * Deliveries of received frames to the client. The average batch size
+	 * is receive_packets / receive_batches.
+	 */
+	unsigned long receive_batches;
+	/** Largest number of frames delivered in a single batch. */
+	unsigned long receive_batch_max;
+	/** Receive interrupts handled. */
+	unsigned long receive_interrupts;
+	/** Polls of the receive buffers. */
+	unsigned long receive_polls;
+	/** Switches from interrupts to polling in NIC_POLL_ADAPTIVE mode. */
+	unsigned long receive_poll_switches;
 } nic_device_stats_t;
 
 /** Errors corresponding to those in the nic_device_stats_t */
@@ -432,7 +466,13 @@ typedef enum nic_poll_mode {
 	 * must create software timer, internal hardware timer of NIC must not be
 	 * used even if the NIC supports it.
 	 */
-	NIC_POLL_SOFTWARE_PERIODIC
+	NIC_POLL_SOFTWARE_PERIODIC,
+	/**
+	 * NIC issues interrupts upon events. Under heavy receive load the
+	 * receive interrupts are masked and the driver polls the NIC until
+	 * the load drops again.
+	 */
+	NIC_POLL_ADAPTIVE
 } nic_poll_mode_t;
 
 /**
@@ -53,6 +53,10 @@ typedef struct {
 } inet_dgram_t;
 
 typedef struct {
+	/**
+	 * Datagram received. The callee may keep the datagram data by
+	 * setting @c data to NULL, it is then responsible for freeing it.
+	 */
 	errno_t (*recv)(inet_dgram_t *);
 } inet_ev_ops_t;
 
@@ -71,8 +71,19 @@ typedef struct {
 	uint32_t f_bsize;    /* fundamental file system block size */
 	uint64_t f_blocks;   /* total data blocks in file system */
 	uint64_t f_bfree;    /* free blocks in fs */
+	uint64_t f_chits;    /* block cache hits */
+	uint64_t f_cmisses;  /* block cache misses */
+	uint64_t f_cevicts;  /* block cache evictions */
 } vfs_statfs_t;
 
+/** VFS directory entry cache statistics */
+typedef struct {
+	uint64_t hits;       /* names resolved from the cache */
+	uint64_t neg_hits;   /* names found not to exist in the cache */
+	uint64_t misses;     /* names resolved by the file system */
+	uint64_t entries;    /* names currently cached */
+} vfs_dcache_stats_t;
+
 /** List of file system types */
 typedef struct {
 	char **fstypes;
@@ -86,6 +97,7 @@ extern char *vfs_absolutize(const char *, size_t *);
 extern errno_t vfs_clone(int, int, bool, int *);
 extern errno_t vfs_cwd_get(char *path, size_t);
 extern errno_t vfs_cwd_set(const char *path);
+extern errno_t vfs_dcache_stats(vfs_dcache_stats_t *);
 extern async_exch_t *vfs_exchange_begin(void);
 extern void vfs_exchange_end(async_exch_t *);
 extern errno_t vfs_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *);
@@ -34,6 +34,7 @@
  * @brief Driver-side RPC skeletons for DDF NIC interface
  */
 
+#include <as.h>
 #include <assert.h>
 #include <async.h>
 #include <errno.h>
@@ -85,7 +86,8 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_RX_POOL_SET
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -149,6 +151,41 @@ errno_t nic_callback_create(async_sess_t *dev_sess, async_port_handler_t cfun,
 	return retval;
 }
 
+/** Share a receive frame pool with the NIC service
+ *
+ * The area is divided into slots of NIC_RX_SLOT_SIZE bytes. The driver
+ * stores received frames directly in the slots and announces them with
+ * NIC_EV_RECEIVED_SLOT instead of copying the frame over IPC. The slot
+ * belongs to the client until the event is answered.
+ *
+ * @param[in] dev_sess
+ * @param[in] area     Address space area to share (read/write)
+ *
+ * @return EOK If the operation was successfully completed
+ * @return ENOTSUP If the driver does not support receive pools
+ *
+ */
+errno_t nic_rx_pool_set(async_sess_t *dev_sess, void *area)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	aid_t req = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RX_POOL_SET, NULL);
+	errno_t rc = async_share_out_start(exch, area,
+	    AS_AREA_READ | AS_AREA_WRITE);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 /** Get the current state of the device
  *
  * @param[in]  dev_sess
@@ -2485,6 +2522,40 @@ static void remote_nic_poll_now(ddf_fun_t *dev, void *iface,
 	async_answer_0(call, rc);
 }
 
+static void remote_nic_rx_pool_set(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+
+	ipc_call_t data;
+	size_t size;
+	unsigned int flags;
+	if (!async_share_out_receive(&data, &size, &flags)) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->rx_pool_set == NULL) {
+		async_answer_0(&data, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	void *area;
+	errno_t rc = async_share_out_finalize(&data, &area);
+	if ((rc != EOK) || (area == AS_MAP_FAILED)) {
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	rc = nic_iface->rx_pool_set(dev, area, size);
+	if (rc != EOK)
+		as_area_destroy(area);
+
+	async_answer_0(call, rc);
+}
+
 /** Remote NIC interface operations.
  *
  */
@@ -2529,7 +2600,8 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_RX_POOL_SET] = remote_nic_rx_pool_set
 };
 
 /** Remote NIC interface structure.
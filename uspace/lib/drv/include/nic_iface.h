@@ -42,11 +42,14 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RECEIVED_SLOT,
+	NIC_EV_RECEIVED_BATCH
 } nic_event_t;
 
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
+extern errno_t nic_rx_pool_set(async_sess_t *, void *);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
 extern errno_t nic_set_state(async_sess_t *, nic_device_state_t);
 extern errno_t nic_get_address(async_sess_t *, nic_address_t *);
@@ -889,7 +889,8 @@ libfs_ops_t ext4_libfs_ops = {
 	.service_get = ext4_service_get,
 	.size_block = ext4_size_block,
 	.total_block_count = ext4_total_block_count,
-	.free_block_count = ext4_free_block_count
+	.free_block_count = ext4_free_block_count,
+	.cache_stats = block_cache_stats
 };
 
 /*
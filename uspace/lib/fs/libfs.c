@@ -789,6 +789,17 @@ void libfs_statfs(libfs_ops_t *ops, fs_handle_t fs_handle, ipc_call_t *req)
 			goto error;
 	}
 
+	if (ops->cache_stats != NULL) {
+		rc = ops->cache_stats(service_id, &st.f_chits, &st.f_cmisses,
+		    &st.f_cevicts);
+		if (rc != EOK) {
+			/* Not every instance has a block cache, that is fine. */
+			st.f_chits = 0;
+			st.f_cmisses = 0;
+			st.f_cevicts = 0;
+		}
+	}
+
 	ops->node_put(fn);
 	async_data_read_finalize(&call, &st, sizeof(vfs_statfs_t));
 	async_answer_0(req, EOK);
@@ -87,6 +87,7 @@ typedef struct {
 	errno_t (*size_block)(service_id_t, uint32_t *);
 	errno_t (*total_block_count)(service_id_t, uint64_t *);
 	errno_t (*free_block_count)(service_id_t, uint64_t *);
+	errno_t (*cache_stats)(service_id_t, uint64_t *, uint64_t *, uint64_t *);
 } libfs_ops_t;
 
 typedef struct {
@@ -68,8 +68,13 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/** Receive pool slot holding the data or NIC_RX_SLOT_NONE */
+	size_t slot;
 } nic_frame_t;
 
+/** Frame data is not stored in a receive pool slot */
+#define NIC_RX_SLOT_NONE  ((size_t) -1)
+
 typedef list_t nic_frame_list_t;
 
 /**
@@ -199,7 +204,7 @@ typedef errno_t (*poll_mode_change_handler)(nic_t *,
 
 /**
  * Event handler called when the NIC should poll its buffers for a new frame
- * (in NIC_POLL_PERIODIC or NIC_POLL_ON_DEMAND) modes.
+ * (in NIC_POLL_PERIODIC, NIC_POLL_ON_DEMAND or NIC_POLL_ADAPTIVE) modes.
  *
  * @param nic_data	NICF main structure
  */
@@ -251,6 +256,8 @@ extern void nic_report_send_error(nic_t *, nic_send_error_cause_t, unsigned);
 extern void nic_report_receive_error(nic_t *, nic_receive_error_cause_t,
     unsigned);
 extern void nic_report_collisions(nic_t *, unsigned);
+extern bool nic_report_rx_interrupt(nic_t *, size_t);
+extern bool nic_report_rx_poll(nic_t *, size_t);
 
 /* Frame / frame list allocation and deallocation */
 extern nic_frame_t *nic_alloc_frame(nic_t *, size_t);
@@ -43,6 +43,7 @@
 #endif
 
 #include <fibril_synch.h>
+#include <stdbool.h>
 #include <nic/nic.h>
 #include <async.h>
 
@@ -56,6 +57,48 @@ struct sw_poll_info {
 	volatile int running;
 };
 
+/**
+ * Receive frame pool shared with the client. Received frames are stored
+ * directly in the pool and only their slot numbers are passed over IPC.
+ */
+typedef struct nic_rx_pool {
+	/** Lock protecting the pool */
+	fibril_mutex_t lock;
+	/** Shared area or NULL if there is no pool */
+	void *area;
+	/** Number of slots in the area */
+	size_t slot_cnt;
+	/** Slot in use flags */
+	bool *busy;
+	/** Number of slots in use */
+	size_t used;
+	/** Next slot to try */
+	size_t next;
+	/**
+	 * Pool belongs to the current client. A detached pool is destroyed
+	 * once all its slots are released.
+	 */
+	bool attached;
+} nic_rx_pool_t;
+
+/**
+ * Adaptive interrupt moderation state (NIC_POLL_ADAPTIVE). While polling,
+ * the driver keeps its receive interrupts masked and the poll fibril calls
+ * the poll request handler repeatedly.
+ */
+typedef struct nic_adaptive {
+	/** Lock protecting the state */
+	fibril_mutex_t lock;
+	/** Signalled when polling is started */
+	fibril_condvar_t cv;
+	/** Poll fibril or zero if it has not been created yet */
+	fid_t fibril;
+	/** Receive interrupts are masked and the NIC is being polled */
+	bool polling;
+	/** Number of consecutive polls under light load */
+	unsigned idle_polls;
+} nic_adaptive_t;
+
 struct nic {
 	/**
 	 * Device from device manager's point of view.
@@ -89,6 +132,8 @@ struct nic {
 	struct timespec default_poll_period;
 	/** Software period fibrill information */
 	struct sw_poll_info sw_poll_info;
+	/** Adaptive interrupt moderation state */
+	nic_adaptive_t adaptive;
 	/**
 	 * Lock on everything but statistics, rx control and wol virtues. This lock
 	 * cannot be used if filters_lock or stats_lock is already held - you must
@@ -105,6 +150,8 @@ struct nic {
 	fibril_rwlock_t stats_lock;
 	/** Receive control configuration */
 	nic_rxc_t rx_control;
+	/** Receive frame pool shared with the client */
+	nic_rx_pool_t rx_pool;
 	/**
 	 * Lock for receive control. You must not hold any other lock from nic_t
 	 * except the main_lock at the same moment. If both this lock and main_lock
@@ -189,7 +236,7 @@ struct nic {
 	poll_mode_change_handler on_poll_mode_change;
 	/**
 	 * Event handler called when the NIC should poll its buffers for a new frame
-	 * (in NIC_POLL_PERIODIC or NIC_POLL_ON_DEMAND) modes.
+	 * (in NIC_POLL_PERIODIC, NIC_POLL_ON_DEMAND or NIC_POLL_ADAPTIVE) modes.
 	 * Called with the main_lock locked for reading.
 	 * The implementation is optional.
 	 */
@@ -209,6 +256,10 @@ typedef struct nic_globals {
 	fibril_mutex_t lock;
 } nic_globals_t;
 
+extern errno_t nic_rx_pool_attach(nic_t *, void *, size_t);
+extern void nic_rx_pool_detach(nic_t *);
+extern void nic_adaptive_stop(nic_t *);
+
 #endif
 
 /** @}
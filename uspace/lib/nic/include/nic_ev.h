@@ -45,6 +45,9 @@
 extern errno_t nic_ev_addr_changed(async_sess_t *, const nic_address_t *);
 extern errno_t nic_ev_device_state(async_sess_t *, sysarg_t);
 extern errno_t nic_ev_received(async_sess_t *, void *, size_t);
+extern errno_t nic_ev_received_slot(async_sess_t *, size_t, size_t);
+extern errno_t nic_ev_received_batch(async_sess_t *, const nic_rx_slot_t *,
+    size_t);
 
 #endif
 
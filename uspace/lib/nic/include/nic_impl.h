@@ -50,6 +50,7 @@
 extern errno_t nic_get_address_impl(ddf_fun_t *dev_fun, nic_address_t *address);
 extern errno_t nic_send_frame_impl(ddf_fun_t *dev_fun, void *data, size_t size);
 extern errno_t nic_callback_create_impl(ddf_fun_t *dev_fun);
+extern errno_t nic_rx_pool_set_impl(ddf_fun_t *, void *, size_t);
 extern errno_t nic_get_state_impl(ddf_fun_t *dev_fun, nic_device_state_t *state);
 extern errno_t nic_set_state_impl(ddf_fun_t *dev_fun, nic_device_state_t state);
 extern errno_t nic_get_stats_impl(ddf_fun_t *dev_fun, nic_device_stats_t *stats);
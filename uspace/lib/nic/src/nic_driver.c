@@ -53,6 +53,11 @@
 
 #define NIC_GLOBALS_MAX_CACHE_SIZE 16
 
+/** Frames received in one interrupt that make NIC_POLL_ADAPTIVE poll */
+#define NIC_ADAPTIVE_POLL_THRESHOLD 4
+/** Consecutive light polls after which NIC_POLL_ADAPTIVE uses interrupts */
+#define NIC_ADAPTIVE_IDLE_POLLS 4
+
 nic_globals_t nic_globals;
 
 /**
@@ -103,6 +108,8 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->send_frame = nic_send_frame_impl;
 		if (!iface->callback_create)
 			iface->callback_create = nic_callback_create_impl;
+		if (!iface->rx_pool_set)
+			iface->rx_pool_set = nic_rx_pool_set_impl;
 		if (!iface->get_address)
 			iface->get_address = nic_get_address_impl;
 		if (!iface->get_stats)
@@ -255,7 +262,157 @@ errno_t nic_get_resources(nic_t *nic_data, hw_res_list_parsed_t *resources)
 	return hw_res_get_list_parsed(parent_sess, resources, 0);
 }
 
+/** Destroy receive pool area and slot flags.
+ *
+ * @param pool	Receive pool, must be locked and have no slots in use
+ */
+static void nic_rx_pool_fini(nic_rx_pool_t *pool)
+{
+	assert(pool->used == 0);
+
+	if (pool->area != NULL)
+		as_area_destroy(pool->area);
+	free(pool->busy);
+
+	pool->area = NULL;
+	pool->busy = NULL;
+	pool->slot_cnt = 0;
+	pool->next = 0;
+	pool->attached = false;
+}
+
+/** Attach receive frame pool shared by the client.
+ *
+ * Any previous pool is destroyed. This is only possible if none of its
+ * slots is in use.
+ *
+ * @param nic_data	The NIC driver data
+ * @param area		Shared area
+ * @param size		Size of the area in bytes
+ *
+ * @return EOK on success
+ * @return EINVAL if the area cannot hold a single slot
+ * @return EBUSY if frames from the previous pool are still in use
+ * @return ENOMEM if out of memory
+ */
+errno_t nic_rx_pool_attach(nic_t *nic_data, void *area, size_t size)
+{
+	nic_rx_pool_t *pool = &nic_data->rx_pool;
+	size_t slot_cnt = size / NIC_RX_SLOT_SIZE;
+
+	if (slot_cnt == 0)
+		return EINVAL;
+
+	bool *busy = calloc(slot_cnt, sizeof(bool));
+	if (busy == NULL)
+		return ENOMEM;
+
+	fibril_mutex_lock(&pool->lock);
+	if (pool->used > 0) {
+		fibril_mutex_unlock(&pool->lock);
+		free(busy);
+		return EBUSY;
+	}
+
+	nic_rx_pool_fini(pool);
+	pool->area = area;
+	pool->busy = busy;
+	pool->slot_cnt = slot_cnt;
+	pool->attached = true;
+	fibril_mutex_unlock(&pool->lock);
+
+	return EOK;
+}
+
+/** Detach receive frame pool from the client.
+ *
+ * New frames are no longer allocated from the pool. The pool is destroyed
+ * as soon as all frames stored in it are released.
+ *
+ * @param nic_data	The NIC driver data
+ */
+void nic_rx_pool_detach(nic_t *nic_data)
+{
+	nic_rx_pool_t *pool = &nic_data->rx_pool;
+
+	fibril_mutex_lock(&pool->lock);
+	pool->attached = false;
+	if (pool->used == 0)
+		nic_rx_pool_fini(pool);
+	fibril_mutex_unlock(&pool->lock);
+}
+
+/** Allocate a slot in the receive frame pool.
+ *
+ * @param nic_data	The NIC driver data
+ * @param size		Frame size in bytes
+ * @param slot		Place to store the slot number
+ * @return Slot data or NULL if there is no pool or no free slot
+ */
+static void *nic_rx_pool_get(nic_t *nic_data, size_t size, size_t *slot)
+{
+	nic_rx_pool_t *pool = &nic_data->rx_pool;
+	void *data = NULL;
+
+	if (size > NIC_RX_SLOT_SIZE)
+		return NULL;
+
+	fibril_mutex_lock(&pool->lock);
+	if (pool->attached && pool->used < pool->slot_cnt) {
+		while (pool->busy[pool->next])
+			pool->next = (pool->next + 1) % pool->slot_cnt;
+
+		*slot = pool->next;
+		pool->busy[*slot] = true;
+		pool->used++;
+		pool->next = (*slot + 1) % pool->slot_cnt;
+		data = (uint8_t *) pool->area + *slot * NIC_RX_SLOT_SIZE;
+	}
+	fibril_mutex_unlock(&pool->lock);
+
+	return data;
+}
+
+/** Return a slot to the receive frame pool.
+ *
+ * @param nic_data	The NIC driver data
+ * @param slot		Slot number
+ */
+static void nic_rx_pool_put(nic_t *nic_data, size_t slot)
+{
+	nic_rx_pool_t *pool = &nic_data->rx_pool;
+
+	fibril_mutex_lock(&pool->lock);
+	assert(slot < pool->slot_cnt);
+	assert(pool->busy[slot]);
+	pool->busy[slot] = false;
+	pool->used--;
+	if (!pool->attached && pool->used == 0)
+		nic_rx_pool_fini(pool);
+	fibril_mutex_unlock(&pool->lock);
+}
+
+/** Determine whether frames can be passed to the client by slot number.
+ *
+ * @param nic_data	The NIC driver data
+ * @return @c true if the pool is shared with the current client
+ */
+static bool nic_rx_pool_attached(nic_t *nic_data)
+{
+	bool attached;
+
+	fibril_mutex_lock(&nic_data->rx_pool.lock);
+	attached = nic_data->rx_pool.attached;
+	fibril_mutex_unlock(&nic_data->rx_pool.lock);
+
+	return attached;
+}
+
 /** Allocate frame
+ *
+ * If the client has shared a receive pool with the driver, the frame
+ * data is placed in a pool slot so that it can be passed to the client
+ * without copying.
  *
  *  @param nic_data 	The NIC driver data
  *  @param size	        Frame size in bytes
@@ -280,10 +437,14 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 		link_initialize(&frame->link);
 	}
 
-	frame->data = malloc(size);
+	frame->data = nic_rx_pool_get(nic_data, size, &frame->slot);
 	if (frame->data == NULL) {
-		free(frame);
-		return NULL;
+		frame->slot = NIC_RX_SLOT_NONE;
+		frame->data = malloc(size);
+		if (frame->data == NULL) {
+			free(frame);
+			return NULL;
+		}
 	}
 
 	frame->size = size;
@@ -301,9 +462,13 @@ void nic_release_frame(nic_t *nic_data, nic_frame_t *frame)
 		return;
 
 	if (frame->data != NULL) {
-		free(frame->data);
+		if (frame->slot != NIC_RX_SLOT_NONE)
+			nic_rx_pool_put(nic_data, frame->slot);
+		else
+			free(frame->data);
 		frame->data = NULL;
 		frame->size = 0;
+		frame->slot = NIC_RX_SLOT_NONE;
 	}
 
 	fibril_mutex_lock(&nic_globals.lock);
@@ -508,19 +673,15 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 }
 
 /**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+ * Check a received frame against the receive filters and update statistics.
  *
  * @param nic_data
  * @param frame		The received frame
+ *
+ * @return True if the frame should be passed to the client
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_received_frame_accept(nic_t *nic_data, nic_frame_t *frame)
 {
-	/*
-	 * Note: this function must not lock main lock, because loopback driver
-	 * 		 calls it inside send_frame handler (with locked main lock)
-	 */
 	fibril_rwlock_read_lock(&nic_data->rxc_lock);
 	nic_frame_type_t frame_type;
 	bool check = nic_rxc_check(&nic_data->rx_control, frame->data,
@@ -543,45 +704,168 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+		return true;
+	}
+
+	switch (frame_type) {
+	case NIC_FRAME_UNICAST:
+		nic_data->stats.receive_filtered_unicast++;
+		break;
+	case NIC_FRAME_MULTICAST:
+		nic_data->stats.receive_filtered_multicast++;
+		break;
+	case NIC_FRAME_BROADCAST:
+		nic_data->stats.receive_filtered_broadcast++;
+		break;
+	}
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	return false;
+}
+
+/**
+ * Account for a delivery of received frames to the client.
+ *
+ * @param nic_data
+ * @param count		Number of frames delivered
+ */
+static void nic_received_batch_stats(nic_t *nic_data, size_t count)
+{
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	nic_data->stats.receive_batches++;
+	if (count > nic_data->stats.receive_batch_max)
+		nic_data->stats.receive_batch_max = count;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+}
+
+/**
+ * Deliver a single accepted frame to the client and release it.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+static void nic_received_frame_deliver(nic_t *nic_data, nic_frame_t *frame)
+{
+	if (frame->slot != NIC_RX_SLOT_NONE &&
+	    nic_rx_pool_attached(nic_data)) {
+		/* The client reads the frame directly from the pool */
+		nic_ev_received_slot(nic_data->client_session,
+		    frame->slot, frame->size);
+	} else {
 		nic_ev_received(nic_data->client_session, frame->data,
 		    frame->size);
-	} else {
-		switch (frame_type) {
-		case NIC_FRAME_UNICAST:
-			nic_data->stats.receive_filtered_unicast++;
-			break;
-		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_filtered_multicast++;
-			break;
-		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_filtered_broadcast++;
-			break;
-		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
 	}
+
+	nic_received_batch_stats(nic_data, 1);
 	nic_release_frame(nic_data, frame);
 }
 
+/**
+ * Deliver a batch of accepted pool frames to the client in a single
+ * message and release them.
+ *
+ * @param nic_data
+ * @param batch		List of frames stored in the receive pool
+ * @param slots		Slot descriptors of the frames in @a batch
+ * @param count		Number of frames in @a batch, reset to zero
+ */
+static void nic_received_batch_flush(nic_t *nic_data, list_t *batch,
+    nic_rx_slot_t *slots, size_t *count)
+{
+	if (*count == 0)
+		return;
+
+	if (*count == 1) {
+		nic_ev_received_slot(nic_data->client_session,
+		    slots[0].slot, slots[0].size);
+	} else {
+		nic_ev_received_batch(nic_data->client_session, slots,
+		    *count);
+	}
+
+	nic_received_batch_stats(nic_data, *count);
+
+	while (!list_empty(batch)) {
+		nic_frame_t *frame =
+		    list_get_instance(list_first(batch), nic_frame_t, link);
+
+		list_remove(&frame->link);
+		nic_release_frame(nic_data, frame);
+	}
+
+	*count = 0;
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	/*
+	 * Note: this function must not lock main lock, because loopback driver
+	 * 		 calls it inside send_frame handler (with locked main lock)
+	 */
+	if (nic_received_frame_accept(nic_data, frame))
+		nic_received_frame_deliver(nic_data, frame);
+	else
+		nic_release_frame(nic_data, frame);
+}
+
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
  * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * the frames are checked by filters and the accepted ones are passed to the
+ * client. Frames stored in the shared receive pool are delivered in batches
+ * of up to NIC_RX_BATCH_MAX frames per message, the others one by one.
+ * The frames and the list are released.
  *
  * @param nic_data
  * @param frames		List of received frames
  */
 void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
+	nic_rx_slot_t slots[NIC_RX_BATCH_MAX];
+	list_t batch;
+	size_t count = 0;
+
 	if (frames == NULL)
 		return;
+
+	list_initialize(&batch);
+
 	while (!list_empty(frames)) {
 		nic_frame_t *frame =
 		    list_get_instance(list_first(frames), nic_frame_t, link);
 
 		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
+
+		if (!nic_received_frame_accept(nic_data, frame)) {
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		if (frame->slot != NIC_RX_SLOT_NONE &&
+		    nic_rx_pool_attached(nic_data)) {
+			slots[count].slot = frame->slot;
+			slots[count].size = frame->size;
+			list_append(&frame->link, &batch);
+			if (++count == NIC_RX_BATCH_MAX) {
+				nic_received_batch_flush(nic_data, &batch,
+				    slots, &count);
+			}
+		} else {
+			/* Keep the frames in order */
+			nic_received_batch_flush(nic_data, &batch, slots,
+			    &count);
+			nic_received_frame_deliver(nic_data, frame);
+		}
 	}
+
+	nic_received_batch_flush(nic_data, &batch, slots, &count);
 	nic_driver_release_frame_list(frames);
 }
 
@@ -622,6 +906,13 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
 
+	memset(&nic_data->rx_pool, 0, sizeof(nic_rx_pool_t));
+	fibril_mutex_initialize(&nic_data->rx_pool.lock);
+
+	memset(&nic_data->adaptive, 0, sizeof(nic_adaptive_t));
+	fibril_mutex_initialize(&nic_data->adaptive.lock);
+	fibril_condvar_initialize(&nic_data->adaptive.cv);
+
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->stats, 0, sizeof(nic_device_stats_t));
@@ -658,6 +949,7 @@ nic_t *nic_create_and_bind(ddf_dev_t *device)
  */
 static void nic_destroy(nic_t *nic_data)
 {
+	nic_rx_pool_detach(nic_data);
 	free(nic_data->specific);
 }
 
@@ -1132,5 +1424,133 @@ void nic_sw_period_stop(nic_t *nic_data)
 	nic_data->sw_poll_info.running = 0;
 }
 
+/** Main function of the adaptive poll fibril
+ *
+ *  Calls poll() back to back while the NIC is in the polling state of
+ *  NIC_POLL_ADAPTIVE, yielding between the polls.
+ *
+ *  @param  data The NIC structure pointer
+ *
+ *  @return 0, never reached
+ */
+static errno_t adaptive_fibril_fun(void *data)
+{
+	nic_t *nic = data;
+	nic_adaptive_t *adaptive = &nic->adaptive;
+
+	while (true) {
+		fibril_mutex_lock(&adaptive->lock);
+		while (!adaptive->polling)
+			fibril_condvar_wait(&adaptive->cv, &adaptive->lock);
+		fibril_mutex_unlock(&adaptive->lock);
+
+		fibril_rwlock_read_lock(&nic->main_lock);
+		nic->on_poll_request(nic);
+		fibril_rwlock_read_unlock(&nic->main_lock);
+
+		fibril_yield();
+	}
+	return EOK;
+}
+
+/** Stops adaptive polling
+ *
+ *  The driver is expected to reconfigure its interrupts afterwards.
+ *
+ *  @param nic_data Nic data structure
+ */
+void nic_adaptive_stop(nic_t *nic_data)
+{
+	fibril_mutex_lock(&nic_data->adaptive.lock);
+	nic_data->adaptive.polling = false;
+	nic_data->adaptive.idle_polls = 0;
+	fibril_mutex_unlock(&nic_data->adaptive.lock);
+}
+
+/** Report frames received in an interrupt
+ *
+ *  The driver should call this function from its interrupt handler with
+ *  the number of frames it has just received. In NIC_POLL_ADAPTIVE mode
+ *  a busy interrupt switches the NIC to polling.
+ *
+ *  @param nic_data Nic data structure
+ *  @param frames   Number of frames received in the interrupt
+ *
+ *  @return True if the driver must leave its receive interrupts masked
+ *  @return False if the driver should enable its receive interrupts
+ */
+bool nic_report_rx_interrupt(nic_t *nic_data, size_t frames)
+{
+	nic_adaptive_t *adaptive = &nic_data->adaptive;
+	bool switched = false;
+	bool polling = false;
+
+	fibril_mutex_lock(&adaptive->lock);
+	if (nic_data->poll_mode == NIC_POLL_ADAPTIVE &&
+	    nic_data->on_poll_request != NULL) {
+		if (!adaptive->polling &&
+		    frames >= NIC_ADAPTIVE_POLL_THRESHOLD) {
+			/* Create the fibril if it is not created */
+			if (adaptive->fibril == 0) {
+				adaptive->fibril = fibril_create(
+				    adaptive_fibril_fun, nic_data);
+				if (adaptive->fibril != 0)
+					fibril_add_ready(adaptive->fibril);
+			}
+
+			if (adaptive->fibril != 0) {
+				adaptive->polling = true;
+				adaptive->idle_polls = 0;
+				fibril_condvar_broadcast(&adaptive->cv);
+				switched = true;
+			}
+		}
+		polling = adaptive->polling;
+	}
+	fibril_mutex_unlock(&adaptive->lock);
+
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	nic_data->stats.receive_interrupts++;
+	if (switched)
+		nic_data->stats.receive_poll_switches++;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+
+	return polling;
+}
+
+/** Report frames received in a poll
+ *
+ *  The driver should call this function from its poll request handler with
+ *  the number of frames it has just received. In NIC_POLL_ADAPTIVE mode
+ *  the NIC returns to interrupts after several polls under light load.
+ *
+ *  @param nic_data Nic data structure
+ *  @param frames   Number of frames received in the poll
+ *
+ *  @return True if the driver must leave its receive interrupts masked
+ *  @return False if the driver should enable its receive interrupts
+ */
+bool nic_report_rx_poll(nic_t *nic_data, size_t frames)
+{
+	nic_adaptive_t *adaptive = &nic_data->adaptive;
+	bool polling = true;
+
+	fibril_mutex_lock(&adaptive->lock);
+	if (nic_data->poll_mode == NIC_POLL_ADAPTIVE) {
+		if (frames >= NIC_ADAPTIVE_POLL_THRESHOLD)
+			adaptive->idle_polls = 0;
+		else if (++adaptive->idle_polls >= NIC_ADAPTIVE_IDLE_POLLS)
+			adaptive->polling = false;
+		polling = adaptive->polling;
+	}
+	fibril_mutex_unlock(&adaptive->lock);
+
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	nic_data->stats.receive_polls++;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+
+	return polling;
+}
+
 /** @}
  */
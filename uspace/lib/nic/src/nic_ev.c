@@ -93,5 +93,39 @@ errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
 	return retval;
 }
 
+/** Frame received into a slot of the shared receive pool. */
+errno_t nic_ev_received_slot(async_sess_t *sess, size_t slot, size_t size)
+{
+	errno_t rc;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	rc = async_req_2_0(exch, NIC_EV_RECEIVED_SLOT, slot, size);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Batch of frames received into slots of the shared receive pool. */
+errno_t nic_ev_received_batch(async_sess_t *sess, const nic_rx_slot_t *slots,
+    size_t count)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, NIC_EV_RECEIVED_BATCH, count, &answer);
+	errno_t retval = async_data_write_start(exch, slots,
+	    count * sizeof(nic_rx_slot_t));
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 /** @}
  */
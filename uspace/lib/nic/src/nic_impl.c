@@ -147,6 +147,8 @@ errno_t nic_set_state_impl(ddf_fun_t *fun, nic_device_state_t state)
 
 		/* Ensure stopping period of NIC_POLL_SOFTWARE_PERIODIC */
 		nic_sw_period_stop(nic_data);
+		/* Ensure stopping polling of NIC_POLL_ADAPTIVE */
+		nic_adaptive_stop(nic_data);
 	}
 
 	nic_data->state = state;
@@ -197,6 +199,9 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 	nic_t *nic = nic_get_from_ddf_fun(fun);
 	fibril_rwlock_write_lock(&nic->main_lock);
 
+	/* Receive pool of the previous client cannot be used anymore */
+	nic_rx_pool_detach(nic);
+
 	nic->client_session = async_callback_receive(EXCHANGE_SERIALIZE);
 	if (nic->client_session == NULL) {
 		fibril_rwlock_write_unlock(&nic->main_lock);
@@ -207,6 +212,24 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 	return EOK;
 }
 
+/**
+ * Default implementation of the rx_pool_set method.
+ * Attaches receive frame pool shared by the client.
+ *
+ * @param	fun
+ * @param	area	Shared area
+ * @param	size	Size of the area
+ *
+ * @return EOK		If the pool was attached
+ * @return EINVAL	If the area is too small
+ * @return EBUSY	If frames from the previous pool are still in use
+ */
+errno_t nic_rx_pool_set_impl(ddf_fun_t *fun, void *area, size_t size)
+{
+	nic_t *nic = nic_get_from_ddf_fun(fun);
+	return nic_rx_pool_attach(nic, area, size);
+}
+
 /**
  * Default implementation of the get_address method.
  * Retrieves the NIC's physical address.
@@ -745,7 +768,8 @@ errno_t nic_poll_set_mode_impl(ddf_fun_t *fun,
 	if (nic_data->on_poll_mode_change == NULL)
 		return ENOTSUP;
 
-	if ((mode == NIC_POLL_ON_DEMAND) && nic_data->on_poll_request == NULL)
+	if ((mode == NIC_POLL_ON_DEMAND || mode == NIC_POLL_ADAPTIVE) &&
+	    nic_data->on_poll_request == NULL)
 		return ENOTSUP;
 
 	if (mode == NIC_POLL_PERIODIC || mode == NIC_POLL_SOFTWARE_PERIODIC) {
@@ -768,6 +792,8 @@ errno_t nic_poll_set_mode_impl(ddf_fun_t *fun,
 			nic_sw_period_start(nic_data);
 	}
 	if (rc == EOK) {
+		/* The interrupts were set up by the driver for the new mode */
+		nic_adaptive_stop(nic_data);
 		nic_data->poll_mode = mode;
 		if (period)
 			nic_data->poll_period = *period;
@@ -205,6 +205,24 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	return true;
 }
 
+/**
+ * Enable or disable interrupts upon used buffers of a virtqueue.
+ *
+ * Disabling is only a hint for the device. After enabling, the caller
+ * should check the used ring again for buffers used in the meantime.
+ */
+void virtio_virtq_set_interrupts(virtio_dev_t *vdev, uint16_t num,
+    bool enable)
+{
+	virtq_t *q = &vdev->queues[num];
+
+	fibril_mutex_lock(&q->lock);
+	pio_write_le16(&q->avail->flags,
+	    enable ? 0 : VIRTQ_AVAIL_F_NO_INTERRUPT);
+	memory_barrier();
+	fibril_mutex_unlock(&q->lock);
+}
+
 errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 {
 	virtq_t *q = &vdev->queues[num];
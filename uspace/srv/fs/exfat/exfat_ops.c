@@ -1008,7 +1008,8 @@ libfs_ops_t exfat_libfs_ops = {
 	.service_get = exfat_service_get,
 	.size_block = exfat_size_block,
 	.total_block_count = exfat_total_block_count,
-	.free_block_count = exfat_free_block_count
+	.free_block_count = exfat_free_block_count,
+	.cache_stats = block_cache_stats
 };
 
 static errno_t exfat_fs_open(service_id_t service_id, enum cache_mode cmode,
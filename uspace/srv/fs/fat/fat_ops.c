@@ -905,7 +905,8 @@ libfs_ops_t fat_libfs_ops = {
 	.service_get = fat_service_get,
 	.size_block = fat_size_block,
 	.total_block_count = fat_total_block_count,
-	.free_block_count = fat_free_block_count
+	.free_block_count = fat_free_block_count,
+	.cache_stats = block_cache_stats
 };
 
 static errno_t fat_fs_open(service_id_t service_id, enum cache_mode cmode,
@@ -52,6 +52,7 @@ struct tmpfs_node;
 
 typedef struct tmpfs_dentry {
 	link_t link;		/**< Linkage for the list of siblings. */
+	ht_link_t hash_link;	/**< Linkage for the children hash table. */
 	struct tmpfs_node *node;/**< Back pointer to TMPFS node. */
 	char *name;		/**< Name of dentry. */
 } tmpfs_dentry_t;
@@ -66,6 +67,8 @@ typedef struct tmpfs_node {
 	size_t size;		/**< File size if type is TMPFS_FILE. */
 	void *data;		/**< File content's if type is TMPFS_FILE. */
 	list_t cs_list;		/**< Child's siblings list. */
+	hash_table_t cs_hash;	/**< Children hash table indexed by name. */
+	bool cs_hashed;		/**< True if cs_hash has been created. */
 } tmpfs_node_t;
 
 extern vfs_out_ops_t tmpfs_ops;
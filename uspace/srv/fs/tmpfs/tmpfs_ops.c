@@ -166,16 +166,52 @@ static bool nodes_key_equal(void *key_arg, const ht_link_t *item)
 	return key->service_id == node->service_id && key->index == node->index;
 }
 
+static size_t dentries_key_hash(void *key)
+{
+	return hash_string((const char *) key);
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    hash_link);
+	return hash_string(dentryp->name);
+}
+
+static bool dentries_key_equal(void *key, const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    hash_link);
+	return str_cmp(dentryp->name, (const char *) key) == 0;
+}
+
+/** TMPFS directory children hash table operations. */
+static hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 static void nodes_remove_callback(ht_link_t *item)
 {
 	tmpfs_node_t *nodep = hash_table_get_inst(item, tmpfs_node_t, nh_link);
 
+	/*
+	 * Destroy the children hash first, it walks the links embedded in
+	 * the dentries freed below.
+	 */
+	if (nodep->cs_hashed)
+		hash_table_destroy(&nodep->cs_hash);
+
 	while (!list_empty(&nodep->cs_list)) {
 		tmpfs_dentry_t *dentryp = list_get_instance(
 		    list_first(&nodep->cs_list), tmpfs_dentry_t, link);
 
 		assert(nodep->type == TMPFS_DIRECTORY);
 		list_remove(&dentryp->link);
+		free(dentryp->name);
 		free(dentryp);
 	}
 
@@ -206,6 +242,7 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->size = 0;
 	nodep->data = NULL;
 	list_initialize(&nodep->cs_list);
+	nodep->cs_hashed = false;
 }
 
 static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
@@ -215,6 +252,20 @@ static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
 	dentryp->node = NULL;
 }
 
+/** Find a directory entry by its name. */
+static tmpfs_dentry_t *tmpfs_dentry_find(tmpfs_node_t *parentp,
+    const char *name)
+{
+	if (!parentp->cs_hashed)
+		return NULL;
+
+	ht_link_t *lnk = hash_table_find(&parentp->cs_hash, (void *) name);
+	if (!lnk)
+		return NULL;
+
+	return hash_table_get_inst(lnk, tmpfs_dentry_t, hash_link);
+}
+
 bool tmpfs_init(void)
 {
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
@@ -254,15 +305,9 @@ static void tmpfs_instance_done(service_id_t service_id)
 errno_t tmpfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
 	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
+	tmpfs_dentry_t *dentryp = tmpfs_dentry_find(parentp, component);
 
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dentryp) {
-		if (!str_cmp(dentryp->name, component)) {
-			*rfn = FS_NODE(dentryp->node);
-			return EOK;
-		}
-	}
-
-	*rfn = NULL;
+	*rfn = dentryp ? FS_NODE(dentryp->node) : NULL;
 	return EOK;
 }
 
@@ -362,9 +407,14 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	assert(parentp->type == TMPFS_DIRECTORY);
 
 	/* Check for duplicit entries. */
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm))
-			return EEXIST;
+	if (tmpfs_dentry_find(parentp, nm))
+		return EEXIST;
+
+	/* The children hash table is only created once needed. */
+	if (!parentp->cs_hashed) {
+		if (!hash_table_create(&parentp->cs_hash, 0, 0, &dentries_ops))
+			return ENOMEM;
+		parentp->cs_hashed = true;
 	}
 
 	/* Allocate and initialize the dentry. */
@@ -384,6 +434,7 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	dentryp->node = childp;
 	childp->lnkcnt++;
 	list_append(&dentryp->link, &parentp->cs_list);
+	hash_table_insert(&parentp->cs_hash, &dentryp->hash_link);
 
 	return EOK;
 }
@@ -391,28 +442,25 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 errno_t tmpfs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 {
 	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
-	tmpfs_node_t *childp = NULL;
+	tmpfs_node_t *childp;
 	tmpfs_dentry_t *dentryp;
 
 	if (!parentp)
 		return EBUSY;
 
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm)) {
-			dentryp = dp;
-			childp = dentryp->node;
-			assert(FS_NODE(childp) == cfn);
-			break;
-		}
-	}
-
-	if (!childp)
+	dentryp = tmpfs_dentry_find(parentp, nm);
+	if (!dentryp)
 		return ENOENT;
 
+	childp = dentryp->node;
+	assert(FS_NODE(childp) == cfn);
+
 	if ((childp->lnkcnt == 1) && !list_empty(&childp->cs_list))
 		return ENOTEMPTY;
 
+	hash_table_remove_item(&parentp->cs_hash, &dentryp->hash_link);
 	list_remove(&dentryp->link);
+	free(dentryp->name);
 	free(dentryp);
 	childp->lnkcnt--;
 
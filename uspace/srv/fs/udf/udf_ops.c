@@ -292,7 +292,8 @@ libfs_ops_t udf_libfs_ops = {
 	.service_get = udf_service_get,
 	.size_block = udf_size_block,
 	.total_block_count = udf_total_block_count,
-	.free_block_count = udf_free_block_count
+	.free_block_count = udf_free_block_count,
+	.cache_stats = block_cache_stats
 };
 
 static errno_t udf_fsprobe(service_id_t service_id, vfs_fs_probe_info_t *info)
@@ -264,7 +264,6 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 		    frame.etype_len);
 	}
 
-	free(frame.data);
 	return rc;
 }
 
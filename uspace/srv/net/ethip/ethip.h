@@ -62,6 +62,11 @@ typedef struct ethip_nic {
 	/** MAC address */
 	addr48_t mac_addr;
 
+	/** Receive frame pool shared with the NIC driver or @c NULL */
+	void *rx_pool;
+	/** Number of slots in the receive frame pool */
+	size_t rx_pool_slots;
+
 	/**
 	 * List of IP addresses configured on this link
 	 * (of the type ethip_link_addr_t)
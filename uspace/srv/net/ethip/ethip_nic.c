@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <as.h>
 #include <async.h>
 #include <stdbool.h>
 #include <errno.h>
@@ -50,6 +51,9 @@
 #include "ethip_nic.h"
 #include "pdu.h"
 
+/** Number of slots in the receive frame pool shared with each NIC */
+#define ETHIP_RX_POOL_SLOTS 64
+
 static errno_t ethip_nic_open(service_id_t sid);
 static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg);
 
@@ -135,6 +139,9 @@ static ethip_link_addr_t *ethip_nic_addr_new(inet_addr_t *addr)
 
 static void ethip_nic_delete(ethip_nic_t *nic)
 {
+	if (nic->rx_pool != NULL)
+		as_area_destroy(nic->rx_pool);
+
 	if (nic->svc_name != NULL)
 		free(nic->svc_name);
 
@@ -146,6 +153,42 @@ static void ethip_link_addr_delete(ethip_link_addr_t *laddr)
 	free(laddr);
 }
 
+/** Share receive frame pool with the NIC driver.
+ *
+ * Frames received into the pool are handed to us by slot number,
+ * possibly many in a single batch, which saves copying them over IPC.
+ * Drivers that do not support this keep sending frame contents.
+ *
+ * @param nic	NIC
+ */
+static void ethip_nic_rx_pool_init(ethip_nic_t *nic)
+{
+	size_t size = ETHIP_RX_POOL_SLOTS * NIC_RX_SLOT_SIZE;
+	void *area;
+	errno_t rc;
+
+	area = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed allocating receive "
+		    "pool for '%s'.", nic->svc_name);
+		return;
+	}
+
+	/* Frames may arrive in the pool before the request is answered */
+	nic->rx_pool = area;
+	nic->rx_pool_slots = ETHIP_RX_POOL_SLOTS;
+
+	rc = nic_rx_pool_set(nic->sess, area);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NIC '%s' does not use "
+		    "receive pool: %s", nic->svc_name, str_error_name(rc));
+		nic->rx_pool = NULL;
+		nic->rx_pool_slots = 0;
+		as_area_destroy(area);
+	}
+}
+
 static errno_t ethip_nic_open(service_id_t sid)
 {
 	bool in_list = false;
@@ -177,6 +220,8 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
+	ethip_nic_rx_pool_init(nic);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened NIC '%s'", nic->svc_name);
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
@@ -282,6 +327,103 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+/** Get frame data stored in a slot of the receive pool.
+ *
+ * @param nic	NIC
+ * @param slot	Slot number
+ * @param size	Frame size
+ *
+ * @return Frame data or @c NULL if the slot is not valid
+ */
+static void *ethip_nic_slot_data(ethip_nic_t *nic, size_t slot, size_t size)
+{
+	if (nic->rx_pool == NULL || slot >= nic->rx_pool_slots ||
+	    size > NIC_RX_SLOT_SIZE)
+		return NULL;
+
+	return (uint8_t *) nic->rx_pool + slot * NIC_RX_SLOT_SIZE;
+}
+
+static void ethip_nic_received_slot(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	size_t slot;
+	size_t size;
+	void *data;
+
+	slot = IPC_GET_ARG1(*call);
+	size = IPC_GET_ARG2(*call);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_slot() nic=%p "
+	    "slot=%zu size=%zu", nic, slot, size);
+
+	data = ethip_nic_slot_data(nic, slot, size);
+	if (data == NULL) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	/* The slot is ours until we answer */
+	rc = ethip_received(&nic->iplink, data, size);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_slot() done, rc=%s",
+	    str_error_name(rc));
+	async_answer_0(call, rc);
+}
+
+static void ethip_nic_received_batch(ethip_nic_t *nic, ipc_call_t *icall)
+{
+	nic_rx_slot_t slots[NIC_RX_BATCH_MAX];
+	ipc_call_t call;
+	size_t count;
+	size_t size;
+	size_t i;
+	void *data;
+	errno_t rc;
+
+	count = IPC_GET_ARG1(*icall);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() nic=%p "
+	    "count=%zu", nic, count);
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (count > NIC_RX_BATCH_MAX || size != count * sizeof(nic_rx_slot_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, slots, size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	/* The slots are ours until we answer */
+	for (i = 0; i < count; i++) {
+		data = ethip_nic_slot_data(nic, slots[i].slot, slots[i].size);
+		if (data == NULL) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "invalid slot %zu",
+			    slots[i].slot);
+			continue;
+		}
+
+		rc = ethip_received(&nic->iplink, data, slots[i].size);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_received() "
+			    "failed, rc=%s", str_error_name(rc));
+		}
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() done");
+	async_answer_0(icall, EOK);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -313,6 +455,12 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RECEIVED_SLOT:
+			ethip_nic_received_slot(nic, &call);
+			break;
+		case NIC_EV_RECEIVED_BATCH:
+			ethip_nic_received_batch(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, IPC_GET_IMETHOD(call));
 			async_answer_0(&call, ENOTSUP);
@@ -300,11 +300,11 @@ errno_t inet_pdu_encode6(inet_packet_t *packet, addr128_t src, addr128_t dest,
  * @param data    Serialized IPv4 datagram
  * @param size    Length of serialized IPv4 datagram
  * @param link_id Link on which PDU was received
- * @param packet  IP datagram structure to be filled
+ * @param packet  IP datagram structure to be filled, its data
+ *                point into @a data
  *
  * @return EOK on success
  * @return EINVAL if the datagram is invalid or damaged
- * @return ENOMEM if not enough memory
  *
  */
 errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
@@ -359,14 +359,15 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
 	size_t data_offs = sizeof(uint32_t) *
 	    BIT_RANGE_EXTRACT(uint8_t, VI_IHL_h, VI_IHL_l, hdr->ver_ihl);
 
-	packet->size = tot_len - data_offs;
-	packet->data = calloc(packet->size, 1);
-	if (packet->data == NULL) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Out of memory.");
-		return ENOMEM;
+	if (data_offs < sizeof(ip_header_t) || data_offs > tot_len) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Invalid header length (%zu)",
+		    data_offs);
+		return EINVAL;
 	}
 
-	memcpy(packet->data, (uint8_t *) data + data_offs, packet->size);
+	/* Payload is not copied, it stays in the caller's buffer */
+	packet->size = tot_len - data_offs;
+	packet->data = (uint8_t *) data + data_offs;
 	packet->link_id = link_id;
 
 	return EOK;
@@ -377,11 +378,11 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
  * @param data    Serialized IPv6 datagram
  * @param size    Length of serialized IPv6 datagram
  * @param link_id Link on which PDU was received
- * @param packet  IP datagram structure to be filled
+ * @param packet  IP datagram structure to be filled, its data
+ *                point into @a data
  *
  * @return EOK on success
  * @return EINVAL if the datagram is invalid or damaged
- * @return ENOMEM if not enough memory
  *
  */
 errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
@@ -426,6 +427,13 @@ errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
 		foff = BIT_RANGE_EXTRACT(uint16_t, OF_FRAGOFF_h, OF_FRAGOFF_l,
 		    offsmf);
 		next = hdr6f->next;
+
+		if (payload_len < sizeof(ip6_header_fragment_t)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Payload Length = %zu "
+			    "too small for fragment header", payload_len);
+			return EINVAL;
+		}
+
 		data_offs += sizeof(ip6_header_fragment_t);
 		payload_len -= sizeof(ip6_header_fragment_t);
 	} else {
@@ -453,14 +461,9 @@ errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
 	packet->mf = (offsmf & BIT_V(uint16_t, OF_FLAG_M)) != 0;
 	packet->offs = foff * FRAG_OFFS_UNIT;
 
+	/* Payload is not copied, it stays in the caller's buffer */
 	packet->size = payload_len;
-	packet->data = calloc(packet->size, 1);
-	if (packet->data == NULL) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Out of memory.");
-		return ENOMEM;
-	}
-
-	memcpy(packet->data, (uint8_t *) data + data_offs, packet->size);
+	packet->data = (uint8_t *) data + data_offs;
 	packet->link_id = link_id;
 	return EOK;
 }
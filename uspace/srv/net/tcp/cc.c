@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file TCP congestion control
+ *
+ * Generic part of congestion control (RFC 5681). Slow start and the
+ * window adjustments during fast recovery (RFC 6582) are common to all
+ * algorithms. The algorithm decides how the window grows during congestion
+ * avoidance and how much it is reduced when a loss is detected.
+ */
+
+#include <io/log.h>
+#include <macros.h>
+#include <mem.h>
+#include <str.h>
+#include "cc.h"
+#include "tcp_type.h"
+
+/** Upper bound of the congestion window */
+#define CWND_MAX	(UINT32_MAX / 2)
+
+/** Congestion control algorithm used for new connections */
+tcp_cc_algo_t tcp_cc_default = tcp_cc_newreno;
+
+static const tcp_cc_ops_t *tcp_cc_algos[] = {
+	[tcp_cc_newreno] = &tcp_cc_newreno_ops,
+	[tcp_cc_cubic] = &tcp_cc_cubic_ops
+};
+
+/** Compute initial congestion window (RFC 5681 3.1).
+ *
+ * @param smss	Sender maximum segment size
+ * @return	Initial window in bytes
+ */
+static uint32_t tcp_cc_initial_wnd(uint32_t smss)
+{
+	if (smss > 2190)
+		return 2 * smss;
+	if (smss > 1095)
+		return 3 * smss;
+	return 4 * smss;
+}
+
+/** Initialize congestion control with the default algorithm.
+ *
+ * @param conn	Connection
+ */
+void tcp_cc_init(tcp_conn_t *conn)
+{
+	tcp_cc_select(conn, tcp_cc_default);
+}
+
+/** Select congestion control algorithm for a connection.
+ *
+ * This resets the congestion control state and should be done before
+ * any data is transmitted.
+ *
+ * @param conn	Connection
+ * @param algo	Congestion control algorithm
+ */
+void tcp_cc_select(tcp_conn_t *conn, tcp_cc_algo_t algo)
+{
+	memset(&conn->cc, 0, sizeof(conn->cc));
+
+	conn->cc.algo = algo;
+	conn->cc.ops = tcp_cc_algos[algo];
+	conn->cc.cwnd = tcp_cc_initial_wnd(conn->smss);
+	conn->cc.ssthresh = UINT32_MAX;
+
+	if (conn->cc.ops->init != NULL)
+		conn->cc.ops->init(conn);
+}
+
+/** Find congestion control algorithm by name.
+ *
+ * @param name	Algorithm name
+ * @param ralgo	Place to store algorithm
+ * @return	EOK on success, EINVAL if there is no such algorithm
+ */
+errno_t tcp_cc_algo_by_name(const char *name, tcp_cc_algo_t *ralgo)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(tcp_cc_algos) / sizeof(tcp_cc_algos[0]); i++) {
+		if (str_cmp(tcp_cc_algos[i]->name, name) == 0) {
+			*ralgo = (tcp_cc_algo_t) i;
+			return EOK;
+		}
+	}
+
+	return EINVAL;
+}
+
+/** Get amount of data that has been sent, but not yet acknowledged.
+ *
+ * @param conn	Connection
+ * @return	Flight size in bytes
+ */
+uint32_t tcp_cc_flight_size(tcp_conn_t *conn)
+{
+	return conn->snd_nxt - conn->snd_una;
+}
+
+/** Grow congestion window by a fraction of a byte.
+ *
+ * Increase the congestion window by @a inc / cwnd bytes. Fractions are
+ * accumulated so that small increments are not lost.
+ *
+ * @param conn	Connection
+ * @param inc	Increment, multiplied by the congestion window
+ */
+void tcp_cc_grow(tcp_conn_t *conn, uint64_t inc)
+{
+	uint64_t bytes;
+
+	conn->cc.cwnd_acc += inc;
+	bytes = conn->cc.cwnd_acc / conn->cc.cwnd;
+	conn->cc.cwnd_acc -= bytes * conn->cc.cwnd;
+
+	conn->cc.cwnd = min(conn->cc.cwnd + bytes, CWND_MAX);
+}
+
+/** New data was acknowledged outside of fast recovery.
+ *
+ * @param conn	Connection
+ * @param acked	Number of newly acknowledged bytes
+ */
+void tcp_cc_ack(tcp_conn_t *conn, uint32_t acked)
+{
+	/* Growing the window is pointless while the peer's window limits us */
+	if (conn->cc.cwnd >= conn->snd_wnd)
+		return;
+
+	if (conn->cc.cwnd < conn->cc.ssthresh) {
+		/* Slow start */
+		conn->cc.cwnd += min(acked, conn->smss);
+		return;
+	}
+
+	/* Congestion avoidance */
+	conn->cc.ops->cong_avoid(conn, acked);
+}
+
+/** Enter fast recovery after fast retransmit.
+ *
+ * @param conn	Connection
+ */
+void tcp_cc_recovery_enter(tcp_conn_t *conn)
+{
+	conn->cc.ssthresh = conn->cc.ops->ssthresh(conn);
+	conn->cc.cwnd = conn->cc.ssthresh + 3 * conn->smss;
+	conn->cc.cwnd_acc = 0;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: %s: loss, cwnd=%" PRIu32
+	    " ssthresh=%" PRIu32, conn->name, conn->cc.ops->name,
+	    conn->cc.cwnd, conn->cc.ssthresh);
+}
+
+/** Another duplicate ACK arrived during fast recovery.
+ *
+ * A segment has left the network, inflate the window accordingly.
+ *
+ * @param conn	Connection
+ */
+void tcp_cc_recovery_dup_ack(tcp_conn_t *conn)
+{
+	conn->cc.cwnd = min(conn->cc.cwnd + conn->smss, CWND_MAX);
+}
+
+/** Partial ACK arrived during fast recovery.
+ *
+ * Deflate the window by the amount of new data acknowledged and add back
+ * one segment if at least one segment was acknowledged (RFC 6582 3.2).
+ *
+ * @param conn	Connection
+ * @param acked	Number of newly acknowledged bytes
+ */
+void tcp_cc_recovery_partial_ack(tcp_conn_t *conn, uint32_t acked)
+{
+	conn->cc.cwnd -= min(acked, conn->cc.cwnd);
+	if (acked >= conn->smss)
+		conn->cc.cwnd += conn->smss;
+
+	conn->cc.cwnd = max(conn->cc.cwnd, conn->smss);
+}
+
+/** Fast recovery ended with a full ACK.
+ *
+ * @param conn	Connection
+ */
+void tcp_cc_recovery_exit(tcp_conn_t *conn)
+{
+	uint32_t flight;
+
+	flight = tcp_cc_flight_size(conn);
+	conn->cc.cwnd = min(conn->cc.ssthresh,
+	    max(flight, conn->smss) + conn->smss);
+}
+
+/** Retransmission timer expired.
+ *
+ * @param conn	Connection
+ * @param first	@c true if the segment is retransmitted for the first time
+ */
+void tcp_cc_timeout(tcp_conn_t *conn, bool first)
+{
+	/* Repeated timeouts of the same segment do not reduce ssthresh */
+	if (first)
+		conn->cc.ssthresh = conn->cc.ops->ssthresh(conn);
+
+	/* Loss window */
+	conn->cc.cwnd = conn->smss;
+	conn->cc.cwnd_acc = 0;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: %s: timeout, cwnd=%" PRIu32
+	    " ssthresh=%" PRIu32, conn->name, conn->cc.ops->name,
+	    conn->cc.cwnd, conn->cc.ssthresh);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file CUBIC congestion control
+ *
+ * During congestion avoidance the window follows a cubic function of
+ * the time elapsed since the last loss, W(t) = C * (t - K)^3 + W_max,
+ * which grows quickly back towards the window at which the loss occurred
+ * and probes carefully around it (RFC 9438). This makes window growth
+ * independent of the round-trip time.
+ *
+ * All computations use integer arithmetic with windows in bytes and
+ * time in milliseconds.
+ */
+
+#include <macros.h>
+#include <time.h>
+#include "cc.h"
+#include "tcp_type.h"
+
+/** Multiplicative decrease factor beta (in tenths) */
+#define CUBIC_BETA	7
+/** Limit of |t - K| to avoid overflow (msec) */
+#define CUBIC_DT_MAX	(30 * 1000)
+
+/** Integer cube root.
+ *
+ * @param a	Argument
+ * @return	Largest integer whose cube does not exceed @a a
+ */
+static uint64_t tcp_cubic_cbrt(uint64_t a)
+{
+	uint64_t y = 0;
+	uint64_t b;
+	int s;
+
+	for (s = 63; s >= 0; s -= 3) {
+		y += y;
+		b = 3 * y * (y + 1) + 1;
+		if ((a >> s) >= b) {
+			a -= b << s;
+			y++;
+		}
+	}
+
+	return y;
+}
+
+/** Compute W_cubic(t).
+ *
+ * @param conn	Connection
+ * @param t	Time since start of the epoch (msec)
+ * @return	Window in bytes
+ */
+static uint64_t tcp_cubic_wnd(tcp_conn_t *conn, int64_t t)
+{
+	tcp_cubic_t *cubic = &conn->cc.u.cubic;
+	int64_t dt;
+	int64_t w;
+
+	dt = t - cubic->k;
+	if (dt > CUBIC_DT_MAX)
+		dt = CUBIC_DT_MAX;
+	if (dt < -CUBIC_DT_MAX)
+		dt = -CUBIC_DT_MAX;
+
+	/* C = 0.4 segments/s^3, dt in msec */
+	w = (int64_t) cubic->w_max +
+	    4 * dt * dt * dt * (int64_t) conn->smss / 10000000000ll;
+
+	return w > 0 ? (uint64_t) w : 0;
+}
+
+/** Start a new congestion avoidance epoch.
+ *
+ * @param conn	Connection
+ * @param now	Current time
+ */
+static void tcp_cubic_epoch_start(tcp_conn_t *conn, struct timespec *now)
+{
+	tcp_cubic_t *cubic = &conn->cc.u.cubic;
+	uint64_t diff;
+
+	cubic->epoch_start = *now;
+	cubic->epoch_valid = true;
+	cubic->cwnd_epoch = conn->cc.cwnd;
+
+	if (cubic->w_max > conn->cc.cwnd) {
+		/* K = cbrt((W_max - cwnd_epoch) / C), in msec */
+		diff = cubic->w_max - conn->cc.cwnd;
+		cubic->k = tcp_cubic_cbrt(diff * 2500000000ull / conn->smss);
+	} else {
+		/* Already above the previous maximum, start probing */
+		cubic->w_max = conn->cc.cwnd;
+		cubic->k = 0;
+	}
+}
+
+/** Grow window in congestion avoidance.
+ *
+ * @param conn	Connection
+ * @param acked	Number of newly acknowledged bytes
+ */
+static void tcp_cubic_cong_avoid(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cubic_t *cubic = &conn->cc.u.cubic;
+	struct timespec now;
+	uint32_t cwnd = conn->cc.cwnd;
+	usec_t rtt;
+	usec_t t;
+	uint64_t target;
+	uint64_t w_est;
+
+	getuptime(&now);
+	if (!cubic->epoch_valid)
+		tcp_cubic_epoch_start(conn, &now);
+
+	t = NSEC2USEC(ts_sub_diff(&now, &cubic->epoch_start));
+	rtt = conn->rtt_valid ? conn->srtt : 0;
+
+	/* Where the window should be one round-trip time from now */
+	target = tcp_cubic_wnd(conn, (t + rtt) / 1000);
+
+	/*
+	 * Reno-friendly region. Make sure we grow at least as fast as
+	 * NewReno would, W_est(t) = cwnd_epoch + alpha * t / RTT
+	 * with alpha = 3 * (1 - beta) / (1 + beta).
+	 */
+	if (rtt > 0) {
+		w_est = cubic->cwnd_epoch + (uint64_t) t * conn->smss *
+		    3 * (10 - CUBIC_BETA) / ((10 + CUBIC_BETA) * (uint64_t) rtt);
+		target = max(target, w_est);
+	}
+
+	if (target > cwnd) {
+		/*
+		 * Grow by (target - cwnd) / cwnd segments per acknowledged
+		 * segment, but at most by half a segment.
+		 */
+		tcp_cc_grow(conn, (uint64_t) acked *
+		    min(target - cwnd, (uint64_t) cwnd / 2));
+	} else {
+		/* Plateau around W_max, probe very slowly */
+		tcp_cc_grow(conn, (uint64_t) acked * conn->smss / 100);
+	}
+}
+
+/** Compute slow start threshold after loss.
+ *
+ * @param conn	Connection
+ * @return	New slow start threshold
+ */
+static uint32_t tcp_cubic_ssthresh(tcp_conn_t *conn)
+{
+	tcp_cubic_t *cubic = &conn->cc.u.cubic;
+	uint32_t cwnd = conn->cc.cwnd;
+
+	/*
+	 * Fast convergence. If the window did not reach the previous
+	 * maximum, another flow is probably competing for the link.
+	 * Release some bandwidth by lowering W_max further.
+	 */
+	if (cwnd < cubic->w_max)
+		cubic->w_max = (uint64_t) cwnd * (10 + CUBIC_BETA) / 20;
+	else
+		cubic->w_max = cwnd;
+
+	/* Start a new epoch once in congestion avoidance again */
+	cubic->epoch_valid = false;
+
+	return max((uint64_t) cwnd * CUBIC_BETA / 10, 2 * conn->smss);
+}
+
+const tcp_cc_ops_t tcp_cc_cubic_ops = {
+	.name = "cubic",
+	.cong_avoid = tcp_cubic_cong_avoid,
+	.ssthresh = tcp_cubic_ssthresh
+};
+
+/**
+ * @}
+ */
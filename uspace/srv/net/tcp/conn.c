@@ -42,9 +42,11 @@
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
+#include "ncsim.h"
 #include "pdu.h"
 #include "rqueue.h"
 #include "segment.h"
@@ -53,12 +55,21 @@
 #include "tqueue.h"
 #include "ucall.h"
 
-#define RCV_BUF_SIZE 4096/*2*/
+/** Large enough to need window scaling */
+#define RCV_BUF_SIZE (256*1024)
 #define SND_BUF_SIZE 4096
 
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
 
+/** Number of duplicate ACKs that trigger fast retransmit */
+#define DUP_ACK_THRESHOLD	3
+
+/** Sender maximum segment size if not negotiated (RFC 1122) */
+#define DEFAULT_SMSS	536
+/** Lower bound of the sender maximum segment size */
+#define MIN_SMSS	64
+
 /** List of all allocated connections */
 static LIST_INITIALIZE(conn_list);
 /** Taken after tcp_conn_t lock */
@@ -152,6 +163,15 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
 
+	/* Window scale needed to advertise the whole receive buffer */
+	while (conn->rcv_wscale < TCP_WSCALE_MAX &&
+	    (conn->rcv_wnd >> conn->rcv_wscale) > UINT16_MAX)
+		++conn->rcv_wscale;
+
+	/* Set up congestion control */
+	conn->smss = DEFAULT_SMSS;
+	tcp_cc_init(conn);
+
 	/* Initialize incoming segment queue */
 	tcp_iqueue_init(&conn->incoming, conn);
 
@@ -511,6 +531,53 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Process options in SYN received from the peer.
+ *
+ * Options that the peer did not include in its SYN are not used
+ * for the connection.
+ *
+ * @param conn		Connection
+ * @param seg		SYN segment
+ */
+static void tcp_conn_syn_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+	uint32_t mss;
+
+	mss = (opts->flags & TOF_MSS) != 0 ? opts->mss : DEFAULT_SMSS;
+	mss = max(mss, MIN_SMSS);
+
+	if ((opts->flags & TOF_WSCALE) != 0) {
+		conn->ws_ok = true;
+		conn->snd_wscale = min(opts->wscale, TCP_WSCALE_MAX);
+	} else {
+		/* Both sides need to agree, otherwise windows are not scaled */
+		conn->ws_ok = false;
+		conn->snd_wscale = 0;
+		conn->rcv_wscale = 0;
+	}
+
+	conn->sack_ok = (opts->flags & TOF_SACK_PERM) != 0;
+
+	if ((opts->flags & TOF_TS) != 0) {
+		conn->ts_ok = true;
+		conn->ts_recent = opts->tsval;
+		/* Timestamp option takes up space in every segment */
+		mss -= 2 + OPT_TIMESTAMP_LEN;
+	} else {
+		conn->ts_ok = false;
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: MSS=%" PRIu32 " WS=%d/%u/%u "
+	    "SACK=%d TS=%d", conn->name, mss, (int) conn->ws_ok,
+	    (unsigned) conn->snd_wscale, (unsigned) conn->rcv_wscale,
+	    (int) conn->sack_ok, (int) conn->ts_ok);
+
+	/* Initial congestion window depends on SMSS */
+	conn->smss = mss;
+	tcp_cc_select(conn, conn->cc.algo);
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -540,6 +607,7 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
+	tcp_conn_syn_opts(conn, seg);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "rcv_nxt=%u", conn->rcv_nxt);
 
@@ -614,10 +682,15 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
+	tcp_conn_syn_opts(conn, seg);
 
 	if ((seg->ctrl & CTL_ACK) != 0) {
 		conn->snd_una = seg->ack;
 
+		/* Peer echoes the timestamp of our SYN */
+		if (conn->ts_ok && seg->opts.tsecr != 0)
+			tcp_tqueue_ts_rtt(conn, seg->opts.tsecr);
+
 		/*
 		 * Prune acked segments from retransmission queue and
 		 * possibly transmit more data.
@@ -665,6 +738,21 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
+	/* Window in SYN is never scaled */
+	if ((seg->ctrl & CTL_SYN) == 0)
+		seg->wnd <<= conn->snd_wscale;
+
+	/* Protect against wrapped sequence numbers (PAWS, RFC 7323 5.3) */
+	if (conn->ts_ok && (seg->opts.flags & TOF_TS) != 0 &&
+	    (seg->ctrl & CTL_RST) == 0 &&
+	    (int32_t) (seg->opts.tsval - conn->ts_recent) < 0) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Replying ACK to segment with "
+		    "old timestamp.");
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		tcp_segment_delete(seg);
+		return;
+	}
+
 	/* Discard unacceptable segments ("old duplicates") */
 	if (!seq_no_segment_acceptable(conn, seg)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Replying ACK to unacceptable segment.");
@@ -673,6 +761,24 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	/* Remember timestamp to echo (RFC 7323 4.3) */
+	if (conn->ts_ok && (seg->opts.flags & TOF_TS) != 0 &&
+	    seq_no_ts_recent_update(conn, seg))
+		conn->ts_recent = seg->opts.tsval;
+
+	/* Most recent out-of-order segment is reported first in SACK */
+	if (!seq_no_segment_ready(conn, seg))
+		conn->sack_recent = seg->seq;
+
+	/*
+	 * Text or FIN that arrives out of order or fills (part of) a hole
+	 * in the sequence space must be acknowledged immediately, so that
+	 * the peer gets duplicate ACKs and can retransmit the missing
+	 * segment (RFC 5681 4.2).
+	 */
+	bool ack_now = seg->len > 0 && (!seq_no_segment_ready(conn, seg) ||
+	    !list_empty(&conn->incoming.list));
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
@@ -684,6 +790,13 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 	while (tcp_iqueue_get_ready_seg(&conn->incoming, &pseg) == EOK)
 		tcp_conn_seg_process(conn, pseg);
+
+	if (conn->cstate == st_closed)
+		return;
+
+	/* Acknowledge all text processed above with a single ACK. */
+	if (conn->ack_pending || ack_now)
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
 }
 
 /** Process segment RST field.
@@ -802,6 +915,49 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
 	return cp_continue;
 }
 
+/** Process duplicate ACK.
+ *
+ * Count duplicate ACKs as defined by RFC 5681 and perform fast retransmit
+ * when the threshold is reached.
+ *
+ * @param conn		Connection
+ * @param seg		Segment
+ */
+static void tcp_conn_dup_ack(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	/*
+	 * Only a pure ACK not updating the window while there is
+	 * outstanding data counts as duplicate.
+	 */
+	if (seg->ack != conn->snd_una || seg->len != 0 ||
+	    seg->wnd != conn->snd_wnd || conn->snd_una == conn->snd_nxt) {
+		conn->dup_acks = 0;
+		return;
+	}
+
+	++conn->stats.dup_acks;
+
+	/* Already recovering, we have retransmitted the segment */
+	if (conn->fast_recovery) {
+		/* Another segment has left the network */
+		tcp_cc_recovery_dup_ack(conn);
+		/* Repair the next hole reported by the peer */
+		(void) tcp_tqueue_sack_retransmit(conn);
+		return;
+	}
+
+	if (++conn->dup_acks < DUP_ACK_THRESHOLD)
+		return;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: %u duplicate ACKs, entering fast "
+	    "recovery", conn->name, conn->dup_acks);
+
+	conn->fast_recovery = true;
+	conn->recover = conn->snd_nxt;
+	tcp_cc_recovery_enter(conn);
+	tcp_tqueue_fast_retransmit(conn);
+}
+
 /** Process segment ACK field in Established state.
  *
  * @param conn		Connection
@@ -811,12 +967,19 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
  */
 static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	bool partial_ack = false;
+	bool full_ack = false;
+	uint32_t acked;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_seg_proc_ack_est(%p, %p)", conn, seg);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "SEG.ACK=%u, SND.UNA=%u, SND.NXT=%u",
 	    (unsigned)seg->ack, (unsigned)conn->snd_una,
 	    (unsigned)conn->snd_nxt);
 
+	/* Note which segments the peer has already received */
+	tcp_tqueue_sack_received(conn, &seg->opts);
+
 	if (!seq_no_ack_acceptable(conn, seg->ack)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "ACK not acceptable.");
 		if (!seq_no_ack_duplicate(conn, seg->ack)) {
@@ -827,11 +990,40 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			tcp_segment_delete(seg);
 			return cp_done;
 		} else {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Duplicate ACK.");
+			tcp_conn_dup_ack(conn, seg);
 		}
 	} else {
+		acked = seg->ack - conn->snd_una;
+
+		/* New data acknowledged, measure round-trip time */
+		if (conn->ts_ok && (seg->opts.flags & TOF_TS) != 0 &&
+		    seg->opts.tsecr != 0)
+			tcp_tqueue_ts_rtt(conn, seg->opts.tsecr);
+
+		if (conn->fast_recovery) {
+			/*
+			 * A partial ACK reveals another lost segment. A full
+			 * ACK ends fast recovery (RFC 6582).
+			 */
+			if (seq_no_ack_partial(conn, seg->ack)) {
+				partial_ack = true;
+				tcp_cc_recovery_partial_ack(conn, acked);
+			} else {
+				conn->fast_recovery = false;
+				full_ack = true;
+			}
+		} else {
+			tcp_cc_ack(conn, acked);
+		}
+
 		/* Update SND.UNA */
 		conn->snd_una = seg->ack;
+		conn->dup_acks = 0;
+
+		/* Deflate the window based on data still in flight */
+		if (full_ack)
+			tcp_cc_recovery_exit(conn);
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
@@ -850,6 +1042,17 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 	tcp_tqueue_ack_received(conn);
 
+	/*
+	 * Retransmit the first unacknowledged segment. With SACK it might
+	 * have been retransmitted already, then repair the next hole.
+	 */
+	if (partial_ack) {
+		if (conn->sack_ok)
+			(void) tcp_tqueue_sack_retransmit(conn);
+		else
+			tcp_tqueue_fast_retransmit(conn);
+	}
+
 	return cp_continue;
 }
 
@@ -1079,9 +1282,9 @@ static cproc_t tcp_conn_seg_proc_text(tcp_conn_t *conn, tcp_segment_t *seg)
 	/* Update receive window. XXX Not an efficient strategy. */
 	conn->rcv_wnd -= xfer_size;
 
-	/* Send ACK */
+	/* Send ACK once all ready segments have been processed */
 	if (xfer_size > 0)
-		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		conn->ack_pending = true;
 
 	if (xfer_size < seg->len) {
 		/* Trim part of segment which we just received */
@@ -1409,11 +1612,20 @@ static void tcp_transmit_segment(inet_ep2_t *epp, tcp_segment_t *seg)
 
 	tcp_segment_dump(seg);
 
+	if (tcp_conn_lb == tcp_lb_ncsim) {
+		/* Loop back segment through network condition simulator */
+		dseg = tcp_segment_dup(seg);
+		if (dseg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "Not enough memory. Segment dropped.");
+			return;
+		}
+
+		tcp_ncsim_bounce_seg(epp, dseg);
+		return;
+	}
+
 	if (tcp_conn_lb == tcp_lb_segment) {
 		/* Loop back segment */
-#if 0
-		tcp_ncsim_bounce_seg(sp, seg);
-#endif
 
 		/* Reverse the identification */
 		tcp_ep2_flipped(epp, &rident);
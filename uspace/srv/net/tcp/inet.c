@@ -50,7 +50,7 @@
 #define NAME       "tcp"
 
 static errno_t tcp_inet_ev_recv(inet_dgram_t *dgram);
-static void tcp_received_pdu(tcp_pdu_t *pdu);
+static errno_t tcp_received_pdu(tcp_pdu_t *, void *);
 
 static inet_ev_ops_t tcp_inet_ev_ops = {
 	.recv = tcp_inet_ev_recv
@@ -71,7 +71,7 @@ static errno_t tcp_inet_ev_recv(inet_dgram_t *dgram)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_inet_ev_recv() - split header/payload");
 
-	tcp_pdu_t *pdu;
+	tcp_pdu_t pdu;
 	size_t hdr_size;
 	tcp_header_t *hdr;
 	uint32_t data_offset;
@@ -102,18 +102,17 @@ static errno_t tcp_inet_ev_recv(inet_dgram_t *dgram)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "pdu_raw_size=%zu, hdr_size=%zu",
 	    pdu_raw_size, hdr_size);
-	pdu = tcp_pdu_create(pdu_raw, hdr_size, pdu_raw + hdr_size,
-	    pdu_raw_size - hdr_size);
-	if (pdu == NULL) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed creating PDU. Dropped.");
-		return ENOMEM;
-	}
 
-	pdu->src = dgram->src;
-	pdu->dest = dgram->dest;
+	/* The PDU refers to the datagram, the segment takes it over */
+	pdu.header = pdu_raw;
+	pdu.header_size = hdr_size;
+	pdu.text = pdu_raw + hdr_size;
+	pdu.text_size = pdu_raw_size - hdr_size;
+	pdu.src = dgram->src;
+	pdu.dest = dgram->dest;
 
-	tcp_received_pdu(pdu);
-	tcp_pdu_delete(pdu);
+	if (tcp_received_pdu(&pdu, pdu_raw) == EOK)
+		dgram->data = NULL;
 
 	return EOK;
 }
@@ -151,21 +150,27 @@ void tcp_transmit_pdu(tcp_pdu_t *pdu)
 	free(pdu_raw);
 }
 
-/** Process received PDU. */
-static void tcp_received_pdu(tcp_pdu_t *pdu)
+/** Process received PDU.
+ *
+ * @param pdu PDU
+ * @param buf Buffer containing the PDU text, taken over on success
+ * @return EOK on success, ENOMEM if the PDU was dropped
+ */
+static errno_t tcp_received_pdu(tcp_pdu_t *pdu, void *buf)
 {
 	tcp_segment_t *dseg;
 	inet_ep2_t rident;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_received_pdu()");
 
-	if (tcp_pdu_decode(pdu, &rident, &dseg) != EOK) {
+	if (tcp_pdu_decode_ref(pdu, buf, &rident, &dseg) != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Not enough memory. PDU dropped.");
-		return;
+		return ENOMEM;
 	}
 
 	/* Insert decoded segment into rqueue */
 	tcp_rqueue_insert_seg(&rident, dseg);
+	return EOK;
 }
 
 /** Initialize TCP inet interface. */
@@ -186,6 +186,112 @@ errno_t tcp_iqueue_get_ready_seg(tcp_iqueue_t *iqueue, tcp_segment_t **seg)
 	return EOK;
 }
 
+/** Get next contiguous block of queued sequence space.
+ *
+ * @param iqueue	Incoming queue
+ * @param link		First queue link to consider or @c NULL
+ * @param blk		Place to store block
+ * @return		Link following the block, @c NULL if there is none
+ *			or the queue is exhausted. If no block was found,
+ *			@a blk is empty (start == end).
+ */
+static link_t *tcp_iqueue_next_block(tcp_iqueue_t *iqueue, link_t *link,
+    tcp_sack_block_t *blk)
+{
+	tcp_iqueue_entry_t *qe;
+	uint32_t end;
+
+	blk->start = blk->end = 0;
+
+	/* Skip segments that will be processed shortly */
+	while (link != NULL) {
+		qe = list_get_instance(link, tcp_iqueue_entry_t, link);
+		if (qe->seg->len > 0 &&
+		    !seq_no_segment_ready(iqueue->conn, qe->seg))
+			break;
+		link = list_next(link, &iqueue->list);
+	}
+
+	if (link == NULL)
+		return NULL;
+
+	blk->start = qe->seg->seq;
+	blk->end = qe->seg->seq + qe->seg->len;
+	link = list_next(link, &iqueue->list);
+
+	/* Merge following segments that overlap or adjoin the block */
+	while (link != NULL) {
+		qe = list_get_instance(link, tcp_iqueue_entry_t, link);
+
+		/* Queue is sorted, segment starts after the block start */
+		if ((int32_t) (qe->seg->seq - blk->end) > 0)
+			break;
+
+		end = qe->seg->seq + qe->seg->len;
+		if ((int32_t) (end - blk->end) > 0)
+			blk->end = end;
+
+		link = list_next(link, &iqueue->list);
+	}
+
+	return link;
+}
+
+/** Get SACK blocks describing the queued out-of-order segments.
+ *
+ * The block containing the most recently received segment is reported
+ * first, other blocks follow in order of sequence number (RFC 2018 4).
+ *
+ * @param iqueue	Incoming queue
+ * @param recent	Sequence number of the most recently received segment
+ * @param blocks	Array to fill in
+ * @param max		Size of @a blocks
+ * @return		Number of blocks filled in
+ */
+size_t tcp_iqueue_sack_blocks(tcp_iqueue_t *iqueue, uint32_t recent,
+    tcp_sack_block_t *blocks, size_t max)
+{
+	tcp_sack_block_t blk;
+	link_t *link;
+	size_t cnt;
+	bool first;
+
+	if (max == 0)
+		return 0;
+
+	/* Find block with the most recent segment */
+	cnt = 0;
+	link = list_first(&iqueue->list);
+	do {
+		link = tcp_iqueue_next_block(iqueue, link, &blk);
+		if (blk.start != blk.end && (int32_t) (recent - blk.start) >= 0 &&
+		    (int32_t) (recent - blk.end) < 0) {
+			blocks[cnt++] = blk;
+			break;
+		}
+	} while (link != NULL);
+
+	first = cnt > 0;
+
+	/* Add remaining blocks */
+	link = list_first(&iqueue->list);
+	do {
+		if (cnt >= max)
+			break;
+
+		link = tcp_iqueue_next_block(iqueue, link, &blk);
+		if (blk.start == blk.end)
+			break;
+
+		if (first && blk.start == blocks[0].start)
+			continue;
+
+		blocks[cnt++] = blk;
+	} while (link != NULL);
+
+	return cnt;
+}
+
 /**
  * @}
  */
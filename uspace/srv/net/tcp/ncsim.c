@@ -36,6 +36,9 @@
  * Simulate network conditions for testing the reliability implementation:
  *    - variable latency
  *    - frame drop
+ *    - limited bandwidth with a finite queue (tail drop)
+ *
+ * The bottleneck link is shared by both directions.
  */
 
 #include <adt/list.h>
@@ -43,8 +46,11 @@
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <fibril.h>
+#include <time.h>
 #include "conn.h"
 #include "ncsim.h"
 #include "rqueue.h"
@@ -54,19 +60,72 @@
 static list_t sim_queue;
 static fibril_mutex_t sim_queue_lock;
 static fibril_condvar_t sim_queue_cv;
+static tcp_ncsim_params_t sim_params;
+static bool sim_fibril_active;
+static bool sim_quit;
+/** Time when the bottleneck link finishes transmitting queued segments */
+static struct timespec sim_link_free;
+
+/** Size of segment on the wire, assuming a minimal header */
+#define SIM_SEG_OVERHEAD	20
 
-/** Initialize segment receive queue. */
+/** Initialize network condition simulator.
+ *
+ * The simulator starts out passing segments through unchanged.
+ */
 void tcp_ncsim_init(void)
 {
 	list_initialize(&sim_queue);
 	fibril_mutex_initialize(&sim_queue_lock);
 	fibril_condvar_initialize(&sim_queue_cv);
+	memset(&sim_params, 0, sizeof(sim_params));
+	sim_fibril_active = false;
+	sim_quit = false;
+	getuptime(&sim_link_free);
+}
+
+/** Finalize network condition simulator.
+ *
+ * Stop the handler fibril and discard segments that were not delivered.
+ */
+void tcp_ncsim_fini(void)
+{
+	tcp_squeue_entry_t *sqe;
+	link_t *link;
+
+	fibril_mutex_lock(&sim_queue_lock);
+
+	sim_quit = true;
+	fibril_condvar_broadcast(&sim_queue_cv);
+
+	while (sim_fibril_active)
+		fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+
+	while ((link = list_first(&sim_queue)) != NULL) {
+		sqe = list_get_instance(link, tcp_squeue_entry_t, link);
+		list_remove(link);
+		tcp_segment_delete(sqe->seg);
+		free(sqe);
+	}
+
+	fibril_mutex_unlock(&sim_queue_lock);
+}
+
+/** Set simulated network conditions.
+ *
+ * @param params	Simulator parameters
+ */
+void tcp_ncsim_set_params(tcp_ncsim_params_t *params)
+{
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_params = *params;
+	fibril_mutex_unlock(&sim_queue_lock);
 }
 
 /** Bounce segment through simulator into receive queue.
  *
  * @param epp	Endpoint pair, oriented for transmission
- * @param seg	Segment
+ * @param seg	Segment (ownership transferred to simulator)
  */
 void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
@@ -74,46 +133,89 @@ void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	tcp_squeue_entry_t *old_qe;
 	inet_ep2_t rident;
 	link_t *link;
+	struct timespec now;
+	struct timespec due;
+	usec_t delay;
+	usec_t backlog;
+	size_t size;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_bounce_seg()");
-	tcp_ep2_flipped(epp, &rident);
-	tcp_rqueue_insert_seg(&rident, seg);
-	return;
 
-	if (0 /*rand() % 4 == 3*/) {
+	fibril_mutex_lock(&sim_queue_lock);
+
+	if ((sim_params.drop != NULL &&
+	    sim_params.drop(epp, seg, sim_params.drop_arg)) ||
+	    (sim_params.loss_rate != 0 &&
+	    rand() % sim_params.loss_rate == 0)) {
 		/* Drop segment */
-		log_msg(LOG_DEFAULT, LVL_ERROR, "NCSim dropping segment");
+		fibril_mutex_unlock(&sim_queue_lock);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim dropping segment");
 		tcp_segment_delete(seg);
 		return;
 	}
 
+	getuptime(&now);
+	due = now;
+
+	if (sim_params.bandwidth != 0) {
+		if (ts_gt(&now, &sim_link_free))
+			sim_link_free = now;
+
+		size = tcp_segment_text_size(seg) + SIM_SEG_OVERHEAD;
+		backlog = NSEC2USEC(ts_sub_diff(&sim_link_free, &now));
+
+		if (sim_params.queue_max != 0 && (uint64_t) backlog *
+		    sim_params.bandwidth / 1000000 + size > sim_params.queue_max) {
+			/* Bottleneck queue is full */
+			fibril_mutex_unlock(&sim_queue_lock);
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim queue overflow");
+			tcp_segment_delete(seg);
+			return;
+		}
+
+		/* Segment leaves the bottleneck after it has been serialized */
+		ts_add_diff(&sim_link_free, USEC2NSEC((usec_t) size * 1000000 /
+		    sim_params.bandwidth));
+		due = sim_link_free;
+	}
+
+	delay = sim_params.delay;
+	if (sim_params.jitter != 0)
+		delay += rand() % (sim_params.jitter + 1);
+
+	if (delay == 0 && sim_params.bandwidth == 0 && list_empty(&sim_queue)) {
+		/* Nothing to wait for, deliver immediately */
+		fibril_mutex_unlock(&sim_queue_lock);
+		tcp_ep2_flipped(epp, &rident);
+		tcp_rqueue_insert_seg(&rident, seg);
+		return;
+	}
+
 	sqe = calloc(1, sizeof(tcp_squeue_entry_t));
 	if (sqe == NULL) {
+		fibril_mutex_unlock(&sim_queue_lock);
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating SQE.");
+		tcp_segment_delete(seg);
 		return;
 	}
 
-	sqe->delay = rand() % (1000 * 1000);
+	sqe->due = due;
+	ts_add_diff(&sqe->due, USEC2NSEC(delay));
 	sqe->epp = *epp;
 	sqe->seg = seg;
 
-	fibril_mutex_lock(&sim_queue_lock);
-
+	/* Keep the queue sorted by delivery time */
 	link = list_first(&sim_queue);
-	while (link != NULL && sqe->delay > 0) {
+	while (link != NULL) {
 		old_qe = list_get_instance(link, tcp_squeue_entry_t, link);
-		if (sqe->delay < old_qe->delay)
+		if (ts_gt(&old_qe->due, &sqe->due))
 			break;
 
-		sqe->delay -= old_qe->delay;
-
-		link = link->next;
-		if (link == &sim_queue.head)
-			link = NULL;
+		link = list_next(link, &sim_queue);
 	}
 
 	if (link != NULL)
-		list_insert_after(&sqe->link, link);
+		list_insert_before(&sqe->link, link);
 	else
 		list_append(&sqe->link, &sim_queue);
 
@@ -127,35 +229,49 @@ static errno_t tcp_ncsim_fibril(void *arg)
 	link_t *link;
 	tcp_squeue_entry_t *sqe;
 	inet_ep2_t rident;
-	errno_t rc;
+	struct timespec now;
+	usec_t timeout;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_fibril()");
 
-	while (true) {
-		fibril_mutex_lock(&sim_queue_lock);
+	fibril_mutex_lock(&sim_queue_lock);
 
-		while (list_empty(&sim_queue))
+	while (!sim_quit) {
+		link = list_first(&sim_queue);
+		if (link == NULL) {
 			fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+			continue;
+		}
+
+		sqe = list_get_instance(link, tcp_squeue_entry_t, link);
 
-		do {
-			link = list_first(&sim_queue);
-			sqe = list_get_instance(link, tcp_squeue_entry_t, link);
+		getuptime(&now);
+		if (ts_gt(&sqe->due, &now)) {
+			/* Zero timeout would mean waiting forever */
+			timeout = max(NSEC2USEC(ts_sub_diff(&sqe->due, &now)), 1);
 
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim - Sleep");
-			rc = fibril_condvar_wait_timeout(&sim_queue_cv,
-			    &sim_queue_lock, sqe->delay);
-		} while (rc != ETIMEOUT);
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "NCSim - Sleep");
+			(void) fibril_condvar_wait_timeout(&sim_queue_cv,
+			    &sim_queue_lock, timeout);
+			continue;
+		}
 
 		list_remove(link);
 		fibril_mutex_unlock(&sim_queue_lock);
 
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim - End Sleep");
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "NCSim - Deliver");
 		tcp_ep2_flipped(&sqe->epp, &rident);
 		tcp_rqueue_insert_seg(&rident, sqe->seg);
 		free(sqe);
+
+		fibril_mutex_lock(&sim_queue_lock);
 	}
 
-	/* Not reached */
+	sim_fibril_active = false;
+	fibril_condvar_broadcast(&sim_queue_cv);
+	fibril_mutex_unlock(&sim_queue_lock);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_fibril() exiting");
 	return 0;
 }
 
@@ -172,6 +288,10 @@ void tcp_ncsim_fibril_start(void)
 		return;
 	}
 
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_fibril_active = true;
+	fibril_mutex_unlock(&sim_queue_lock);
+
 	fibril_add_ready(fid);
 }
 
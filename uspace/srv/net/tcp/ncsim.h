@@ -39,6 +39,8 @@
 #include "tcp_type.h"
 
 extern void tcp_ncsim_init(void);
+extern void tcp_ncsim_fini(void);
+extern void tcp_ncsim_set_params(tcp_ncsim_params_t *);
 extern void tcp_ncsim_bounce_seg(inet_ep2_t *, tcp_segment_t *);
 extern void tcp_ncsim_fibril_start(void);
 
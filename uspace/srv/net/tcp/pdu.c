@@ -38,6 +38,7 @@
 #include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "pdu.h"
@@ -125,7 +126,257 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+/** Encode 16-bit value in network byte order.
+ *
+ * @param buf	Buffer
+ * @param val	Value
+ */
+static void tcp_opt_put16(uint8_t *buf, uint16_t val)
+{
+	buf[0] = val >> 8;
+	buf[1] = val & 0xff;
+}
+
+/** Encode 32-bit value in network byte order.
+ *
+ * @param buf	Buffer
+ * @param val	Value
+ */
+static void tcp_opt_put32(uint8_t *buf, uint32_t val)
+{
+	tcp_opt_put16(buf, val >> 16);
+	tcp_opt_put16(buf + 2, val & 0xffff);
+}
+
+/** Decode 16-bit value in network byte order.
+ *
+ * @param buf	Buffer
+ * @return	Value
+ */
+static uint16_t tcp_opt_get16(uint8_t *buf)
+{
+	return ((uint16_t) buf[0] << 8) | buf[1];
+}
+
+/** Decode 32-bit value in network byte order.
+ *
+ * @param buf	Buffer
+ * @return	Value
+ */
+static uint32_t tcp_opt_get32(uint8_t *buf)
+{
+	return ((uint32_t) tcp_opt_get16(buf) << 16) | tcp_opt_get16(buf + 2);
+}
+
+/** Compute size of encoded options other than SACK.
+ *
+ * Options are padded with NOPs so that each of them is 32-bit aligned.
+ *
+ * @param opts	Segment options
+ * @return	Size in bytes (a multiple of four)
+ */
+static size_t tcp_opts_base_size(tcp_seg_opts_t *opts)
+{
+	size_t size = 0;
+
+	if ((opts->flags & TOF_MSS) != 0)
+		size += OPT_MAX_SEG_SIZE_LEN;
+	if ((opts->flags & TOF_WSCALE) != 0)
+		size += 1 + OPT_WINDOW_SCALE_LEN;
+	if ((opts->flags & TOF_TS) != 0)
+		size += 2 + OPT_TIMESTAMP_LEN;
+	else if ((opts->flags & TOF_SACK_PERM) != 0)
+		size += 2 + OPT_SACK_PERMITTED_LEN;
+
+	return size;
+}
+
+/** Determine how many SACK blocks fit into the options.
+ *
+ * @param opts	Segment options
+ * @return	Number of SACK blocks that will be encoded
+ */
+static size_t tcp_opts_sack_cnt(tcp_seg_opts_t *opts)
+{
+	size_t base;
+
+	base = tcp_opts_base_size(opts) + 2 + OPT_SACK_LEN;
+	if (opts->sack_cnt == 0 || base > TCP_OPTS_MAX_SIZE)
+		return 0;
+
+	return min(opts->sack_cnt,
+	    (TCP_OPTS_MAX_SIZE - base) / OPT_SACK_BLOCK_LEN);
+}
+
+/** Compute size of encoded options.
+ *
+ * @param opts	Segment options
+ * @return	Size in bytes (a multiple of four)
+ */
+static size_t tcp_opts_size(tcp_seg_opts_t *opts)
+{
+	size_t size;
+	size_t sack_cnt;
+
+	size = tcp_opts_base_size(opts);
+
+	sack_cnt = tcp_opts_sack_cnt(opts);
+	if (sack_cnt > 0)
+		size += 2 + OPT_SACK_LEN + sack_cnt * OPT_SACK_BLOCK_LEN;
+
+	return size;
+}
+
+/** Encode segment options.
+ *
+ * @param opts	Segment options
+ * @param buf	Buffer of size returned by tcp_opts_size()
+ */
+static void tcp_opts_encode(tcp_seg_opts_t *opts, uint8_t *buf)
+{
+	size_t sack_cnt;
+	size_t i;
+
+	if ((opts->flags & TOF_MSS) != 0) {
+		buf[0] = OPT_MAX_SEG_SIZE;
+		buf[1] = OPT_MAX_SEG_SIZE_LEN;
+		tcp_opt_put16(buf + 2, opts->mss);
+		buf += OPT_MAX_SEG_SIZE_LEN;
+	}
+
+	if ((opts->flags & TOF_WSCALE) != 0) {
+		*buf++ = OPT_NOP;
+		buf[0] = OPT_WINDOW_SCALE;
+		buf[1] = OPT_WINDOW_SCALE_LEN;
+		buf[2] = opts->wscale;
+		buf += OPT_WINDOW_SCALE_LEN;
+	}
+
+	if ((opts->flags & TOF_SACK_PERM) != 0) {
+		/* Fill the padding in front of timestamps if possible */
+		if ((opts->flags & TOF_TS) == 0) {
+			*buf++ = OPT_NOP;
+			*buf++ = OPT_NOP;
+		}
+
+		buf[0] = OPT_SACK_PERMITTED;
+		buf[1] = OPT_SACK_PERMITTED_LEN;
+		buf += OPT_SACK_PERMITTED_LEN;
+	}
+
+	if ((opts->flags & TOF_TS) != 0) {
+		if ((opts->flags & TOF_SACK_PERM) == 0) {
+			*buf++ = OPT_NOP;
+			*buf++ = OPT_NOP;
+		}
+
+		buf[0] = OPT_TIMESTAMP;
+		buf[1] = OPT_TIMESTAMP_LEN;
+		tcp_opt_put32(buf + 2, opts->tsval);
+		tcp_opt_put32(buf + 6, opts->tsecr);
+		buf += OPT_TIMESTAMP_LEN;
+	}
+
+	sack_cnt = tcp_opts_sack_cnt(opts);
+	if (sack_cnt > 0) {
+		*buf++ = OPT_NOP;
+		*buf++ = OPT_NOP;
+		buf[0] = OPT_SACK;
+		buf[1] = OPT_SACK_LEN + sack_cnt * OPT_SACK_BLOCK_LEN;
+		buf += OPT_SACK_LEN;
+
+		for (i = 0; i < sack_cnt; i++) {
+			tcp_opt_put32(buf, opts->sack[i].start);
+			tcp_opt_put32(buf + 4, opts->sack[i].end);
+			buf += OPT_SACK_BLOCK_LEN;
+		}
+	}
+}
+
+/** Decode segment options.
+ *
+ * Unknown options are skipped. Decoding stops at the first malformed
+ * option, the options decoded so far are kept.
+ *
+ * @param buf	Encoded options
+ * @param size	Size of encoded options
+ * @param opts	Place to store decoded options
+ */
+static void tcp_opts_decode(uint8_t *buf, size_t size, tcp_seg_opts_t *opts)
+{
+	uint8_t kind;
+	uint8_t len;
+	size_t i;
+
+	memset(opts, 0, sizeof(tcp_seg_opts_t));
+
+	while (size > 0) {
+		kind = buf[0];
+		if (kind == OPT_END_LIST)
+			break;
+
+		if (kind == OPT_NOP) {
+			++buf;
+			--size;
+			continue;
+		}
+
+		if (size < 2)
+			break;
+
+		len = buf[1];
+		if (len < 2 || len > size)
+			break;
+
+		switch (kind) {
+		case OPT_MAX_SEG_SIZE:
+			if (len != OPT_MAX_SEG_SIZE_LEN)
+				return;
+			opts->mss = tcp_opt_get16(buf + 2);
+			opts->flags |= TOF_MSS;
+			break;
+		case OPT_WINDOW_SCALE:
+			if (len != OPT_WINDOW_SCALE_LEN)
+				return;
+			opts->wscale = buf[2];
+			opts->flags |= TOF_WSCALE;
+			break;
+		case OPT_SACK_PERMITTED:
+			if (len != OPT_SACK_PERMITTED_LEN)
+				return;
+			opts->flags |= TOF_SACK_PERM;
+			break;
+		case OPT_SACK:
+			if ((len - OPT_SACK_LEN) % OPT_SACK_BLOCK_LEN != 0)
+				return;
+			opts->sack_cnt = min((size_t) (len - OPT_SACK_LEN) /
+			    OPT_SACK_BLOCK_LEN, TCP_SACK_BLOCKS_MAX);
+			for (i = 0; i < opts->sack_cnt; i++) {
+				opts->sack[i].start = tcp_opt_get32(buf +
+				    OPT_SACK_LEN + i * OPT_SACK_BLOCK_LEN);
+				opts->sack[i].end = tcp_opt_get32(buf +
+				    OPT_SACK_LEN + i * OPT_SACK_BLOCK_LEN + 4);
+			}
+			break;
+		case OPT_TIMESTAMP:
+			if (len != OPT_TIMESTAMP_LEN)
+				return;
+			opts->tsval = tcp_opt_get32(buf + 2);
+			opts->tsecr = tcp_opt_get32(buf + 6);
+			opts->flags |= TOF_TS;
+			break;
+		default:
+			/* Ignore unknown option */
+			break;
+		}
+
+		buf += len;
+		size -= len;
+	}
+}
+
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t hdr_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +386,7 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = (hdr_size / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -194,14 +445,18 @@ static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	size_t hdr_size;
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	hdr_size = sizeof(tcp_header_t) + tcp_opts_size(&seg->opts);
+
+	hdr = calloc(1, hdr_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, hdr_size);
+	tcp_opts_encode(&seg->opts, (uint8_t *) (hdr + 1));
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = hdr_size;
 
 	return EOK;
 }
@@ -293,26 +548,63 @@ static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
 	hdr->checksum = host2uint16_t_be(checksum);
 }
 
-/** Decode incoming PDU */
-errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
+/** Decode header of incoming PDU into a segment holding its text */
+static void tcp_pdu_decode_hdr(tcp_pdu_t *pdu, inet_ep2_t *epp,
+    tcp_segment_t *nseg)
 {
-	tcp_segment_t *nseg;
 	tcp_header_t *hdr;
 
-	nseg = tcp_segment_make_data(0, pdu->text, pdu->text_size);
-	if (nseg == NULL)
-		return ENOMEM;
-
 	tcp_header_decode(pdu->header, nseg);
 	nseg->len += seq_no_control_len(nseg->ctrl);
 
 	hdr = (tcp_header_t *)pdu->header;
 
+	if (pdu->header_size > sizeof(tcp_header_t)) {
+		tcp_opts_decode((uint8_t *) (hdr + 1),
+		    pdu->header_size - sizeof(tcp_header_t), &nseg->opts);
+	}
+
 	epp->local.port = uint16_t_be2host(hdr->dest_port);
 	epp->local.addr = pdu->dest;
 	epp->remote.port = uint16_t_be2host(hdr->src_port);
 	epp->remote.addr = pdu->src;
+}
+
+/** Decode incoming PDU */
+errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
+{
+	tcp_segment_t *nseg;
+
+	nseg = tcp_segment_make_data(0, pdu->text, pdu->text_size);
+	if (nseg == NULL)
+		return ENOMEM;
+
+	tcp_pdu_decode_hdr(pdu, epp, nseg);
+	*seg = nseg;
+	return EOK;
+}
+
+/** Decode incoming PDU without copying its text.
+ *
+ * On success the segment takes over @a buf, which must be an allocated
+ * buffer containing the PDU text.
+ *
+ * @param pdu	PDU
+ * @param buf	Buffer containing the PDU text
+ * @param epp	Place to store endpoint pair
+ * @param seg	Place to store pointer to new segment
+ * @return	EOK on success, ENOMEM if out of memory
+ */
+errno_t tcp_pdu_decode_ref(tcp_pdu_t *pdu, void *buf, inet_ep2_t *epp,
+    tcp_segment_t **seg)
+{
+	tcp_segment_t *nseg;
+
+	nseg = tcp_segment_make_ref(0, buf, pdu->text, pdu->text_size);
+	if (nseg == NULL)
+		return ENOMEM;
 
+	tcp_pdu_decode_hdr(pdu, epp, nseg);
 	*seg = nseg;
 	return EOK;
 }
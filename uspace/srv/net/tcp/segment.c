@@ -74,6 +74,7 @@ tcp_segment_t *tcp_segment_dup(tcp_segment_t *seg)
 	scopy->len = seg->len;
 	scopy->wnd = seg->wnd;
 	scopy->up = seg->up;
+	scopy->opts = seg->opts;
 
 	tsize = tcp_segment_text_size(seg);
 	scopy->data = calloc(tsize, 1);
@@ -158,6 +159,33 @@ tcp_segment_t *tcp_segment_make_data(tcp_control_t ctrl, void *data,
 	return seg;
 }
 
+/** Create a data segment referring to text in an existing buffer.
+ *
+ * The segment takes over @a buf and frees it when it is deleted.
+ *
+ * @param ctrl	Control flags
+ * @param buf	Allocated buffer containing the text
+ * @param data	Start of the text in @a buf
+ * @param size	Text size
+ * @return	Segment or NULL if out of memory
+ */
+tcp_segment_t *tcp_segment_make_ref(tcp_control_t ctrl, void *buf,
+    void *data, size_t size)
+{
+	tcp_segment_t *seg;
+
+	seg = tcp_segment_new();
+	if (seg == NULL)
+		return NULL;
+
+	seg->ctrl = ctrl;
+	seg->len = seq_no_control_len(ctrl) + size;
+	seg->dfptr = buf;
+	seg->data = data;
+
+	return seg;
+}
+
 /** Trim segment from left and right by the specified amount.
  *
  * Trim any text or control to remove the specified amount of sequence
@@ -44,6 +44,8 @@ extern tcp_segment_t *tcp_segment_dup(tcp_segment_t *);
 extern tcp_segment_t *tcp_segment_make_ctrl(tcp_control_t);
 extern tcp_segment_t *tcp_segment_make_rst(tcp_segment_t *);
 extern tcp_segment_t *tcp_segment_make_data(tcp_control_t, void *, size_t);
+extern tcp_segment_t *tcp_segment_make_ref(tcp_control_t, void *, void *,
+    size_t);
 extern void tcp_segment_trim(tcp_segment_t *, uint32_t, uint32_t);
 extern void tcp_segment_text_copy(tcp_segment_t *, void *, size_t);
 extern size_t tcp_segment_text_size(tcp_segment_t *);
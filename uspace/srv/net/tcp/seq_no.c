@@ -87,6 +87,61 @@ bool seq_no_ack_duplicate(tcp_conn_t *conn, uint32_t seg_ack)
 	return diff == 0 || (diff & (0x1 << 31)) != 0;
 }
 
+/** Determine whether ack is partial.
+ *
+ * During fast recovery an ACK is partial if it acknowledges new data,
+ * but not everything that was outstanding when fast recovery was
+ * entered (SND.UNA < SEG.ACK < recover).
+ */
+bool seq_no_ack_partial(tcp_conn_t *conn, uint32_t seg_ack)
+{
+	return seq_no_lt_le(conn->snd_una, seg_ack, conn->recover) &&
+	    seg_ack != conn->recover;
+}
+
+/** Determine whether TS.Recent should be updated from segment.
+ *
+ * The timestamp of a segment is recorded if the segment starts at or
+ * before the last acknowledgement we sent (SEG.SEQ <= Last.ACK.sent,
+ * RFC 7323 4.3). Same as with duplicate ACKs, this is decided based on
+ * the difference of the two sequence numbers.
+ */
+bool seq_no_ts_recent_update(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	uint32_t diff;
+
+	diff = conn->last_ack_sent - seg->seq;
+	return (diff & (0x1 << 31)) == 0;
+}
+
+/** Determine whether SACK block is valid.
+ *
+ * A SACK block is only valid if it covers data that was sent,
+ * but not acknowledged yet (SND.UNA <= start < end <= SND.NXT).
+ */
+bool seq_no_sack_valid(tcp_conn_t *conn, tcp_sack_block_t *blk)
+{
+	return seq_no_le_lt(conn->snd_una, blk->start, blk->end) &&
+	    seq_no_lt_le(blk->start, blk->end, conn->snd_nxt);
+}
+
+/** Determine whether segment is fully covered by SACK block. */
+bool seq_no_segment_sacked(tcp_segment_t *seg, tcp_sack_block_t *blk)
+{
+	return seq_no_le_lt(blk->start, seg->seq, blk->end) &&
+	    seq_no_lt_le(blk->start, seg->seq + seg->len, blk->end);
+}
+
+/** Determine whether segment was not retransmitted yet during recovery.
+ *
+ * Segments starting before the SACK retransmission mark have already
+ * been retransmitted (mark <= SEG.SEQ < SND.NXT).
+ */
+bool seq_no_sack_rexmit_pending(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	return seq_no_le_lt(conn->sack_rexmit, seg->seq, conn->snd_nxt);
+}
+
 /** Determine if sequence number is in receive window. */
 bool seq_no_in_rcv_wnd(tcp_conn_t *conn, uint32_t sn)
 {
@@ -40,6 +40,11 @@
 
 extern bool seq_no_ack_acceptable(tcp_conn_t *, uint32_t);
 extern bool seq_no_ack_duplicate(tcp_conn_t *, uint32_t);
+extern bool seq_no_ack_partial(tcp_conn_t *, uint32_t);
+extern bool seq_no_ts_recent_update(tcp_conn_t *, tcp_segment_t *);
+extern bool seq_no_sack_valid(tcp_conn_t *, tcp_sack_block_t *);
+extern bool seq_no_segment_sacked(tcp_segment_t *, tcp_sack_block_t *);
+extern bool seq_no_sack_rexmit_pending(tcp_conn_t *, tcp_segment_t *);
 extern bool seq_no_in_rcv_wnd(tcp_conn_t *, uint32_t);
 extern bool seq_no_new_wnd_update(tcp_conn_t *, tcp_segment_t *);
 extern bool seq_no_segment_acked(tcp_conn_t *, tcp_segment_t *, uint32_t);
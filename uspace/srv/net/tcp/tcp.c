@@ -38,8 +38,10 @@
 #include <errno.h>
 #include <io/log.h>
 #include <stdio.h>
+#include <str.h>
 #include <task.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "ncsim.h"
@@ -101,6 +103,18 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
+	if (argc == 3 && str_cmp(argv[1], "--cc") == 0) {
+		rc = tcp_cc_algo_by_name(argv[2], &tcp_cc_default);
+		if (rc != EOK) {
+			printf(NAME ": Unknown congestion control algorithm "
+			    "'%s'.\n", argv[2]);
+			return 1;
+		}
+	} else if (argc != 1) {
+		printf(NAME ": Unrecognized parameters.\n");
+		return 1;
+	}
+
 	rc = tcp_init();
 	if (rc != EOK)
 		return 1;
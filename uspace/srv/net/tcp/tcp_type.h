@@ -43,6 +43,7 @@
 #include <refcount.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 
@@ -154,6 +155,47 @@ typedef struct {
 	tcp_cstate_t cstate;
 } tcp_conn_status_t;
 
+/** Options present in a segment */
+typedef enum {
+	/** Maximum segment size */
+	TOF_MSS		= 0x1,
+	/** Window scale */
+	TOF_WSCALE	= 0x2,
+	/** SACK permitted */
+	TOF_SACK_PERM	= 0x4,
+	/** Timestamps */
+	TOF_TS		= 0x8
+} tcp_opt_flags_t;
+
+/** Maximum number of SACK blocks in a segment */
+#define TCP_SACK_BLOCKS_MAX	4
+
+/** SACK block (a contiguous range of sequence numbers) */
+typedef struct {
+	/** First sequence number of the block */
+	uint32_t start;
+	/** Sequence number immediately following the block */
+	uint32_t end;
+} tcp_sack_block_t;
+
+/** Segment options */
+typedef struct {
+	/** Options present */
+	tcp_opt_flags_t flags;
+	/** Maximum segment size */
+	uint16_t mss;
+	/** Window scale shift count */
+	uint8_t wscale;
+	/** Timestamp value */
+	uint32_t tsval;
+	/** Timestamp echo reply */
+	uint32_t tsecr;
+	/** Number of SACK blocks */
+	size_t sack_cnt;
+	/** SACK blocks */
+	tcp_sack_block_t sack[TCP_SACK_BLOCKS_MAX];
+} tcp_seg_opts_t;
+
 typedef struct {
 	/** SYN, FIN */
 	tcp_control_t ctrl;
@@ -168,6 +210,8 @@ typedef struct {
 	uint32_t wnd;
 	/** Segment urgent pointer */
 	uint32_t up;
+	/** Options */
+	tcp_seg_opts_t opts;
 
 	/** Segment data, may be moved when trimming segment */
 	void *data;
@@ -191,11 +235,30 @@ typedef struct {
 /** NCSim queue entry */
 typedef struct {
 	link_t link;
-	usec_t delay;
+	/** Time when the segment should be delivered */
+	struct timespec due;
 	inet_ep2_t epp;
 	tcp_segment_t *seg;
 } tcp_squeue_entry_t;
 
+/** NCSim parameters */
+typedef struct {
+	/** Constant delay added to every segment (usec) */
+	usec_t delay;
+	/** Maximum random delay added on top of @c delay (usec) */
+	usec_t jitter;
+	/** Drop one in @c loss_rate segments at random (zero to disable) */
+	unsigned loss_rate;
+	/** Decide whether to drop a particular segment (or @c NULL) */
+	bool (*drop)(inet_ep2_t *, tcp_segment_t *, void *);
+	/** Argument to @c drop */
+	void *drop_arg;
+	/** Bottleneck link bandwidth (bytes/s, zero for unlimited) */
+	uint64_t bandwidth;
+	/** Bottleneck queue size (bytes, zero for unlimited) */
+	size_t queue_max;
+} tcp_ncsim_params_t;
+
 /** Incoming queue entry */
 typedef struct {
 	link_t link;
@@ -207,6 +270,12 @@ typedef struct {
 	link_t link;
 	tcp_conn_t *conn;
 	tcp_segment_t *seg;
+	/** Time of the first transmission */
+	struct timespec sent;
+	/** Segment has been retransmitted (not usable for RTT measurement) */
+	bool retransmitted;
+	/** Segment has been selectively acknowledged by the peer */
+	bool sacked;
 } tcp_tqueue_entry_t;
 
 /** Retransmission queue callbacks */
@@ -227,6 +296,74 @@ typedef struct {
 	tcp_tqueue_cb_t *cb;
 } tcp_tqueue_t;
 
+/** Congestion control algorithm */
+typedef enum {
+	/** NewReno (RFC 5681, RFC 6582) */
+	tcp_cc_newreno,
+	/** CUBIC (RFC 9438) */
+	tcp_cc_cubic
+} tcp_cc_algo_t;
+
+/** CUBIC congestion control state */
+typedef struct {
+	/** Congestion window before the last reduction (bytes) */
+	uint32_t w_max;
+	/** Congestion window at the start of the epoch (bytes) */
+	uint32_t cwnd_epoch;
+	/** Time to grow back to @c w_max since the start of the epoch (msec) */
+	uint32_t k;
+	/** Start of the current congestion avoidance epoch */
+	struct timespec epoch_start;
+	/** A congestion avoidance epoch is in progress */
+	bool epoch_valid;
+} tcp_cubic_t;
+
+/** Congestion control algorithm operations */
+typedef struct {
+	/** Algorithm name */
+	const char *name;
+	/** Initialize algorithm state */
+	void (*init)(tcp_conn_t *);
+	/** Grow window in congestion avoidance after @a acked bytes were ACKed */
+	void (*cong_avoid)(tcp_conn_t *, uint32_t);
+	/** Loss was detected, return the new slow start threshold */
+	uint32_t (*ssthresh)(tcp_conn_t *);
+} tcp_cc_ops_t;
+
+/** Congestion control state */
+typedef struct {
+	/** Algorithm */
+	tcp_cc_algo_t algo;
+	/** Algorithm operations */
+	const tcp_cc_ops_t *ops;
+	/** Congestion window (bytes) */
+	uint32_t cwnd;
+	/** Slow start threshold (bytes) */
+	uint32_t ssthresh;
+	/** Fractional congestion window increment (bytes times @c cwnd) */
+	uint64_t cwnd_acc;
+	/** Algorithm-specific state */
+	union {
+		tcp_cubic_t cubic;
+	} u;
+} tcp_cc_t;
+
+/** Connection statistics */
+typedef struct {
+	/** Number of round-trip time measurements */
+	uint64_t rtt_samples;
+	/** Number of retransmitted segments */
+	uint64_t retransmits;
+	/** Number of retransmission timeouts */
+	uint64_t timeouts;
+	/** Number of fast retransmits */
+	uint64_t fast_retransmits;
+	/** Number of duplicate ACKs received */
+	uint64_t dup_acks;
+	/** Number of segments retransmitted based on SACK information */
+	uint64_t sack_retransmits;
+} tcp_conn_stats_t;
+
 /** Connection */
 struct tcp_conn {
 	char *name;
@@ -307,6 +444,48 @@ struct tcp_conn {
 	uint32_t snd_wl2;
 	/** Initial send sequence number */
 	uint32_t iss;
+	/** Sender maximum segment size */
+	uint32_t smss;
+
+	/** Congestion control */
+	tcp_cc_t cc;
+
+	/** Smoothed round-trip time (usec) */
+	usec_t srtt;
+	/** Round-trip time variation (usec) */
+	usec_t rttvar;
+	/** Retransmission timeout (usec) */
+	usec_t rto;
+	/** @c srtt and @c rttvar have been set from a measurement */
+	bool rtt_valid;
+
+	/** Number of consecutive duplicate ACKs */
+	unsigned dup_acks;
+	/** Fast recovery is in progress */
+	bool fast_recovery;
+	/** SND.NXT at the time fast recovery was entered */
+	uint32_t recover;
+	/** ACK should be sent after processing incoming segments */
+	bool ack_pending;
+	/** Retransmit no segment below this during SACK-based recovery */
+	uint32_t sack_rexmit;
+
+	/** Window scaling is in use */
+	bool ws_ok;
+	/** Shift count applied to windows received from the peer */
+	uint8_t snd_wscale;
+	/** Shift count applied to windows we advertise */
+	uint8_t rcv_wscale;
+	/** Timestamps are in use */
+	bool ts_ok;
+	/** Timestamp to be echoed to the peer (TS.Recent) */
+	uint32_t ts_recent;
+	/** Acknowledgement number in the last ACK we sent (Last.ACK.sent) */
+	uint32_t last_ack_sent;
+	/** Selective acknowledgements are in use */
+	bool sack_ok;
+	/** Sequence number of the last out-of-order segment received */
+	uint32_t sack_recent;
 
 	/** Receive next */
 	uint32_t rcv_nxt;
@@ -316,6 +495,9 @@ struct tcp_conn {
 	uint32_t rcv_up;
 	/** Initial receive sequence number */
 	uint32_t irs;
+
+	/** Statistics */
+	tcp_conn_stats_t stats;
 };
 
 /** Continuation of processing.
@@ -386,7 +568,9 @@ typedef enum {
 	/** Segment loopback */
 	tcp_lb_segment,
 	/** PDU loopback */
-	tcp_lb_pdu
+	tcp_lb_pdu,
+	/** Segment loopback through network condition simulator */
+	tcp_lb_ncsim
 } tcp_lb_t;
 
 #endif
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <pcut/pcut.h>
+#include <time.h>
+
+#include "../cc.h"
+#include "../conn.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cc);
+
+static tcp_conn_t *cc_test_conn(void);
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+PCUT_TEST_AFTER
+{
+	tcp_conns_fini();
+}
+
+/** Test initial state of congestion control */
+PCUT_TEST(init)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn();
+
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_newreno, conn->cc.algo);
+	PCUT_ASSERT_TRUE(conn->cc.ops == &tcp_cc_newreno_ops);
+	PCUT_ASSERT_INT_EQUALS(4 * conn->smss, conn->cc.cwnd);
+	PCUT_ASSERT_INT_EQUALS(UINT32_MAX, conn->cc.ssthresh);
+
+	tcp_cc_select(conn, tcp_cc_cubic);
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_cubic, conn->cc.algo);
+	PCUT_ASSERT_TRUE(conn->cc.ops == &tcp_cc_cubic_ops);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test looking up algorithm by name */
+PCUT_TEST(algo_by_name)
+{
+	tcp_cc_algo_t algo;
+	errno_t rc;
+
+	rc = tcp_cc_algo_by_name("newreno", &algo);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_newreno, algo);
+
+	rc = tcp_cc_algo_by_name("cubic", &algo);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_cubic, algo);
+
+	rc = tcp_cc_algo_by_name("vegas", &algo);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+}
+
+/** Test slow start */
+PCUT_TEST(slow_start)
+{
+	tcp_conn_t *conn;
+	uint32_t cwnd;
+
+	conn = cc_test_conn();
+	cwnd = conn->cc.cwnd;
+
+	/* Window grows by the amount acknowledged */
+	tcp_cc_ack(conn, 100);
+	PCUT_ASSERT_INT_EQUALS(cwnd + 100, conn->cc.cwnd);
+
+	/* But at most by one segment per ACK */
+	tcp_cc_ack(conn, 4 * conn->smss);
+	PCUT_ASSERT_INT_EQUALS(cwnd + 100 + conn->smss, conn->cc.cwnd);
+
+	/* Window does not grow beyond what the peer allows */
+	conn->snd_wnd = conn->cc.cwnd;
+	cwnd = conn->cc.cwnd;
+	tcp_cc_ack(conn, conn->smss);
+	PCUT_ASSERT_INT_EQUALS(cwnd, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test NewReno congestion avoidance */
+PCUT_TEST(newreno_cong_avoid)
+{
+	tcp_conn_t *conn;
+	int i;
+
+	conn = cc_test_conn();
+	conn->cc.cwnd = 10 * conn->smss;
+	conn->cc.ssthresh = conn->cc.cwnd;
+
+	/* Grow by about one segment per window acknowledged */
+	for (i = 0; i < 10; i++)
+		tcp_cc_ack(conn, conn->smss);
+
+	PCUT_ASSERT_INT_EQUALS(5873, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test NewReno fast recovery */
+PCUT_TEST(newreno_recovery)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn();
+	conn->snd_una = 0;
+	conn->snd_nxt = 8000;
+	conn->cc.cwnd = 10 * conn->smss;
+
+	/* Window is halved and inflated by three segments */
+	tcp_cc_recovery_enter(conn);
+	PCUT_ASSERT_INT_EQUALS(4000, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(4000 + 3 * conn->smss, conn->cc.cwnd);
+
+	tcp_cc_recovery_dup_ack(conn);
+	PCUT_ASSERT_INT_EQUALS(4000 + 4 * conn->smss, conn->cc.cwnd);
+
+	/* Deflate by amount ACKed, add back one segment */
+	tcp_cc_recovery_partial_ack(conn, 2 * conn->smss);
+	PCUT_ASSERT_INT_EQUALS(4000 + 3 * conn->smss, conn->cc.cwnd);
+
+	/* Full ACK with some data still in flight */
+	conn->snd_una = 5000;
+	tcp_cc_recovery_exit(conn);
+	PCUT_ASSERT_INT_EQUALS(3000 + conn->smss, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test retransmission timeout */
+PCUT_TEST(timeout)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn();
+	conn->snd_una = 0;
+	conn->snd_nxt = 8000;
+	conn->cc.cwnd = 10 * conn->smss;
+
+	tcp_cc_timeout(conn, true);
+	PCUT_ASSERT_INT_EQUALS(4000, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(conn->smss, conn->cc.cwnd);
+
+	/* Backed-off retransmission does not reduce ssthresh further */
+	tcp_cc_timeout(conn, false);
+	PCUT_ASSERT_INT_EQUALS(4000, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(conn->smss, conn->cc.cwnd);
+
+	/* Slow start threshold is at least two segments */
+	conn->snd_nxt = 100;
+	tcp_cc_timeout(conn, true);
+	PCUT_ASSERT_INT_EQUALS(2 * conn->smss, conn->cc.ssthresh);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test CUBIC window reduction and fast convergence */
+PCUT_TEST(cubic_ssthresh)
+{
+	tcp_conn_t *conn;
+	tcp_cubic_t *cubic;
+
+	conn = cc_test_conn();
+	conn->smss = 1000;
+	tcp_cc_select(conn, tcp_cc_cubic);
+	cubic = &conn->cc.u.cubic;
+
+	conn->cc.cwnd = 100000;
+	tcp_cc_timeout(conn, true);
+	PCUT_ASSERT_INT_EQUALS(70000, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(100000, cubic->w_max);
+
+	/* Loss before reaching W_max again lowers W_max further */
+	conn->cc.cwnd = 80000;
+	tcp_cc_timeout(conn, true);
+	PCUT_ASSERT_INT_EQUALS(56000, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(68000, cubic->w_max);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test CUBIC window growth */
+PCUT_TEST(cubic_cong_avoid)
+{
+	tcp_conn_t *conn;
+	tcp_cubic_t *cubic;
+
+	conn = cc_test_conn();
+	conn->smss = 1000;
+	tcp_cc_select(conn, tcp_cc_cubic);
+	cubic = &conn->cc.u.cubic;
+
+	conn->cc.cwnd = 100000;
+	tcp_cc_timeout(conn, true);
+	conn->cc.cwnd = conn->cc.ssthresh;
+
+	/* First ACK in congestion avoidance starts a new epoch */
+	tcp_cc_ack(conn, conn->smss);
+	PCUT_ASSERT_TRUE(cubic->epoch_valid);
+	PCUT_ASSERT_INT_EQUALS(70000, cubic->cwnd_epoch);
+	/* K = cbrt(W_max * (1 - beta) / C) = cbrt(30 / 0.4) s */
+	PCUT_ASSERT_INT_EQUALS(4217, cubic->k);
+	/* Window is on the plateau, it barely grows */
+	PCUT_ASSERT_INT_EQUALS(70000, conn->cc.cwnd);
+
+	/* Well past K the window grows by half a segment per ACK */
+	ts_add_diff(&cubic->epoch_start, -MSEC2NSEC(2 * cubic->k));
+	tcp_cc_ack(conn, conn->smss);
+	PCUT_ASSERT_INT_EQUALS(70500, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Create connection for testing congestion control.
+ *
+ * @return New connection
+ */
+static tcp_conn_t *cc_test_conn(void)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Do not let the peer's window limit the congestion window */
+	conn->snd_wnd = 1024 * 1024;
+
+	return conn;
+}
+
+PCUT_EXPORT(cc);
@@ -27,6 +27,7 @@
  */
 
 #include <inet/endpoint.h>
+#include <mem.h>
 #include <pcut/pcut.h>
 
 #include "../conn.h"
@@ -175,4 +176,82 @@ PCUT_TEST(two_segments)
 	tcp_conn_delete(conn);
 }
 
+/** Test reporting out-of-order segments as SACK blocks */
+PCUT_TEST(sack_blocks)
+{
+	tcp_conn_t *conn;
+	tcp_iqueue_t iqueue;
+	inet_ep2_t epp;
+	tcp_segment_t *seg1, *seg2, *seg3, *seg4;
+	tcp_sack_block_t blocks[TCP_SACK_BLOCKS_MAX];
+	uint8_t data[10];
+	size_t cnt;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->rcv_nxt = 10;
+	conn->rcv_wnd = 100;
+
+	memset(data, 0, sizeof(data));
+	seg1 = tcp_segment_make_data(0, data, 10);
+	PCUT_ASSERT_NOT_NULL(seg1);
+	seg2 = tcp_segment_make_data(0, data, 5);
+	PCUT_ASSERT_NOT_NULL(seg2);
+	seg3 = tcp_segment_make_data(0, data, 10);
+	PCUT_ASSERT_NOT_NULL(seg3);
+	seg4 = tcp_segment_make_data(0, data, 10);
+	PCUT_ASSERT_NOT_NULL(seg4);
+
+	tcp_iqueue_init(&iqueue, conn);
+	cnt = tcp_iqueue_sack_blocks(&iqueue, 10, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(0, cnt);
+
+	/* Ready segment is not reported */
+	seg1->seq = 10;
+	tcp_iqueue_insert_seg(&iqueue, seg1);
+	cnt = tcp_iqueue_sack_blocks(&iqueue, 10, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(0, cnt);
+
+	/* Adjoining segments 30-45 form one block, followed by 60-70 */
+	seg3->seq = 60;
+	tcp_iqueue_insert_seg(&iqueue, seg3);
+	seg2->seq = 40;
+	tcp_iqueue_insert_seg(&iqueue, seg2);
+	seg4->seq = 30;
+	tcp_iqueue_insert_seg(&iqueue, seg4);
+
+	cnt = tcp_iqueue_sack_blocks(&iqueue, 30, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(2, cnt);
+	PCUT_ASSERT_INT_EQUALS(30, blocks[0].start);
+	PCUT_ASSERT_INT_EQUALS(45, blocks[0].end);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[1].start);
+	PCUT_ASSERT_INT_EQUALS(70, blocks[1].end);
+
+	/* Block with the most recent segment goes first */
+	cnt = tcp_iqueue_sack_blocks(&iqueue, 60, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(2, cnt);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[0].start);
+	PCUT_ASSERT_INT_EQUALS(70, blocks[0].end);
+	PCUT_ASSERT_INT_EQUALS(30, blocks[1].start);
+	PCUT_ASSERT_INT_EQUALS(45, blocks[1].end);
+
+	/* Number of blocks is limited */
+	cnt = tcp_iqueue_sack_blocks(&iqueue, 60, blocks, 1);
+	PCUT_ASSERT_INT_EQUALS(1, cnt);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[0].start);
+
+	tcp_iqueue_remove_seg(&iqueue, seg1);
+	tcp_iqueue_remove_seg(&iqueue, seg2);
+	tcp_iqueue_remove_seg(&iqueue, seg3);
+	tcp_iqueue_remove_seg(&iqueue, seg4);
+
+	tcp_segment_delete(seg1);
+	tcp_segment_delete(seg2);
+	tcp_segment_delete(seg3);
+	tcp_segment_delete(seg4);
+	tcp_conn_delete(conn);
+}
+
 PCUT_EXPORT(iqueue);
@@ -36,12 +36,26 @@
 /** Verify that two segments have the same content */
 void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 {
+	size_t i;
+
 	PCUT_ASSERT_INT_EQUALS(a->ctrl, b->ctrl);
 	PCUT_ASSERT_INT_EQUALS(a->seq, b->seq);
 	PCUT_ASSERT_INT_EQUALS(a->ack, b->ack);
 	PCUT_ASSERT_INT_EQUALS(a->len, b->len);
 	PCUT_ASSERT_INT_EQUALS(a->wnd, b->wnd);
 	PCUT_ASSERT_INT_EQUALS(a->up, b->up);
+	PCUT_ASSERT_INT_EQUALS(a->opts.flags, b->opts.flags);
+	PCUT_ASSERT_INT_EQUALS(a->opts.mss, b->opts.mss);
+	PCUT_ASSERT_INT_EQUALS(a->opts.wscale, b->opts.wscale);
+	PCUT_ASSERT_INT_EQUALS(a->opts.tsval, b->opts.tsval);
+	PCUT_ASSERT_INT_EQUALS(a->opts.tsecr, b->opts.tsecr);
+	PCUT_ASSERT_INT_EQUALS(a->opts.sack_cnt, b->opts.sack_cnt);
+	for (i = 0; i < a->opts.sack_cnt; i++) {
+		PCUT_ASSERT_INT_EQUALS(a->opts.sack[i].start,
+		    b->opts.sack[i].start);
+		PCUT_ASSERT_INT_EQUALS(a->opts.sack[i].end,
+		    b->opts.sack[i].end);
+	}
 	PCUT_ASSERT_INT_EQUALS(tcp_segment_text_size(a),
 	    tcp_segment_text_size(b));
 	if (tcp_segment_text_size(a) != 0)
@@ -56,8 +70,10 @@ void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 
 PCUT_INIT;
 
+PCUT_IMPORT(cc);
 PCUT_IMPORT(conn);
 PCUT_IMPORT(iqueue);
+PCUT_IMPORT(ncsim);
 PCUT_IMPORT(pdu);
 PCUT_IMPORT(rqueue);
 PCUT_IMPORT(segment);
@@ -0,0 +1,606 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+
+#include "../cc.h"
+#include "../conn.h"
+#include "../ncsim.h"
+#include "../rqueue.h"
+#include "../segment.h"
+#include "../ucall.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(ncsim);
+
+enum {
+	/** Size of data sent in one segment */
+	test_seg_size = 8,
+	/** Number of segments sent */
+	test_seg_cnt = 4,
+	/** Size of data sent in bulk transfer tests */
+	test_bulk_size = 32 * 1024,
+	/** Timeout for bulk transfer tests (sec) */
+	test_bulk_timeout = 10
+};
+
+static tcp_rqueue_cb_t test_rqueue_cb = {
+	.seg_received = tcp_as_segment_arrived
+};
+
+static uint8_t test_data[test_seg_size * test_seg_cnt];
+static uint8_t test_bulk_data[test_bulk_size];
+static uint8_t test_bulk_rdata[test_bulk_size];
+
+static FIBRIL_MUTEX_INITIALIZE(test_sender_lock);
+static FIBRIL_CONDVAR_INITIALIZE(test_sender_cv);
+static bool test_sender_done;
+static tcp_error_t test_sender_trc;
+
+static void ncsim_test_connect(tcp_conn_t **, tcp_conn_t **);
+static void ncsim_test_disconnect(tcp_conn_t *, tcp_conn_t *);
+static void ncsim_test_send(tcp_conn_t *, size_t);
+static void ncsim_test_recv(tcp_conn_t *, size_t);
+static void ncsim_test_bulk(tcp_conn_t *, tcp_conn_t *);
+static bool ncsim_test_drop_data(inet_ep2_t *, tcp_segment_t *, void *);
+static bool ncsim_test_drop_nth(inet_ep2_t *, tcp_segment_t *, void *);
+static bool ncsim_test_drop_mask(inet_ep2_t *, tcp_segment_t *, void *);
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+	size_t i;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tcp_rqueue_init(&test_rqueue_cb);
+	tcp_rqueue_fibril_start();
+
+	tcp_ncsim_init();
+	tcp_ncsim_fibril_start();
+
+	/* Loop segments back through the network condition simulator */
+	tcp_conn_lb = tcp_lb_ncsim;
+
+	for (i = 0; i < sizeof(test_data); i++)
+		test_data[i] = i;
+	for (i = 0; i < sizeof(test_bulk_data); i++)
+		test_bulk_data[i] = i * 7 + (i >> 8);
+}
+
+PCUT_TEST_AFTER
+{
+	tcp_ncsim_fini();
+	tcp_rqueue_fini();
+	tcp_conns_fini();
+}
+
+/** Test transfer over a link with constant delay */
+PCUT_TEST(delay)
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+
+	memset(&params, 0, sizeof(params));
+	params.delay = 10 * 1000;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+	ncsim_test_send(cconn, test_seg_cnt);
+	ncsim_test_recv(sconn, sizeof(test_data));
+
+	tcp_conn_lock(cconn);
+
+	/* Every segment crossed the link twice before being acknowledged */
+	PCUT_ASSERT_TRUE(cconn->rtt_valid);
+	PCUT_ASSERT_TRUE(cconn->srtt >= 2 * params.delay);
+	PCUT_ASSERT_INT_EQUALS(0, cconn->stats.retransmits);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test transfer over a link that reorders segments */
+PCUT_TEST(jitter)
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+
+	memset(&params, 0, sizeof(params));
+	params.delay = 1000;
+	params.jitter = 10 * 1000;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+	ncsim_test_send(cconn, test_seg_cnt);
+	ncsim_test_recv(sconn, sizeof(test_data));
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test recovery from segment loss using fast retransmit */
+PCUT_TEST(loss_fast_retransmit)
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+	int ndrop;
+
+	ndrop = 1;
+	memset(&params, 0, sizeof(params));
+	params.delay = 1000;
+	params.drop = ncsim_test_drop_data;
+	params.drop_arg = &ndrop;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+
+	/*
+	 * The first segment is lost, the following ones produce duplicate
+	 * ACKs which trigger retransmission before the timer expires.
+	 */
+	ncsim_test_send(cconn, test_seg_cnt);
+	ncsim_test_recv(sconn, sizeof(test_data));
+	PCUT_ASSERT_INT_EQUALS(0, ndrop);
+
+	tcp_conn_lock(cconn);
+
+	PCUT_ASSERT_INT_EQUALS(test_seg_cnt - 1, cconn->stats.dup_acks);
+	PCUT_ASSERT_INT_EQUALS(1, cconn->stats.fast_retransmits);
+	PCUT_ASSERT_INT_EQUALS(1, cconn->stats.retransmits);
+	PCUT_ASSERT_INT_EQUALS(0, cconn->stats.timeouts);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test recovery from segment loss using retransmission timeout */
+PCUT_TEST(loss_timeout)
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+	usec_t rto;
+	int ndrop;
+
+	ndrop = 1;
+	memset(&params, 0, sizeof(params));
+	params.delay = 1000;
+	params.drop = ncsim_test_drop_data;
+	params.drop_arg = &ndrop;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+
+	tcp_conn_lock(cconn);
+	rto = cconn->rto;
+	tcp_conn_unlock(cconn);
+
+	/* A lone lost segment can only be recovered by the timer */
+	ncsim_test_send(cconn, 1);
+	ncsim_test_recv(sconn, test_seg_size);
+	PCUT_ASSERT_INT_EQUALS(0, ndrop);
+
+	tcp_conn_lock(cconn);
+
+	PCUT_ASSERT_INT_EQUALS(1, cconn->stats.timeouts);
+	PCUT_ASSERT_INT_EQUALS(1, cconn->stats.retransmits);
+	PCUT_ASSERT_INT_EQUALS(0, cconn->stats.fast_retransmits);
+
+	/*
+	 * The timestamp echo yields an RTT sample even for the ACK of
+	 * the retransmission, which undoes the back-off (RFC 7323)
+	 */
+	PCUT_ASSERT_TRUE(cconn->ts_ok);
+	PCUT_ASSERT_INT_EQUALS(rto, cconn->rto);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test NewReno bulk transfer over a slow link with a lost segment */
+PCUT_TEST(bulk_newreno, PCUT_TEST_SET_TIMEOUT(test_bulk_timeout))
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+	int nth;
+
+	nth = 10;
+	memset(&params, 0, sizeof(params));
+	params.delay = 5 * 1000;
+	params.bandwidth = 1000 * 1000;
+	params.drop = ncsim_test_drop_nth;
+	params.drop_arg = &nth;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_newreno, cconn->cc.algo);
+
+	ncsim_test_bulk(cconn, sconn);
+	PCUT_ASSERT_INT_EQUALS(0, nth);
+
+	tcp_conn_lock(cconn);
+
+	/* Loss was repaired and the window reduced */
+	PCUT_ASSERT_TRUE(cconn->stats.retransmits > 0);
+	PCUT_ASSERT_TRUE(cconn->cc.ssthresh != UINT32_MAX);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test CUBIC bulk transfer over a slow link with a lost segment */
+PCUT_TEST(bulk_cubic, PCUT_TEST_SET_TIMEOUT(test_bulk_timeout))
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+	int nth;
+
+	nth = 10;
+	memset(&params, 0, sizeof(params));
+	params.delay = 5 * 1000;
+	params.bandwidth = 1000 * 1000;
+	params.drop = ncsim_test_drop_nth;
+	params.drop_arg = &nth;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+
+	tcp_conn_lock(cconn);
+	tcp_cc_select(cconn, tcp_cc_cubic);
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_bulk(cconn, sconn);
+	PCUT_ASSERT_INT_EQUALS(0, nth);
+
+	tcp_conn_lock(cconn);
+
+	PCUT_ASSERT_INT_EQUALS(tcp_cc_cubic, cconn->cc.algo);
+	PCUT_ASSERT_TRUE(cconn->stats.retransmits > 0);
+	PCUT_ASSERT_TRUE(cconn->cc.u.cubic.w_max != 0);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test bulk transfer through a bottleneck with a short queue */
+PCUT_TEST(bulk_queue_overflow, PCUT_TEST_SET_TIMEOUT(test_bulk_timeout))
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+
+	memset(&params, 0, sizeof(params));
+	params.delay = 2 * 1000;
+	params.bandwidth = 256 * 1024;
+	params.queue_max = 2048;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+	ncsim_test_bulk(cconn, sconn);
+
+	tcp_conn_lock(cconn);
+
+	/* The initial window alone overflows the queue */
+	PCUT_ASSERT_TRUE(cconn->stats.retransmits > 0);
+	PCUT_ASSERT_TRUE(cconn->cc.ssthresh != UINT32_MAX);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Test SACK recovery from two losses in the same window */
+PCUT_TEST(bulk_sack, PCUT_TEST_SET_TIMEOUT(test_bulk_timeout))
+{
+	tcp_ncsim_params_t params;
+	tcp_conn_t *cconn, *sconn;
+	uint32_t mask;
+
+	/* Drop the 10th and the 12th data segment */
+	mask = (1 << 9) | (1 << 11);
+	memset(&params, 0, sizeof(params));
+	params.delay = 5 * 1000;
+	params.bandwidth = 1000 * 1000;
+	params.drop = ncsim_test_drop_mask;
+	params.drop_arg = &mask;
+	tcp_ncsim_set_params(&params);
+
+	ncsim_test_connect(&cconn, &sconn);
+
+	tcp_conn_lock(cconn);
+
+	/* Both sides support all options */
+	PCUT_ASSERT_TRUE(cconn->ws_ok);
+	PCUT_ASSERT_TRUE(cconn->ts_ok);
+	PCUT_ASSERT_TRUE(cconn->sack_ok);
+	PCUT_ASSERT_INT_EQUALS(sconn->rcv_wscale, cconn->snd_wscale);
+	PCUT_ASSERT_TRUE(cconn->snd_wscale > 0);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_bulk(cconn, sconn);
+	PCUT_ASSERT_INT_EQUALS(0, mask);
+
+	tcp_conn_lock(cconn);
+
+	/* The second hole was repaired using SACK information */
+	PCUT_ASSERT_TRUE(cconn->stats.sack_retransmits > 0);
+
+	tcp_conn_unlock(cconn);
+
+	ncsim_test_disconnect(cconn, sconn);
+}
+
+/** Establish a connection through the simulator.
+ *
+ * @param rcconn Place to store client side of the connection
+ * @param rsconn Place to store server side of the connection
+ */
+static void ncsim_test_connect(tcp_conn_t **rcconn, tcp_conn_t **rsconn)
+{
+	tcp_conn_t *cconn, *sconn;
+	inet_ep2_t cepp, sepp;
+	errno_t rc;
+
+	/* Client EPP */
+	inet_ep2_init(&cepp);
+	inet_addr(&cepp.local.addr, 127, 0, 0, 1);
+	inet_addr(&cepp.remote.addr, 127, 0, 0, 1);
+	cepp.remote.port = inet_port_user_lo;
+
+	/* Server EPP */
+	inet_ep2_init(&sepp);
+	inet_addr(&sepp.local.addr, 127, 0, 0, 1);
+	sepp.local.port = inet_port_user_lo;
+
+	cconn = tcp_conn_new(&cepp);
+	PCUT_ASSERT_NOT_NULL(cconn);
+
+	rc = tcp_conn_add(cconn);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	sconn = tcp_conn_new(&sepp);
+	PCUT_ASSERT_NOT_NULL(sconn);
+
+	rc = tcp_conn_add(sconn);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tcp_conn_lock(cconn);
+	tcp_conn_sync(cconn);
+
+	while (cconn->cstate == st_syn_sent)
+		fibril_condvar_wait(&cconn->cstate_cv, &cconn->lock);
+
+	PCUT_ASSERT_INT_EQUALS(st_established, cconn->cstate);
+	tcp_conn_unlock(cconn);
+
+	tcp_conn_lock(sconn);
+	while (sconn->cstate == st_listen || sconn->cstate == st_syn_received)
+		fibril_condvar_wait(&sconn->cstate_cv, &sconn->lock);
+
+	PCUT_ASSERT_INT_EQUALS(st_established, sconn->cstate);
+	tcp_conn_unlock(sconn);
+
+	*rcconn = cconn;
+	*rsconn = sconn;
+}
+
+/** Tear down both sides of a connection.
+ *
+ * @param cconn Client side of the connection
+ * @param sconn Server side of the connection
+ */
+static void ncsim_test_disconnect(tcp_conn_t *cconn, tcp_conn_t *sconn)
+{
+	tcp_conn_lock(cconn);
+	tcp_conn_reset(cconn);
+	tcp_conn_unlock(cconn);
+	tcp_conn_delete(cconn);
+
+	tcp_conn_lock(sconn);
+	tcp_conn_reset(sconn);
+	tcp_conn_unlock(sconn);
+	tcp_conn_delete(sconn);
+}
+
+/** Send test data, one segment per send call.
+ *
+ * @param conn Connection
+ * @param nsegs Number of segments to send
+ */
+static void ncsim_test_send(tcp_conn_t *conn, size_t nsegs)
+{
+	tcp_error_t trc;
+	size_t i;
+
+	for (i = 0; i < nsegs; i++) {
+		trc = tcp_uc_send(conn, test_data + i * test_seg_size,
+		    test_seg_size, 0);
+		PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+	}
+}
+
+/** Wait for test data to be received and verify it.
+ *
+ * @param conn Connection
+ * @param size Number of bytes to wait for
+ */
+static void ncsim_test_recv(tcp_conn_t *conn, size_t size)
+{
+	tcp_conn_lock(conn);
+
+	while (conn->rcv_buf_used < size)
+		fibril_condvar_wait(&conn->rcv_buf_cv, &conn->lock);
+
+	PCUT_ASSERT_INT_EQUALS(size, conn->rcv_buf_used);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(conn->rcv_buf, test_data, size));
+
+	tcp_conn_unlock(conn);
+}
+
+/** Bulk transfer sender fibril.
+ *
+ * @param arg Connection
+ * @return EOK
+ */
+static errno_t ncsim_test_sender(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+	tcp_error_t trc;
+
+	trc = tcp_uc_send(conn, test_bulk_data, sizeof(test_bulk_data), 0);
+
+	fibril_mutex_lock(&test_sender_lock);
+	test_sender_trc = trc;
+	test_sender_done = true;
+	fibril_condvar_broadcast(&test_sender_cv);
+	fibril_mutex_unlock(&test_sender_lock);
+
+	return EOK;
+}
+
+/** Transfer bulk data from client to server and verify it.
+ *
+ * @param cconn Client side of the connection
+ * @param sconn Server side of the connection
+ */
+static void ncsim_test_bulk(tcp_conn_t *cconn, tcp_conn_t *sconn)
+{
+	tcp_error_t trc;
+	xflags_t xflags;
+	size_t rcvd;
+	size_t total;
+	fid_t fid;
+
+	test_sender_done = false;
+
+	fid = fibril_create(ncsim_test_sender, cconn);
+	PCUT_ASSERT_TRUE(fid != 0);
+	fibril_add_ready(fid);
+
+	total = 0;
+	while (total < sizeof(test_bulk_rdata)) {
+		tcp_conn_lock(sconn);
+		while (sconn->rcv_buf_used == 0)
+			fibril_condvar_wait(&sconn->rcv_buf_cv, &sconn->lock);
+		tcp_conn_unlock(sconn);
+
+		/* Receiving data opens the window again */
+		trc = tcp_uc_receive(sconn, test_bulk_rdata + total,
+		    sizeof(test_bulk_rdata) - total, &rcvd, &xflags);
+		PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+		total += rcvd;
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(test_bulk_rdata, test_bulk_data,
+	    sizeof(test_bulk_data)));
+
+	fibril_mutex_lock(&test_sender_lock);
+	while (!test_sender_done)
+		fibril_condvar_wait(&test_sender_cv, &test_sender_lock);
+	fibril_mutex_unlock(&test_sender_lock);
+
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, test_sender_trc);
+}
+
+/** Drop the first segments carrying data.
+ *
+ * @param epp Endpoint pair
+ * @param seg Segment
+ * @param arg Pointer to number of segments left to drop
+ * @return @c true if segment should be dropped
+ */
+static bool ncsim_test_drop_data(inet_ep2_t *epp, tcp_segment_t *seg,
+    void *arg)
+{
+	int *ndrop = (int *) arg;
+
+	if (*ndrop > 0 && tcp_segment_text_size(seg) > 0) {
+		--*ndrop;
+		return true;
+	}
+
+	return false;
+}
+
+/** Drop the n-th segment carrying data.
+ *
+ * @param epp Endpoint pair
+ * @param seg Segment
+ * @param arg Pointer to number of data segments until the one to drop
+ * @return @c true if segment should be dropped
+ */
+static bool ncsim_test_drop_nth(inet_ep2_t *epp, tcp_segment_t *seg,
+    void *arg)
+{
+	int *nth = (int *) arg;
+
+	if (*nth > 0 && tcp_segment_text_size(seg) > 0)
+		return --*nth == 0;
+
+	return false;
+}
+
+/** Drop data segments selected by a bit mask.
+ *
+ * Bit i of the mask selects the (i + 1)-th segment carrying data.
+ *
+ * @param epp Endpoint pair
+ * @param seg Segment
+ * @param arg Pointer to mask of data segments to drop
+ * @return @c true if segment should be dropped
+ */
+static bool ncsim_test_drop_mask(inet_ep2_t *epp, tcp_segment_t *seg,
+    void *arg)
+{
+	uint32_t *mask = (uint32_t *) arg;
+	bool drop;
+
+	if (tcp_segment_text_size(seg) == 0)
+		return false;
+
+	drop = (*mask & 1) != 0;
+	*mask >>= 1;
+	return drop;
+}
+
+PCUT_EXPORT(ncsim);
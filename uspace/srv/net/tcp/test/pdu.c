@@ -108,4 +108,122 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test decoding data PDU without copying its text */
+PCUT_TEST(decode_ref)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	uint8_t data[15];
+	uint8_t *buf;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	memset(data, 0xa5, sizeof(data));
+	seg = tcp_segment_make_data(CTL_ACK, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 19;
+	seg->wnd = 18;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	buf = malloc(pdu->text_size);
+	PCUT_ASSERT_NOT_NULL(buf);
+	memcpy(buf, pdu->text, pdu->text_size);
+	free(pdu->text);
+	pdu->text = buf;
+
+	rc = tcp_pdu_decode_ref(pdu, buf, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* The segment refers to the buffer */
+	PCUT_ASSERT_EQUALS(buf, dseg->data);
+	test_seg_same(seg, dseg);
+
+	tcp_segment_delete(dseg);
+	tcp_segment_delete(seg);
+}
+
+/** Test encode/decode round trip for PDUs with options */
+PCUT_TEST(encdec_opts)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	uint8_t data[15];
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	/* SYN offering all supported options */
+	seg = tcp_segment_make_ctrl(CTL_SYN);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->wnd = 18;
+	seg->opts.flags = TOF_MSS | TOF_WSCALE | TOF_SACK_PERM | TOF_TS;
+	seg->opts.mss = 1460;
+	seg->opts.wscale = 7;
+	seg->opts.tsval = 0x12345678;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(sizeof(tcp_header_t) + 20, pdu->header_size);
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	tcp_segment_delete(seg);
+
+	/* Data segment with timestamp and SACK blocks */
+	memset(data, 0x5a, sizeof(data));
+	seg = tcp_segment_make_data(CTL_ACK, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 19;
+	seg->wnd = 18;
+	seg->opts.flags = TOF_TS;
+	seg->opts.tsval = 100;
+	seg->opts.tsecr = 0xfffffff0;
+	seg->opts.sack_cnt = 3;
+	seg->opts.sack[0].start = 1000;
+	seg->opts.sack[0].end = 1100;
+	seg->opts.sack[1].start = 200;
+	seg->opts.sack[1].end = 300;
+	seg->opts.sack[2].start = 0xffffff00;
+	seg->opts.sack[2].end = 100;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+
+	/* Only three SACK blocks fit along with the timestamp */
+	seg->opts.sack_cnt = 4;
+	seg->opts.sack[3].start = 500;
+	seg->opts.sack[3].end = 600;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(3, dseg->opts.sack_cnt);
+	PCUT_ASSERT_INT_EQUALS(TCP_OPTS_MAX_SIZE,
+	    pdu->header_size - sizeof(tcp_header_t));
+
+	tcp_segment_delete(seg);
+}
+
 PCUT_EXPORT(pdu);
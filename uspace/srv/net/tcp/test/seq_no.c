@@ -28,6 +28,7 @@
 
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <mem.h>
 #include <pcut/pcut.h>
 
 #include "../conn.h"
@@ -102,6 +103,185 @@ PCUT_TEST(ack_duplicate)
 	tcp_conn_delete(conn);
 }
 
+/** Test seq_no_ack_partial() */
+PCUT_TEST(ack_partial)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* ACK is partial iff SND.UNA < SEG.ACK < recover */
+
+	conn->snd_una = 10;
+	conn->recover = 30;
+
+	PCUT_ASSERT_FALSE(seq_no_ack_partial(conn, 10));
+	PCUT_ASSERT_TRUE(seq_no_ack_partial(conn, 11));
+	PCUT_ASSERT_TRUE(seq_no_ack_partial(conn, 29));
+	PCUT_ASSERT_FALSE(seq_no_ack_partial(conn, 30));
+	PCUT_ASSERT_FALSE(seq_no_ack_partial(conn, 31));
+
+	conn->snd_una = (uint32_t) -10;
+	conn->recover = 10;
+
+	PCUT_ASSERT_FALSE(seq_no_ack_partial(conn, (uint32_t) -10));
+	PCUT_ASSERT_TRUE(seq_no_ack_partial(conn, (uint32_t) -9));
+	PCUT_ASSERT_TRUE(seq_no_ack_partial(conn, 9));
+	PCUT_ASSERT_FALSE(seq_no_ack_partial(conn, 10));
+
+	tcp_conn_delete(conn);
+}
+
+/** Test seq_no_ts_recent_update() */
+PCUT_TEST(ts_recent_update)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_segment_t *seg;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	seg = tcp_segment_make_ctrl(CTL_ACK);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	/* Update iff SEG.SEQ <= Last.ACK.sent */
+
+	conn->last_ack_sent = 10;
+
+	seg->seq = 9;
+	PCUT_ASSERT_TRUE(seq_no_ts_recent_update(conn, seg));
+	seg->seq = 10;
+	PCUT_ASSERT_TRUE(seq_no_ts_recent_update(conn, seg));
+	seg->seq = 11;
+	PCUT_ASSERT_FALSE(seq_no_ts_recent_update(conn, seg));
+
+	conn->last_ack_sent = 5;
+
+	seg->seq = (uint32_t) -5;
+	PCUT_ASSERT_TRUE(seq_no_ts_recent_update(conn, seg));
+	seg->seq = 6;
+	PCUT_ASSERT_FALSE(seq_no_ts_recent_update(conn, seg));
+
+	tcp_segment_delete(seg);
+	tcp_conn_delete(conn);
+}
+
+/** Test seq_no_sack_valid() */
+PCUT_TEST(sack_valid)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_sack_block_t blk;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Block is valid iff SND.UNA <= start < end <= SND.NXT */
+
+	conn->snd_una = 10;
+	conn->snd_nxt = 30;
+
+	blk.start = 10;
+	blk.end = 30;
+	PCUT_ASSERT_TRUE(seq_no_sack_valid(conn, &blk));
+	blk.start = 15;
+	blk.end = 20;
+	PCUT_ASSERT_TRUE(seq_no_sack_valid(conn, &blk));
+	blk.start = 9;
+	PCUT_ASSERT_FALSE(seq_no_sack_valid(conn, &blk));
+	blk.start = 20;
+	PCUT_ASSERT_FALSE(seq_no_sack_valid(conn, &blk));
+	blk.start = 25;
+	blk.end = 31;
+	PCUT_ASSERT_FALSE(seq_no_sack_valid(conn, &blk));
+
+	conn->snd_una = (uint32_t) -10;
+	conn->snd_nxt = 10;
+
+	blk.start = (uint32_t) -5;
+	blk.end = 5;
+	PCUT_ASSERT_TRUE(seq_no_sack_valid(conn, &blk));
+	blk.start = 5;
+	blk.end = (uint32_t) -5;
+	PCUT_ASSERT_FALSE(seq_no_sack_valid(conn, &blk));
+
+	tcp_conn_delete(conn);
+}
+
+/** Test seq_no_segment_sacked() */
+PCUT_TEST(segment_sacked)
+{
+	tcp_segment_t *seg;
+	tcp_sack_block_t blk;
+	uint8_t data[10];
+
+	memset(data, 0, sizeof(data));
+	seg = tcp_segment_make_data(0, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	/* Segment must lie within the block entirely */
+
+	blk.start = 10;
+	blk.end = 30;
+
+	seg->seq = 10;
+	PCUT_ASSERT_TRUE(seq_no_segment_sacked(seg, &blk));
+	seg->seq = 20;
+	PCUT_ASSERT_TRUE(seq_no_segment_sacked(seg, &blk));
+	seg->seq = 5;
+	PCUT_ASSERT_FALSE(seq_no_segment_sacked(seg, &blk));
+	seg->seq = 21;
+	PCUT_ASSERT_FALSE(seq_no_segment_sacked(seg, &blk));
+
+	blk.start = (uint32_t) -5;
+	blk.end = 5;
+
+	seg->seq = (uint32_t) -5;
+	PCUT_ASSERT_TRUE(seq_no_segment_sacked(seg, &blk));
+	seg->seq = (uint32_t) -6;
+	PCUT_ASSERT_FALSE(seq_no_segment_sacked(seg, &blk));
+
+	tcp_segment_delete(seg);
+}
+
+/** Test seq_no_sack_rexmit_pending() */
+PCUT_TEST(sack_rexmit_pending)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_segment_t *seg;
+	uint8_t data[10];
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	memset(data, 0, sizeof(data));
+	seg = tcp_segment_make_data(0, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	/* Pending iff mark <= SEG.SEQ < SND.NXT */
+
+	conn->sack_rexmit = 20;
+	conn->snd_nxt = 50;
+
+	seg->seq = 10;
+	PCUT_ASSERT_FALSE(seq_no_sack_rexmit_pending(conn, seg));
+	seg->seq = 20;
+	PCUT_ASSERT_TRUE(seq_no_sack_rexmit_pending(conn, seg));
+	seg->seq = 40;
+	PCUT_ASSERT_TRUE(seq_no_sack_rexmit_pending(conn, seg));
+
+	tcp_segment_delete(seg);
+	tcp_conn_delete(conn);
+}
+
 /** Test seq_no_in_rcv_wnd() */
 PCUT_TEST(in_rcv_wnd)
 {
@@ -28,9 +28,12 @@
 
 //#include <inet/endpoint.h>
 #include <io/log.h>
+#include <macros.h>
+#include <mem.h>
 #include <pcut/pcut.h>
 
 #include "../conn.h"
+#include "../segment.h"
 #include "../tqueue.h"
 
 PCUT_INIT;
@@ -64,6 +67,12 @@ PCUT_TEST_BEFORE
 
 PCUT_TEST_AFTER
 {
+	int i;
+
+	for (i = 0; i < seg_cnt; i++)
+		tcp_segment_delete(trans_seg[i]);
+	seg_cnt = 0;
+
 	tcp_conns_fini();
 }
 
@@ -199,6 +208,54 @@ PCUT_TEST(new_data_small_win)
 	PCUT_ASSERT_EQUALS(10, trans_seg[0]->seq);
 }
 
+/** Test sending data limited by segment size and congestion window */
+PCUT_TEST(new_data_cwnd)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	int i;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 4096;
+	conn->smss = 100;
+	conn->cc.cwnd = 250;
+	conn->snd_buf_used = 300;
+	conn->snd_buf_fin = true;
+	for (i = 0; i < 300; i++)
+		conn->snd_buf[i] = i;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	tcp_tqueue_new_data(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+
+	/* FIN is held back along with the data */
+	PCUT_ASSERT_EQUALS(260, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(50, conn->snd_buf_used);
+	PCUT_ASSERT_TRUE(conn->snd_buf_fin);
+
+	tcp_conn_delete(conn);
+	PCUT_ASSERT_EQUALS(3, seg_cnt);
+	PCUT_ASSERT_EQUALS(10, trans_seg[0]->seq);
+	PCUT_ASSERT_EQUALS(100, trans_seg[0]->len);
+	PCUT_ASSERT_EQUALS(110, trans_seg[1]->seq);
+	PCUT_ASSERT_EQUALS(100, trans_seg[1]->len);
+	PCUT_ASSERT_EQUALS(210, trans_seg[2]->seq);
+	PCUT_ASSERT_EQUALS(50, trans_seg[2]->len);
+	PCUT_ASSERT_EQUALS(CTL_ACK, trans_seg[2]->ctrl);
+}
+
 /** Test flushing tqueue due to receiving an ACK */
 PCUT_TEST(ack_received)
 {
@@ -253,9 +310,246 @@ PCUT_TEST(ack_received)
 	tcp_conn_delete(conn);
 }
 
+/** Test round-trip time estimation */
+PCUT_TEST(rtt_sample)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	usec_t rto;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	PCUT_ASSERT_FALSE(conn->rtt_valid);
+	rto = conn->rto;
+
+	/* First measurement: SRTT = R, RTTVAR = R / 2 */
+	tcp_tqueue_rtt_sample(conn, 100 * 1000);
+	PCUT_ASSERT_TRUE(conn->rtt_valid);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, conn->srtt);
+	PCUT_ASSERT_INT_EQUALS(50 * 1000, conn->rttvar);
+	PCUT_ASSERT_INT_EQUALS(300 * 1000, conn->rto);
+	PCUT_ASSERT_TRUE(conn->rto < rto);
+
+	/* Stable RTT decreases the variation */
+	tcp_tqueue_rtt_sample(conn, 100 * 1000);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, conn->srtt);
+	PCUT_ASSERT_INT_EQUALS(37500, conn->rttvar);
+	PCUT_ASSERT_INT_EQUALS(250 * 1000, conn->rto);
+
+	/* Sudden change increases the variation */
+	tcp_tqueue_rtt_sample(conn, 0);
+	PCUT_ASSERT_INT_EQUALS(87500, conn->srtt);
+	PCUT_ASSERT_INT_EQUALS(53125, conn->rttvar);
+	PCUT_ASSERT_INT_EQUALS(300 * 1000, conn->rto);
+
+	/* Very small RTT is bounded by the minimum RTO */
+	conn->rtt_valid = false;
+	tcp_tqueue_rtt_sample(conn, 1000);
+	PCUT_ASSERT_INT_EQUALS(200 * 1000, conn->rto);
+
+	PCUT_ASSERT_INT_EQUALS(4, conn->stats.rtt_samples);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test that acknowledging a segment produces an RTT measurement */
+PCUT_TEST(ack_rtt)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 1024;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	conn->snd_buf_used = 10;
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_FALSE(conn->rtt_valid);
+
+	conn->snd_una = 20;
+	tcp_tqueue_ack_received(conn);
+
+	PCUT_ASSERT_TRUE(conn->rtt_valid);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.rtt_samples);
+	PCUT_ASSERT_INT_EQUALS(0, conn->stats.retransmits);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Test fast retransmit of the first unacknowledged segment */
+PCUT_TEST(fast_retransmit)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 1024;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* Send two data segments */
+	conn->snd_buf_used = 10;
+	tcp_tqueue_new_data(conn);
+	conn->snd_buf_used = 20;
+	tcp_tqueue_new_data(conn);
+
+	PCUT_ASSERT_EQUALS(40, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(2, seg_cnt);
+
+	/* The first segment is retransmitted */
+	tcp_tqueue_fast_retransmit(conn);
+
+	PCUT_ASSERT_EQUALS(3, seg_cnt);
+	PCUT_ASSERT_EQUALS(10, trans_seg[2]->seq);
+	PCUT_ASSERT_EQUALS(10, trans_seg[2]->len);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.retransmits);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.fast_retransmits);
+
+	/* Retransmitted segment cannot be used to measure RTT */
+	conn->snd_una = 20;
+	tcp_tqueue_ack_received(conn);
+
+	PCUT_ASSERT_INT_EQUALS(1, list_count(&conn->retransmit.list));
+	PCUT_ASSERT_FALSE(conn->rtt_valid);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Test options offered in SYN */
+PCUT_TEST(syn_opts)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	tcp_tqueue_ctrl_seg(conn, CTL_SYN);
+
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(TOF_MSS | TOF_WSCALE | TOF_SACK_PERM | TOF_TS,
+	    trans_seg[0]->opts.flags);
+	PCUT_ASSERT_INT_EQUALS(conn->rcv_wscale, trans_seg[0]->opts.wscale);
+	PCUT_ASSERT_TRUE(trans_seg[0]->opts.mss > 0);
+	PCUT_ASSERT_INT_EQUALS(0, trans_seg[0]->opts.tsecr);
+
+	/* Window in SYN is never scaled */
+	PCUT_ASSERT_INT_EQUALS(min(conn->rcv_wnd, UINT16_MAX),
+	    trans_seg[0]->wnd);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Test retransmission of holes reported by SACK */
+PCUT_TEST(sack_retransmit)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_seg_opts_t opts;
+	int i;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 1024;
+	conn->sack_ok = true;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* Send four data segments, 10-20, 20-30, 30-40 and 40-50 */
+	for (i = 1; i <= 4; i++) {
+		conn->snd_buf_used = 10 * i;
+		tcp_tqueue_new_data(conn);
+	}
+
+	PCUT_ASSERT_EQUALS(50, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(4, seg_cnt);
+
+	/* First segment is lost, the peer reports having 30-40 */
+	tcp_tqueue_fast_retransmit(conn);
+	PCUT_ASSERT_EQUALS(5, seg_cnt);
+	PCUT_ASSERT_EQUALS(10, trans_seg[4]->seq);
+
+	memset(&opts, 0, sizeof(opts));
+	opts.sack_cnt = 1;
+	opts.sack[0].start = 30;
+	opts.sack[0].end = 40;
+	tcp_tqueue_sack_received(conn, &opts);
+
+	/* Hole 20-30 is retransmitted exactly once */
+	PCUT_ASSERT_TRUE(tcp_tqueue_sack_retransmit(conn));
+	PCUT_ASSERT_EQUALS(6, seg_cnt);
+	PCUT_ASSERT_EQUALS(20, trans_seg[5]->seq);
+	PCUT_ASSERT_EQUALS(10, trans_seg[5]->len);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.sack_retransmits);
+
+	/* Nothing is known to be lost after the SACKed block */
+	PCUT_ASSERT_FALSE(tcp_tqueue_sack_retransmit(conn));
+	PCUT_ASSERT_EQUALS(6, seg_cnt);
+
+	/* Invalid block is ignored */
+	opts.sack[0].start = 40;
+	opts.sack[0].end = 60;
+	tcp_tqueue_sack_received(conn, &opts);
+	PCUT_ASSERT_FALSE(tcp_tqueue_sack_retransmit(conn));
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
 static void tqueue_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
-	trans_seg[seg_cnt++] = seg;
+	/* Segment is owned by the caller */
+	if (seg_cnt < test_seg_max)
+		trans_seg[seg_cnt++] = tcp_segment_dup(seg);
 }
 
 PCUT_EXPORT(tqueue);
@@ -42,9 +42,12 @@
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
+#include "iqueue.h"
 #include "ncsim.h"
 #include "rqueue.h"
 #include "segment.h"
@@ -52,9 +55,20 @@
 #include "tqueue.h"
 #include "tcp_type.h"
 
-#define RETRANSMIT_TIMEOUT	(2*1000*1000)
+/** Initial retransmission timeout (RFC 6298) */
+#define RTO_INITIAL	(1000*1000)
+/** Lower bound of the retransmission timeout */
+#define RTO_MIN		(200*1000)
+/** Upper bound of the retransmission timeout */
+#define RTO_MAX		(60*1000*1000)
+/** Clock granularity (G in RFC 6298) */
+#define RTO_CLOCK_GRANULARITY	(1000)
+
+/** Maximum segment size we advertise (assumes Ethernet MTU) */
+#define ADV_MSS		1460
 
 static void retransmit_timeout_func(void *);
+static void tcp_tqueue_retransmit_seg(tcp_conn_t *, tcp_tqueue_entry_t *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
 static void tcp_tqueue_seg(tcp_conn_t *, tcp_segment_t *);
@@ -73,6 +87,9 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 
 	list_initialize(&tqueue->list);
 
+	conn->rto = RTO_INITIAL;
+	conn->rtt_valid = false;
+
 	return EOK;
 }
 
@@ -146,6 +163,7 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 		tqe->conn = conn;
 		tqe->seg = rt_seg;
 		rt_seg->seq = conn->snd_nxt;
+		getuptime(&tqe->sent);
 
 		list_append(&tqe->link, &conn->retransmit.list);
 
@@ -173,11 +191,16 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 }
 
 /** Transmit data from the send buffer.
+ *
+ * Data is sent in segments of at most SMSS bytes as long as both the
+ * peer's receive window and the congestion window allow it.
  *
  * @param conn	Connection
  */
 void tcp_tqueue_new_data(tcp_conn_t *conn)
 {
+	uint32_t wnd;
+	uint32_t flight;
 	size_t avail_wnd;
 	size_t xfer_seqlen;
 	size_t snd_buf_seqlen;
@@ -189,62 +212,76 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
 
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
-	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
+	/* Usable window is limited by the congestion window */
+	wnd = min(conn->snd_wnd, conn->cc.cwnd);
 
-	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+	while (true) {
+		/* Number of free sequence numbers in send window */
+		flight = conn->snd_nxt - conn->snd_una;
+		avail_wnd = flight < wnd ? wnd - flight : 0;
+		snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
 
-	if (xfer_seqlen == 0)
-		return;
+		xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, "
+		    "SND.WND = %" PRIu32 ", CWND = %" PRIu32 ", "
+		    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen,
+		    conn->snd_wnd, conn->cc.cwnd, xfer_seqlen);
 
-	/* XXX Do not always send immediately */
+		if (xfer_seqlen == 0)
+			return;
 
-	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
-	data_size = xfer_seqlen - (send_fin ? 1 : 0);
+		/* XXX Do not always send immediately */
 
-	if (send_fin) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
-		/* We are sending out FIN */
-		ctrl = CTL_FIN;
-	} else {
-		ctrl = 0;
-	}
+		send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen &&
+		    conn->snd_buf_used <= conn->smss;
+		data_size = min(xfer_seqlen - (send_fin ? 1 : 0), conn->smss);
 
-	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
-	if (seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
-		return;
-	}
+		if (send_fin) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
+			/* We are sending out FIN */
+			ctrl = CTL_FIN;
+		} else {
+			ctrl = 0;
+		}
 
-	/* Remove data from send buffer */
-	memmove(conn->snd_buf, conn->snd_buf + data_size,
-	    conn->snd_buf_used - data_size);
-	conn->snd_buf_used -= data_size;
+		seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
+		if (seg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+			return;
+		}
 
-	if (send_fin)
-		conn->snd_buf_fin = false;
+		/* Remove data from send buffer */
+		memmove(conn->snd_buf, conn->snd_buf + data_size,
+		    conn->snd_buf_used - data_size);
+		conn->snd_buf_used -= data_size;
 
-	fibril_condvar_broadcast(&conn->snd_buf_cv);
+		if (send_fin)
+			conn->snd_buf_fin = false;
 
-	if (send_fin)
-		tcp_conn_fin_sent(conn);
+		fibril_condvar_broadcast(&conn->snd_buf_cv);
 
-	tcp_tqueue_seg(conn, seg);
-	tcp_segment_delete(seg);
+		if (send_fin)
+			tcp_conn_fin_sent(conn);
+
+		tcp_tqueue_seg(conn, seg);
+		tcp_segment_delete(seg);
+	}
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
  * more data.
  *
  * This should be called when SND.UNA is updated due to incoming ACK.
+ * If a segment that has not been retransmitted was acknowledged, the
+ * round-trip time estimate is updated (Karn's algorithm).
  */
 void tcp_tqueue_ack_received(tcp_conn_t *conn)
 {
 	link_t *cur, *next;
+	struct timespec sent;
+	struct timespec now;
+	bool acked = false;
+	bool have_sample = false;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_ack_received(%p)", conn->name,
 	    conn);
@@ -270,35 +307,309 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 				conn->fin_is_acked = true;
 			}
 
+			/*
+			 * Measure using the most recently sent segment,
+			 * unless timestamps provide better measurements.
+			 */
+			if (!tqe->retransmitted && !conn->ts_ok) {
+				sent = tqe->sent;
+				have_sample = true;
+			}
+
 			tcp_segment_delete(tqe->seg);
 			free(tqe);
-
-			/* Reset retransmission timer */
-			tcp_tqueue_timer_set(conn);
+			acked = true;
 		}
 
 		cur = next;
 	}
 
-	/* Clear retransmission timer if the queue is empty. */
-	if (list_empty(&conn->retransmit.list))
+	if (have_sample) {
+		getuptime(&now);
+		tcp_tqueue_rtt_sample(conn, NSEC2USEC(ts_sub_diff(&now, &sent)));
+	}
+
+	if (list_empty(&conn->retransmit.list)) {
+		/* Clear retransmission timer if the queue is empty. */
 		tcp_tqueue_timer_clear(conn);
+	} else if (acked) {
+		/* Reset retransmission timer */
+		tcp_tqueue_timer_set(conn);
+	}
 
 	/* Possibly transmit more data */
 	tcp_tqueue_new_data(conn);
 }
 
+/** Update round-trip time estimate with a new measurement.
+ *
+ * Computes SRTT, RTTVAR and the retransmission timeout as per RFC 6298.
+ *
+ * @param conn	Connection
+ * @param rtt	Measured round-trip time (usec)
+ */
+void tcp_tqueue_rtt_sample(tcp_conn_t *conn, usec_t rtt)
+{
+	usec_t delta;
+
+	if (!conn->rtt_valid) {
+		/* First measurement */
+		conn->srtt = rtt;
+		conn->rttvar = rtt / 2;
+		conn->rtt_valid = true;
+	} else {
+		delta = conn->srtt > rtt ? conn->srtt - rtt : rtt - conn->srtt;
+		conn->rttvar = (3 * conn->rttvar + delta) / 4;
+		conn->srtt = (7 * conn->srtt + rtt) / 8;
+	}
+
+	conn->rto = conn->srtt + max(RTO_CLOCK_GRANULARITY, 4 * conn->rttvar);
+	if (conn->rto < RTO_MIN)
+		conn->rto = RTO_MIN;
+	if (conn->rto > RTO_MAX)
+		conn->rto = RTO_MAX;
+
+	++conn->stats.rtt_samples;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: RTT=%lld SRTT=%lld RTTVAR=%lld "
+	    "RTO=%lld", conn->name, rtt, conn->srtt, conn->rttvar, conn->rto);
+}
+
+/** Retransmit the first unacknowledged segment immediately.
+ *
+ * Used for fast retransmit and for repairing further holes upon
+ * partial acknowledgements during fast recovery.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_fast_retransmit(tcp_conn_t *conn)
+{
+	tcp_tqueue_entry_t *tqe;
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	link = list_first(&conn->retransmit.list);
+	if (link == NULL)
+		return;
+
+	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Fast retransmit, SEG.SEQ=%" PRIu32,
+	    conn->name, tqe->seg->seq);
+
+	++conn->stats.fast_retransmits;
+	tcp_tqueue_retransmit_seg(conn, tqe);
+	conn->sack_rexmit = tqe->seg->seq + tqe->seg->len;
+
+	/* Reset retransmission timer */
+	tcp_tqueue_timer_set(conn);
+}
+
+/** Process SACK blocks received from the peer.
+ *
+ * Mark segments in the retransmission queue that the peer has received.
+ *
+ * @param conn	Connection
+ * @param opts	Options of the received segment
+ */
+void tcp_tqueue_sack_received(tcp_conn_t *conn, tcp_seg_opts_t *opts)
+{
+	size_t i;
+
+	if (!conn->sack_ok)
+		return;
+
+	for (i = 0; i < opts->sack_cnt; i++) {
+		if (!seq_no_sack_valid(conn, &opts->sack[i]))
+			continue;
+
+		list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t,
+		    tqe) {
+			if (seq_no_segment_sacked(tqe->seg, &opts->sack[i]))
+				tqe->sacked = true;
+		}
+	}
+}
+
+/** Retransmit next segment known to be lost during fast recovery.
+ *
+ * A segment is considered lost if the peer has selectively acknowledged
+ * data following it. Each segment is retransmitted at most once per
+ * recovery episode. The first unacknowledged segment is also retransmitted
+ * if this did not happen yet during the episode.
+ *
+ * @param conn	Connection
+ * @return	@c true if a segment was retransmitted
+ */
+bool tcp_tqueue_sack_retransmit(tcp_conn_t *conn)
+{
+	tcp_tqueue_entry_t *tqe;
+	tcp_tqueue_entry_t *cand = NULL;
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (!conn->sack_ok)
+		return false;
+
+	link = list_first(&conn->retransmit.list);
+	while (link != NULL) {
+		tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+
+		if (cand == NULL) {
+			if (!tqe->sacked &&
+			    seq_no_sack_rexmit_pending(conn, tqe->seg)) {
+				cand = tqe;
+				/* First unacknowledged segment is always a hole */
+				if (link == list_first(&conn->retransmit.list))
+					break;
+			}
+		} else if (tqe->sacked) {
+			/* Candidate is followed by SACKed data */
+			break;
+		}
+
+		link = list_next(link, &conn->retransmit.list);
+	}
+
+	if (link == NULL)
+		return false;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: SACK retransmit, SEG.SEQ=%" PRIu32,
+	    conn->name, cand->seg->seq);
+
+	++conn->stats.sack_retransmits;
+	tcp_tqueue_retransmit_seg(conn, cand);
+	conn->sack_rexmit = cand->seg->seq + cand->seg->len;
+
+	return true;
+}
+
+/** Get current timestamp value.
+ *
+ * @return	Timestamp (msec)
+ */
+static uint32_t tcp_tqueue_ts_now(void)
+{
+	struct timespec now;
+
+	getuptime(&now);
+	return (uint32_t) (SEC2MSEC(now.tv_sec) + NSEC2MSEC(now.tv_nsec));
+}
+
+/** Update round-trip time estimate from echoed timestamp.
+ *
+ * @param conn	Connection
+ * @param tsecr	Timestamp echo reply from segment acknowledging new data
+ */
+void tcp_tqueue_ts_rtt(tcp_conn_t *conn, uint32_t tsecr)
+{
+	uint32_t rtt;
+
+	rtt = tcp_tqueue_ts_now() - tsecr;
+
+	/* Ignore bogus echo replies from the future */
+	if ((int32_t) rtt < 0)
+		return;
+
+	tcp_tqueue_rtt_sample(conn, MSEC2USEC((usec_t) rtt));
+}
+
+/** Set up options of an outgoing segment.
+ *
+ * In SYN we offer all the options we support, in SYN-ACK we confirm
+ * those that the peer offered. In other segments we only use options
+ * that have been agreed upon.
+ *
+ * @param conn	Connection
+ * @param seg	Segment
+ */
+static void tcp_tqueue_set_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+	bool offer;
+
+	memset(opts, 0, sizeof(tcp_seg_opts_t));
+
+	offer = (seg->ctrl & (CTL_SYN | CTL_ACK)) == CTL_SYN;
+
+	if ((seg->ctrl & CTL_SYN) != 0) {
+		opts->flags |= TOF_MSS;
+		opts->mss = ADV_MSS;
+
+		if (offer || conn->ws_ok) {
+			opts->flags |= TOF_WSCALE;
+			opts->wscale = conn->rcv_wscale;
+		}
+
+		if (offer || conn->sack_ok)
+			opts->flags |= TOF_SACK_PERM;
+	}
+
+	if (offer || conn->ts_ok) {
+		opts->flags |= TOF_TS;
+		opts->tsval = tcp_tqueue_ts_now();
+		if ((seg->ctrl & CTL_ACK) != 0)
+			opts->tsecr = conn->ts_recent;
+	}
+
+	/* Tell the peer which out-of-order data we have */
+	if (conn->sack_ok && (seg->ctrl & (CTL_SYN | CTL_ACK)) == CTL_ACK &&
+	    !list_empty(&conn->incoming.list)) {
+		opts->sack_cnt = tcp_iqueue_sack_blocks(&conn->incoming,
+		    conn->sack_recent, opts->sack, TCP_SACK_BLOCKS_MAX);
+	}
+}
+
+/** Retransmit segment from the retransmission queue.
+ *
+ * @param conn	Connection
+ * @param tqe	Retransmission queue entry
+ */
+static void tcp_tqueue_retransmit_seg(tcp_conn_t *conn, tcp_tqueue_entry_t *tqe)
+{
+	tcp_segment_t *rt_seg;
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		/* XXX Handle properly */
+		return;
+	}
+
+	/* Segment in the queue might have been created before ACK was set */
+	if (tcp_conn_got_syn(conn) && (rt_seg->ctrl & CTL_RST) == 0)
+		rt_seg->ctrl |= CTL_ACK;
+
+	tqe->retransmitted = true;
+	++conn->stats.retransmits;
+
+	tcp_conn_transmit_segment(conn, rt_seg);
+	tcp_segment_delete(rt_seg);
+}
+
 static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	/* Window in SYN is never scaled (RFC 7323 2.2) */
+	if ((seg->ctrl & CTL_SYN) != 0)
+		seg->wnd = min(conn->rcv_wnd, UINT16_MAX);
+	else
+		seg->wnd = min(conn->rcv_wnd >> conn->rcv_wscale, UINT16_MAX);
 
-	if ((seg->ctrl & CTL_ACK) != 0)
+	if ((seg->ctrl & CTL_ACK) != 0) {
 		seg->ack = conn->rcv_nxt;
-	else
+		conn->last_ack_sent = seg->ack;
+		/* This acknowledges everything received so far */
+		conn->ack_pending = false;
+	} else {
 		seg->ack = 0;
+	}
+
+	tcp_tqueue_set_opts(conn, seg);
 
 	tcp_tqueue_send_immed(conn, seg);
 }
@@ -321,7 +632,6 @@ static void retransmit_timeout_func(void *arg)
 {
 	tcp_conn_t *conn = (tcp_conn_t *) arg;
 	tcp_tqueue_entry_t *tqe;
-	tcp_segment_t *rt_seg;
 	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
@@ -345,20 +655,27 @@ static void retransmit_timeout_func(void *arg)
 
 	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
-	}
+	/* Back off the timer (RFC 6298 5.5) */
+	conn->rto = min(2 * conn->rto, RTO_MAX);
+	++conn->stats.timeouts;
+
+	/* Timeout ends fast recovery */
+	conn->fast_recovery = false;
+	conn->dup_acks = 0;
+
+	/* Collapse the congestion window */
+	tcp_cc_timeout(conn, !tqe->retransmitted);
+
+	/* The peer may have discarded data it selectively acknowledged */
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, sqe)
+		sqe->sacked = false;
+	conn->sack_rexmit = conn->snd_una;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_tqueue_retransmit_seg(conn, tqe);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -377,7 +694,7 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
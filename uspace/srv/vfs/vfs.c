@@ -99,6 +99,15 @@ int main(int argc, char **argv)
 		return ENOMEM;
 	}
 
+	/*
+	 * Initialize the directory entry cache.
+	 */
+	if (!vfs_dcache_init()) {
+		printf("%s: Failed to initialize directory entry cache\n",
+		    NAME);
+		return ENOMEM;
+	}
+
 	/*
 	 * Allocate and initialize the Path Lookup Buffer.
 	 */
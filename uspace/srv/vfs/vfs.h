@@ -187,6 +187,16 @@ extern unsigned vfs_nodes_refcount_sum_get(fs_handle_t, service_id_t);
 
 extern bool vfs_node_has_children(vfs_node_t *node);
 
+extern bool vfs_dcache_init(void);
+extern vfs_node_t *vfs_dcache_lookup(vfs_triplet_t *, const char *, bool *);
+extern unsigned vfs_dcache_generation(void);
+extern void vfs_dcache_insert(vfs_triplet_t *, const char *, vfs_node_t *,
+    unsigned);
+extern void vfs_dcache_added(void);
+extern void vfs_dcache_forget(vfs_triplet_t *);
+extern void vfs_dcache_forget_fs(fs_handle_t, service_id_t);
+extern void vfs_dcache_stats_get(vfs_dcache_stats_t *);
+
 extern void *vfs_client_data_create(void);
 extern void vfs_client_data_destroy(void *);
 
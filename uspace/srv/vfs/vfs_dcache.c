@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_dcache.c
+ * @brief	Cache of resolved path components.
+ *
+ * The cache maps a (directory, name) pair to the VFS node the name resolves
+ * to. Positive entries hold a reference to the node so that its identity,
+ * type, size and mount point stay known. Negative entries record names which
+ * the file system did not find. Since names are only ever added by a lookup
+ * with L_CREATE or by a link, adding a name simply bumps a generation number
+ * which invalidates all negative entries at once.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Maximum number of cached directory entries. */
+#define DCACHE_MAX_ENTRIES	1024
+
+typedef struct {
+	ht_link_t link;		/**< Cache hash table link. */
+	link_t lru_link;	/**< LRU list link, most recently used first. */
+
+	vfs_triplet_t parent;	/**< Directory containing the name. */
+	char *name;		/**< Name of the entry. */
+
+	/** Referenced node the name resolves to or NULL if it does not exist. */
+	vfs_node_t *node;
+	/** Value of dcache_gen when a negative entry was looked up. */
+	unsigned gen;
+} dcache_entry_t;
+
+typedef struct {
+	vfs_triplet_t *parent;
+	const char *name;
+} dcache_key_t;
+
+/** Mutex protecting the directory entry cache. */
+static FIBRIL_MUTEX_INITIALIZE(dcache_mutex);
+
+static hash_table_t dcache;
+static LIST_INITIALIZE(dcache_lru);
+static size_t dcache_count;
+
+/** Generation of negative entries. */
+static unsigned dcache_gen;
+
+static uint64_t dcache_hits;
+static uint64_t dcache_neg_hits;
+static uint64_t dcache_misses;
+
+static bool triplet_equal(vfs_triplet_t *a, vfs_triplet_t *b)
+{
+	return a->fs_handle == b->fs_handle &&
+	    a->service_id == b->service_id && a->index == b->index;
+}
+
+static size_t dcache_hash(vfs_triplet_t *parent, const char *name)
+{
+	size_t hash = hash_combine(parent->fs_handle, parent->service_id);
+	hash = hash_combine(hash, parent->index);
+	return hash_combine(hash, hash_string(name));
+}
+
+static size_t dcache_key_hash(void *arg)
+{
+	dcache_key_t *key = (dcache_key_t *) arg;
+	return dcache_hash(key->parent, key->name);
+}
+
+static size_t dcache_item_hash(const ht_link_t *item)
+{
+	dcache_entry_t *entry = hash_table_get_inst(item, dcache_entry_t, link);
+	return dcache_hash(&entry->parent, entry->name);
+}
+
+static bool dcache_key_equal(void *arg, const ht_link_t *item)
+{
+	dcache_key_t *key = (dcache_key_t *) arg;
+	dcache_entry_t *entry = hash_table_get_inst(item, dcache_entry_t, link);
+
+	return triplet_equal(key->parent, &entry->parent) &&
+	    str_cmp(key->name, entry->name) == 0;
+}
+
+/** Directory entry cache hash table operations. */
+static hash_table_ops_t dcache_ops = {
+	.hash = dcache_item_hash,
+	.key_hash = dcache_key_hash,
+	.key_equal = dcache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the directory entry cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_dcache_init(void)
+{
+	return hash_table_create(&dcache, 0, 0, &dcache_ops);
+}
+
+/** Move an entry from the cache to a list of entries to be released.
+ *
+ * Must be called with dcache_mutex held.
+ */
+static void dcache_remove(dcache_entry_t *entry, list_t *victims)
+{
+	hash_table_remove_item(&dcache, &entry->link);
+	list_remove(&entry->lru_link);
+	list_append(&entry->lru_link, victims);
+	dcache_count--;
+}
+
+/** Release entries removed from the cache.
+ *
+ * Must be called without dcache_mutex held as dropping the last reference
+ * to a node talks to its file system.
+ */
+static void dcache_release(list_t *victims)
+{
+	while (!list_empty(victims)) {
+		dcache_entry_t *entry = list_get_instance(list_first(victims),
+		    dcache_entry_t, lru_link);
+		list_remove(&entry->lru_link);
+
+		if (entry->node)
+			vfs_node_put(entry->node);
+		free(entry->name);
+		free(entry);
+	}
+}
+
+/** Look up a name in the directory entry cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name to look up.
+ * @param negative	Set to true if the name is known not to exist.
+ *
+ * @return		Referenced VFS node the name resolves to or NULL if the
+ *			name is not cached or is known not to exist.
+ */
+vfs_node_t *vfs_dcache_lookup(vfs_triplet_t *parent, const char *name,
+    bool *negative)
+{
+	dcache_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+	vfs_node_t *node = NULL;
+
+	LIST_INITIALIZE(victims);
+	*negative = false;
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	ht_link_t *item = hash_table_find(&dcache, &key);
+	if (item) {
+		dcache_entry_t *entry = hash_table_get_inst(item,
+		    dcache_entry_t, link);
+
+		if (entry->node || entry->gen == dcache_gen) {
+			list_remove(&entry->lru_link);
+			list_prepend(&entry->lru_link, &dcache_lru);
+
+			node = entry->node;
+			if (node) {
+				vfs_node_addref(node);
+				dcache_hits++;
+			} else {
+				*negative = true;
+				dcache_neg_hits++;
+			}
+		} else {
+			/* The name may have been created since. */
+			dcache_remove(entry, &victims);
+			dcache_misses++;
+		}
+	} else {
+		dcache_misses++;
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dcache_release(&victims);
+	return node;
+}
+
+/** Get the current generation of negative entries.
+ *
+ * The generation must be obtained before asking the file system about a name
+ * which may end up as a negative entry.
+ */
+unsigned vfs_dcache_generation(void)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	unsigned gen = dcache_gen;
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return gen;
+}
+
+/** Add a name to the directory entry cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name of the entry.
+ * @param node		Node the name resolves to or NULL if the name does not
+ *			exist. The cache takes its own reference.
+ * @param gen		Generation obtained by vfs_dcache_generation() before
+ *			the name was looked up.
+ */
+void vfs_dcache_insert(vfs_triplet_t *parent, const char *name,
+    vfs_node_t *node, unsigned gen)
+{
+	dcache_entry_t *entry = malloc(sizeof(dcache_entry_t));
+	if (!entry)
+		return;
+
+	entry->name = str_dup(name);
+	if (!entry->name) {
+		free(entry);
+		return;
+	}
+
+	entry->parent = *parent;
+	entry->node = node;
+	entry->gen = gen;
+	if (node)
+		vfs_node_addref(node);
+
+	LIST_INITIALIZE(victims);
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	if (!node && gen != dcache_gen) {
+		/* A name was added while this one was being looked up. */
+		list_append(&entry->lru_link, &victims);
+		fibril_mutex_unlock(&dcache_mutex);
+		dcache_release(&victims);
+		return;
+	}
+
+	dcache_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	ht_link_t *item = hash_table_find(&dcache, &key);
+	if (item) {
+		dcache_remove(hash_table_get_inst(item, dcache_entry_t, link),
+		    &victims);
+	}
+
+	hash_table_insert(&dcache, &entry->link);
+	list_prepend(&entry->lru_link, &dcache_lru);
+	dcache_count++;
+
+	while (dcache_count > DCACHE_MAX_ENTRIES) {
+		dcache_remove(list_get_instance(list_last(&dcache_lru),
+		    dcache_entry_t, lru_link), &victims);
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dcache_release(&victims);
+}
+
+/** Note that a name was added to the namespace.
+ *
+ * Invalidates all negative entries.
+ */
+void vfs_dcache_added(void)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	dcache_gen++;
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Drop all entries referring to a node.
+ *
+ * This drops both the names which resolve to the node and the names cached
+ * within the node if it is a directory. It must be called whenever a name of
+ * the node is removed.
+ *
+ * @param triplet	Node whose entries are to be dropped.
+ */
+void vfs_dcache_forget(vfs_triplet_t *triplet)
+{
+	LIST_INITIALIZE(victims);
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	list_foreach_safe(dcache_lru, cur, next) {
+		dcache_entry_t *entry = list_get_instance(cur, dcache_entry_t,
+		    lru_link);
+
+		if (triplet_equal(&entry->parent, triplet) ||
+		    (entry->node &&
+		    triplet_equal((vfs_triplet_t *) entry->node, triplet)))
+			dcache_remove(entry, &victims);
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dcache_release(&victims);
+}
+
+/** Drop all entries within a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_dcache_forget_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	LIST_INITIALIZE(victims);
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	list_foreach_safe(dcache_lru, cur, next) {
+		dcache_entry_t *entry = list_get_instance(cur, dcache_entry_t,
+		    lru_link);
+
+		if (entry->parent.fs_handle == fs_handle &&
+		    entry->parent.service_id == service_id)
+			dcache_remove(entry, &victims);
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dcache_release(&victims);
+}
+
+/** Get directory entry cache statistics.
+ *
+ * @param stats		Place to store the statistics.
+ */
+void vfs_dcache_stats_get(vfs_dcache_stats_t *stats)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	stats->hits = dcache_hits;
+	stats->neg_hits = dcache_neg_hits;
+	stats->misses = dcache_misses;
+	stats->entries = dcache_count;
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/**
+ * @}
+ */
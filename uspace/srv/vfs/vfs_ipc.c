@@ -45,6 +45,25 @@ static void vfs_in_clone(ipc_call_t *req)
 	async_answer_1(req, rc, outfd);
 }
 
+static void vfs_in_dcache_stats(ipc_call_t *req)
+{
+	vfs_dcache_stats_t stats;
+	vfs_dcache_stats_get(&stats);
+
+	ipc_call_t call;
+	size_t len;
+	if (!async_data_read_receive(&call, &len)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (len > sizeof(stats))
+		len = sizeof(stats);
+	errno_t rc = async_data_read_finalize(&call, &stats, len);
+	async_answer_0(req, rc);
+}
+
 static void vfs_in_fsprobe(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) IPC_GET_ARG1(*req);
@@ -338,6 +357,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_CLONE:
 			vfs_in_clone(&call);
 			break;
+		case VFS_IN_DCACHE_STATS:
+			vfs_in_dcache_stats(&call);
+			break;
 		case VFS_IN_FSPROBE:
 			vfs_in_fsprobe(&call);
 			break;
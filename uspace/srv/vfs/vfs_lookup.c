@@ -202,6 +202,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	if (rc == EOK)
+		vfs_dcache_added();
+
 out:
 	return rc;
 }
@@ -321,6 +324,194 @@ out:
 	return rc;
 }
 
+/** Cross mount points starting at a node.
+ *
+ * @param node   Referenced node. On success it is replaced by the referenced
+ *               root of the file system mounted on it, if any.
+ * @param lflag  Lookup flags.
+ *
+ * @return EOK on success, EXDEV if a mount point is to be crossed but mount
+ *         points are disabled by @a lflag.
+ */
+static errno_t lookup_cross_mounts(vfs_node_t **node, int lflag)
+{
+	while ((*node)->mount) {
+		if (lflag & L_DISABLE_MOUNTS)
+			return EXDEV;
+
+		vfs_node_t *root = (*node)->mount;
+		vfs_node_addref(root);
+		vfs_node_put(*node);
+		*node = root;
+	}
+
+	return EOK;
+}
+
+/** Ask the file system to resolve a single path component.
+ *
+ * @param base    Directory in which to look up the component.
+ * @param path    Component preceded by a slash; it need not be
+ *                NULL-terminated.
+ * @param len     Length of the component including the slash.
+ * @param result  Place to store the lookup result.
+ * @param found   Set to false if the component does not exist.
+ *
+ * @return EOK on success or an error code from errno.h.
+ */
+static errno_t lookup_component(vfs_node_t *base, char *path, size_t len,
+    vfs_lookup_res_t *result, bool *found)
+{
+	size_t first;
+	errno_t rc;
+
+	plb_entry_t entry;
+	rc = plb_insert_entry(&entry, path, &first, len);
+	if (rc != EOK)
+		return rc;
+
+	size_t next = first;
+	size_t nlen = len;
+
+	rc = out_lookup((vfs_triplet_t *) base, &next, &nlen, L_NONE, result);
+
+	/*
+	 * If the component was not found, the file system returns the
+	 * directory and leaves the component unresolved.
+	 */
+	*found = (nlen == 0);
+
+	plb_clear_entry(&entry, first, len);
+	return rc;
+}
+
+/** Perform a path lookup one component at a time.
+ *
+ * Each component is first looked up in the directory entry cache. Only the
+ * components that are not cached are resolved by the file system and their
+ * results, including negative ones, are added to the cache. Once a file system
+ * whose namespace can change behind our back is reached, the rest of the path
+ * is handed over to _vfs_lookup_internal().
+ *
+ * The arguments and the return value are the same as for
+ * _vfs_lookup_internal(). The lookup must not create or unlink anything.
+ */
+static errno_t _vfs_lookup_cached(vfs_node_t *base, char *path, int lflag,
+    vfs_lookup_res_t *result, size_t len)
+{
+	char component[NAME_MAX + 1];
+	vfs_node_t *cur = base;
+	size_t pos = 0;
+	errno_t rc;
+
+	assert(!(lflag & (L_CREATE | L_UNLINK)));
+	assert(len > 0 && path[0] == '/');
+
+	vfs_node_addref(cur);
+
+	rc = lookup_cross_mounts(&cur, lflag);
+	if (rc != EOK)
+		goto out;
+
+	/* An empty component is only possible in "/". */
+	while (pos + 1 < len) {
+		size_t end = pos + 1;
+		while (end < len && path[end] != '/')
+			end++;
+
+		size_t clen = end - pos - 1;
+
+		if (cur->type == VFS_NODE_FILE) {
+			rc = ENOTDIR;
+			goto out;
+		}
+
+		vfs_node_t *child = NULL;
+		bool negative = false;
+
+		if (clen <= NAME_MAX) {
+			memcpy(component, &path[pos + 1], clen);
+			component[clen] = 0;
+
+			child = vfs_dcache_lookup((vfs_triplet_t *) cur,
+			    component, &negative);
+			if (negative) {
+				rc = ENOENT;
+				goto out;
+			}
+		}
+
+		if (!child) {
+			vfs_info_t *info = fs_handle_to_info(cur->fs_handle);
+			if (clen > NAME_MAX || !info ||
+			    info->volatile_namespace) {
+				rc = _vfs_lookup_internal(cur, &path[pos], lflag,
+				    result, len - pos);
+				goto out;
+			}
+
+			unsigned gen = vfs_dcache_generation();
+			vfs_lookup_res_t res;
+			bool found;
+
+			rc = lookup_component(cur, &path[pos], end - pos, &res,
+			    &found);
+			if (rc != EOK)
+				goto out;
+
+			if (!found) {
+				vfs_dcache_insert((vfs_triplet_t *) cur,
+				    component, NULL, gen);
+				rc = ENOENT;
+				goto out;
+			}
+
+			child = vfs_node_get(&res);
+			if (!child) {
+				rc = ENOMEM;
+				goto out;
+			}
+
+			vfs_dcache_insert((vfs_triplet_t *) cur, component,
+			    child, gen);
+		}
+
+		vfs_node_put(cur);
+		cur = child;
+		pos = end;
+
+		if (pos < len) {
+			rc = lookup_cross_mounts(&cur, lflag);
+			if (rc != EOK)
+				goto out;
+		}
+	}
+
+	if ((lflag & L_FILE) && cur->type == VFS_NODE_DIRECTORY) {
+		rc = EISDIR;
+		goto out;
+	}
+
+	if ((lflag & L_DIRECTORY) && cur->type == VFS_NODE_FILE) {
+		rc = ENOTDIR;
+		goto out;
+	}
+
+	/* The found file may be a mount point. Try to cross it. */
+	if (!(lflag & (L_MP | L_DISABLE_MOUNTS)))
+		(void) lookup_cross_mounts(&cur, lflag);
+
+	if (result != NULL) {
+		result->triplet = *((vfs_triplet_t *) cur);
+		result->type = cur->type;
+		result->size = cur->size;
+	}
+
+out:
+	vfs_node_put(cur);
+	return rc;
+}
+
 /** Perform a path lookup.
  *
  * @param base    The file from which to perform the lookup.
@@ -372,7 +563,7 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 			tflag &= ~(L_CREATE | L_EXCLUSIVE | L_UNLINK | L_FILE);
 			tflag |= L_DIRECTORY;
-			rc = _vfs_lookup_internal(base, path, tflag, &tres,
+			rc = _vfs_lookup_cached(base, path, tflag, &tres,
 			    slash - path);
 			if (rc != EOK)
 				return rc;
@@ -387,8 +578,12 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 		vfs_node_put(parent);
 
+		/* Unlinked names are dropped from the cache by the caller. */
+		if (rc == EOK && (lflag & L_CREATE))
+			vfs_dcache_added();
+
 	} else {
-		rc = _vfs_lookup_internal(base, path, lflag, result, len);
+		rc = _vfs_lookup_cached(base, path, lflag, result, len);
 	}
 
 	return rc;
@@ -578,8 +578,11 @@ errno_t vfs_op_rename(int basefd, char *old, char *new)
 	rc = vfs_link_internal(base, new, &old_lr.triplet);
 	if (rc != EOK) {
 		vfs_link_internal(base, old, &old_lr.triplet);
-		if (orig_unlinked)
+		if (orig_unlinked) {
 			vfs_link_internal(base, new, &new_lr_orig.triplet);
+			vfs_dcache_forget(&new_lr_orig.triplet);
+		}
+		vfs_dcache_forget(&old_lr.triplet);
 		vfs_node_put(base);
 		fibril_rwlock_write_unlock(&namespace_rwlock);
 		return rc;
@@ -588,16 +591,22 @@ errno_t vfs_op_rename(int basefd, char *old, char *new)
 	rc = vfs_lookup_internal(base, old, L_UNLINK | L_DISABLE_MOUNTS,
 	    &old_lr);
 	if (rc != EOK) {
-		if (orig_unlinked)
+		if (orig_unlinked) {
 			vfs_link_internal(base, new, &new_lr_orig.triplet);
+			vfs_dcache_forget(&new_lr_orig.triplet);
+		}
+		vfs_dcache_forget(&old_lr.triplet);
 		vfs_node_put(base);
 		fibril_rwlock_write_unlock(&namespace_rwlock);
 		return rc;
 	}
 
+	vfs_dcache_forget(&old_lr.triplet);
+
 	/* If the node is not held by anyone, try to destroy it. */
 	if (orig_unlinked) {
 		vfs_node_t *node = vfs_node_peek(&new_lr_orig);
+		vfs_dcache_forget(&new_lr_orig.triplet);
 		if (!node)
 			out_destroy(&new_lr_orig.triplet);
 		else
@@ -759,8 +768,14 @@ errno_t vfs_op_unlink(int parentfd, int expectfd, char *path)
 	if (rc != EOK)
 		goto exit;
 
-	/* If the node is not held by anyone, try to destroy it. */
+	/*
+	 * Drop the node from the directory entry cache. The node is peeked
+	 * first so that releasing the cache's reference cannot destroy it.
+	 */
 	vfs_node_t *node = vfs_node_peek(&lr);
+	vfs_dcache_forget(&lr.triplet);
+
+	/* If the node is not held by anyone, try to destroy it. */
 	if (!node)
 		out_destroy(&lr.triplet);
 	else
@@ -790,6 +805,10 @@ errno_t vfs_op_unmount(int mpfd)
 
 	fibril_rwlock_write_lock(&namespace_rwlock);
 
+	/* Cached names hold references to nodes of the mounted file system. */
+	vfs_dcache_forget_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+
 	/*
 	 * Count the total number of references for the mounted file system. We
 	 * are expecting at least one, which is held by the mount point.
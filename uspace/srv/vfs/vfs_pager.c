@@ -36,31 +36,98 @@
  */
 
 #include "vfs.h"
+#include <adt/list.h>
 #include <async.h>
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Maximum number of idle page-in buffers kept around. */
+#define PAGER_POOL_MAX	4
+
+typedef struct {
+	link_t link;
+	void *buffer;
+	size_t size;
+} pager_buffer_t;
+
+static FIBRIL_MUTEX_INITIALIZE(pager_pool_mutex);
+static LIST_INITIALIZE(pager_pool);
+static size_t pager_pool_count;
+
+/** Get a page-in buffer of at least the given size.
+ *
+ * The kernel copies the paged-in data out of the buffer while the page-in
+ * request is being answered, so the buffers can be reused right away.
+ */
+static pager_buffer_t *pager_buffer_get(size_t size)
+{
+	fibril_mutex_lock(&pager_pool_mutex);
+	list_foreach(pager_pool, link, pager_buffer_t, pbuf) {
+		if (pbuf->size >= size) {
+			list_remove(&pbuf->link);
+			pager_pool_count--;
+			fibril_mutex_unlock(&pager_pool_mutex);
+			return pbuf;
+		}
+	}
+	fibril_mutex_unlock(&pager_pool_mutex);
+
+	pager_buffer_t *pbuf = malloc(sizeof(pager_buffer_t));
+	if (!pbuf)
+		return NULL;
+
+	pbuf->buffer = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	    AS_AREA_UNPAGED);
+	if (pbuf->buffer == AS_MAP_FAILED) {
+		free(pbuf);
+		return NULL;
+	}
+
+	link_initialize(&pbuf->link);
+	pbuf->size = size;
+	return pbuf;
+}
+
+static void pager_buffer_put(pager_buffer_t *pbuf)
+{
+	fibril_mutex_lock(&pager_pool_mutex);
+	if (pager_pool_count < PAGER_POOL_MAX) {
+		list_prepend(&pbuf->link, &pager_pool);
+		pager_pool_count++;
+		pbuf = NULL;
+	}
+	fibril_mutex_unlock(&pager_pool_mutex);
+
+	if (pbuf) {
+		as_area_destroy(pbuf->buffer);
+		free(pbuf);
+	}
+}
 
 void vfs_page_in(ipc_call_t *req)
 {
 	aoff64_t offset = IPC_GET_ARG1(*req);
-	size_t page_size = IPC_GET_ARG2(*req);
+	size_t size = IPC_GET_ARG2(*req);
 	int fd = IPC_GET_ARG3(*req);
-	void *page;
 	errno_t rc;
 
-	page = as_area_create(AS_AREA_ANY, page_size,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
-	    AS_AREA_UNPAGED);
-
-	if (page == AS_MAP_FAILED) {
+	/*
+	 * The kernel asks for a whole cluster of pages at once. All of them
+	 * are read in a single pass over the file.
+	 */
+	pager_buffer_t *pbuf = pager_buffer_get(size);
+	if (!pbuf) {
 		async_answer_0(req, ENOMEM);
 		return;
 	}
 
 	rdwr_io_chunk_t chunk = {
-		.buffer = page,
-		.size = page_size
+		.buffer = pbuf->buffer,
+		.size = size
 	};
 
 	size_t total = 0;
@@ -74,10 +141,14 @@ void vfs_page_in(ipc_call_t *req)
 		total += chunk.size;
 		pos += chunk.size;
 		chunk.buffer += chunk.size;
-		chunk.size = page_size - total;
-	} while (total < page_size);
+		chunk.size = size - total;
+	} while (total < size);
+
+	/* Pages past the end of the file are filled with zeros. */
+	if (total < size)
+		memset(pbuf->buffer + total, 0, size - total);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	async_answer_2(req, rc, (sysarg_t) pbuf->buffer, size);
 
 	/*
 	 * FIXME:
@@ -85,7 +156,7 @@ void vfs_page_in(ipc_call_t *req)
 	 * management.  Not keeping the pages around in a cache results in
 	 * inherently non-coherent private mappings.
 	 */
-	as_area_destroy(page);
+	pager_buffer_put(pbuf);
 }
 
 /**